@@ -76,6 +76,7 @@
 #include "chthreads.h"
 
 /* Optional subsystems headers.*/
+#include "chperiodic.h"
 #include "chregistry.h"
 #include "chsem.h"
 #include "chbsem.h"
@@ -84,11 +85,17 @@
 #include "chevents.h"
 #include "chmsg.h"
 #include "chmboxes.h"
+#include "chring.h"
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
+#include "chobjfifos.h"
+#include "chmemarena.h"
+#include "chheapcache.h"
 #include "chdynamic.h"
+#include "chthdpool.h"
 #include "chqueues.h"
+#include "chwaitsets.h"
 #include "chstreams.h"
 
 #endif /* _CH_H_ */
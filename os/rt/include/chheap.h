@@ -34,10 +34,71 @@
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+/**
+ * @name    TLSF allocator parameters
+ * @{
+ */
+/**
+ * @brief   Logarithm of the number of second level classes.
+ */
+#define CH_HEAP_SL_LOG2         3
+
+/**
+ * @brief   Number of second level classes in each first level class.
+ */
+#define CH_HEAP_SL_COUNT        (1 << CH_HEAP_SL_LOG2)
+
+/**
+ * @brief   Number of first level classes.
+ * @details The first class contains the blocks smaller than
+ *          @p CH_HEAP_SL_COUNT alignment units, each one of the other
+ *          classes covers a power of two size range.
+ */
+#define CH_HEAP_FL_COUNT        24
+/** @} */
+#endif
+
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Number of size buckets in the allocations histogram.
+ * @details The bucket @p i counts the blocks not larger than
+ *          <tt>16 << i</tt> bytes, the last bucket counts all the larger
+ *          blocks.
+ */
+#define CH_HEAP_PROFILE_BUCKETS 8
+
+/**
+ * @name    Heap trace event types
+ * @{
+ */
+#define CH_HEAP_TRACE_ALLOC     1U  /**< @brief Block allocated.            */
+#define CH_HEAP_TRACE_FREE      2U  /**< @brief Block released.             */
+#define CH_HEAP_TRACE_FAIL      3U  /**< @brief Allocation failed.          */
+/** @} */
+#endif
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Number of call sites tracked by each heap.
+ * @details The site zero collects the untagged allocations and the
+ *          allocations exceeding the sites table.
+ */
+#if !defined(CH_CFG_HEAP_PROFILE_SITES) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_PROFILE_SITES           8
+#endif
+
+/**
+ * @brief   Heap trace buffer size (entries).
+ * @note    Zero disables the heap trace.
+ */
+#if !defined(CH_CFG_HEAP_TRACE_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_TRACE_BUFFER_SIZE       64
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -50,6 +111,14 @@
 #error "CH_CFG_USE_HEAP requires CH_CFG_USE_MUTEXES and/or CH_CFG_USE_SEMAPHORES"
 #endif
 
+#if CH_CFG_HEAP_TLSF && (CH_HEAP_FL_COUNT > 32)
+#error "too many TLSF first level classes"
+#endif
+
+#if CH_CFG_HEAP_PROFILE && (CH_CFG_HEAP_PROFILE_SITES < 2)
+#error "CH_CFG_HEAP_PROFILE_SITES must be at least two"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -59,6 +128,65 @@
  */
 typedef struct memory_heap memory_heap_t;
 
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Allocations owned by a call site.
+ */
+typedef struct {
+  const void            *hs_tag;    /**< @brief Call site tag.              */
+  size_t                hs_blocks;  /**< @brief Live blocks.                */
+  size_t                hs_bytes;   /**< @brief Live bytes.                 */
+} heap_site_t;
+
+/**
+ * @brief   Heap profiling data.
+ * @note    The sizes are the sizes of the allocated blocks, headers
+ *          excluded.
+ */
+typedef struct {
+  size_t                hp_used;    /**< @brief Allocated bytes.            */
+  size_t                hp_max_used;/**< @brief Allocated bytes high water
+                                                mark.                       */
+  ucnt_t                hp_allocs;  /**< @brief Successful allocations.     */
+  ucnt_t                hp_frees;   /**< @brief Released blocks.            */
+  ucnt_t                hp_failures;/**< @brief Failed allocations.         */
+  size_t                hp_hist[CH_HEAP_PROFILE_BUCKETS];
+                                    /**< @brief Live blocks by size.        */
+  heap_site_t           hp_sites[CH_CFG_HEAP_PROFILE_SITES];
+                                    /**< @brief Live blocks by call site.   */
+} heap_profile_t;
+
+#if (CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Heap trace buffer record.
+ */
+typedef struct {
+  systime_t             he_time;    /**< @brief Time of the event.          */
+  uint8_t               he_type;    /**< @brief Event type.                 */
+  thread_t              *he_tp;     /**< @brief Calling thread.             */
+  memory_heap_t         *he_heap;   /**< @brief Heap.                       */
+  void                  *he_ptr;    /**< @brief Block or @p NULL.           */
+  size_t                he_size;    /**< @brief Block or requested size.    */
+  const void            *he_tag;    /**< @brief Call site tag.              */
+} heap_trace_event_t;
+
+/**
+ * @brief   Heap trace buffer.
+ * @note    The buffer is meant to be dumped by a debugger and decoded on
+ *          the host, the header only contains 32 bits fields in order to
+ *          make the layout easy to decode.
+ */
+typedef struct {
+  uint32_t              ht_size;    /**< @brief Buffer size (entries).      */
+  uint32_t              ht_next;    /**< @brief Index of the next entry to
+                                                be written.                 */
+  uint32_t              ht_events;  /**< @brief Recorded events counter.    */
+  heap_trace_event_t    ht_buffer[CH_CFG_HEAP_TRACE_BUFFER_SIZE];
+                                    /**< @brief Ring buffer.                */
+} heap_trace_buffer_t;
+#endif /* CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0 */
+#endif /* CH_CFG_HEAP_PROFILE */
+
 /**
  * @brief   Memory heap block header.
  */
@@ -70,6 +198,13 @@ union heap_header {
       memory_heap_t     *heap;      /**< @brief Block owner heap.           */
     } u;                            /**< @brief Overlapped fields.          */
     size_t              size;       /**< @brief Size of the memory block.   */
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+    size_t              site;       /**< @brief Call site index.            */
+#endif
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+    union heap_header   *prev;      /**< @brief Previous physical block or
+                                                @p NULL.                    */
+#endif
   } h;
 };
 
@@ -79,12 +214,25 @@ union heap_header {
 struct memory_heap {
   memgetfunc_t          h_provider; /**< @brief Memory blocks provider for
                                                 this heap.                  */
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  uint32_t              h_flmap;    /**< @brief First level classes with
+                                                free blocks.                */
+  uint32_t              h_slmap[CH_HEAP_FL_COUNT];
+                                    /**< @brief Second level classes with
+                                                free blocks.                */
+  union heap_header     *h_lists[CH_HEAP_FL_COUNT][CH_HEAP_SL_COUNT];
+                                    /**< @brief Free blocks lists.          */
+#else
   union heap_header     h_free;     /**< @brief Free blocks list header.    */
+#endif
 #if CH_CFG_USE_MUTEXES
   mutex_t               h_mtx;      /**< @brief Heap access mutex.          */
 #else
   semaphore_t           h_sem;      /**< @brief Heap access semaphore.      */
 #endif
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+  heap_profile_t        h_profile;  /**< @brief Profiling data.             */
+#endif
 };
 
 /*===========================================================================*/
@@ -95,14 +243,31 @@ struct memory_heap {
 /* External declarations.                                                    */
 /*===========================================================================*/
 
+#if (CH_CFG_HEAP_PROFILE && (CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0)) ||           \
+    defined(__DOXYGEN__)
+extern heap_trace_buffer_t ch_heap_trace;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
   void _heap_init(void);
   void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size);
+  void chHeapObjectInitProvider(memory_heap_t *heapp, memgetfunc_t provider);
   void *chHeapAlloc(memory_heap_t *heapp, size_t size);
+  void *chHeapAllocTagged(memory_heap_t *heapp, size_t size,
+                          const void *tag);
+  void *chHeapAllocAligned(memory_heap_t *heapp, size_t size, size_t align);
+  size_t chHeapAllocBatch(memory_heap_t *heapp, size_t size,
+                          void *objs[], size_t n);
   void chHeapFree(void *p);
+  void chHeapFreeBatch(void *objs[], size_t n);
   size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep);
+  size_t chHeapGetLargestFree(memory_heap_t *heapp);
+  memory_heap_t *chHeapGetDefaultX(void);
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+  void chHeapGetProfile(memory_heap_t *heapp, heap_profile_t *hpp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,176 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chheapcache.h
+ * @brief   Heap caches macros and structures.
+ *
+ * @addtogroup heap_caches
+ * @{
+ */
+
+#ifndef _CHHEAPCACHE_H_
+#define _CHHEAPCACHE_H_
+
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of size classes in a heap cache.
+ */
+#define CH_HEAP_CACHE_CLASSES           4
+
+/**
+ * @brief   Size of the objects in the smallest class.
+ * @details Each class doubles the objects size of the previous one.
+ */
+#define CH_HEAP_CACHE_MIN_SIZE          16
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of objects moved from or to the heap in a single batch.
+ */
+#if !defined(CH_CFG_HEAP_CACHE_BATCH) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_CACHE_BATCH         8
+#endif
+
+/**
+ * @brief   Maximum number of objects held in each class.
+ * @details When the limit is exceeded a batch of objects is returned to the
+ *          heap.
+ */
+#if !defined(CH_CFG_HEAP_CACHE_LIMIT) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_CACHE_LIMIT         16
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_CFG_USE_HEAP
+#error "CH_CFG_USE_HEAP_CACHE requires CH_CFG_USE_HEAP"
+#endif
+
+#if !CH_CFG_USE_MEMPOOLS
+#error "CH_CFG_USE_HEAP_CACHE requires CH_CFG_USE_MEMPOOLS"
+#endif
+
+#if (CH_CFG_HEAP_CACHE_BATCH < 1) ||                                        \
+    (CH_CFG_HEAP_CACHE_LIMIT < CH_CFG_HEAP_CACHE_BATCH)
+#error "invalid CH_CFG_HEAP_CACHE_BATCH or CH_CFG_HEAP_CACHE_LIMIT value"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a heap cache.
+ */
+typedef struct ch_heap_cache heap_cache_t;
+
+/**
+ * @brief   Structure representing a heap cache.
+ * @note    The cache is only accessed by the threads it is bound to, the
+ *          statistics can be read by other threads.
+ */
+struct ch_heap_cache {
+  memory_heap_t         *hc_heap;       /**< @brief Heap refilling the
+                                             cache.                         */
+  memory_pool_t         hc_pools[CH_HEAP_CACHE_CLASSES];
+                                        /**< @brief Cached objects, one pool
+                                             for each size class.           */
+  size_t                hc_counts[CH_HEAP_CACHE_CLASSES];
+                                        /**< @brief Objects in each pool.   */
+  ucnt_t                hc_hits;        /**< @brief Allocations served by
+                                             the cache.                     */
+  ucnt_t                hc_misses;      /**< @brief Allocations requiring
+                                             a refill or served by the
+                                             heap.                          */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chHeapCacheObjectInit(heap_cache_t *hcp, memory_heap_t *heapp);
+  void chHeapCacheBind(heap_cache_t *hcp);
+  void *chHeapCacheAlloc(size_t size);
+  void chHeapCacheFree(void *p);
+  void chHeapCacheFlush(heap_cache_t *hcp);
+  size_t chHeapCacheStatus(heap_cache_t *hcp, size_t *sizep);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the heap cache bound to a thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The heap cache or @p NULL if the thread has no
+ *                      cache bound.
+ *
+ * @iclass
+ */
+static inline heap_cache_t *chHeapCacheGetI(thread_t *tp) {
+
+  chDbgCheckClassI();
+
+  return tp->p_hcache;
+}
+
+/**
+ * @brief   Returns the hit rate of a heap cache.
+ *
+ * @param[in] hcp       pointer to the @p heap_cache_t object
+ * @return              The percentage of allocations served by the cache.
+ *
+ * @xclass
+ */
+static inline unsigned chHeapCacheGetHitRateX(heap_cache_t *hcp) {
+  ucnt_t total = hcp->hc_hits + hcp->hc_misses;
+
+  if (total == (ucnt_t)0) {
+    return 0U;
+  }
+  return (unsigned)(((uint64_t)hcp->hc_hits * 100U) / (uint64_t)total);
+}
+
+#endif /* CH_CFG_USE_HEAP_CACHE */
+
+#endif /* _CHHEAPCACHE_H_ */
+
+/** @} */
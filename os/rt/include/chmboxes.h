@@ -119,6 +119,14 @@ extern "C" {
   msg_t chMBFetch(mailbox_t *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchS(mailbox_t *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp);
+  cnt_t chMBPostMany(mailbox_t *mbp, const msg_t *msgs, cnt_t n,
+                     systime_t time);
+  cnt_t chMBPostManyS(mailbox_t *mbp, const msg_t *msgs, cnt_t n,
+                      systime_t time);
+  cnt_t chMBPostManyI(mailbox_t *mbp, const msg_t *msgs, cnt_t n);
+  cnt_t chMBFetchMany(mailbox_t *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchManyS(mailbox_t *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchManyI(mailbox_t *mbp, msg_t *msgs, cnt_t n);
 #ifdef __cplusplus
 }
 #endif
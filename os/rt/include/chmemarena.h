@@ -0,0 +1,182 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chmemarena.h
+ * @brief   Memory Arenas macros and structures.
+ *
+ * @addtogroup arenas
+ * @{
+ */
+
+#ifndef _CHMEMARENA_H_
+#define _CHMEMARENA_H_
+
+#if CH_CFG_USE_MEMARENAS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of an arena mark.
+ * @details A mark records the arena allocation point, the memory allocated
+ *          after the mark is released by rewinding the arena to the mark.
+ */
+typedef uint8_t *arena_mark_t;
+
+/**
+ * @brief   Memory arena descriptor.
+ */
+typedef struct {
+  uint8_t               *ma_base;       /**< @brief Arena buffer base.      */
+  uint8_t               *ma_next;       /**< @brief Next free location.     */
+  uint8_t               *ma_end;        /**< @brief Arena buffer end.       */
+  size_t                ma_peak;        /**< @brief Allocated bytes high
+                                                    water mark.             */
+} memory_arena_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Arena alignment macros
+ * @note    Arenas do not depend on the core allocator so the alignment
+ *          macros are defined locally.
+ * @{
+ */
+/**
+ * @brief   Arena blocks alignment.
+ */
+#define ARENA_ALIGN_SIZE    sizeof (stkalign_t)
+
+/**
+ * @brief   Arena alignment mask.
+ */
+#define ARENA_ALIGN_MASK    (ARENA_ALIGN_SIZE - 1U)
+
+/**
+ * @brief   Aligns a size or address to the previous boundary.
+ */
+#define ARENA_ALIGN_PREV(p) ((size_t)(p) & ~ARENA_ALIGN_MASK)
+
+/**
+ * @brief   Aligns a size or address to the next boundary.
+ */
+#define ARENA_ALIGN_NEXT(p) ARENA_ALIGN_PREV((size_t)(p) + ARENA_ALIGN_MASK)
+
+/**
+ * @brief   Returns whatever a pointer or size is aligned to the arena
+ *          blocks alignment.
+ */
+#define ARENA_IS_ALIGNED(p) (((size_t)(p) & ARENA_ALIGN_MASK) == 0U)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chArenaObjectInit(memory_arena_t *map, void *buf, size_t size);
+  void *chArenaAlloc(memory_arena_t *map, size_t size);
+  void chArenaRewind(memory_arena_t *map, arena_mark_t mark);
+  void chArenaReset(memory_arena_t *map);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns a mark of the current allocation point.
+ * @details The mark opens a scope, the scope is closed by rewinding the
+ *          arena to the mark using @p chArenaRewind(). Scopes can be
+ *          nested.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @return              The arena mark.
+ *
+ * @xclass
+ */
+static inline arena_mark_t chArenaGetMarkX(memory_arena_t *map) {
+
+  return map->ma_next;
+}
+
+/**
+ * @brief   Returns the size of the memory allocated from an arena.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @return              The allocated size.
+ *
+ * @xclass
+ */
+static inline size_t chArenaGetUsedX(memory_arena_t *map) {
+
+  return (size_t)(map->ma_next - map->ma_base);
+}
+
+/**
+ * @brief   Returns the size of the memory still available in an arena.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @return              The free size.
+ *
+ * @xclass
+ */
+static inline size_t chArenaGetFreeX(memory_arena_t *map) {
+
+  return (size_t)(map->ma_end - map->ma_next);
+}
+
+/**
+ * @brief   Returns the peak usage of an arena.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @return              The allocated size high water mark.
+ *
+ * @xclass
+ */
+static inline size_t chArenaGetPeakX(memory_arena_t *map) {
+
+  return map->ma_peak;
+}
+
+#endif /* CH_CFG_USE_MEMARENAS */
+
+#endif /* _CHMEMARENA_H_ */
+
+/** @} */
@@ -34,14 +34,54 @@
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Memory region attributes
+ * @{
+ */
+#define CH_MEM_ATTR_DMA         1U  /**< @brief DMA-capable memory.         */
+#define CH_MEM_ATTR_FAST        2U  /**< @brief Fast memory, for example
+                                                CCM or TCM.                 */
+/** @} */
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Number of core memory regions.
+ * @details The region zero is the default one, the other regions can be
+ *          registered using @p chCoreAddRegion().
+ */
+#if !defined(CH_CFG_MEMCORE_REGIONS) || defined(__DOXYGEN__)
+#define CH_CFG_MEMCORE_REGIONS              1
+#endif
+
+/**
+ * @brief   Attributes of the region zero.
+ */
+#if !defined(CH_CFG_MEMCORE_DEFAULT_ATTR) || defined(__DOXYGEN__)
+#define CH_CFG_MEMCORE_DEFAULT_ATTR         CH_MEM_ATTR_DMA
+#endif
+
+/**
+ * @brief   Attributes preferred by the default core allocations.
+ * @details If not zero then @p chCoreAlloc() tries the regions having
+ *          these attributes before the region zero, this makes the
+ *          default heap, and then the dynamic threads stacks, and the
+ *          memory pools providers use those regions first.
+ */
+#if !defined(CH_CFG_MEMCORE_PREFER) || defined(__DOXYGEN__)
+#define CH_CFG_MEMCORE_PREFER               0
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if CH_CFG_MEMCORE_REGIONS < 1
+#error "CH_CFG_MEMCORE_REGIONS must be at least one"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -53,6 +93,17 @@
  */
 typedef void *(*memgetfunc_t)(size_t size);
 
+/**
+ * @brief   Core memory region descriptor.
+ */
+typedef struct {
+  const char            *mr_name;       /**< @brief Region name.            */
+  uint8_t               *mr_next;       /**< @brief Next free location.     */
+  uint8_t               *mr_end;        /**< @brief Region end.             */
+  uint32_t              mr_attr;        /**< @brief Region attributes.      */
+  size_t                mr_align;       /**< @brief Blocks alignment.       */
+} memory_region_t;
+
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
@@ -97,7 +148,22 @@ extern "C" {
   void _core_init(void);
   void *chCoreAlloc(size_t size);
   void *chCoreAllocI(size_t size);
+  void *chCoreAllocAlignedI(size_t size, size_t align);
+  void *chCoreAllocAligned(size_t size, size_t align);
   size_t chCoreGetStatusX(void);
+  memory_region_t *chCoreAddRegion(const char *name, void *base, size_t size,
+                                   uint32_t attr, size_t align);
+  memory_region_t *chCoreFindRegion(const char *name);
+  void *chCoreAllocFromI(memory_region_t *mrp, size_t size);
+  void *chCoreAllocFrom(memory_region_t *mrp, size_t size);
+  void *chCoreAllocPolicyI(uint32_t required, uint32_t preferred,
+                           size_t size);
+  void *chCoreAllocPolicy(uint32_t required, uint32_t preferred,
+                          size_t size);
+  void *chCoreAllocFastI(size_t size);
+  void *chCoreAllocFast(size_t size);
+  void *chCoreAllocDMAI(size_t size);
+  void *chCoreAllocDMA(size_t size);
 #ifdef __cplusplus
 }
 #endif
@@ -106,6 +172,19 @@ extern "C" {
 /* Module inline functions.                                                  */
 /*===========================================================================*/
 
+/**
+ * @brief   Core memory region status.
+ *
+ * @param[in] mrp       pointer to the region
+ * @return              The size, in bytes, of the free memory in the region.
+ *
+ * @xclass
+ */
+static inline size_t chCoreGetRegionStatusX(memory_region_t *mrp) {
+
+  return (size_t)(mrp->mr_end - mrp->mr_next);
+}
+
 #endif /* CH_CFG_USE_MEMCORE */
 
 #endif /* _CHMEMCORE_H_ */
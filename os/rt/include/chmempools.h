@@ -67,8 +67,24 @@ typedef struct {
                                                     size.                   */
   memgetfunc_t          mp_provider;    /**< @brief Memory blocks provider
                                                     for this pool.          */
+  size_t                mp_align;       /**< @brief Objects alignment.      */
 } memory_pool_t;
 
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Guarded memory pool descriptor.
+ * @details The semaphore counts the objects in the pool, the threads
+ *          allocating from an empty pool are suspended until an object is
+ *          returned.
+ */
+typedef struct {
+  semaphore_t           gmp_sem;        /**< @brief Counter semaphore
+                                                    guarding the memory
+                                                    pool.                   */
+  memory_pool_t         gmp_pool;       /**< @brief The memory pool itself. */
+} guarded_memory_pool_t;
+#endif
+
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
@@ -83,7 +99,7 @@ typedef struct {
  * @param[in] provider  memory provider function for the memory pool
  */
 #define _MEMORYPOOL_DATA(name, size, provider)                              \
-  {NULL, size, provider}
+  {NULL, size, provider, sizeof (void *)}
 
 /**
  * @brief Static memory pool initializer in hungry mode.
@@ -98,6 +114,30 @@ typedef struct {
 #define MEMORYPOOL_DECL(name, size, provider)                               \
   memory_pool_t name = _MEMORYPOOL_DATA(name, size, provider)
 
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Data part of a static guarded memory pool initializer.
+ * @details This macro should be used when statically initializing a
+ *          guarded memory pool that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the guarded memory pool variable
+ * @param[in] size      size of the memory pool contained objects
+ */
+#define _GUARDEDMEMORYPOOL_DATA(name, size)                                 \
+  {_SEMAPHORE_DATA(name.gmp_sem, 0), _MEMORYPOOL_DATA(NULL, size, NULL)}
+
+/**
+ * @brief   Static guarded memory pool initializer.
+ * @details Statically initialized guarded memory pools require no explicit
+ *          initialization using @p chGuardedPoolObjectInit().
+ *
+ * @param[in] name      the name of the guarded memory pool variable
+ * @param[in] size      size of the memory pool contained objects
+ */
+#define GUARDEDMEMORYPOOL_DECL(name, size)                                  \
+  guarded_memory_pool_t name = _GUARDEDMEMORYPOOL_DATA(name, size)
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -106,11 +146,30 @@ typedef struct {
 extern "C" {
 #endif
   void chPoolObjectInit(memory_pool_t *mp, size_t size, memgetfunc_t provider);
+  void chPoolObjectInitAligned(memory_pool_t *mp, size_t size, size_t align,
+                               memgetfunc_t provider);
   void chPoolLoadArray(memory_pool_t *mp, void *p, size_t n);
   void *chPoolAllocI(memory_pool_t *mp);
   void *chPoolAlloc(memory_pool_t *mp);
   void chPoolFreeI(memory_pool_t *mp, void *objp);
   void chPoolFree(memory_pool_t *mp, void *objp);
+  size_t chPoolAllocBatchI(memory_pool_t *mp, void *objs[], size_t n);
+  size_t chPoolAllocBatch(memory_pool_t *mp, void *objs[], size_t n);
+  void chPoolFreeBatchI(memory_pool_t *mp, void *objs[], size_t n);
+  void chPoolFreeBatch(memory_pool_t *mp, void *objs[], size_t n);
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+  void chGuardedPoolObjectInit(guarded_memory_pool_t *gmp, size_t size);
+  void chGuardedPoolObjectInitAligned(guarded_memory_pool_t *gmp,
+                                      size_t size, size_t align);
+  void chGuardedPoolLoadArray(guarded_memory_pool_t *gmp, void *p, size_t n);
+  void *chGuardedPoolAllocI(guarded_memory_pool_t *gmp);
+  void *chGuardedPoolAllocTimeoutS(guarded_memory_pool_t *gmp,
+                                   systime_t time);
+  void *chGuardedPoolAllocTimeout(guarded_memory_pool_t *gmp,
+                                  systime_t time);
+  void chGuardedPoolFreeI(guarded_memory_pool_t *gmp, void *objp);
+  void chGuardedPoolFree(guarded_memory_pool_t *gmp, void *objp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -161,6 +220,64 @@ static inline void chPoolAddI(memory_pool_t *mp, void *objp) {
   chPoolFreeI(mp, objp);
 }
 
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Gets the count of objects in a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @return              The counter of the guard semaphore.
+ *
+ * @iclass
+ */
+static inline cnt_t chGuardedPoolGetCounterI(guarded_memory_pool_t *gmp) {
+
+  chDbgCheckClassI();
+
+  return chSemGetCounterI(&gmp->gmp_sem);
+}
+
+/**
+ * @brief   Adds an object to a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The added object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The added object must be properly aligned.
+ * @note    This function is just an alias for @p chGuardedPoolFree() and
+ *          has been added for clarity.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] objp      the pointer to the object to be added
+ *
+ * @api
+ */
+static inline void chGuardedPoolAdd(guarded_memory_pool_t *gmp, void *objp) {
+
+  chGuardedPoolFree(gmp, objp);
+}
+
+/**
+ * @brief   Adds an object to a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The added object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The added object must be properly aligned.
+ * @note    This function is just an alias for @p chGuardedPoolFreeI() and
+ *          has been added for clarity.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] objp      the pointer to the object to be added
+ *
+ * @iclass
+ */
+static inline void chGuardedPoolAddI(guarded_memory_pool_t *gmp, void *objp) {
+
+  chDbgCheckClassI();
+
+  chGuardedPoolFreeI(gmp, objp);
+}
+#endif /* CH_CFG_USE_SEMAPHORES */
+
 #endif /* CH_CFG_USE_MEMPOOLS */
 
 #endif /* _CHMEMPOOLS_H_ */
@@ -34,6 +34,15 @@
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Message handle states
+ * @{
+ */
+#define MSG_HANDLE_QUEUED       0   /**< @brief Queued on the server.       */
+#define MSG_HANDLE_SERVING      1   /**< @brief Received by the server.     */
+#define MSG_HANDLE_DONE         2   /**< @brief Answer available.           */
+/** @} */
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -46,6 +55,27 @@
 /* Module data structures and types.                                         */
 /*===========================================================================*/
 
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Type of an asynchronous message handle.
+ */
+typedef struct ch_msg_handle msg_handle_t;
+
+/**
+ * @brief   Structure representing an asynchronous message handle.
+ * @details The handle carries the message to the server and the answer
+ *          back to the client, it must stay valid until the answer has
+ *          been collected.
+ */
+struct ch_msg_handle {
+  msg_handle_t          *mh_next;       /**< @brief Next queued message.    */
+  msg_t                 mh_msg;         /**< @brief Message, then answer.   */
+  uint8_t               mh_state;       /**< @brief Handle state.           */
+  thread_reference_t    mh_thread;      /**< @brief Thread collecting the
+                                                    answer.                 */
+};
+#endif
+
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
@@ -60,6 +90,13 @@ extern "C" {
   msg_t chMsgSend(thread_t *tp, msg_t msg);
   thread_t * chMsgWait(void);
   void chMsgRelease(thread_t *tp, msg_t msg);
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  void chMsgSendAsyncI(thread_t *tp, msg_handle_t *mhp, msg_t msg);
+  void chMsgSendAsync(thread_t *tp, msg_handle_t *mhp, msg_t msg);
+  msg_handle_t *chMsgWaitAsync(void);
+  void chMsgReleaseAsync(msg_handle_t *mhp, msg_t msg);
+  msg_t chMsgCollectTimeout(msg_handle_t *mhp, msg_t *msgp, systime_t time);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -115,6 +152,73 @@ static inline void chMsgReleaseS(thread_t *tp, msg_t msg) {
   chSchWakeupS(tp, msg);
 }
 
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Evaluates to @p true if the thread has pending asynchronous
+ *          messages.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The pending messages status.
+ *
+ * @iclass
+ */
+static inline bool chMsgIsPendingAsyncI(thread_t *tp) {
+
+  chDbgCheckClassI();
+
+  return (bool)(tp->p_amsghead != NULL);
+}
+
+/**
+ * @brief   Returns the message carried by an asynchronous message handle.
+ * @pre     This function must be invoked after receiving the handle from
+ *          @p chMsgWaitAsync() and before releasing it.
+ *
+ * @param[in] mhp       pointer to the @p msg_handle_t structure
+ * @return              The message carried by the handle.
+ *
+ * @api
+ */
+static inline msg_t chMsgGetAsync(msg_handle_t *mhp) {
+
+  return mhp->mh_msg;
+}
+
+/**
+ * @brief   Evaluates to @p true if the answer of an asynchronous message
+ *          is available.
+ *
+ * @param[in] mhp       pointer to the @p msg_handle_t structure
+ * @return              The completion status.
+ *
+ * @iclass
+ */
+static inline bool chMsgIsCompletedI(msg_handle_t *mhp) {
+
+  chDbgCheckClassI();
+
+  return (bool)(mhp->mh_state == MSG_HANDLE_DONE);
+}
+
+/**
+ * @brief   Collects the answer of an asynchronous message.
+ * @details The invoking thread waits until the server releases the
+ *          message.
+ *
+ * @param[in] mhp       pointer to the @p msg_handle_t structure
+ * @return              The answer message from @p chMsgReleaseAsync().
+ *
+ * @api
+ */
+static inline msg_t chMsgCollect(msg_handle_t *mhp) {
+  msg_t msg;
+
+  (void) chMsgCollectTimeout(mhp, &msg, TIME_INFINITE);
+
+  return msg;
+}
+#endif /* CH_CFG_USE_MESSAGES_ASYNC */
+
 #endif /* CH_CFG_USE_MESSAGES */
 
 #endif /* _CHMSG_H_ */
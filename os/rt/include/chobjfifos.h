@@ -0,0 +1,391 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chobjfifos.h
+ * @brief   Objects FIFOs structures and macros.
+ * @details This module implements a generic FIFO queue of objects by
+ *          coupling a guarded memory pool (for objects storage) and a
+ *          mailbox (for FIFO management).<br>
+ *          The objects are passed by reference, the producer takes a free
+ *          object, fills it and sends it, the consumer receives it and
+ *          returns it after use. The module is implemented as inline
+ *          functions over the mailboxes and memory pools APIs.
+ *          <h2>Operation mode</h2>
+ *          - <b>Take</b>: A free object is taken from the pool, the
+ *            invoking thread waits if there are no free objects.
+ *          - <b>Send</b>: An object is posted in the FIFO, this operation
+ *            never blocks because the mailbox has a slot for each object.
+ *          - <b>Receive</b>: An object is fetched from the FIFO, the
+ *            invoking thread waits if the FIFO is empty.
+ *          - <b>Return</b>: An object is released into the pool.
+ *          .
+ *          The mailbox carries the objects indexes rather than pointers
+ *          so the FIFO works on ports where @p msg_t is smaller than a
+ *          pointer.
+ * @pre     In order to use the objects FIFOs APIs the
+ *          @p CH_CFG_USE_OBJ_FIFOS option must be enabled in @p chconf.h.
+ *
+ * @addtogroup objects_fifos
+ * @{
+ */
+
+#ifndef _CHOBJFIFOS_H_
+#define _CHOBJFIFOS_H_
+
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_CFG_USE_MEMPOOLS
+#error "CH_CFG_USE_OBJ_FIFOS requires CH_CFG_USE_MEMPOOLS"
+#endif
+
+#if !CH_CFG_USE_MAILBOXES
+#error "CH_CFG_USE_OBJ_FIFOS requires CH_CFG_USE_MAILBOXES"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of an objects FIFO.
+ */
+typedef struct ch_objects_fifo {
+  guarded_memory_pool_t of_free;        /**< @brief Pool of the free
+                                             objects.                       */
+  mailbox_t             of_mbx;         /**< @brief Mailbox of the sent
+                                             objects indexes.               */
+  uint8_t               *of_base;       /**< @brief Pointer to the objects
+                                             array.                         */
+} objects_fifo_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a FIFO object.
+ *
+ * @param[out] ofp      pointer to a @p objects_fifo_t structure
+ * @param[in] objsize   size of objects
+ * @param[in] objn      number of objects available
+ * @param[in] objalign  required objects alignment, it must be a power of
+ *                      two not smaller than the size of a pointer to void
+ * @param[in] adr       pointer to the objects array, the objects are
+ *                      @p objsize rounded up to @p objalign bytes apart
+ * @param[in] msgbuf    pointer to the buffer of messages, it must be able
+ *                      to hold @p objn messages
+ *
+ * @init
+ */
+static inline void chFifoObjectInit(objects_fifo_t *ofp, size_t objsize,
+                                    size_t objn, size_t objalign,
+                                    void *adr, msg_t *msgbuf) {
+
+  chDbgCheck((objsize >= sizeof (void *)) && (objn > (size_t)0));
+
+  chGuardedPoolObjectInitAligned(&ofp->of_free, objsize, objalign);
+  chGuardedPoolLoadArray(&ofp->of_free, adr, objn);
+  chMBObjectInit(&ofp->of_mbx, msgbuf, (cnt_t)objn);
+  ofp->of_base = (uint8_t *)adr;
+}
+
+/**
+ * @brief   Converts an object pointer to the message sent in the mailbox.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object
+ * @return              The object index.
+ *
+ * @notapi
+ */
+static inline msg_t _fifo_obj2msg(objects_fifo_t *ofp, void *objp) {
+
+  return (msg_t)((size_t)((uint8_t *)objp - ofp->of_base) /
+                 ofp->of_free.gmp_pool.mp_object_size);
+}
+
+/**
+ * @brief   Converts a message received from the mailbox to an object pointer.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] msg       the object index
+ * @return              The pointer to the object.
+ *
+ * @notapi
+ */
+static inline void *_fifo_msg2obj(objects_fifo_t *ofp, msg_t msg) {
+
+  return (void *)(ofp->of_base +
+                  ((size_t)msg * ofp->of_free.gmp_pool.mp_object_size));
+}
+
+/**
+ * @brief   Allocates a free object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if an object is not immediately available.
+ *
+ * @iclass
+ */
+static inline void *chFifoTakeObjectI(objects_fifo_t *ofp) {
+
+  return chGuardedPoolAllocI(&ofp->of_free);
+}
+
+/**
+ * @brief   Allocates a free object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if an object is not available within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+static inline void *chFifoTakeObjectTimeoutS(objects_fifo_t *ofp,
+                                             systime_t time) {
+
+  return chGuardedPoolAllocTimeoutS(&ofp->of_free, time);
+}
+
+/**
+ * @brief   Allocates a free object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if an object is not available within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+static inline void *chFifoTakeObjectTimeout(objects_fifo_t *ofp,
+                                            systime_t time) {
+
+  return chGuardedPoolAllocTimeout(&ofp->of_free, time);
+}
+
+/**
+ * @brief   Releases a fetched object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be released
+ *
+ * @iclass
+ */
+static inline void chFifoReturnObjectI(objects_fifo_t *ofp, void *objp) {
+
+  chGuardedPoolFreeI(&ofp->of_free, objp);
+}
+
+/**
+ * @brief   Releases a fetched object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be released
+ *
+ * @sclass
+ */
+static inline void chFifoReturnObjectS(objects_fifo_t *ofp, void *objp) {
+
+  chGuardedPoolFreeI(&ofp->of_free, objp);
+  chSchRescheduleS();
+}
+
+/**
+ * @brief   Releases a fetched object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be released
+ *
+ * @api
+ */
+static inline void chFifoReturnObject(objects_fifo_t *ofp, void *objp) {
+
+  chGuardedPoolFree(&ofp->of_free, objp);
+}
+
+/**
+ * @brief   Posts an object.
+ * @note    By design the object can be always immediately posted.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @iclass
+ */
+static inline void chFifoSendObjectI(objects_fifo_t *ofp, void *objp) {
+  msg_t msg;
+
+  msg = chMBPostI(&ofp->of_mbx, _fifo_obj2msg(ofp, objp));
+  chDbgAssert(msg == MSG_OK, "post failed");
+  (void)msg;
+}
+
+/**
+ * @brief   Posts an object.
+ * @note    By design the object can be always immediately posted.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @sclass
+ */
+static inline void chFifoSendObjectS(objects_fifo_t *ofp, void *objp) {
+  msg_t msg;
+
+  msg = chMBPostS(&ofp->of_mbx, _fifo_obj2msg(ofp, objp), TIME_IMMEDIATE);
+  chDbgAssert(msg == MSG_OK, "post failed");
+  (void)msg;
+}
+
+/**
+ * @brief   Posts an object.
+ * @note    By design the object can be always immediately posted.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @api
+ */
+static inline void chFifoSendObject(objects_fifo_t *ofp, void *objp) {
+  msg_t msg;
+
+  msg = chMBPost(&ofp->of_mbx, _fifo_obj2msg(ofp, objp), TIME_IMMEDIATE);
+  chDbgAssert(msg == MSG_OK, "post failed");
+  (void)msg;
+}
+
+/**
+ * @brief   Fetches an object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[out] objpp    pointer to the fetched object reference
+ * @return              The operation status.
+ * @retval MSG_OK       if an object has been correctly fetched.
+ * @retval MSG_TIMEOUT  if the FIFO is empty and a message cannot be fetched.
+ *
+ * @iclass
+ */
+static inline msg_t chFifoReceiveObjectI(objects_fifo_t *ofp,
+                                         void **objpp) {
+  msg_t msg, idx;
+
+  msg = chMBFetchI(&ofp->of_mbx, &idx);
+  if (msg == MSG_OK) {
+    *objpp = _fifo_msg2obj(ofp, idx);
+  }
+
+  return msg;
+}
+
+/**
+ * @brief   Fetches an object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[out] objpp    pointer to the fetched object reference
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if an object has been correctly fetched.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+static inline msg_t chFifoReceiveObjectTimeoutS(objects_fifo_t *ofp,
+                                                void **objpp,
+                                                systime_t time) {
+  msg_t msg, idx;
+
+  msg = chMBFetchS(&ofp->of_mbx, &idx, time);
+  if (msg == MSG_OK) {
+    *objpp = _fifo_msg2obj(ofp, idx);
+  }
+
+  return msg;
+}
+
+/**
+ * @brief   Fetches an object.
+ *
+ * @param[in] ofp       pointer to a @p objects_fifo_t structure
+ * @param[out] objpp    pointer to the fetched object reference
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if an object has been correctly fetched.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+static inline msg_t chFifoReceiveObjectTimeout(objects_fifo_t *ofp,
+                                               void **objpp,
+                                               systime_t time) {
+  msg_t msg, idx;
+
+  msg = chMBFetch(&ofp->of_mbx, &idx, time);
+  if (msg == MSG_OK) {
+    *objpp = _fifo_msg2obj(ofp, idx);
+  }
+
+  return msg;
+}
+
+#endif /* CH_CFG_USE_OBJ_FIFOS */
+
+#endif /* _CHOBJFIFOS_H_ */
+
+/** @} */
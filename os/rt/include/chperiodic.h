@@ -0,0 +1,131 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chperiodic.h
+ * @brief   Periodic threads macros and structures.
+ *
+ * @addtogroup periodic
+ * @{
+ */
+
+#ifndef _CHPERIODIC_H_
+#define _CHPERIODIC_H_
+
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a periodic thread object.
+ */
+typedef struct ch_periodic periodic_t;
+
+/**
+ * @brief   Deadline miss callback type.
+ */
+typedef void (*ptmiss_t)(periodic_t *ptp);
+
+/**
+ * @brief   Structure representing a periodic thread object.
+ * @note    The activation jitter is the delay, in system ticks, between
+ *          the nominal activation time and the moment the thread actually
+ *          resumes execution, the peak to peak jitter is
+ *          @p pt_jworst - @p pt_jbest.
+ */
+struct ch_periodic {
+  systime_t             pt_next;        /**< @brief Next activation time.   */
+  systime_t             pt_period;      /**< @brief Activation period.      */
+  ptmiss_t              pt_miss;        /**< @brief Deadline miss callback
+                                             or @p NULL.                    */
+  thread_t              *pt_thread;     /**< @brief Thread owning the object
+                                             or @p NULL if not yet
+                                             started.                       */
+  ucnt_t                pt_activations; /**< @brief Number of activations.  */
+  ucnt_t                pt_overruns;    /**< @brief Number of missed
+                                             deadlines.                     */
+  systime_t             pt_jbest;       /**< @brief Best activation
+                                             jitter.                        */
+  systime_t             pt_jworst;      /**< @brief Worst activation
+                                             jitter.                        */
+  uint32_t              pt_jcumulative; /**< @brief Cumulative activation
+                                             jitter.                        */
+#if CH_CFG_USE_TM || defined(__DOXYGEN__)
+  time_measurement_t    pt_exec;        /**< @brief Execution time of the
+                                             periodic jobs.                 */
+#endif
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chPTObjectInit(periodic_t *ptp, systime_t start, systime_t period,
+                      ptmiss_t miss);
+  void chPTWaitNext(periodic_t *ptp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the average activation jitter.
+ *
+ * @param[in] ptp       pointer to the @p periodic_t object
+ * @return              The average jitter in system ticks.
+ *
+ * @xclass
+ */
+static inline systime_t chPTGetAverageJitterX(periodic_t *ptp) {
+
+  if (ptp->pt_activations == (ucnt_t)0) {
+    return (systime_t)0;
+  }
+  return (systime_t)(ptp->pt_jcumulative / (uint32_t)ptp->pt_activations);
+}
+
+#endif /* CH_CFG_USE_PERIODIC */
+
+#endif /* _CHPERIODIC_H_ */
+
+/** @} */
@@ -84,6 +84,10 @@ struct io_queue {
   uint8_t               *q_rdptr;   /**< @brief Read pointer.               */
   qnotify_t             q_notify;   /**< @brief Data notification callback. */
   void                  *q_link;    /**< @brief Application defined field.  */
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+  struct ch_waitset_entry *q_wse;   /**< @brief Wait-set entry linked to the
+                                                queue or @p NULL.           */
+#endif
 };
 
 /**
@@ -116,6 +120,15 @@ typedef io_queue_t output_queue_t;
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Wait-set link part of a static queue initializer.
+ */
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+#define _QUEUE_WAITSET_DATA , NULL
+#else
+#define _QUEUE_WAITSET_DATA
+#endif
+
 /**
  * @brief   Data part of a static input queue initializer.
  * @details This macro should be used when statically initializing an
@@ -136,6 +149,7 @@ typedef io_queue_t output_queue_t;
   (uint8_t *)(buffer),                                                      \
   (inotify),                                                                \
   (link)                                                                    \
+  _QUEUE_WAITSET_DATA                                                       \
 }
 
 /**
@@ -172,6 +186,7 @@ typedef io_queue_t output_queue_t;
   (uint8_t *)(buffer),                                                      \
   (onotify),                                                                \
   (link)                                                                    \
+  _QUEUE_WAITSET_DATA                                                       \
 }
 
 /**
@@ -96,6 +96,17 @@ typedef struct {
 #endif /* !CH_CFG_USE_REGISTRY */
 
 #if CH_CFG_USE_REGISTRY || defined(__DOXYGEN__)
+/**
+ * @brief   Registry list header.
+ * @note    In SMP mode the registry is shared among the cores, the header
+ *          is the ready list of the core zero.
+ */
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+#define REG_HEADER ch_cores[0].rlist
+#else
+#define REG_HEADER ch.rlist
+#endif
+
 /**
  * @brief   Removes a thread from the registry list.
  * @note    This macro is not meant for use in application code.
@@ -114,9 +125,9 @@ typedef struct {
  * @param[in] tp        thread to add to the registry
  */
 #define REG_INSERT(tp) {                                                    \
-  (tp)->p_newer = (thread_t *)&ch.rlist;                                    \
-  (tp)->p_older = ch.rlist.r_older;                                         \
-  (tp)->p_older->p_newer = ch.rlist.r_older = (tp);                         \
+  (tp)->p_newer = (thread_t *)&REG_HEADER;                                  \
+  (tp)->p_older = REG_HEADER.r_older;                                       \
+  (tp)->p_older->p_newer = REG_HEADER.r_older = (tp);                       \
 }
 
 /*===========================================================================*/
@@ -129,6 +140,12 @@ extern "C" {
   extern ROMCONST chdebug_t ch_debug;
   thread_t *chRegFirstThread(void);
   thread_t *chRegNextThread(thread_t *tp);
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+  size_t chRegScanStack(thread_t *tp);
+  void chRegScanStacks(void);
+  thread_t *chRegStartStackScanner(void *wsp, size_t size,
+                                   systime_t interval);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -161,6 +178,44 @@ static inline const char *chRegGetThreadNameI(thread_t *tp) {
 #endif
 }
 
+#if (CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the unused stack of the specified thread.
+ * @details The value is the one found by the last scan of the thread
+ *          stack, it does not trigger a new scan.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @return              The unused stack size in bytes.
+ * @retval 0            if the stack has not been scanned yet.
+ *
+ * @xclass
+ */
+static inline size_t chRegGetStackUnusedX(thread_t *tp) {
+
+  return tp->p_stkunused;
+}
+#endif
+
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the periodic object bound to the specified thread.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @return              Pointer to the @p periodic_t object.
+ * @retval NULL         if the thread is not a periodic thread.
+ *
+ * @iclass
+ */
+static inline periodic_t *chRegGetThreadPeriodicI(thread_t *tp) {
+
+  chDbgCheckClassI();
+
+  return tp->p_periodic;
+}
+#endif /* CH_CFG_USE_PERIODIC */
+
 #endif /* CH_CFG_USE_REGISTRY */
 
 #endif /* _CHREGISTRY_H_ */
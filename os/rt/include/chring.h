@@ -0,0 +1,225 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chring.h
+ * @brief   Rings macros and structures.
+ *
+ * @addtogroup rings
+ * @{
+ */
+
+#ifndef _CHRING_H_
+#define _CHRING_H_
+
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_SMP_MODE && !defined(port_memory_barrier)
+#error "CH_CFG_USE_RINGS requires port_memory_barrier() in SMP mode"
+#endif
+
+/**
+ * @brief   Memory barrier ordering the ring data and indexes accesses.
+ * @details On single core systems a compiler barrier is sufficient, ports
+ *          supporting SMP must define @p port_memory_barrier() as a full
+ *          hardware barrier.
+ */
+#if !defined(port_memory_barrier) || defined(__DOXYGEN__)
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define port_memory_barrier() __asm__ volatile ("" : : : "memory")
+#else
+#define port_memory_barrier() {port_lock(); port_unlock();}
+#endif
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Structure representing a single producer single consumer ring.
+ * @note    The indexes are free running counters, the buffer position is
+ *          obtained masking them with the ring capacity.
+ */
+typedef struct {
+  uint8_t               *rg_buffer;     /**< @brief Pointer to the ring
+                                                    buffer.                 */
+  size_t                rg_esize;       /**< @brief Size of an element.     */
+  size_t                rg_mask;        /**< @brief Capacity minus one.     */
+  volatile size_t       rg_wrcnt;       /**< @brief Elements written, only
+                                                    updated by the
+                                                    producer.               */
+  volatile size_t       rg_rdcnt;       /**< @brief Elements read, only
+                                                    updated by the
+                                                    consumer.               */
+  volatile bool         rg_waiting;     /**< @brief The consumer is waiting
+                                                    for data.               */
+  thread_reference_t    rg_thread;      /**< @brief Suspended consumer.     */
+} ring_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Data part of a static ring initializer.
+ * @details This macro should be used when statically initializing a
+ *          ring that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] esize     size of an element
+ * @param[in] n         number of elements in the buffer, it must be a power
+ *                      of two
+ */
+#define _RING_DATA(name, buffer, esize, n) {                            \
+  (uint8_t *)(buffer),                                                  \
+  (size_t)(esize),                                                      \
+  (size_t)(n) - 1U,                                                     \
+  (size_t)0,                                                            \
+  (size_t)0,                                                            \
+  false,                                                                \
+  NULL                                                                  \
+}
+
+/**
+ * @brief   Static ring initializer.
+ * @details Statically initialized rings require no explicit
+ *          initialization using @p chRingObjectInit().
+ *
+ * @param[in] name      the name of the ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] esize     size of an element
+ * @param[in] n         number of elements in the buffer, it must be a power
+ *                      of two
+ */
+#define RING_DECL(name, buffer, esize, n)                               \
+  ring_t name = _RING_DATA(name, buffer, esize, n)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRingObjectInit(ring_t *rp, void *buf, size_t esize, size_t n);
+  size_t chRingWriteX(ring_t *rp, const void *bp, size_t n);
+  size_t chRingReadX(ring_t *rp, void *bp, size_t n);
+  size_t chRingReadTimeout(ring_t *rp, void *bp, size_t n, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the ring capacity.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @return              The capacity in elements.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetSizeX(ring_t *rp) {
+
+  return rp->rg_mask + 1U;
+}
+
+/**
+ * @brief   Returns the number of elements in the ring.
+ * @note    The value is exact only if invoked by the producer or by the
+ *          consumer, from other contexts it is just an estimate.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @return              The number of used elements.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetUsedX(ring_t *rp) {
+
+  return rp->rg_wrcnt - rp->rg_rdcnt;
+}
+
+/**
+ * @brief   Returns the number of free elements in the ring.
+ * @note    The value is exact only if invoked by the producer or by the
+ *          consumer, from other contexts it is just an estimate.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @return              The number of free elements.
+ *
+ * @xclass
+ */
+static inline size_t chRingGetFreeX(ring_t *rp) {
+
+  return chRingGetSizeX(rp) - chRingGetUsedX(rp);
+}
+
+/**
+ * @brief   Writes an element into a ring.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @param[in] ep        pointer to the element
+ * @return              The operation status.
+ * @retval true         if the element has been written.
+ * @retval false        if the ring is full.
+ *
+ * @xclass
+ */
+static inline bool chRingPutX(ring_t *rp, const void *ep) {
+
+  return chRingWriteX(rp, ep, 1U) == 1U;
+}
+
+/**
+ * @brief   Reads an element from a ring.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @param[out] ep       pointer to the element buffer
+ * @return              The operation status.
+ * @retval true         if an element has been read.
+ * @retval false        if the ring is empty.
+ *
+ * @xclass
+ */
+static inline bool chRingGetX(ring_t *rp, void *ep) {
+
+  return chRingReadX(rp, ep, 1U) == 1U;
+}
+
+#endif /* CH_CFG_USE_RINGS */
+
+#endif /* _CHRING_H_ */
+
+/** @} */
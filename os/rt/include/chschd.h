@@ -78,6 +78,7 @@
                                          answer.                            */
 #define CH_STATE_WTMSG          14  /**< @brief Waiting for a message.      */
 #define CH_STATE_FINAL          15  /**< @brief Thread terminated.          */
+#define CH_STATE_WTSET          16  /**< @brief Waiting on a wait-set.      */
 
 /**
  * @brief   Thread states as array of strings.
@@ -87,7 +88,7 @@
 #define CH_STATE_NAMES                                                     \
   "READY", "CURRENT", "WTSTART", "SUSPENDED", "QUEUED", "WTSEM", "WTMTX",  \
   "WTCOND", "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ",        \
-  "SNDMSG", "WTMSG", "FINAL"
+  "SNDMSG", "WTMSG", "FINAL", "WTSET"
 /** @} */
 
 /**
@@ -101,6 +102,8 @@
 #define CH_FLAG_MODE_MEMPOOL    2   /**< @brief Thread allocated from a
                                          Memory Pool.                       */
 #define CH_FLAG_TERMINATE       4   /**< @brief Termination requested flag. */
+#define CH_FLAG_THRESHOLD       8   /**< @brief Thread ready at its
+                                         preemption threshold level.    */
 /** @} */
 
 /**
@@ -158,10 +161,108 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Priority of the deferred virtual timers callbacks thread.
+ */
+#if !defined(CH_CFG_VT_DEFERRED_PRIO) || defined(__DOXYGEN__)
+#define CH_CFG_VT_DEFERRED_PRIO         HIGHPRIO
+#endif
+
+/**
+ * @brief   Stack size of the deferred virtual timers callbacks thread.
+ */
+#if !defined(CH_CFG_VT_DEFERRED_STACK_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_VT_DEFERRED_STACK_SIZE   256
+#endif
+#endif /* CH_CFG_VT_DEFERRED */
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Priority level reserved to the EDF threads.
+ */
+#if !defined(CH_CFG_EDF_PRIO) || defined(__DOXYGEN__)
+#define CH_CFG_EDF_PRIO                 (NORMALPRIO + 32)
+#endif
+#endif /* CH_CFG_SCHED_EDF */
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if CH_CFG_RLIST_BITMAP || defined(__DOXYGEN__)
+/**
+ * @brief   Number of priority levels handled by the bitmap ready list.
+ * @note    Threads can never have a priority greater than @p HIGHPRIO so
+ *          there is no need to reserve queues for the levels above it.
+ */
+#define CH_RLIST_LEVELS         (HIGHPRIO + 1)
+
+/**
+ * @brief   Number of 32 bits words in the ready list bitmap.
+ */
+#define CH_RLIST_WORDS          ((CH_RLIST_LEVELS + 31) / 32)
+
+#if CH_RLIST_WORDS > 32
+#error "too many priority levels for the ready list bitmap"
+#endif
+#endif /* CH_CFG_RLIST_BITMAP */
+
+/**
+ * @brief   Round robin driven by a one-shot slice timer.
+ * @details In tick-less mode there is no periodic tick decreasing the
+ *          threads quantum so a virtual timer is armed, when a thread gets
+ *          the CPU, only if there are other threads with the same priority
+ *          ready to run.
+ */
+#define CH_SCH_SLICE_TIMER                                                  \
+  ((CH_CFG_TIME_QUANTUM > 0) && (CH_CFG_ST_TIMEDELTA > 0))
+
+#if CH_CFG_SCHED_EDF && ((CH_CFG_EDF_PRIO <= IDLEPRIO) ||                  \
+                         (CH_CFG_EDF_PRIO > HIGHPRIO))
+#error "invalid CH_CFG_EDF_PRIO value specified"
+#endif
+
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+#if !defined(PORT_SUPPORTS_SMP) || !PORT_SUPPORTS_SMP
+#error "CH_CFG_SMP_MODE requires PORT_SUPPORTS_SMP"
+#endif
+
+#if !defined(PORT_SUPPORTS_NOTIFY_PENDING) || !PORT_SUPPORTS_NOTIFY_PENDING
+#error "CH_CFG_SMP_MODE requires PORT_SUPPORTS_NOTIFY_PENDING"
+#endif
+
+#if CH_CFG_RLIST_BITMAP || CH_CFG_SCHED_EDF || CH_CFG_SCHED_BUDGET
+#error "CH_CFG_SMP_MODE does not support the bitmap ready list, EDF and budgets"
+#endif
+
+#if CH_CFG_VT_DEFERRED
+#error "CH_CFG_SMP_MODE does not support deferred virtual timers"
+#endif
+
+#if CH_SCH_SLICE_TIMER
+#error "CH_CFG_SMP_MODE does not support round robin in tick-less mode"
+#endif
+#endif /* CH_CFG_SMP_MODE */
+
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+#if (CH_CFG_VT_WHEEL_BITS < 2) || (CH_CFG_VT_WHEEL_BITS > 5)
+#error "invalid CH_CFG_VT_WHEEL_BITS specified, must be between 2 and 5"
+#endif
+
+/**
+ * @brief   Number of slots in each timing wheel level.
+ */
+#define CH_VT_WHEEL_SLOTS       (1 << CH_CFG_VT_WHEEL_BITS)
+
+/**
+ * @brief   Number of timing wheel levels.
+ * @details The levels are enough to cover the whole system time range.
+ */
+#define CH_VT_WHEEL_LEVELS                                                  \
+  ((CH_CFG_ST_RESOLUTION + CH_CFG_VT_WHEEL_BITS - 1) / CH_CFG_VT_WHEEL_BITS)
+#endif /* CH_CFG_VT_TIMING_WHEEL */
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -205,6 +306,28 @@ struct ch_thread {
    */
   const char            *p_name;
 #endif
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+  /**
+   * @brief Core the thread is bound to.
+   */
+  unsigned              p_core;
+#endif
+#if (CH_CFG_USE_REGISTRY && CH_CFG_USE_PERIODIC) || defined(__DOXYGEN__)
+  /**
+   * @brief Periodic object bound to the thread or @p NULL.
+   */
+  struct ch_periodic    *p_periodic;
+#endif
+#if (CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+  /**
+   * @brief Unused stack bytes found by the last stack scan.
+   */
+  size_t                p_stkunused;
+  /**
+   * @brief End of the filled stack or @p NULL if the stack is not filled.
+   */
+  uint8_t               *p_stkend;
+#endif
 #if CH_DBG_ENABLE_STACK_CHECK || defined(__DOXYGEN__)
   /**
    * @brief Thread stack boundary.
@@ -231,6 +354,29 @@ struct ch_thread {
 #if (CH_CFG_TIME_QUANTUM > 0) || defined(__DOXYGEN__)
   tslices_t             p_preempt;
 #endif
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+  /**
+   * @brief Absolute deadline, only used at the EDF priority level.
+   */
+  systime_t             p_deadline;
+#endif
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+  /**
+   * @brief Preemption threshold, only effective if above @p p_prio.
+   */
+  tprio_t               p_threshold;
+  /**
+   * @brief Thread priority saved while the thread waits in the ready list
+   *        at its threshold level.
+   */
+  tprio_t               p_savedprio;
+#endif
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+  /**
+   * @brief CPU budget attached to the thread or @p NULL.
+   */
+  struct ch_thread_budget *p_budget;
+#endif
 #if CH_DBG_THREADS_PROFILING || defined(__DOXYGEN__)
   /**
    * @brief Thread consumed time in ticks.
@@ -269,7 +415,8 @@ struct ch_thread {
     /**
      * @brief Enabled events mask.
      * @note  This field is only valid while the thread is in the
-     *        @p CH_STATE_WTOREVT or @p CH_STATE_WTANDEVT states.
+     *        @p CH_STATE_WTOREVT, @p CH_STATE_WTANDEVT or
+     *        @p CH_STATE_WTSET states.
      */
     eventmask_t         ewmask;
 #endif
@@ -289,6 +436,16 @@ struct ch_thread {
    * @brief Thread message.
    */
   msg_t                 p_msg;
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  /**
+   * @brief First queued asynchronous message.
+   */
+  struct ch_msg_handle  *p_amsghead;
+  /**
+   * @brief Last queued asynchronous message.
+   */
+  struct ch_msg_handle  *p_amsgtail;
+#endif
 #endif
 #if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
   /**
@@ -313,6 +470,12 @@ struct ch_thread {
    */
   void                  *p_mpool;
 #endif
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+  /**
+   * @brief Heap cache bound to the thread or @p NULL.
+   */
+  struct ch_heap_cache  *p_hcache;
+#endif
 #if CH_DBG_STATISTICS || defined(__DOXYGEN__)
   /**
    * @brief Thread statistics.
@@ -333,25 +496,57 @@ struct ch_thread {
 struct ch_virtual_timer {
   virtual_timer_t       *vt_next;   /**< @brief Next timer in the list.     */
   virtual_timer_t       *vt_prev;   /**< @brief Previous timer in the list. */
+#if !CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
   systime_t             vt_delta;   /**< @brief Time delta before timeout.  */
+#endif
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+  systime_t             vt_time;    /**< @brief Absolute expiration time.   */
+#endif
   vtfunc_t              vt_func;    /**< @brief Timer callback function
                                                 pointer.                    */
   void                  *vt_par;    /**< @brief Timer callback function
                                                 parameter.                  */
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+  uint8_t               vt_flags;   /**< @brief Timer flags.                */
+#endif
 };
 
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Timing wheel slot, it is the header of a list of timers.
+ */
+typedef struct {
+  virtual_timer_t       *vt_next;   /**< @brief First timer in the slot.    */
+  virtual_timer_t       *vt_prev;   /**< @brief Last timer in the slot.     */
+} vt_wheel_slot_t;
+#endif
+
 /**
  * @brief   Virtual timers list header.
  * @note    The timers list is implemented as a double link bidirectional list
  *          in order to make the unlink time constant, the reset of a virtual
  *          timer is often used in the code.
+ * @note    When @p CH_CFG_VT_TIMING_WHEEL is enabled the single list is
+ *          replaced by the wheel slots, timers in a slot are not ordered.
  */
 struct ch_virtual_timers_list {
+#if !CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
   virtual_timer_t       *vt_next;   /**< @brief Next timer in the delta
                                                 list.                       */
   virtual_timer_t       *vt_prev;   /**< @brief Last timer in the delta
                                                 list.                       */
   systime_t             vt_delta;   /**< @brief Must be initialized to -1.  */
+#endif
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+  /**
+   * @brief   Wheel slots, level zero has a resolution of one tick.
+   */
+  vt_wheel_slot_t       vt_slots[CH_VT_WHEEL_LEVELS][CH_VT_WHEEL_SLOTS];
+  /**
+   * @brief   Slots bitmaps, a bit is set for each non-empty slot.
+   */
+  uint32_t              vt_map[CH_VT_WHEEL_LEVELS];
+#endif
 #if CH_CFG_ST_TIMEDELTA == 0 || defined(__DOXYGEN__)
   volatile systime_t    vt_systime; /**< @brief System Time counter.        */
 #endif
@@ -364,6 +559,53 @@ struct ch_virtual_timers_list {
 #endif
 };
 
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Deferred virtual timers callbacks queue.
+ * @details Expired deferred timers wait here for their callbacks to be
+ *          invoked by the callbacks thread, the counters can be inspected
+ *          in order to size the thread priority and stack.
+ */
+typedef struct {
+  virtual_timer_t       *vt_next;   /**< @brief First pending timer.        */
+  virtual_timer_t       *vt_prev;   /**< @brief Last pending timer.         */
+  thread_t              *vt_thread; /**< @brief Callbacks thread while
+                                                waiting for work.           */
+  ucnt_t                vt_depth;   /**< @brief Pending callbacks.          */
+  ucnt_t                vt_maxdepth;/**< @brief Maximum pending callbacks.  */
+  ucnt_t                vt_ncallbacks;/**< @brief Invoked callbacks.        */
+  ucnt_t                vt_nbatches;/**< @brief Processed batches.          */
+#if CH_CFG_USE_TM || defined(__DOXYGEN__)
+  time_measurement_t    vt_batch;   /**< @brief Measurement of the batches
+                                                run time.                   */
+#endif
+} vt_deferred_t;
+#endif
+
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+/**
+ * @brief   Thread CPU budget structure.
+ * @details The thread owning the budget can run for @p tb_budget ticks in
+ *          each @p tb_period ticks period, when the budget is used up the
+ *          thread is demoted to the @p tb_prio priority until the next
+ *          replenishment.
+ */
+typedef struct ch_thread_budget {
+  virtual_timer_t       tb_timer;   /**< @brief Replenishment timer.        */
+  thread_t              *tb_thread; /**< @brief Owner thread or @p NULL.    */
+  systime_t             tb_budget;  /**< @brief Ticks allowed per period.   */
+  systime_t             tb_period;  /**< @brief Replenishment period.       */
+  systime_t             tb_remaining;/**< @brief Ticks left in the current
+                                                period.                     */
+  tprio_t               tb_prio;    /**< @brief Priority while exhausted.   */
+  tprio_t               tb_savedprio;/**< @brief Owner priority saved while
+                                                demoted.                    */
+  bool                  tb_demoted; /**< @brief Owner demoted.              */
+  ucnt_t                tb_overruns;/**< @brief Periods where the budget
+                                                has been used up.           */
+} thread_budget_t;
+#endif
+
 /**
  * @extends threads_queue_t
  */
@@ -380,6 +622,29 @@ struct ch_ready_list {
   /* End of the fields shared with the thread_t structure.*/
   thread_t              *r_current; /**< @brief The currently running
                                                 thread.                     */
+#if CH_SCH_SLICE_TIMER || defined(__DOXYGEN__)
+  /**
+   * @brief   Time slice timer of the currently running thread.
+   */
+  virtual_timer_t       r_slice;
+#endif
+#if CH_CFG_RLIST_BITMAP || defined(__DOXYGEN__)
+  /**
+   * @brief   Summary word, a bit is set for each non-zero @p r_map word.
+   */
+  uint32_t              r_summary;
+  /**
+   * @brief   Priorities bitmap, a bit is set for each non-empty queue.
+   */
+  uint32_t              r_map[CH_RLIST_WORDS];
+  /**
+   * @brief   FIFO threads queues, one for each priority level.
+   * @note    When the bitmap ready list is in use the @p r_queue field
+   *          is unused, it is kept because the registry relies on the
+   *          structure layout.
+   */
+  threads_queue_t       r_queues[CH_RLIST_LEVELS];
+#endif
 };
 
 /**
@@ -426,6 +691,12 @@ struct ch_system {
    * @brief   Virtual timers delta list header.
    */
   virtual_timers_list_t vtlist;
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief   Deferred virtual timers callbacks queue.
+   */
+  vt_deferred_t         vtdeferred;
+#endif
   /**
    * @brief   System debug.
    */
@@ -452,6 +723,12 @@ struct ch_system {
    */
   THD_WORKING_AREA(idle_thread_wa, PORT_IDLE_THREAD_STACK_SIZE);
 #endif
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief   Deferred virtual timers callbacks thread working area.
+   */
+  THD_WORKING_AREA(vtdeferred_wa, CH_CFG_VT_DEFERRED_STACK_SIZE);
+#endif
 };
 
 /*===========================================================================*/
@@ -460,10 +737,51 @@ struct ch_system {
 
 /**
  * @brief   Returns the priority of the first thread on the given ready list.
+ * @note    If the ready list is empty then @p NOPRIO is returned.
+ *
+ * @notapi
+ */
+#if !CH_CFG_RLIST_BITMAP || defined(__DOXYGEN__)
+#define firstprio(rlp)  ((rlp)->r_queue.p_next->p_prio)
+#else
+#define firstprio(rlp)  rlist_bitmap_firstprio(rlp)
+#endif
+
+/**
+ * @brief   Priority to be exceeded in order to preempt the specified thread.
+ * @details It is the thread priority or, if higher, its preemption
+ *          threshold.
+ *
+ * @notapi
+ */
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+#define preemptprio(tp)                                                     \
+  ((tp)->p_threshold > (tp)->p_prio ? (tp)->p_threshold : (tp)->p_prio)
+#else
+#define preemptprio(tp) ((tp)->p_prio)
+#endif
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Checks if the deadline @p d1 comes before the deadline @p d2.
+ * @note    Deadlines are compared modulo the system time range so they
+ *          must not be more than half the range apart.
  *
  * @notapi
  */
-#define firstprio(rlp)  ((rlp)->p_next->p_prio)
+#define edf_before(d1, d2)                                                  \
+  ((systime_t)((d1) - (d2)) > (((systime_t)-1) >> 1))
+#endif
+
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   System data structure of the executing core.
+ * @note    In SMP mode each core has its own system data structure, the
+ *          kernel code accessing @p ch always refers to the structure of
+ *          the core executing it.
+ */
+#define ch ch_cores[port_get_core_id()]
+#endif
 
 /**
  * @brief   Current thread pointer access macro.
@@ -488,8 +806,13 @@ struct ch_system {
 /*===========================================================================*/
 
 #if !defined(__DOXYGEN__)
+#if CH_CFG_SMP_MODE
+extern ch_system_t ch_cores[PORT_CORES_NUMBER];
+extern port_spinlock_t ch_spinlock;
+#else
 extern ch_system_t ch;
 #endif
+#endif
 
 /*
  * Scheduler APIs.
@@ -499,6 +822,9 @@ extern "C" {
 #endif
   void _scheduler_init(void);
   thread_t *chSchReadyI(thread_t *tp);
+#if CH_CFG_SCHED_THRESHOLD
+  void _threshold_set_base_prio(thread_t *tp, tprio_t newprio);
+#endif
   void chSchGoSleepS(tstate_t newstate);
   msg_t chSchGoSleepTimeoutS(tstate_t newstate, systime_t time);
   void chSchWakeupS(thread_t *tp, msg_t msg);
@@ -660,10 +986,200 @@ static inline thread_t *queue_dequeue(thread_t *tp) {
 }
 #endif /* CH_CFG_OPTIMIZE_SPEED */
 
+/**
+ * @brief   Returns the index of the most significant bit set in a word.
+ * @pre     The word must not be zero.
+ *
+ * @param[in] w         the word to be scanned
+ * @return              The bit index, from 0 to 31.
+ *
+ * @notapi
+ */
+static inline unsigned bit_msb(uint32_t w) {
+
+#if defined(__GNUC__)
+  return 31U - (unsigned)__builtin_clz(w);
+#else
+  unsigned n = 0U;
+
+  if (w >= 0x10000U) {
+    w >>= 16;
+    n += 16U;
+  }
+  if (w >= 0x100U) {
+    w >>= 8;
+    n += 8U;
+  }
+  if (w >= 0x10U) {
+    w >>= 4;
+    n += 4U;
+  }
+  if (w >= 0x4U) {
+    w >>= 2;
+    n += 2U;
+  }
+  return n + (w >> 1);
+#endif
+}
+
+#if CH_CFG_RLIST_BITMAP || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the highest priority having a non-empty ready queue.
+ *
+ * @param[in] rlp       pointer to the ready list
+ * @return              The highest ready priority or @p NOPRIO if the
+ *                      ready list is empty.
+ *
+ * @notapi
+ */
+static inline tprio_t rlist_bitmap_firstprio(ready_list_t *rlp) {
+  unsigned w;
+
+  if (rlp->r_summary == 0U) {
+    return NOPRIO;
+  }
+  w = bit_msb(rlp->r_summary);
+
+  return (tprio_t)((w << 5) + bit_msb(rlp->r_map[w]));
+}
+
+/**
+ * @brief   Marks the queue of the specified priority level as non-empty.
+ *
+ * @param[in] rlp       pointer to the ready list
+ * @param[in] prio      the priority level
+ *
+ * @notapi
+ */
+static inline void rlist_bitmap_set(ready_list_t *rlp, tprio_t prio) {
+
+  rlp->r_map[prio >> 5] |= (uint32_t)1U << (prio & 31U);
+  rlp->r_summary |= (uint32_t)1U << (prio >> 5);
+}
+
+/**
+ * @brief   Marks the queue of the specified priority level as empty.
+ *
+ * @param[in] rlp       pointer to the ready list
+ * @param[in] prio      the priority level
+ *
+ * @notapi
+ */
+static inline void rlist_bitmap_clear(ready_list_t *rlp, tprio_t prio) {
+
+  rlp->r_map[prio >> 5] &= ~((uint32_t)1U << (prio & 31U));
+  if (rlp->r_map[prio >> 5] == 0U) {
+    rlp->r_summary &= ~((uint32_t)1U << (prio >> 5));
+  }
+}
+#endif /* CH_CFG_RLIST_BITMAP */
+
+/**
+ * @brief   Removes a thread from the ready list.
+ * @details The thread is removed regardless of its position in the ready
+ *          list, its @p p_prio field is not used so it can be modified
+ *          before invoking this function.
+ *
+ * @param[in] tp        the pointer to the thread to be removed
+ * @return              The removed thread pointer.
+ *
+ * @notapi
+ */
+static inline thread_t *rlist_dequeue(thread_t *tp) {
+
+#if CH_CFG_RLIST_BITMAP
+  (void)queue_dequeue(tp);
+
+  /* If the queue became empty then both links point to its header, the
+     header position in the array gives the priority level to clear.*/
+  if (tp->p_next == tp->p_prev) {
+    rlist_bitmap_clear(&ch.rlist,
+                       (tprio_t)((threads_queue_t *)tp->p_next -
+                                 &ch.rlist.r_queues[0]));
+  }
+
+  return tp;
+#else
+  return queue_dequeue(tp);
+#endif
+}
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the first ready thread at the EDF priority level.
+ * @pre     The EDF priority level must be the highest ready priority.
+ *
+ * @return              The first EDF thread in the ready list.
+ *
+ * @notapi
+ */
+static inline thread_t *rlist_edf_first(void) {
+
+#if CH_CFG_RLIST_BITMAP
+  return ch.rlist.r_queues[CH_CFG_EDF_PRIO].p_next;
+#else
+  return ch.rlist.r_queue.p_next;
+#endif
+}
+
+/**
+ * @brief   Determines if a thread must preempt the current thread.
+ * @details This function returns @p true if both threads belong to the EDF
+ *          priority level and the specified thread has an earlier deadline.
+ *
+ * @param[in] tp        the thread to be compared with the current thread
+ * @return              The deadlines situation.
+ *
+ * @notapi
+ */
+static inline bool edf_preempts(thread_t *tp) {
+
+  return (tp->p_prio == CH_CFG_EDF_PRIO) &&
+         (currp->p_prio == CH_CFG_EDF_PRIO) &&
+         (preemptprio(currp) == CH_CFG_EDF_PRIO) &&
+         edf_before(tp->p_deadline, currp->p_deadline);
+}
+
+/**
+ * @brief   Determines if the first ready thread must preempt the current one.
+ *
+ * @param[in] p1        the highest ready priority
+ * @return              The deadlines situation.
+ *
+ * @notapi
+ */
+static inline bool edf_first_preempts(tprio_t p1) {
+
+  return (p1 == CH_CFG_EDF_PRIO) && edf_preempts(rlist_edf_first());
+}
+
+/**
+ * @brief   Determines if the first ready thread has a later deadline.
+ * @details The EDF threads with a later deadline cannot receive the CPU
+ *          through yielding or round robin.
+ *
+ * @param[in] p1        the highest ready priority
+ * @return              The deadlines situation.
+ *
+ * @notapi
+ */
+static inline bool edf_first_later(tprio_t p1) {
+
+  return (p1 == CH_CFG_EDF_PRIO) && (currp->p_prio == CH_CFG_EDF_PRIO) &&
+         edf_before(currp->p_deadline, rlist_edf_first()->p_deadline);
+}
+#else /* !CH_CFG_SCHED_EDF */
+#define edf_preempts(tp) false
+#define edf_first_preempts(p1) false
+#define edf_first_later(p1) false
+#endif /* !CH_CFG_SCHED_EDF */
+
 /**
  * @brief   Determines if the current thread must reschedule.
  * @details This function returns @p true if there is a ready thread with
- *          higher priority.
+ *          higher priority or, at the EDF priority level, with an earlier
+ *          deadline. The preemption threshold of the current thread, if
+ *          enabled, is taken into account.
  *
  * @return              The priorities situation.
  * @retval false        if rescheduling is not necessary.
@@ -673,9 +1189,11 @@ static inline thread_t *queue_dequeue(thread_t *tp) {
  */
 static inline bool chSchIsRescRequiredI(void) {
 
+  tprio_t p1 = firstprio(&ch.rlist);
+
   chDbgCheckClassI();
 
-  return firstprio(&ch.rlist.r_queue) > currp->p_prio;
+  return (p1 > preemptprio(currp)) || edf_first_preempts(p1);
 }
 
 /**
@@ -691,9 +1209,11 @@ static inline bool chSchIsRescRequiredI(void) {
  */
 static inline bool chSchCanYieldS(void) {
 
+  tprio_t p1 = firstprio(&ch.rlist);
+
   chDbgCheckClassS();
 
-  return firstprio(&ch.rlist.r_queue) >= currp->p_prio;
+  return (p1 >= currp->p_prio) && !edf_first_later(p1);
 }
 
 /**
@@ -720,22 +1240,25 @@ static inline void chSchDoYieldS(void) {
  * @special
  */
 static inline void chSchPreemption(void) {
-  tprio_t p1 = firstprio(&ch.rlist.r_queue);
+  tprio_t p1 = firstprio(&ch.rlist);
   tprio_t p2 = currp->p_prio;
+  tprio_t pt = preemptprio(currp);
 
 #if CH_CFG_TIME_QUANTUM > 0
-  if (currp->p_preempt) {
-    if (p1 > p2) {
+  /* A preemption threshold above the thread priority disables the round
+     robin.*/
+  if ((currp->p_preempt > (tslices_t)0) || (pt != p2)) {
+    if ((p1 > pt) || edf_first_preempts(p1)) {
       chSchDoRescheduleAhead();
     }
   }
   else {
-    if (p1 >= p2) {
+    if ((p1 >= p2) && !edf_first_later(p1)) {
       chSchDoRescheduleBehind();
     }
   }
 #else /* CH_CFG_TIME_QUANTUM == 0 */
-  if (p1 >= p2) {
+  if ((pt != p2) ? (p1 > pt) : ((p1 >= p2) && !edf_first_later(p1))) {
     chSchDoRescheduleAhead();
   }
 #endif /* CH_CFG_TIME_QUANTUM == 0 */
@@ -53,6 +53,10 @@ typedef struct semaphore {
   threads_queue_t       s_queue;    /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 s_cnt;      /**< @brief The semaphore counter.      */
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+  struct ch_waitset_entry *s_wse;   /**< @brief Wait-set entry linked to the
+                                                semaphore or @p NULL.       */
+#endif
 } semaphore_t;
 
 /*===========================================================================*/
@@ -68,7 +72,11 @@ typedef struct semaphore {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+#define _SEMAPHORE_DATA(name, n) {_THREADS_QUEUE_DATA(name.s_queue), n, NULL}
+#else
 #define _SEMAPHORE_DATA(name, n) {_THREADS_QUEUE_DATA(name.s_queue), n}
+#endif
 
 /**
  * @brief   Static semaphore initializer.
@@ -126,6 +134,7 @@ static inline void chSemFastWaitI(semaphore_t *sp) {
  * @brief   Increases the semaphore counter.
  * @details This macro can be used when the counter is known to be not
  *          negative.
+ * @note    A linked wait-set is not signaled.
  *
  * @param[in] sp        pointer to a @p semaphore_t structure
  *
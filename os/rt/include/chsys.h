@@ -201,6 +201,56 @@
 #define chSysGetRealtimeCounterX() (rtcnt_t)port_rt_get_counter_value()
 #endif
 
+/**
+ * @brief   Returns the identifier of the executing core.
+ * @note    This function is only available if the option
+ *          @p CH_CFG_SMP_MODE is enabled.
+ *
+ * @return              The core identifier, from zero to
+ *                      @p PORT_CORES_NUMBER - 1.
+ *
+ * @xclass
+ */
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+#define chSysGetCoreX() port_get_core_id()
+#endif
+
+/**
+ * @name    Kernel spinlock macros
+ * @{
+ */
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   Acquires the spinlock shared among the cores.
+ * @note    Not a user function, in SMP mode the kernel lock is the core
+ *          interrupts lock plus this spinlock.
+ *
+ * @notapi
+ */
+#define _smp_lock() port_spin_lock(&ch_spinlock)
+
+/**
+ * @brief   Releases the spinlock shared among the cores.
+ *
+ * @notapi
+ */
+#define _smp_unlock() port_spin_unlock(&ch_spinlock)
+
+/**
+ * @brief   Checks for a cross-core notification pending on this core.
+ * @details The SMP ports must provide both @p port_notify_core() and
+ *          @p port_is_notify_pending(), the latter is declared by defining
+ *          @p PORT_SUPPORTS_NOTIFY_PENDING as @p TRUE.
+ *
+ * @notapi
+ */
+#define _smp_notify_pending() port_is_notify_pending()
+#else
+#define _smp_lock()
+#define _smp_unlock()
+#endif
+/** @} */
+
 /**
  * @brief   Performs a context switch.
  * @note    Not a user function, it is meant to be invoked by the scheduler
@@ -227,6 +277,9 @@
 extern "C" {
 #endif
   void chSysInit(void);
+#if CH_CFG_SMP_MODE
+  void chSysInitCore(void);
+#endif
   void chSysHalt(const char *reason);
   void chSysTimerHandlerI(void);
   syssts_t chSysGetStatusAndLockX(void);
@@ -297,6 +350,7 @@ static inline void chSysEnable(void) {
 static inline void chSysLock(void)  {
 
   port_lock();
+  _smp_lock();
   _stats_start_measure_crit_thd();
   _dbg_check_lock();
 }
@@ -315,9 +369,19 @@ static inline void chSysUnlock(void) {
      in a critical section not followed by a chSchResceduleS(), this means
      that the current thread has a lower priority than the next thread in
      the ready list.*/
-  chDbgAssert(ch.rlist.r_current->p_prio >= ch.rlist.r_queue.p_next->p_prio,
+#if CH_CFG_SMP_MODE
+  /* In SMP mode another core can make ready a thread with higher priority
+     on this core, the reschedule is performed when the notification is
+     served.*/
+  chDbgAssert(_smp_notify_pending() ||
+              (preemptprio(ch.rlist.r_current) >= firstprio(&ch.rlist)),
               "priority violation, missing reschedule");
+#else
+  chDbgAssert(preemptprio(ch.rlist.r_current) >= firstprio(&ch.rlist),
+              "priority violation, missing reschedule");
+#endif
 
+  _smp_unlock();
   port_unlock();
 }
 
@@ -336,6 +400,7 @@ static inline void chSysUnlock(void) {
 static inline void chSysLockFromISR(void) {
 
   port_lock_from_isr();
+  _smp_lock();
   _stats_start_measure_crit_isr();
   _dbg_check_lock_from_isr();
 }
@@ -357,6 +422,7 @@ static inline void chSysUnlockFromISR(void) {
 
   _dbg_check_unlock_from_isr();
   _stats_stop_measure_crit_isr();
+  _smp_unlock();
   port_unlock_from_isr();
 }
 
@@ -403,7 +469,11 @@ static inline void chSysUnconditionalUnlock(void) {
  */
 static inline thread_t *chSysGetIdleThreadX(void) {
 
+#if CH_CFG_RLIST_BITMAP
+  return ch.rlist.r_queues[IDLEPRIO].p_next;
+#else
   return ch.rlist.r_queue.p_prev;
+#endif
 }
 #endif /* !CH_CFG_NO_IDLE_THREAD */
 
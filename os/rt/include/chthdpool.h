@@ -0,0 +1,157 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chthdpool.h
+ * @brief   Thread pools macros and structures.
+ *
+ * @addtogroup thread_pools
+ * @{
+ */
+
+#ifndef _CHTHDPOOL_H_
+#define _CHTHDPOOL_H_
+
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_CFG_USE_SEMAPHORES
+#error "CH_CFG_USE_THREADPOOLS requires CH_CFG_USE_SEMAPHORES"
+#endif
+
+#if !CH_CFG_USE_MEMPOOLS
+#error "CH_CFG_USE_THREADPOOLS requires CH_CFG_USE_MEMPOOLS"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Job function type.
+ */
+typedef void (*tpfunc_t)(void *arg);
+
+/**
+ * @brief   Type of a job descriptor.
+ */
+typedef struct ch_thread_pool_job thread_pool_job_t;
+
+/**
+ * @brief   Structure representing a job descriptor.
+ */
+struct ch_thread_pool_job {
+  thread_pool_job_t     *tj_next;       /**< @brief Next job in the queue.  */
+  tpfunc_t              tj_func;        /**< @brief Job function.           */
+  void                  *tj_arg;        /**< @brief Job function argument.  */
+};
+
+/**
+ * @brief   Type of a thread pool.
+ */
+typedef struct ch_thread_pool {
+  guarded_memory_pool_t tp_free;        /**< @brief Free job descriptors.   */
+  semaphore_t           tp_sem;         /**< @brief Jobs in the queue.      */
+  thread_pool_job_t     *tp_head;       /**< @brief First queued job.       */
+  thread_pool_job_t     *tp_tail;       /**< @brief Last queued job.        */
+  size_t                tp_pending;     /**< @brief Jobs submitted and not
+                                             yet completed.                 */
+  threads_queue_t       tp_waiting;     /**< @brief Threads waiting for the
+                                             jobs completion.               */
+  tprio_t               tp_prio;        /**< @brief Workers priority.       */
+  unsigned              tp_workers;     /**< @brief Number of workers.      */
+} thread_pool_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chThdPoolObjectInit(thread_pool_t *tpp, thread_pool_job_t *jobs,
+                           size_t n, tprio_t prio);
+  thread_t *chThdPoolAddWorker(thread_pool_t *tpp, void *wsp, size_t size);
+  msg_t chThdPoolSubmitI(thread_pool_t *tpp, tpfunc_t func, void *arg);
+  msg_t chThdPoolSubmitTimeoutS(thread_pool_t *tpp, tpfunc_t func,
+                                void *arg, systime_t time);
+  msg_t chThdPoolSubmitTimeout(thread_pool_t *tpp, tpfunc_t func,
+                               void *arg, systime_t time);
+  msg_t chThdPoolWaitTimeoutS(thread_pool_t *tpp, systime_t time);
+  msg_t chThdPoolWaitTimeout(thread_pool_t *tpp, systime_t time);
+  void chThdPoolStop(thread_pool_t *tpp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Submits a job to a thread pool.
+ * @details The invoking thread waits until a job descriptor is available.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] func      the job function
+ * @param[in] arg       the job function argument
+ *
+ * @api
+ */
+static inline void chThdPoolSubmit(thread_pool_t *tpp,
+                                   tpfunc_t func, void *arg) {
+
+  (void) chThdPoolSubmitTimeout(tpp, func, arg, TIME_INFINITE);
+}
+
+/**
+ * @brief   Returns the number of jobs submitted and not yet completed.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @return              The number of pending jobs.
+ *
+ * @iclass
+ */
+static inline size_t chThdPoolGetPendingI(thread_pool_t *tpp) {
+
+  chDbgCheckClassI();
+
+  return tpp->tp_pending;
+}
+
+#endif /* CH_CFG_USE_THREADPOOLS */
+
+#endif /* _CHTHDPOOL_H_ */
+
+/** @} */
@@ -132,6 +132,9 @@ typedef msg_t (*tfunc_t)(void *);
 extern "C" {
 #endif
    thread_t *_thread_init(thread_t *tp, tprio_t prio);
+#if CH_CFG_SCHED_BUDGET
+  void _thread_budget_exhausted(thread_t *tp);
+#endif
 #if CH_DBG_FILL_THREADS
   void _thread_memfill(uint8_t *startp, uint8_t *endp, uint8_t v);
 #endif
@@ -141,6 +144,14 @@ extern "C" {
                               tprio_t prio, tfunc_t pf, void *arg);
   thread_t *chThdStart(thread_t *tp);
   tprio_t chThdSetPriority(tprio_t newprio);
+#if CH_CFG_SCHED_THRESHOLD
+  tprio_t chThdSetThreshold(tprio_t newthreshold);
+#endif
+#if CH_CFG_SCHED_BUDGET
+  void chThdBudgetObjectInit(thread_budget_t *bp, systime_t budget,
+                             systime_t period, tprio_t prio);
+  void chThdSetBudget(thread_t *tp, thread_budget_t *bp);
+#endif
   msg_t chThdSuspendS(thread_reference_t *trp);
   msg_t chThdSuspendTimeoutS(thread_reference_t *trp, systime_t timeout);
   void chThdResumeI(thread_reference_t *trp, msg_t msg);
@@ -153,6 +164,10 @@ extern "C" {
   void chThdSleep(systime_t time);
   void chThdSleepUntil(systime_t time);
   systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next);
+#if CH_CFG_SCHED_EDF
+  void chThdSetDeadline(systime_t deadline);
+  void chThdSleepUntilWithDeadline(systime_t time, systime_t deadline);
+#endif
   void chThdYield(void);
   void chThdExit(msg_t msg);
   void chThdExitS(msg_t msg);
@@ -192,6 +207,110 @@ static inline tprio_t chThdGetPriorityX(void) {
   return chThdGetSelfX()->p_prio;
 }
 
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the current thread preemption threshold.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SCHED_THRESHOLD configuration option is enabled.
+ *
+ * @return              The current thread preemption threshold.
+ *
+ * @xclass
+ */
+static inline tprio_t chThdGetThresholdX(void) {
+
+  return chThdGetSelfX()->p_threshold;
+}
+#endif
+
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the ticks left in the current budget period.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SCHED_BUDGET configuration option is enabled.
+ *
+ * @param[in] bp        pointer to the @p thread_budget_t object
+ * @return              The remaining ticks.
+ *
+ * @xclass
+ */
+static inline systime_t chThdGetBudgetRemainingX(thread_budget_t *bp) {
+
+  return bp->tb_remaining;
+}
+
+/**
+ * @brief   Returns the number of periods where the budget was used up.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SCHED_BUDGET configuration option is enabled.
+ *
+ * @param[in] bp        pointer to the @p thread_budget_t object
+ * @return              The overruns counter.
+ *
+ * @xclass
+ */
+static inline ucnt_t chThdGetBudgetOverrunsX(thread_budget_t *bp) {
+
+  return bp->tb_overruns;
+}
+#endif
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the current thread absolute deadline.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SCHED_EDF configuration option is enabled.
+ *
+ * @return              The current thread deadline.
+ *
+ * @xclass
+ */
+static inline systime_t chThdGetDeadlineX(void) {
+
+  return chThdGetSelfX()->p_deadline;
+}
+#endif
+
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   Binds a thread to a core.
+ * @details The thread will be executed exclusively by the specified core,
+ *          by default threads are bound to the core creating them.
+ * @pre     The thread must have been created using @p chThdCreateI() and
+ *          not yet started, threads never migrate among cores.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SMP_MODE configuration option is enabled.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] core      the core identifier
+ *
+ * @iclass
+ */
+static inline void chThdSetAffinityI(thread_t *tp, unsigned core) {
+
+  chDbgCheckClassI();
+  chDbgCheck(core < (unsigned)PORT_CORES_NUMBER);
+  chDbgAssert(tp->p_state == CH_STATE_WTSTART, "wrong state");
+
+  tp->p_core = core;
+}
+
+/**
+ * @brief   Returns the core the specified thread is bound to.
+ * @note    This function is only available when the
+ *          @p CH_CFG_SMP_MODE configuration option is enabled.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The core identifier.
+ *
+ * @xclass
+ */
+static inline unsigned chThdGetAffinityX(thread_t *tp) {
+
+  return tp->p_core;
+}
+#endif
+
 /**
  * @brief   Returns the number of ticks consumed by the specified thread.
  * @note    This function is only available when the
@@ -53,6 +53,16 @@
 #define TIME_INFINITE   ((systime_t)-1)
 /** @} */
 
+/**
+ * @name    Virtual timer flags
+ * @{
+ */
+#define CH_VT_FLAG_DEFERRED     1U  /**< @brief Callback invoked by the
+                                         deferred callbacks thread.         */
+#define CH_VT_FLAG_PENDING      2U  /**< @brief Expired, callback waiting
+                                         in the deferred queue.             */
+/** @} */
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -74,14 +84,14 @@
        "be zero or greater than one"
 #endif
 
-#if (CH_CFG_ST_TIMEDELTA > 0) && (CH_CFG_TIME_QUANTUM > 0)
-#error "CH_CFG_TIME_QUANTUM not supported in tickless mode"
-#endif
-
 #if (CH_CFG_ST_TIMEDELTA > 0) && CH_DBG_THREADS_PROFILING
 #error "CH_DBG_THREADS_PROFILING not supported in tickless mode"
 #endif
 
+#if (CH_CFG_ST_TIMEDELTA > 0) && CH_CFG_SCHED_BUDGET
+#error "CH_CFG_SCHED_BUDGET not supported in tickless mode"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -183,9 +193,18 @@
 extern "C" {
 #endif
   void _vt_init(void);
-  void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
-                  vtfunc_t vtfunc, void *par);
+  void chVTDoSetWithSlackI(virtual_timer_t *vtp, systime_t delay,
+                           systime_t slack, vtfunc_t vtfunc, void *par);
   void chVTDoResetI(virtual_timer_t *vtp);
+#if CH_CFG_VT_TIMING_WHEEL
+  void _vt_wheel_tick(void);
+#endif
+#if CH_CFG_VT_DEFERRED
+  void chVTDoSetDeferredI(virtual_timer_t *vtp, systime_t delay,
+                          vtfunc_t vtfunc, void *par);
+  void _vt_defer(virtual_timer_t *vtp);
+  void _vt_deferred_thread(void *p);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -218,6 +237,8 @@ static inline void chVTObjectInit(virtual_timer_t *vtp) {
  * @note    This function can be called from any context but its atomicity
  *          is not guaranteed on architectures whose word size is less than
  *          @p systime_t size.
+ * @note    In SMP tick mode the system time is the counter of the core
+ *          zero, the timers of each core are driven by the core own tick.
  *
  * @return              The system time in ticks.
  *
@@ -225,7 +246,9 @@ static inline void chVTObjectInit(virtual_timer_t *vtp) {
  */
 static inline systime_t chVTGetSystemTimeX(void) {
 
-#if CH_CFG_ST_TIMEDELTA == 0
+#if (CH_CFG_ST_TIMEDELTA == 0) && CH_CFG_SMP_MODE
+  return ch_cores[0].vtlist.vt_systime;
+#elif CH_CFG_ST_TIMEDELTA == 0
   return ch.vtlist.vt_systime;
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
   return port_timer_get_time();
@@ -322,6 +345,34 @@ static inline bool chVTIsSystemTimeWithin(systime_t start, systime_t end) {
   return chVTIsTimeWithinX(chVTGetSystemTime(), start, end);
 }
 
+/**
+ * @brief   Enables a virtual timer.
+ * @details The timer is enabled and programmed to trigger after the delay
+ *          specified as parameter.
+ * @pre     The timer must not be already armed before calling this function.
+ * @note    The callback function is invoked from interrupt context.
+ *
+ * @param[out] vtp      the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+static inline void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
+                              vtfunc_t vtfunc, void *par) {
+
+  chVTDoSetWithSlackI(vtp, delay, (systime_t)0, vtfunc, par);
+}
+
 /**
  * @brief   Returns @p true if the specified timer is armed.
  * @pre     The timer must have been initialized using @p chVTObjectInit()
@@ -432,6 +483,65 @@ static inline void chVTSet(virtual_timer_t *vtp, systime_t delay,
   chSysUnlock();
 }
 
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Enables a deferred virtual timer.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function, it is invoked from the
+ *                      deferred callbacks thread
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+static inline void chVTSetDeferredI(virtual_timer_t *vtp, systime_t delay,
+                                    vtfunc_t vtfunc, void *par) {
+
+  chVTResetI(vtp);
+  chVTDoSetDeferredI(vtp, delay, vtfunc, par);
+}
+
+/**
+ * @brief   Enables a deferred virtual timer.
+ * @details If the virtual timer was already enabled then it is re-enabled
+ *          using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function, it is invoked from the
+ *                      deferred callbacks thread
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @api
+ */
+static inline void chVTSetDeferred(virtual_timer_t *vtp, systime_t delay,
+                                   vtfunc_t vtfunc, void *par) {
+
+  chSysLock();
+  chVTSetDeferredI(vtp, delay, vtfunc, par);
+  chSysUnlock();
+}
+#endif /* CH_CFG_VT_DEFERRED */
+
 /**
  * @brief   Virtual timers ticker.
  * @note    The system lock is released before entering the callback and
@@ -445,7 +555,9 @@ static inline void chVTDoTickI(void) {
 
   chDbgCheckClassI();
 
-#if CH_CFG_ST_TIMEDELTA == 0
+#if CH_CFG_VT_TIMING_WHEEL
+  _vt_wheel_tick();
+#elif CH_CFG_ST_TIMEDELTA == 0
   ch.vtlist.vt_systime++;
   if (&ch.vtlist != (virtual_timers_list_t *)ch.vtlist.vt_next) {
     virtual_timer_t *vtp;
@@ -453,15 +565,21 @@ static inline void chVTDoTickI(void) {
     --ch.vtlist.vt_next->vt_delta;
     while (!(vtp = ch.vtlist.vt_next)->vt_delta) {
       vtfunc_t fn = vtp->vt_func;
-      vtp->vt_func = (vtfunc_t)NULL;
       vtp->vt_next->vt_prev = (virtual_timer_t *)&ch.vtlist;
       ch.vtlist.vt_next = vtp->vt_next;
+#if CH_CFG_VT_DEFERRED
+      if ((vtp->vt_flags & CH_VT_FLAG_DEFERRED) != 0U) {
+        _vt_defer(vtp);
+        continue;
+      }
+#endif
+      vtp->vt_func = (vtfunc_t)NULL;
       chSysUnlockFromISR();
       fn(vtp->vt_par);
       chSysLockFromISR();
     }
   }
-#else /* CH_CFG_ST_TIMEDELTA > 0 */
+#else /* !CH_CFG_VT_TIMING_WHEEL && CH_CFG_ST_TIMEDELTA > 0 */
   virtual_timer_t *vtp;
   systime_t now;
 
@@ -487,6 +605,12 @@ static inline void chVTDoTickI(void) {
     /* The timer is removed from the list and marked as non-armed.*/
     vtp->vt_next->vt_prev = (virtual_timer_t *)&ch.vtlist;
     ch.vtlist.vt_next = vtp->vt_next;
+#if CH_CFG_VT_DEFERRED
+    if ((vtp->vt_flags & CH_VT_FLAG_DEFERRED) != 0U) {
+      _vt_defer(vtp);
+      continue;
+    }
+#endif
     fn = vtp->vt_func;
     vtp->vt_func = (vtfunc_t)NULL;
 
@@ -510,7 +634,7 @@ static inline void chVTDoTickI(void) {
       port_timer_set_alarm(now + CH_CFG_ST_TIMEDELTA);
     }
   }
-#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#endif /* !CH_CFG_VT_TIMING_WHEEL && CH_CFG_ST_TIMEDELTA > 0 */
 }
 
 #endif /* _CHVT_H_ */
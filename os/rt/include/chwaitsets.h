@@ -0,0 +1,157 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwaitsets.h
+ * @brief   Wait-sets macros and structures.
+ *
+ * @addtogroup waitsets
+ * @{
+ */
+
+#ifndef _CHWAITSETS_H_
+#define _CHWAITSETS_H_
+
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Wait-set entry types
+ * @{
+ */
+#define WS_TYPE_NONE            0   /**< @brief Unused entry.               */
+#define WS_TYPE_SEMAPHORE       1   /**< @brief Semaphore or mailbox.       */
+#define WS_TYPE_INPUTQUEUE      2   /**< @brief Input queue.                */
+#define WS_TYPE_EVENTS          3   /**< @brief Events mask.                */
+/** @} */
+
+/**
+ * @brief   Maximum number of entries in a wait-set.
+ */
+#define WS_MAX_ENTRIES          (sizeof (eventmask_t) * 8U)
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_CFG_USE_SEMAPHORES
+#error "CH_CFG_USE_WAITSETS requires CH_CFG_USE_SEMAPHORES"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a wait-set.
+ */
+typedef struct ch_waitset waitset_t;
+
+/**
+ * @brief   Type of a wait-set entry.
+ */
+typedef struct ch_waitset_entry waitset_entry_t;
+
+/**
+ * @brief   Structure representing a wait-set entry.
+ */
+struct ch_waitset_entry {
+  waitset_t             *we_ws;         /**< @brief Owner wait-set.         */
+  void                  *we_objp;       /**< @brief Registered object.      */
+  eventmask_t           we_events;      /**< @brief Events of an events
+                                                    entry.                  */
+  uint8_t               we_type;        /**< @brief Entry type.             */
+};
+
+/**
+ * @brief   Structure representing a wait-set.
+ * @note    The objects mark their entry as signaled when becoming ready so
+ *          the waiting thread only checks the signaled entries, the events
+ *          entries are checked against the thread pending events.
+ */
+struct ch_waitset {
+  waitset_entry_t       *ws_entries;    /**< @brief Entries array.          */
+  unsigned              ws_n;           /**< @brief Number of entries.      */
+  eventmask_t           ws_signaled;    /**< @brief Entries signaled by the
+                                                    objects.                */
+  eventmask_t           ws_evtentries;  /**< @brief Events entries.         */
+  eventmask_t           ws_events;      /**< @brief Events of all the
+                                                    events entries.         */
+  thread_t              *ws_thread;     /**< @brief Waiting thread.         */
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _waitset_signal(waitset_entry_t *wep);
+  void chWSObjectInit(waitset_t *wsp, waitset_entry_t *entries, unsigned n);
+  void chWSAddSemaphore(waitset_t *wsp, unsigned id, semaphore_t *sp);
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+  void chWSAddMailbox(waitset_t *wsp, unsigned id, mailbox_t *mbp);
+#endif
+#if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
+  void chWSAddInputQueue(waitset_t *wsp, unsigned id, input_queue_t *iqp);
+#endif
+#if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
+  void chWSAddEvents(waitset_t *wsp, unsigned id, eventmask_t events);
+#endif
+  void chWSRemove(waitset_t *wsp, unsigned id);
+  msg_t chWSWaitTimeoutS(waitset_t *wsp, systime_t time);
+  msg_t chWSWaitTimeout(waitset_t *wsp, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Waits for any of the wait-set entries to become ready.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @return              The identifier of the ready entry.
+ *
+ * @api
+ */
+static inline msg_t chWSWait(waitset_t *wsp) {
+
+  return chWSWaitTimeout(wsp, TIME_INFINITE);
+}
+
+#endif /* CH_CFG_USE_WAITSETS */
+
+#endif /* _CHWAITSETS_H_ */
+
+/** @} */
@@ -192,7 +192,7 @@ osStatus osThreadSetPriority(osThreadId thread_id, osPriority newprio) {
     tp->p_state = CH_STATE_CURRENT;
 #endif
     /* Re-enqueues tp with its new priority on the ready list.*/
-    chSchReadyI(queue_dequeue(tp));
+    chSchReadyI(rlist_dequeue(tp));
     break;
   }
 
@@ -0,0 +1,306 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    SIMLINUX/chcore.c
+ * @brief   Multi-core simulator on Linux port code.
+ *
+ * @addtogroup SIMLINUX_GCC_CORE
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   System tick period in nanoseconds.
+ */
+#define SIM_TICK_NS     (1000000000ULL / (uint64_t)CH_CFG_ST_FREQUENCY)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Identifier of the core associated to the POSIX thread.
+ */
+__thread unsigned _sim_core_id;
+
+/**
+ * @brief   Pending inter-core notifications.
+ */
+volatile uint32_t _sim_notify[PORT_CORES_NUMBER];
+
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Alarm time of each core.
+ */
+volatile systime_t _sim_alarm[PORT_CORES_NUMBER];
+
+/**
+ * @brief   Alarm enable of each core.
+ */
+volatile bool _sim_alarm_enabled[PORT_CORES_NUMBER];
+#endif
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Host time of the system start.
+ */
+static uint64_t sim_start;
+
+#if (CH_CFG_ST_TIMEDELTA == 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Host time of the next tick of each core.
+ */
+static uint64_t sim_next_tick[PORT_CORES_NUMBER];
+#endif
+
+/**
+ * @brief   Main functions of the simulated cores.
+ */
+static void (*sim_entries[PORT_CORES_NUMBER])(void);
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the host monotonic time in nanoseconds.
+ */
+static uint64_t sim_host_ns(void) {
+  struct timespec ts;
+
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief   Start a thread by invoking its work function.
+ * @details If the work function returns @p chThdExit() is automatically
+ *          invoked. The pointers are split in 32 bits halves because
+ *          @p makecontext() only passes @p int arguments.
+ */
+static void _port_thread_start(unsigned pflo, unsigned pfhi,
+                               unsigned arglo, unsigned arghi) {
+  tfunc_t pf = (tfunc_t)(((uintptr_t)pfhi << 16 << 16) | (uintptr_t)pflo);
+  void *arg = (void *)(((uintptr_t)arghi << 16 << 16) | (uintptr_t)arglo);
+
+  chSysUnlock();
+  chThdExit(pf(arg));
+}
+
+/**
+ * @brief   Entry point of the POSIX threads simulating the cores.
+ */
+static void *sim_core_thread(void *p) {
+  void (**entryp)(void) = (void (**)(void))p;
+
+  _sim_core_id = (unsigned)(entryp - sim_entries);
+  (*entryp)();
+  return NULL;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulator initialization.
+ * @note    Invoked by @p port_init() from the core zero.
+ */
+void _sim_init(void) {
+
+  _sim_core_id = 0U;
+  sim_start = sim_host_ns();
+#if CH_CFG_ST_TIMEDELTA == 0
+  sim_next_tick[0] = sim_start + SIM_TICK_NS;
+#endif
+}
+
+/**
+ * @brief   Starts a simulated core.
+ * @details A POSIX thread is created, it invokes the specified function
+ *          in the context of the new core. The function is expected to
+ *          invoke @p chSysInitCore() before any other system API.
+ * @pre     The core zero must have already invoked @p chSysInit().
+ *
+ * @param[in] core      the core identifier, zero excluded
+ * @param[in] pf        the core main function
+ */
+void _sim_start_core(unsigned core, void (*pf)(void)) {
+  pthread_t thread;
+
+  chDbgCheck((core > 0U) && (core < (unsigned)PORT_CORES_NUMBER));
+
+#if CH_CFG_SMP_MODE
+  /* The new core shares the tick phase of the core zero, this keeps the
+     system time of the cores aligned.*/
+#if CH_CFG_ST_TIMEDELTA == 0
+  sim_next_tick[core] = sim_start +
+                        ((uint64_t)ch_cores[0].vtlist.vt_systime + 1ULL) *
+                        SIM_TICK_NS;
+#endif
+#endif
+  sim_entries[core] = pf;
+  if (pthread_create(&thread, NULL, sim_core_thread,
+                     &sim_entries[core]) != 0) {
+    printf("pthread_create() error\n");
+    exit(1);
+  }
+  (void) pthread_detach(thread);
+}
+
+/**
+ * @brief   Returns the value of the simulated realtime counter.
+ *
+ * @return              The realtime counter value.
+ */
+rtcnt_t _sim_get_counter_value(void) {
+
+  return (rtcnt_t)((sim_host_ns() - sim_start) /
+                   (1000000000ULL / (uint64_t)PORT_SIM_RT_FREQUENCY));
+}
+
+/**
+ * @brief   Returns the simulated system time.
+ *
+ * @return              The system time.
+ */
+systime_t _sim_get_time(void) {
+
+  return (systime_t)((sim_host_ns() - sim_start) / SIM_TICK_NS);
+}
+
+/**
+ * @brief   Initializes the context of a new thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] wsp       pointer to the working area
+ * @param[in] size      size of the working area
+ * @param[in] pf        the thread function
+ * @param[in] arg       the thread function argument
+ */
+void _port_setup_context(thread_t *tp, void *wsp, size_t size,
+                         void *pf, void *arg) {
+  uint8_t *stack = (uint8_t *)wsp + sizeof(thread_t);
+
+  (void) getcontext(&tp->p_ctx.uc);
+  tp->p_ctx.uc.uc_stack.ss_sp = stack;
+  tp->p_ctx.uc.uc_stack.ss_size = (size_t)((uint8_t *)wsp + size - stack);
+  tp->p_ctx.uc.uc_link = NULL;
+  makecontext(&tp->p_ctx.uc, (void (*)(void))_port_thread_start, 4,
+              (unsigned)(uintptr_t)pf,
+              (unsigned)((uintptr_t)pf >> 16 >> 16),
+              (unsigned)(uintptr_t)arg,
+              (unsigned)((uintptr_t)arg >> 16 >> 16));
+}
+
+/**
+ * @brief   Performs a context switch between two threads.
+ *
+ * @param[in] ntp       the thread to be switched in
+ * @param[in] otp       the thread to be switched out
+ */
+void port_switch(thread_t *ntp, thread_t *otp) {
+
+  (void) swapcontext(&otp->p_ctx.uc, &ntp->p_ctx.uc);
+}
+
+/**
+ * @brief   Notifies a core.
+ * @details The core reschedules, if required, when it serves the
+ *          notification.
+ *
+ * @param[in] core      the core identifier
+ */
+void port_notify_core(unsigned core) {
+
+  __atomic_store_n(&_sim_notify[core], 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief   Interrupts simulation.
+ * @details Serves the system tick, or the alarm in tick-less mode, and the
+ *          notifications of the executing core.
+ */
+void _sim_check_for_interrupts(void) {
+  unsigned core = port_get_core_id();
+  bool resched = false;
+
+  if (__atomic_exchange_n(&_sim_notify[core], 0U, __ATOMIC_ACQUIRE) != 0U) {
+    resched = true;
+  }
+
+#if CH_CFG_ST_TIMEDELTA == 0
+  if (sim_host_ns() >= sim_next_tick[core]) {
+    sim_next_tick[core] += SIM_TICK_NS;
+#else
+  if (_sim_alarm_enabled[core] &&
+      ((systime_t)(_sim_get_time() - _sim_alarm[core]) <
+       ((systime_t)-1 >> 1))) {
+#endif
+    CH_IRQ_PROLOGUE();
+
+    chSysLockFromISR();
+    chSysTimerHandlerI();
+    chSysUnlockFromISR();
+
+    CH_IRQ_EPILOGUE();
+
+    resched = true;
+  }
+
+  if (resched) {
+    chSysLock();
+    if (chSchIsPreemptionRequired()) {
+      chSchDoReschedule();
+    }
+    chSysUnlock();
+  }
+}
+
+/**
+ * @brief   Idle simulation.
+ * @details The host CPU is released for a short time then the pending
+ *          interrupts are served.
+ */
+void _sim_idle(void) {
+  struct timespec ts = {0, PORT_SIM_IDLE_SLEEP * 1000L};
+
+  (void) nanosleep(&ts, NULL);
+  _sim_check_for_interrupts();
+}
+
+/** @} */
@@ -0,0 +1,484 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    SIMLINUX/chcore.h
+ * @brief   Multi-core simulator on Linux port macros and structures.
+ *
+ * @addtogroup SIMLINUX_GCC_CORE
+ * @details Each simulated core is a POSIX thread, the ChibiOS/RT threads
+ *          are user contexts switched by the POSIX thread of the core
+ *          they are bound to. Interrupts are simulated by polling, the
+ *          system tick and the inter-core notifications are served when
+ *          @p _sim_check_for_interrupts() is invoked.
+ * @{
+ */
+
+#ifndef _CHCORE_H_
+#define _CHCORE_H_
+
+#include <sched.h>
+#include <ucontext.h>
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * Macro defining the simulated architecture.
+ */
+#define PORT_ARCHITECTURE_SIMLINUX
+
+/**
+ * Name of the implemented architecture.
+ */
+#define PORT_ARCHITECTURE_NAME          "Simulator"
+
+/**
+ * @brief   Name of the architecture variant (optional).
+ */
+#define PORT_CORE_VARIANT_NAME          "Linux POSIX threads"
+
+/**
+ * @brief   Name of the compiler supported by this port.
+ */
+#define PORT_COMPILER_NAME              "GCC " __VERSION__
+
+/**
+ * @brief   Port-specific information string.
+ */
+#define PORT_INFO                       "No preemption, one thread per core"
+
+/**
+ * @brief   This port supports a realtime counter.
+ */
+#define PORT_SUPPORTS_RT                TRUE
+
+/**
+ * @brief   This port supports multiple cores.
+ */
+#define PORT_SUPPORTS_SMP               TRUE
+
+/**
+ * @brief   This port provides @p port_is_notify_pending().
+ */
+#define PORT_SUPPORTS_NOTIFY_PENDING    TRUE
+
+/**
+ * @brief   Frequency of the simulated realtime counter.
+ */
+#define PORT_SIM_RT_FREQUENCY           100000000
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of simulated cores.
+ */
+#if !defined(PORT_CORES_NUMBER) || defined(__DOXYGEN__)
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+#define PORT_CORES_NUMBER               2
+#else
+#define PORT_CORES_NUMBER               1
+#endif
+#endif
+
+/**
+ * @brief   Stack size for the system idle thread.
+ * @details This size depends on the idle thread implementation, usually
+ *          the idle thread should take no more space than those reserved
+ *          by @p PORT_INT_REQUIRED_STACK.
+ */
+#ifndef PORT_IDLE_THREAD_STACK_SIZE
+#define PORT_IDLE_THREAD_STACK_SIZE     256
+#endif
+
+/**
+ * @brief   Per-thread stack overhead for interrupts servicing.
+ * @details This constant is used in the calculation of the correct working
+ *          area size.
+ */
+#ifndef PORT_INT_REQUIRED_STACK
+#define PORT_INT_REQUIRED_STACK         32768
+#endif
+
+/**
+ * @brief   Idle sleep time in microseconds.
+ * @details The idle thread releases the host CPU for this time while
+ *          waiting for interrupts.
+ */
+#ifndef PORT_SIM_IDLE_SLEEP
+#define PORT_SIM_IDLE_SLEEP             50
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_DBG_ENABLE_STACK_CHECK
+#error "option CH_DBG_ENABLE_STACK_CHECK not supported by this port"
+#endif
+
+#if PORT_CORES_NUMBER < 1
+#error "invalid PORT_CORES_NUMBER value"
+#endif
+
+#if !CH_CFG_SMP_MODE && (PORT_CORES_NUMBER > 1)
+#error "PORT_CORES_NUMBER > 1 requires CH_CFG_SMP_MODE"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   16 bytes stack and memory alignment enforcement.
+ */
+typedef struct {
+  uint8_t a[16];
+} stkalign_t __attribute__((aligned(16)));
+
+/**
+ * @brief   Type of a spinlock.
+ */
+typedef volatile uint32_t port_spinlock_t;
+
+/**
+ * @brief   Platform dependent part of the @p thread_t structure.
+ * @details In this port the structure holds the user context of the
+ *          thread.
+ */
+struct context {
+  ucontext_t            uc;
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Platform dependent part of the @p chThdCreateI() API.
+ * @details The user context of the thread is initialized in order to
+ *          start execution on its own stack.
+ */
+#define PORT_SETUP_CONTEXT(tp, workspace, wsize, pf, arg)                   \
+  _port_setup_context(tp, workspace, wsize, (void *)(pf), (void *)(arg))
+
+/**
+ * @brief   Computes the thread working area global size.
+ * @note    There is no need to perform alignments in this macro.
+ */
+#define PORT_WA_SIZE(n) (sizeof(stkalign_t) +                               \
+                         ((size_t)(n)) +                                    \
+                         ((size_t)(PORT_INT_REQUIRED_STACK)))
+
+/**
+ * @brief   IRQ prologue code.
+ * @details This macro must be inserted at the start of all IRQ handlers
+ *          enabled to invoke system APIs.
+ */
+#define PORT_IRQ_PROLOGUE()
+
+/**
+ * @brief   IRQ epilogue code.
+ * @details This macro must be inserted at the end of all IRQ handlers
+ *          enabled to invoke system APIs.
+ */
+#define PORT_IRQ_EPILOGUE()
+
+/**
+ * @brief   IRQ handler function declaration.
+ * @note    @p id can be a function name or a vector number depending on the
+ *          port implementation.
+ */
+#define PORT_IRQ_HANDLER(id) void id(void)
+
+/**
+ * @brief   Fast IRQ handler function declaration.
+ * @note    @p id can be a function name or a vector number depending on the
+ *          port implementation.
+ */
+#define PORT_FAST_IRQ_HANDLER(id) void id(void)
+
+/**
+ * @brief   Returns the current value of the realtime counter.
+ *
+ * @return              The realtime counter value.
+ */
+#define port_rt_get_counter_value() _sim_get_counter_value()
+
+/**
+ * @brief   Full memory barrier.
+ * @details The cores are host threads so a hardware barrier is required for
+ *          data shared without the kernel lock.
+ */
+#define port_memory_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if !defined(__DOXYGEN__)
+extern __thread unsigned _sim_core_id;
+extern volatile uint32_t _sim_notify[PORT_CORES_NUMBER];
+#if CH_CFG_ST_TIMEDELTA > 0
+extern volatile systime_t _sim_alarm[PORT_CORES_NUMBER];
+extern volatile bool _sim_alarm_enabled[PORT_CORES_NUMBER];
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _sim_init(void);
+  void _sim_start_core(unsigned core, void (*pf)(void));
+  void _sim_check_for_interrupts(void);
+  void _sim_idle(void);
+  rtcnt_t _sim_get_counter_value(void);
+  systime_t _sim_get_time(void);
+  void _port_setup_context(thread_t *tp, void *wsp, size_t size,
+                           void *pf, void *arg);
+  void port_switch(thread_t *ntp, thread_t *otp);
+  void port_notify_core(unsigned core);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Port-related initialization code.
+ */
+static inline void port_init(void) {
+
+  _sim_init();
+}
+
+/**
+ * @brief   Returns a word encoding the current interrupts status.
+ *
+ * @return              The interrupts status.
+ */
+static inline syssts_t port_get_irq_status(void) {
+
+  return (syssts_t)0;
+}
+
+/**
+ * @brief   Checks the interrupt status.
+ *
+ * @param[in] sts       the interrupt status word
+ *
+ * @return              The interrupt status.
+ * @retvel false        the word specified a disabled interrupts status.
+ * @retvel true         the word specified an enabled interrupts status.
+ */
+static inline bool port_irq_enabled(syssts_t sts) {
+
+  return (sts & 1) == 0;
+}
+
+/**
+ * @brief   Determines the current execution context.
+ *
+ * @return              The execution context.
+ * @retval false        not running in ISR mode.
+ * @retval true         running in ISR mode.
+ */
+static inline bool port_is_isr_context(void) {
+
+  return false;
+}
+
+/**
+ * @brief   Kernel-lock action.
+ * @details In this port interrupts are polled so this function is just
+ *          a compiler barrier.
+ */
+static inline void port_lock(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Kernel-unlock action.
+ * @details In this port interrupts are polled so this function is just
+ *          a compiler barrier.
+ */
+static inline void port_unlock(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Kernel-lock action from an interrupt handler.
+ * @note    Same as @p port_lock() in this port.
+ */
+static inline void port_lock_from_isr(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Kernel-unlock action from an interrupt handler.
+ * @note    Same as @p port_unlock() in this port.
+ */
+static inline void port_unlock_from_isr(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Disables all the interrupt sources.
+ */
+static inline void port_disable(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Disables the interrupt sources below kernel-level priority.
+ */
+static inline void port_suspend(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Enables all the interrupt sources.
+ */
+static inline void port_enable(void) {
+
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Enters an architecture-dependent IRQ-waiting mode.
+ * @details The host CPU is released for a short time then the pending
+ *          interrupts are served.
+ */
+static inline void port_wait_for_interrupt(void) {
+
+  _sim_idle();
+}
+
+/**
+ * @brief   Returns the identifier of the executing core.
+ *
+ * @return              The core identifier.
+ */
+static inline unsigned port_get_core_id(void) {
+
+  return _sim_core_id;
+}
+
+/**
+ * @brief   Checks for a notification pending on the executing core.
+ *
+ * @return              The notification state.
+ * @retval false        if no notification is pending.
+ * @retval true         if a notification has not been served yet.
+ */
+static inline bool port_is_notify_pending(void) {
+
+  return __atomic_load_n(&_sim_notify[port_get_core_id()],
+                         __ATOMIC_ACQUIRE) != 0U;
+}
+
+/**
+ * @brief   Acquires a spinlock.
+ * @details The host CPU is yielded while the lock is taken by another
+ *          core, the simulated cores could share the same host CPU.
+ *
+ * @param[in] slp       pointer to the spinlock
+ */
+static inline void port_spin_lock(port_spinlock_t *slp) {
+
+  while (__atomic_exchange_n(slp, 1U, __ATOMIC_ACQUIRE) != 0U) {
+    (void) sched_yield();
+  }
+}
+
+/**
+ * @brief   Releases a spinlock.
+ *
+ * @param[in] slp       pointer to the spinlock
+ */
+static inline void port_spin_unlock(port_spinlock_t *slp) {
+
+  __atomic_store_n(slp, 0U, __ATOMIC_RELEASE);
+}
+
+#if (CH_CFG_ST_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Starts the alarm of the executing core.
+ *
+ * @param[in] time      the time to be set for the first alarm
+ */
+static inline void port_timer_start_alarm(systime_t time) {
+
+  _sim_alarm[port_get_core_id()] = time;
+  _sim_alarm_enabled[port_get_core_id()] = true;
+}
+
+/**
+ * @brief   Stops the alarm of the executing core.
+ */
+static inline void port_timer_stop_alarm(void) {
+
+  _sim_alarm_enabled[port_get_core_id()] = false;
+}
+
+/**
+ * @brief   Sets the alarm time of the executing core.
+ *
+ * @param[in] time      the time to be set for the next alarm
+ */
+static inline void port_timer_set_alarm(systime_t time) {
+
+  _sim_alarm[port_get_core_id()] = time;
+}
+
+/**
+ * @brief   Returns the system time, common to all the cores.
+ *
+ * @return              The system time.
+ */
+static inline systime_t port_timer_get_time(void) {
+
+  return _sim_get_time();
+}
+
+/**
+ * @brief   Returns the current alarm time of the executing core.
+ *
+ * @return              The currently set alarm time.
+ */
+static inline systime_t port_timer_get_alarm(void) {
+
+  return _sim_alarm[port_get_core_id()];
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+
+#endif /* _CHCORE_H_ */
+
+/** @} */
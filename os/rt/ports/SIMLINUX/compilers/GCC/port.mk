@@ -0,0 +1,7 @@
+# List of the ChibiOS/RT SIMLINUX port files.
+PORTSRC = ${CHIBIOS}/os/rt/ports/SIMLINUX/chcore.c
+
+PORTASM = 
+
+PORTINC = ${CHIBIOS}/os/rt/ports/SIMLINUX/compilers/GCC \
+          ${CHIBIOS}/os/rt/ports/SIMLINUX
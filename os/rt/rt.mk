@@ -8,17 +8,23 @@ KERNSRC = ${CHIBIOS}/os/rt/src/chsys.c \
           ${CHIBIOS}/os/rt/src/chvt.c \
           ${CHIBIOS}/os/rt/src/chthreads.c \
           ${CHIBIOS}/os/rt/src/chdynamic.c \
+          ${CHIBIOS}/os/rt/src/chthdpool.c \
           ${CHIBIOS}/os/rt/src/chregistry.c \
+          ${CHIBIOS}/os/rt/src/chperiodic.c \
           ${CHIBIOS}/os/rt/src/chsem.c \
           ${CHIBIOS}/os/rt/src/chmtx.c \
           ${CHIBIOS}/os/rt/src/chcond.c \
           ${CHIBIOS}/os/rt/src/chevents.c \
           ${CHIBIOS}/os/rt/src/chmsg.c \
           ${CHIBIOS}/os/rt/src/chmboxes.c \
+          ${CHIBIOS}/os/rt/src/chring.c \
           ${CHIBIOS}/os/rt/src/chqueues.c \
+          ${CHIBIOS}/os/rt/src/chwaitsets.c \
           ${CHIBIOS}/os/rt/src/chmemcore.c \
           ${CHIBIOS}/os/rt/src/chheap.c \
-          ${CHIBIOS}/os/rt/src/chmempools.c
+          ${CHIBIOS}/os/rt/src/chmempools.c \
+          ${CHIBIOS}/os/rt/src/chmemarena.c \
+          ${CHIBIOS}/os/rt/src/chheapcache.c
 
 # Required include directories
 KERNINC = ${CHIBIOS}/os/rt/include
@@ -165,6 +165,9 @@ thread_t *chThdCreateFromHeap(memory_heap_t *heapp, size_t size,
   chSysLock();
   tp = chThdCreateI(wsp, size, prio, pf, arg);
   tp->p_flags = CH_FLAG_MODE_HEAP;
+#if CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS
+  tp->p_stkend = (uint8_t *)wsp + size;
+#endif
   chSchWakeupS(tp, MSG_OK);
   chSysUnlock();
 
@@ -220,6 +223,9 @@ thread_t *chThdCreateFromMemoryPool(memory_pool_t *mp, tprio_t prio,
   tp = chThdCreateI(wsp, mp->mp_object_size, prio, pf, arg);
   tp->p_flags = CH_FLAG_MODE_MEMPOOL;
   tp->p_mpool = mp;
+#if CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS
+  tp->p_stkend = (uint8_t *)wsp + mp->mp_object_size;
+#endif
   chSchWakeupS(tp, MSG_OK);
   chSysUnlock();
 
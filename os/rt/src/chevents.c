@@ -277,9 +277,14 @@ void chEvtSignalI(thread_t *tp, eventmask_t events) {
   chDbgCheck(tp != NULL);
 
   tp->p_epending |= events;
-  /* Test on the AND/OR conditions wait states.*/
+  /* Test on the AND/OR conditions wait states, a thread waiting on a
+     wait-set is handled as an OR wait.*/
   if (((tp->p_state == CH_STATE_WTOREVT) &&
        ((tp->p_epending & tp->p_u.ewmask) != 0)) ||
+#if CH_CFG_USE_WAITSETS
+      ((tp->p_state == CH_STATE_WTSET) &&
+       ((tp->p_epending & tp->p_u.ewmask) != 0)) ||
+#endif
       ((tp->p_state == CH_STATE_WTANDEVT) &&
        ((tp->p_epending & tp->p_u.ewmask) == tp->p_u.ewmask))) {
     tp->p_u.rdymsg = MSG_OK;
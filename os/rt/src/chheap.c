@@ -28,6 +28,21 @@
  *          are functionally equivalent to the usual @p malloc() and @p free()
  *          library functions. The main difference is that the OS heap APIs
  *          are guaranteed to be thread safe.<br>
+ *          If the @p CH_CFG_HEAP_TLSF option is enabled then a Two-Level
+ *          Segregated Fit strategy is used instead, the free blocks are kept
+ *          in lists segregated by size and bitmaps of the non-empty lists
+ *          allow to find a suitable block in constant time, the released
+ *          blocks are merged with their physical neighbors in constant
+ *          time too.<br>
+ *          If the @p CH_CFG_HEAP_PROFILE option is enabled then each heap
+ *          keeps the allocated bytes and their high water mark, a histogram
+ *          of the live blocks by size and the live blocks owned by each
+ *          call site, see @p chHeapGetProfile(). The call site of
+ *          @p chHeapAlloc() is its return address, explicit tags can be
+ *          specified using @p chHeapAllocTagged(). The allocation and free
+ *          operations are also recorded into the @p ch_heap_trace ring
+ *          buffer, it can be dumped using a debugger and decoded on the
+ *          host using @p tools/heaptrace/heaptrace.py.<br>
  * @pre     In order to use the heap APIs the @p CH_CFG_USE_HEAP option must
  *          be enabled in @p chconf.h.
  * @{
@@ -52,10 +67,74 @@
 #define H_UNLOCK(h)     chSemSignal(&(h)->h_sem)
 #endif
 
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+/*
+ * Free block flag, stored in the least significant bit of the block size.
+ */
+#define H_FREE          ((size_t)1)
+
+#define H_SIZE(hp)      ((hp)->h.size & ~H_FREE)
+
+#define H_IS_FREE(hp)   (((hp)->h.size & H_FREE) != (size_t)0)
+
+/*
+ * Previous block in the free list, stored in the free block payload.
+ */
+#define H_PREV_FREE(hp) (*(union heap_header **)(void *)((hp) + 1))
+
+#define H_NEXT_PHYS(hp) ((union heap_header *)((uint8_t *)((hp) + 1) +     \
+                                               H_SIZE(hp)))
+
+/*
+ * Minimum payload size, it must be able to contain the free list link.
+ */
+#define H_MIN_SIZE      MEM_ALIGN_NEXT(sizeof(union heap_header *))
+
+/*
+ * Blocks smaller than this size belong to the first level class zero.
+ */
+#define H_SMALL_SIZE    ((size_t)CH_HEAP_SL_COUNT * MEM_ALIGN_SIZE)
+
+/*
+ * Minimum size of a block, header included.
+ */
+#define H_MIN_FRAG      (sizeof(union heap_header) + H_MIN_SIZE)
+#else /* !CH_CFG_HEAP_TLSF */
+#define H_SIZE(hp)      ((hp)->h.size)
+
+#define H_MIN_FRAG      sizeof(union heap_header)
+#endif /* !CH_CFG_HEAP_TLSF */
+
+/*
+ * Call site of the exported function, used as default allocation tag.
+ */
+#if CH_CFG_HEAP_PROFILE && defined(__GNUC__)
+#define H_CALLER()      ((const void *)__builtin_return_address(0))
+#else
+#define H_CALLER()      NULL
+#endif
+
+/* When the profiling is disabled the profiling functions are replaced by
+   empty macros.*/
+#if !CH_CFG_HEAP_PROFILE
+#define heap_profile_init(heapp)
+#define heap_profile_alloc(heapp, hp, tag)
+#define heap_profile_free(hp)
+#define heap_profile_fail(heapp, size, tag)
+#endif
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
 
+#if (CH_CFG_HEAP_PROFILE && (CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0)) ||           \
+    defined(__DOXYGEN__)
+/**
+ * @brief   Heap trace buffer.
+ */
+heap_trace_buffer_t ch_heap_trace;
+#endif
+
 /*===========================================================================*/
 /* Module local types.                                                       */
 /*===========================================================================*/
@@ -73,6 +152,647 @@ static memory_heap_t default_heap;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the index of the least significant bit set in a word.
+ * @pre     The word must not be zero.
+ */
+static inline unsigned heap_lsb(uint32_t w) {
+
+  return bit_msb(w & (~w + 1U));
+}
+
+/**
+ * @brief   Returns the classes of the free blocks of the specified size.
+ *
+ * @note    The classes are always set, a size beyond the largest class is
+ *          clamped to the last class.
+ *
+ * @param[in] size      the block size
+ * @param[out] flp      the first level class
+ * @param[out] slp      the second level class
+ * @return              The operation status.
+ * @retval false        if the size is beyond the largest class.
+ */
+static bool heap_mapping(size_t size, unsigned *flp, unsigned *slp) {
+  unsigned msb;
+
+  if (size < H_SMALL_SIZE) {
+    *flp = 0U;
+    *slp = (unsigned)(size / MEM_ALIGN_SIZE);
+    return true;
+  }
+
+  if (size <= (size_t)0x7FFFFFFFU) {
+    msb = bit_msb((uint32_t)size);
+    *flp = msb - bit_msb((uint32_t)H_SMALL_SIZE) + 1U;
+    *slp = (unsigned)(size >> (msb - (unsigned)CH_HEAP_SL_LOG2)) -
+           (unsigned)CH_HEAP_SL_COUNT;
+    if (*flp < (unsigned)CH_HEAP_FL_COUNT) {
+      return true;
+    }
+  }
+
+  *flp = (unsigned)CH_HEAP_FL_COUNT - 1U;
+  *slp = (unsigned)CH_HEAP_SL_COUNT - 1U;
+
+  return false;
+}
+
+/**
+ * @brief   Initializes the free lists of a heap.
+ */
+static void heap_lists_init(memory_heap_t *heapp) {
+  unsigned fl, sl;
+
+  heapp->h_flmap = 0U;
+  for (fl = 0U; fl < (unsigned)CH_HEAP_FL_COUNT; fl++) {
+    heapp->h_slmap[fl] = 0U;
+    for (sl = 0U; sl < (unsigned)CH_HEAP_SL_COUNT; sl++) {
+      heapp->h_lists[fl][sl] = NULL;
+    }
+  }
+}
+
+/**
+ * @brief   Inserts a block in the free list of its class.
+ */
+static void heap_insert(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  if (!heap_mapping(H_SIZE(hp), &fl, &sl)) {
+    /* Regions are validated so blocks are always within the classes.*/
+    chDbgAssert(false, "block too large");
+  }
+  hp->h.size |= H_FREE;
+  hp->h.u.next = heapp->h_lists[fl][sl];
+  H_PREV_FREE(hp) = NULL;
+  if (hp->h.u.next != NULL) {
+    H_PREV_FREE(hp->h.u.next) = hp;
+  }
+  heapp->h_lists[fl][sl] = hp;
+  heapp->h_flmap |= (uint32_t)1 << fl;
+  heapp->h_slmap[fl] |= (uint32_t)1 << sl;
+}
+
+/**
+ * @brief   Removes a block from the free list of its class.
+ */
+static void heap_remove(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  if (!heap_mapping(H_SIZE(hp), &fl, &sl)) {
+    chDbgAssert(false, "block too large");
+  }
+  if (H_PREV_FREE(hp) != NULL) {
+    H_PREV_FREE(hp)->h.u.next = hp->h.u.next;
+  }
+  else {
+    heapp->h_lists[fl][sl] = hp->h.u.next;
+    if (hp->h.u.next == NULL) {
+      heapp->h_slmap[fl] &= ~((uint32_t)1 << sl);
+      if (heapp->h_slmap[fl] == 0U) {
+        heapp->h_flmap &= ~((uint32_t)1 << fl);
+      }
+    }
+  }
+  if (hp->h.u.next != NULL) {
+    H_PREV_FREE(hp->h.u.next) = H_PREV_FREE(hp);
+  }
+  hp->h.size &= ~H_FREE;
+}
+
+/**
+ * @brief   Finds a free block of at least the specified size.
+ * @details The size is rounded up to the next class so that any block in
+ *          the found list is large enough, if there is no such block then
+ *          the first block of the exact class is checked too.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the requested size
+ * @return              A pointer to the free block.
+ * @retval NULL         if there is no free block large enough.
+ */
+static union heap_header *heap_find(memory_heap_t *heapp, size_t size) {
+  union heap_header *hp;
+  unsigned fl, sl;
+  uint32_t map;
+
+  if (size >= H_SMALL_SIZE) {
+    size_t rsize = size + ((size_t)1 << (bit_msb((uint32_t)size) -
+                                        (unsigned)CH_HEAP_SL_LOG2)) - 1U;
+
+    if (heap_mapping(rsize, &fl, &sl)) {
+      map = heapp->h_slmap[fl] & (~(uint32_t)0 << sl);
+      if (map == 0U) {
+        map = heapp->h_flmap & (~(uint32_t)0 << fl << 1);
+        if (map != 0U) {
+          fl = heap_lsb(map);
+          map = heapp->h_slmap[fl];
+        }
+      }
+      if (map != 0U) {
+        return heapp->h_lists[fl][heap_lsb(map)];
+      }
+    }
+  }
+  else {
+    if (!heap_mapping(size, &fl, &sl)) {
+      return NULL;
+    }
+    map = heapp->h_slmap[0] & (~(uint32_t)0 << sl);
+    if (map == 0U) {
+      map = heapp->h_flmap & ~(uint32_t)1;
+      if (map != 0U) {
+        fl = heap_lsb(map);
+        map = heapp->h_slmap[fl];
+      }
+    }
+    if (map != 0U) {
+      return heapp->h_lists[fl][heap_lsb(map)];
+    }
+    return NULL;
+  }
+
+  /* Last chance, the first block in the list of the exact class.*/
+  if (!heap_mapping(size, &fl, &sl)) {
+    return NULL;
+  }
+  hp = heapp->h_lists[fl][sl];
+  if ((hp != NULL) && (H_SIZE(hp) >= size)) {
+    return hp;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Makes a memory area a region of the heap.
+ * @details The area contains a block followed by a zero-sized sentinel
+ *          block marking the end of the region.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] buf       the memory area
+ * @param[in] size      the memory area size
+ * @return              The region block, not inserted in the free lists.
+ */
+static union heap_header *heap_region(memory_heap_t *heapp, void *buf,
+                                      size_t size) {
+  union heap_header *hp = buf, *sp;
+
+  hp->h.u.heap = heapp;
+  hp->h.size = size - (sizeof(union heap_header) * 2U);
+  hp->h.prev = NULL;
+  sp = H_NEXT_PHYS(hp);
+  sp->h.u.heap = heapp;
+  sp->h.size = 0;
+  sp->h.prev = hp;
+
+  return hp;
+}
+#endif /* CH_CFG_HEAP_TLSF */
+
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes the profiling data of a heap.
+ */
+static void heap_profile_init(memory_heap_t *heapp) {
+  heap_profile_t *hpp = &heapp->h_profile;
+  unsigned i;
+
+  hpp->hp_used = 0;
+  hpp->hp_max_used = 0;
+  hpp->hp_allocs = (ucnt_t)0;
+  hpp->hp_frees = (ucnt_t)0;
+  hpp->hp_failures = (ucnt_t)0;
+  for (i = 0U; i < (unsigned)CH_HEAP_PROFILE_BUCKETS; i++) {
+    hpp->hp_hist[i] = 0;
+  }
+  for (i = 0U; i < (unsigned)CH_CFG_HEAP_PROFILE_SITES; i++) {
+    hpp->hp_sites[i].hs_tag = NULL;
+    hpp->hp_sites[i].hs_blocks = 0;
+    hpp->hp_sites[i].hs_bytes = 0;
+  }
+}
+
+/**
+ * @brief   Returns the histogram bucket of a block size.
+ */
+static unsigned heap_bucket(size_t size) {
+  unsigned i = 0U;
+
+  while ((i < ((unsigned)CH_HEAP_PROFILE_BUCKETS - 1U)) &&
+         (size > ((size_t)16 << i))) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * @brief   Returns the sites table entry of a call site tag.
+ * @details A free entry is assigned to a new tag, the site zero is returned
+ *          for untagged allocations or if the table is full.
+ * @pre     Must be called from within a critical zone.
+ */
+static size_t heap_site(heap_profile_t *hpp, const void *tag) {
+  size_t i, free = 0;
+
+  if (tag == NULL) {
+    return 0;
+  }
+
+  for (i = 1; i < (size_t)CH_CFG_HEAP_PROFILE_SITES; i++) {
+    if (hpp->hp_sites[i].hs_tag == tag) {
+      return i;
+    }
+    if ((free == 0) && (hpp->hp_sites[i].hs_blocks == 0)) {
+      free = i;
+    }
+  }
+  if (free != 0) {
+    hpp->hp_sites[free].hs_tag = tag;
+  }
+
+  return free;
+}
+
+#if (CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Records an event into the heap trace buffer.
+ * @pre     Must be called from within a critical zone.
+ */
+static void heap_trace(uint8_t type, memory_heap_t *heapp,
+                       void *p, size_t size, const void *tag) {
+  heap_trace_event_t *hep = &ch_heap_trace.ht_buffer[ch_heap_trace.ht_next];
+
+  hep->he_time = chVTGetSystemTimeX();
+  hep->he_type = type;
+  hep->he_tp   = currp;
+  hep->he_heap = heapp;
+  hep->he_ptr  = p;
+  hep->he_size = size;
+  hep->he_tag  = tag;
+  if (++ch_heap_trace.ht_next >= ch_heap_trace.ht_size) {
+    ch_heap_trace.ht_next = 0U;
+  }
+  ch_heap_trace.ht_events++;
+}
+#else
+#define heap_trace(type, heapp, p, size, tag)
+#endif
+
+/**
+ * @brief   Accounts an allocated block.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        the block header
+ * @param[in] tag       the call site tag or @p NULL
+ */
+static void heap_profile_alloc(memory_heap_t *heapp, union heap_header *hp,
+                               const void *tag) {
+  heap_profile_t *hpp = &heapp->h_profile;
+  size_t site;
+
+  chSysLock();
+  site = heap_site(hpp, tag);
+  hp->h.site = site;
+  hpp->hp_sites[site].hs_blocks++;
+  hpp->hp_sites[site].hs_bytes += hp->h.size;
+  hpp->hp_hist[heap_bucket(hp->h.size)]++;
+  hpp->hp_allocs++;
+  hpp->hp_used += hp->h.size;
+  if (hpp->hp_used > hpp->hp_max_used) {
+    hpp->hp_max_used = hpp->hp_used;
+  }
+  heap_trace(CH_HEAP_TRACE_ALLOC, heapp, (void *)(hp + 1), hp->h.size, tag);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Accounts a block about to be released.
+ *
+ * @param[in] hp        the block header
+ */
+static void heap_profile_free(union heap_header *hp) {
+  heap_profile_t *hpp = &hp->h.u.heap->h_profile;
+
+  chSysLock();
+  hpp->hp_sites[hp->h.site].hs_blocks--;
+  hpp->hp_sites[hp->h.site].hs_bytes -= hp->h.size;
+  hpp->hp_hist[heap_bucket(hp->h.size)]--;
+  hpp->hp_frees++;
+  hpp->hp_used -= hp->h.size;
+  heap_trace(CH_HEAP_TRACE_FREE, hp->h.u.heap, (void *)(hp + 1), hp->h.size,
+             hpp->hp_sites[hp->h.site].hs_tag);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Accounts a failed allocation.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the requested size
+ * @param[in] tag       the call site tag or @p NULL
+ */
+static void heap_profile_fail(memory_heap_t *heapp, size_t size,
+                              const void *tag) {
+
+  chSysLock();
+  heapp->h_profile.hp_failures++;
+  heap_trace(CH_HEAP_TRACE_FAIL, heapp, NULL, size, tag);
+  chSysUnlock();
+}
+#endif /* CH_CFG_HEAP_PROFILE */
+
+/**
+ * @brief   Aligns and validates the size of a block to be allocated.
+ *
+ * @param[in,out] sizep pointer to the requested size
+ * @return              The operation status.
+ * @retval false        if the size cannot be allocated from free lists.
+ */
+static bool heap_align_size(size_t *sizep) {
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  unsigned fl, sl;
+
+  *sizep = MEM_ALIGN_NEXT(*sizep);
+  if (*sizep < H_MIN_SIZE) {
+    *sizep = H_MIN_SIZE;
+  }
+  return heap_mapping(*sizep, &fl, &sl);
+#else
+  *sizep = MEM_ALIGN_NEXT(*sizep);
+  return true;
+#endif
+}
+
+/**
+ * @brief   Takes a block from the free blocks of a heap.
+ * @pre     The heap must be locked.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the aligned block size
+ * @return              The block header.
+ * @retval NULL         if there is no free block large enough.
+ */
+static union heap_header *heap_take(memory_heap_t *heapp, size_t size) {
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  union heap_header *hp, *fp;
+
+  hp = heap_find(heapp, size);
+  if (hp != NULL) {
+    heap_remove(heapp, hp);
+    if (H_SIZE(hp) >= size + sizeof(union heap_header) + H_MIN_SIZE) {
+      /* Block bigger enough, must split it, the remainder cannot have a
+         free physical neighbor.*/
+      fp = (union heap_header *)((uint8_t *)(hp + 1) + size);
+      fp->h.size = H_SIZE(hp) - sizeof(union heap_header) - size;
+      fp->h.prev = hp;
+      H_NEXT_PHYS(fp)->h.prev = fp;
+      hp->h.size = size;
+      heap_insert(heapp, fp);
+    }
+    hp->h.u.heap = heapp;
+  }
+
+  return hp;
+#else
+  union heap_header *qp, *hp, *fp;
+
+  qp = &heapp->h_free;
+  while (qp->h.u.next != NULL) {
+    hp = qp->h.u.next;
+    if (hp->h.size >= size) {
+      if (hp->h.size < size + sizeof(union heap_header)) {
+        /* Gets the whole block even if it is slightly bigger than the
+           requested size because the fragment would be too small to be
+           useful.*/
+        qp->h.u.next = hp->h.u.next;
+      }
+      else {
+        /* Block bigger enough, must split it.*/
+        fp = (void *)((uint8_t *)(hp) + sizeof(union heap_header) + size);
+        fp->h.u.next = hp->h.u.next;
+        fp->h.size = hp->h.size - sizeof(union heap_header) - size;
+        qp->h.u.next = fp;
+        hp->h.size = size;
+      }
+      hp->h.u.heap = heapp;
+
+      return hp;
+    }
+    qp = hp;
+  }
+
+  return NULL;
+#endif
+}
+
+/**
+ * @brief   Gets a block from the memory provider of a heap.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the aligned block size
+ * @return              The block header.
+ * @retval NULL         if the heap has no provider or the provider failed.
+ */
+static union heap_header *heap_provide(memory_heap_t *heapp, size_t size) {
+  union heap_header *hp;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  unsigned fl, sl;
+#endif
+
+  if (heapp->h_provider == NULL) {
+    return NULL;
+  }
+
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  /* The new block is a region on its own, it must be within the classes
+     in order to be freed later.*/
+  if (!heap_mapping(size, &fl, &sl)) {
+    return NULL;
+  }
+  hp = heapp->h_provider(size + (sizeof(union heap_header) * 2U));
+  if (hp != NULL) {
+    hp = heap_region(heapp, hp, size + (sizeof(union heap_header) * 2U));
+  }
+#else
+  hp = heapp->h_provider(size + sizeof(union heap_header));
+  if (hp != NULL) {
+    hp->h.u.heap = heapp;
+    hp->h.size = size;
+  }
+#endif
+
+  return hp;
+}
+
+/**
+ * @brief   Allocates a block of memory from a heap.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] tag       the call site tag or @p NULL
+ * @return              A pointer to the allocated block.
+ * @retval NULL         if the block cannot be allocated.
+ */
+static void *heap_alloc(memory_heap_t *heapp, size_t size, const void *tag) {
+  union heap_header *hp;
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  if (!heap_align_size(&size)) {
+    heap_profile_fail(heapp, size, tag);
+    return NULL;
+  }
+
+  H_LOCK(heapp);
+  hp = heap_take(heapp, size);
+  H_UNLOCK(heapp);
+
+  /* More memory is required, tries to get it from the associated provider
+     else fails.*/
+  if (hp == NULL) {
+    hp = heap_provide(heapp, size);
+    if (hp == NULL) {
+      heap_profile_fail(heapp, size, tag);
+      return NULL;
+    }
+  }
+  heap_profile_alloc(heapp, hp, tag);
+
+  return (void *)(hp + 1);
+}
+
+#define LIMIT(p) (union heap_header *)((uint8_t *)(p) + \
+                                        sizeof(union heap_header) + \
+                                        (p)->h.size)
+
+/**
+ * @brief   Returns a block to the free blocks of its heap.
+ * @pre     The heap must be locked.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        the block header
+ */
+static void heap_release(memory_heap_t *heapp, union heap_header *hp) {
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  union heap_header *qp;
+
+  chDbgAssert(!H_IS_FREE(hp), "already free");
+
+  qp = H_NEXT_PHYS(hp);
+  if (H_IS_FREE(qp)) {
+    /* Merge with the next block.*/
+    heap_remove(heapp, qp);
+    hp->h.size += qp->h.size + sizeof(union heap_header);
+    H_NEXT_PHYS(hp)->h.prev = hp;
+  }
+  qp = hp->h.prev;
+  if ((qp != NULL) && H_IS_FREE(qp)) {
+    /* Merge with the previous block.*/
+    heap_remove(heapp, qp);
+    qp->h.size += hp->h.size + sizeof(union heap_header);
+    H_NEXT_PHYS(qp)->h.prev = qp;
+    hp = qp;
+  }
+  heap_insert(heapp, hp);
+#else
+  union heap_header *qp;
+
+  qp = &heapp->h_free;
+  while (true) {
+    chDbgAssert((hp < qp) || (hp >= LIMIT(qp)), "within free block");
+
+    if (((qp == &heapp->h_free) || (hp > qp)) &&
+        ((qp->h.u.next == NULL) || (hp < qp->h.u.next))) {
+      /* Insertion after qp.*/
+      hp->h.u.next = qp->h.u.next;
+      qp->h.u.next = hp;
+      /* Verifies if the newly inserted block should be merged.*/
+      if (LIMIT(hp) == hp->h.u.next) {
+        /* Merge with the next block.*/
+        hp->h.size += hp->h.u.next->h.size + sizeof(union heap_header);
+        hp->h.u.next = hp->h.u.next->h.u.next;
+      }
+      if ((LIMIT(qp) == hp)) {
+        /* Merge with the previous block.*/
+        qp->h.size += hp->h.size + sizeof(union heap_header);
+        qp->h.u.next = hp->h.u.next;
+      }
+      break;
+    }
+    qp = qp->h.u.next;
+  }
+#endif
+}
+
+/**
+ * @brief   Splits an allocated block in two allocated blocks.
+ * @pre     The heap must be locked.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        the block header
+ * @param[in] size      the new size of the block, the remainder must be at
+ *                      least @p H_MIN_FRAG bytes
+ * @return              The remainder block header.
+ */
+static union heap_header *heap_split(memory_heap_t *heapp,
+                                     union heap_header *hp, size_t size) {
+  union heap_header *np;
+
+  np = (union heap_header *)((uint8_t *)(hp + 1) + size);
+  np->h.u.heap = heapp;
+  np->h.size = H_SIZE(hp) - size - sizeof(union heap_header);
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  np->h.prev = hp;
+  H_NEXT_PHYS(np)->h.prev = np;
+#endif
+  hp->h.size = size;
+
+  return np;
+}
+
+/**
+ * @brief   Trims an allocated block to an aligned block.
+ * @details The memory before the first suitably aligned address and the
+ *          memory after the requested size are returned to the free
+ *          blocks.
+ * @pre     The heap must be locked.
+ * @pre     The block must be at least <tt>size + align + H_MIN_FRAG -
+ *          MEM_ALIGN_SIZE</tt> bytes large.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        the block header
+ * @param[in] size      the aligned block size
+ * @param[in] align     the block alignment
+ * @return              The aligned block header.
+ */
+static union heap_header *heap_trim(memory_heap_t *heapp,
+                                    union heap_header *hp,
+                                    size_t size, size_t align) {
+  union heap_header *np;
+  uint8_t *p = (uint8_t *)(hp + 1);
+
+  if (((size_t)p & (align - 1U)) != 0U) {
+    /* The leading fragment must be large enough to be a block.*/
+    p = (uint8_t *)(((size_t)p + H_MIN_FRAG + align - 1U) & ~(align - 1U));
+    np = heap_split(heapp, hp, (size_t)(p - (uint8_t *)(hp + 1)) -
+                               sizeof(union heap_header));
+    heap_release(heapp, hp);
+    hp = np;
+  }
+  if (H_SIZE(hp) >= size + H_MIN_FRAG) {
+    np = heap_split(heapp, hp, size);
+    heap_release(heapp, np);
+  }
+
+  return hp;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -84,13 +804,12 @@ static memory_heap_t default_heap;
  */
 void _heap_init(void) {
 
-  default_heap.h_provider = chCoreAlloc;
-  default_heap.h_free.h.u.next = (union heap_header *)NULL;
-  default_heap.h_free.h.size = 0;
-#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
-  chMtxObjectInit(&default_heap.h_mtx);
-#else
-  chSemObjectInit(&default_heap.h_sem, 1);
+  chHeapObjectInitProvider(&default_heap, chCoreAlloc);
+#if (CH_CFG_HEAP_PROFILE && (CH_CFG_HEAP_TRACE_BUFFER_SIZE > 0)) ||           \
+    defined(__DOXYGEN__)
+  ch_heap_trace.ht_size = (uint32_t)CH_CFG_HEAP_TRACE_BUFFER_SIZE;
+  ch_heap_trace.ht_next = 0U;
+  ch_heap_trace.ht_events = 0U;
 #endif
 }
 
@@ -107,19 +826,71 @@ void _heap_init(void) {
  */
 void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
   union heap_header *hp;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  unsigned fl, sl;
+#endif
 
   chDbgCheck(MEM_IS_ALIGNED(buf) && MEM_IS_ALIGNED(size));
 
   heapp->h_provider = (memgetfunc_t)NULL;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  chDbgCheck(size >= (sizeof(union heap_header) * 2U) + H_MIN_SIZE);
+
+  heap_lists_init(heapp);
+  hp = heap_region(heapp, buf, size);
+  if (heap_mapping(H_SIZE(hp), &fl, &sl)) {
+    heap_insert(heapp, hp);
+  }
+  else {
+    /* A region beyond the largest class is rejected, the heap is left
+       empty.*/
+    chDbgAssert(false, "heap too large");
+  }
+#else
   heapp->h_free.h.u.next = hp = buf;
   heapp->h_free.h.size = 0;
   hp->h.u.next = NULL;
   hp->h.size = size - sizeof(union heap_header);
+#endif
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
   chMtxObjectInit(&heapp->h_mtx);
 #else
   chSemObjectInit(&heapp->h_sem, 1);
 #endif
+  heap_profile_init(heapp);
+}
+
+/**
+ * @brief   Initializes an empty memory heap fed by a memory provider.
+ * @details The heap has no initial memory, blocks are requested from the
+ *          provider when no free block is large enough, for example
+ *          @p chCoreAllocFast() or @p chCoreAllocDMA() can be used in order
+ *          to create a heap allocating from a specific core memory region.
+ * @note    The provider is called outside any lock from thread context so
+ *          it must be a normal API, not an I-class function.
+ *
+ * @param[out] heapp    pointer to the memory heap descriptor to be initialized
+ * @param[in] provider  memory provider function
+ *
+ * @init
+ */
+void chHeapObjectInitProvider(memory_heap_t *heapp, memgetfunc_t provider) {
+
+  chDbgCheck((heapp != NULL) && (provider != NULL));
+
+  heapp->h_provider = provider;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  heap_lists_init(heapp);
+#else
+  heapp->h_free.h.u.next = (union heap_header *)NULL;
+  heapp->h_free.h.size = 0;
+#endif
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+  chMtxObjectInit(&heapp->h_mtx);
+#else
+  chSemObjectInit(&heapp->h_sem, 1);
+#endif
+  heap_profile_init(heapp);
 }
 
 /**
@@ -127,6 +898,9 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
  *          algorithm.
  * @details The allocated block is guaranteed to be properly aligned for a
  *          pointer data type (@p stkalign_t).
+ * @note    If @p CH_CFG_HEAP_TLSF is enabled then a good-fit algorithm is
+ *          used, the execution time does not depend on the number of free
+ *          blocks.
  *
  * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
  *                      access the default heap.
@@ -139,60 +913,151 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
  * @api
  */
 void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
-  union heap_header *qp, *hp, *fp;
+
+  return heap_alloc(heapp, size, H_CALLER());
+}
+
+/**
+ * @brief   Allocates a block of memory from the heap tagging its call site.
+ * @details The tag identifies the owner of the block in the heap profiling
+ *          data and trace, it is usually the address of a constant object
+ *          or string.
+ * @note    The tag is ignored if @p CH_CFG_HEAP_PROFILE is disabled.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] tag       the call site tag or @p NULL
+ * @return              A pointer to the allocated block.
+ * @retval NULL         if the block cannot be allocated.
+ *
+ * @api
+ */
+void *chHeapAllocTagged(memory_heap_t *heapp, size_t size, const void *tag) {
+
+  return heap_alloc(heapp, size, tag);
+}
+
+/**
+ * @brief   Allocates an aligned block of memory from the heap.
+ * @details A block large enough to contain an aligned block of the
+ *          requested size is taken from the heap then the memory before
+ *          and after the aligned block is returned to the free blocks.
+ * @note    The block is released using @p chHeapFree() like the other
+ *          blocks.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the block alignment, it must be a power of two
+ * @return              A pointer to the allocated block.
+ * @retval NULL         if the block cannot be allocated.
+ *
+ * @api
+ */
+void *chHeapAllocAligned(memory_heap_t *heapp, size_t size, size_t align) {
+  union heap_header *hp;
+  const void *tag = H_CALLER();
+  size_t total;
+
+  chDbgCheck((align > 0U) && ((align & (align - 1U)) == 0U));
+
+  if (align <= MEM_ALIGN_SIZE) {
+    return heap_alloc(heapp, size, tag);
+  }
 
   if (heapp == NULL)
     heapp = &default_heap;
 
-  size = MEM_ALIGN_NEXT(size);
-  qp = &heapp->h_free;
+  total = size + H_MIN_FRAG + align - MEM_ALIGN_SIZE;
+  if (!heap_align_size(&size) || !heap_align_size(&total)) {
+    heap_profile_fail(heapp, size, tag);
+    return NULL;
+  }
 
   H_LOCK(heapp);
-  while (qp->h.u.next != NULL) {
-    hp = qp->h.u.next;
-    if (hp->h.size >= size) {
-      if (hp->h.size < size + sizeof(union heap_header)) {
-        /* Gets the whole block even if it is slightly bigger than the
-           requested size because the fragment would be too small to be
-           useful.*/
-        qp->h.u.next = hp->h.u.next;
-      }
-      else {
-        /* Block bigger enough, must split it.*/
-        fp = (void *)((uint8_t *)(hp) + sizeof(union heap_header) + size);
-        fp->h.u.next = hp->h.u.next;
-        fp->h.size = hp->h.size - sizeof(union heap_header) - size;
-        qp->h.u.next = fp;
-        hp->h.size = size;
-      }
-      hp->h.u.heap = heapp;
-      H_UNLOCK(heapp);
+  hp = heap_take(heapp, total);
+  if (hp != NULL) {
+    hp = heap_trim(heapp, hp, size, align);
+  }
+  H_UNLOCK(heapp);
 
-      return (void *)(hp + 1);
+  if (hp == NULL) {
+    hp = heap_provide(heapp, total);
+    if (hp == NULL) {
+      heap_profile_fail(heapp, size, tag);
+      return NULL;
     }
-    qp = hp;
+    H_LOCK(heapp);
+    hp = heap_trim(heapp, hp, size, align);
+    H_UNLOCK(heapp);
   }
-  H_UNLOCK(heapp);
+  heap_profile_alloc(heapp, hp, tag);
 
-  /* More memory is required, tries to get it from the associated provider
-     else fails.*/
-  if (heapp->h_provider) {
-    hp = heapp->h_provider(size + sizeof(union heap_header));
-    if (hp != NULL) {
-      hp->h.u.heap = heapp;
-      hp->h.size = size;
-      hp++;
+  return (void *)(hp + 1);
+}
+
+/**
+ * @brief   Allocates a batch of blocks of the same size from the heap.
+ * @details The heap is locked once for the whole batch, the blocks that
+ *          cannot be taken from the free blocks are requested to the heap
+ *          provider, if any.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] size      the size of the blocks to be allocated
+ * @param[out] objs     array receiving the pointers to the allocated blocks
+ * @param[in] n         number of blocks to be allocated
+ * @return              The number of allocated blocks, it can be less
+ *                      than @p n if the heap is exhausted.
+ *
+ * @api
+ */
+size_t chHeapAllocBatch(memory_heap_t *heapp, size_t size,
+                        void *objs[], size_t n) {
+  union heap_header *hp;
+  size_t i;
+#if CH_CFG_HEAP_PROFILE
+  const void *tag = H_CALLER();
+  size_t k;
+#endif
+
+  chDbgCheck(objs != NULL);
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  if (!heap_align_size(&size)) {
+    heap_profile_fail(heapp, size, tag);
+    return 0;
+  }
+
+  H_LOCK(heapp);
+  for (i = 0; i < n; i++) {
+    hp = heap_take(heapp, size);
+    if (hp == NULL)
+      break;
+    objs[i] = (void *)(hp + 1);
+  }
+  H_UNLOCK(heapp);
 
-      return (void *)hp;
+  for (; i < n; i++) {
+    hp = heap_provide(heapp, size);
+    if (hp == NULL) {
+      heap_profile_fail(heapp, size, tag);
+      break;
     }
+    objs[i] = (void *)(hp + 1);
   }
 
-  return NULL;
-}
+#if CH_CFG_HEAP_PROFILE
+  for (k = 0; k < i; k++) {
+    heap_profile_alloc(heapp, (union heap_header *)objs[k] - 1, tag);
+  }
+#endif
 
-#define LIMIT(p) (union heap_header *)((uint8_t *)(p) + \
-                                        sizeof(union heap_header) + \
-                                        (p)->h.size)
+  return i;
+}
 
 /**
  * @brief   Frees a previously allocated memory block.
@@ -202,42 +1067,50 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
  * @api
  */
 void chHeapFree(void *p) {
-  union heap_header *qp, *hp;
+  union heap_header *hp;
   memory_heap_t *heapp;
 
   chDbgCheck(p != NULL);
 
   hp = (union heap_header *)p - 1;
   heapp = hp->h.u.heap;
-  qp = &heapp->h_free;
+  heap_profile_free(hp);
 
   H_LOCK(heapp);
-  while (true) {
-    chDbgAssert((hp < qp) || (hp >= LIMIT(qp)), "within free block");
+  heap_release(heapp, hp);
+  H_UNLOCK(heapp);
+}
 
-    if (((qp == &heapp->h_free) || (hp > qp)) &&
-        ((qp->h.u.next == NULL) || (hp < qp->h.u.next))) {
-      /* Insertion after qp.*/
-      hp->h.u.next = qp->h.u.next;
-      qp->h.u.next = hp;
-      /* Verifies if the newly inserted block should be merged.*/
-      if (LIMIT(hp) == hp->h.u.next) {
-        /* Merge with the next block.*/
-        hp->h.size += hp->h.u.next->h.size + sizeof(union heap_header);
-        hp->h.u.next = hp->h.u.next->h.u.next;
-      }
-      if ((LIMIT(qp) == hp)) {
-        /* Merge with the previous block.*/
-        qp->h.size += hp->h.size + sizeof(union heap_header);
-        qp->h.u.next = hp->h.u.next;
-      }
-      break;
-    }
-    qp = qp->h.u.next;
+/**
+ * @brief   Frees a batch of previously allocated memory blocks.
+ * @details The heap is locked once for the whole batch.
+ * @pre     All the blocks must belong to the same heap.
+ *
+ * @param[in] objs      array of pointers to the memory blocks to be freed
+ * @param[in] n         number of blocks to be freed
+ *
+ * @api
+ */
+void chHeapFreeBatch(void *objs[], size_t n) {
+  union heap_header *hp;
+  memory_heap_t *heapp;
+  size_t i;
+
+  chDbgCheck(objs != NULL);
+
+  if (n == 0)
+    return;
+
+  heapp = ((union heap_header *)objs[0] - 1)->h.u.heap;
+
+  H_LOCK(heapp);
+  for (i = 0; i < n; i++) {
+    hp = (union heap_header *)objs[i] - 1;
+    chDbgAssert(hp->h.u.heap == heapp, "different heaps");
+    heap_profile_free(hp);
+    heap_release(heapp, hp);
   }
   H_UNLOCK(heapp);
-
-  return;
 }
 
 /**
@@ -256,6 +1129,9 @@ void chHeapFree(void *p) {
 size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
   union heap_header *qp;
   size_t n, sz;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  unsigned fl, sl;
+#endif
 
   if (heapp == NULL) {
     heapp = &default_heap;
@@ -263,9 +1139,20 @@ size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
 
   H_LOCK(heapp);
   sz = 0;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  n = 0;
+  for (fl = 0U; fl < (unsigned)CH_HEAP_FL_COUNT; fl++) {
+    for (sl = 0U; sl < (unsigned)CH_HEAP_SL_COUNT; sl++) {
+      for (qp = heapp->h_lists[fl][sl]; qp != NULL; n++, qp = qp->h.u.next) {
+        sz += H_SIZE(qp);
+      }
+    }
+  }
+#else
   for (n = 0, qp = &heapp->h_free; qp->h.u.next; n++, qp = qp->h.u.next) {
     sz += qp->h.u.next->h.size;
   }
+#endif
   if (sizep) {
     *sizep = sz;
   }
@@ -274,6 +1161,95 @@ size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
   return n;
 }
 
+/**
+ * @brief   Returns the size of the largest free block of a heap.
+ * @details It is the largest block that can be allocated without
+ *          requesting more memory to the heap provider.
+ * @note    If @p CH_CFG_HEAP_TLSF is enabled then an allocation of the
+ *          returned size could fail because the free lists are only
+ *          searched for blocks of a class large enough.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @return              The size of the largest free block.
+ *
+ * @api
+ */
+size_t chHeapGetLargestFree(memory_heap_t *heapp) {
+  union heap_header *qp;
+  size_t sz;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  unsigned fl;
+#endif
+
+  if (heapp == NULL) {
+    heapp = &default_heap;
+  }
+
+  H_LOCK(heapp);
+  sz = 0;
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  /* The largest block is in the list of the largest non-empty class.*/
+  if (heapp->h_flmap != 0U) {
+    fl = bit_msb(heapp->h_flmap);
+    qp = heapp->h_lists[fl][bit_msb(heapp->h_slmap[fl])];
+    for (; qp != NULL; qp = qp->h.u.next) {
+      if (H_SIZE(qp) > sz) {
+        sz = H_SIZE(qp);
+      }
+    }
+  }
+#else
+  for (qp = heapp->h_free.h.u.next; qp != NULL; qp = qp->h.u.next) {
+    if (qp->h.size > sz) {
+      sz = qp->h.size;
+    }
+  }
+#endif
+  H_UNLOCK(heapp);
+
+  return sz;
+}
+
+/**
+ * @brief   Returns the default heap descriptor.
+ * @details The returned pointer is the owner recorded in the headers of
+ *          the blocks allocated using a @p NULL heap pointer.
+ *
+ * @return              Pointer to the default heap descriptor.
+ *
+ * @xclass
+ */
+memory_heap_t *chHeapGetDefaultX(void) {
+
+  return &default_heap;
+}
+
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the profiling data of a heap.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[out] hpp      pointer to a @p heap_profile_t structure receiving a
+ *                      copy of the profiling data
+ *
+ * @api
+ */
+void chHeapGetProfile(memory_heap_t *heapp, heap_profile_t *hpp) {
+
+  chDbgCheck(hpp != NULL);
+
+  if (heapp == NULL) {
+    heapp = &default_heap;
+  }
+
+  chSysLock();
+  *hpp = heapp->h_profile;
+  chSysUnlock();
+}
+#endif /* CH_CFG_HEAP_PROFILE */
+
 #endif /* CH_CFG_USE_HEAP */
 
 /** @} */
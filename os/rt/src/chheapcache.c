@@ -0,0 +1,339 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chheapcache.c
+ * @brief   Heap caches code.
+ *
+ * @addtogroup heap_caches
+ * @details Per-thread small objects caches in front of the heap.
+ *          <h2>Operation mode</h2>
+ *          A heap cache holds heap blocks of a few fixed sizes, one
+ *          @p memory_pool_t for each size class. A thread binds a cache
+ *          using @p chHeapCacheBind() then the @p chHeapCacheAlloc() and
+ *          @p chHeapCacheFree() functions use the cache of the calling
+ *          thread without locking the heap:
+ *          - An allocation is served by the pool of the smallest class
+ *            large enough, an empty pool is refilled with a batch of
+ *            blocks allocated from the heap with a single heap lock.
+ *          - A released block is returned to the pool of its class, when
+ *            a pool exceeds @p CH_CFG_HEAP_CACHE_LIMIT objects a batch is
+ *            returned to the heap with a single heap lock.
+ *          - Larger requests, blocks not matching a class and threads
+ *            without a cache fall back to the heap APIs.
+ *          .
+ *          The cached objects are regular heap blocks so they can also be
+ *          released using @p chHeapFree(), a block can be released by a
+ *          thread different from the one that allocated it.<br>
+ *          The cache keeps hit and miss counters and reports the memory it
+ *          holds using @p chHeapCacheStatus().
+ * @pre     In order to use the heap caches APIs the
+ *          @p CH_CFG_USE_HEAP_CACHE option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*
+ * Size of the objects in a class.
+ */
+#define HC_CLASS_SIZE(i)    ((size_t)CH_HEAP_CACHE_MIN_SIZE << (i))
+
+/*
+ * Size of a block, it is taken from the heap block header.
+ */
+#define HC_BLOCK_SIZE(p)    (((union heap_header *)(p) - 1)->h.size)
+
+/*
+ * Heap owning a block, it is taken from the heap block header.
+ */
+#define HC_BLOCK_HEAP(p)    (((union heap_header *)(p) - 1)->h.u.heap)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the smallest class able to contain an object.
+ *
+ * @param[in] size      the object size
+ * @return              The class index.
+ * @retval CH_HEAP_CACHE_CLASSES if the object is too large.
+ */
+static unsigned hc_class(size_t size) {
+  unsigned i;
+
+  for (i = 0U; i < (unsigned)CH_HEAP_CACHE_CLASSES; i++) {
+    if (size <= HC_CLASS_SIZE(i)) {
+      break;
+    }
+  }
+
+  return i;
+}
+
+/**
+ * @brief   Returns a batch of objects of a class to the heap.
+ *
+ * @param[in] hcp       pointer to the @p heap_cache_t object
+ * @param[in] i         the class index
+ * @param[in] n         maximum number of objects to be returned
+ */
+static void hc_drain(heap_cache_t *hcp, unsigned i, size_t n) {
+  void *objs[CH_CFG_HEAP_CACHE_BATCH];
+  size_t k;
+
+  chSysLock();
+  for (k = 0; k < n; k++) {
+    objs[k] = chPoolAllocI(&hcp->hc_pools[i]);
+    if (objs[k] == NULL) {
+      break;
+    }
+  }
+  hcp->hc_counts[i] -= k;
+  chSysUnlock();
+
+  chHeapFreeBatch(objs, k);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p heap_cache_t object.
+ *
+ * @param[out] hcp      pointer to a @p heap_cache_t structure
+ * @param[in] heapp     heap refilling the cache or @p NULL for the default
+ *                      heap
+ *
+ * @init
+ */
+void chHeapCacheObjectInit(heap_cache_t *hcp, memory_heap_t *heapp) {
+  unsigned i;
+
+  chDbgCheck(hcp != NULL);
+
+  if (heapp == NULL) {
+    heapp = chHeapGetDefaultX();
+  }
+  hcp->hc_heap = heapp;
+  for (i = 0U; i < (unsigned)CH_HEAP_CACHE_CLASSES; i++) {
+    chPoolObjectInit(&hcp->hc_pools[i], HC_CLASS_SIZE(i), NULL);
+    hcp->hc_counts[i] = 0;
+  }
+  hcp->hc_hits = (ucnt_t)0;
+  hcp->hc_misses = (ucnt_t)0;
+}
+
+/**
+ * @brief   Binds a heap cache to the current thread.
+ * @note    A cache can be bound to more threads only if they cannot
+ *          preempt each other while using it, for example threads at the
+ *          same priority level without round robin.
+ * @note    The cached objects are not released when the thread terminates,
+ *          use @p chHeapCacheFlush() before.
+ *
+ * @param[in] hcp       pointer to the @p heap_cache_t object or @p NULL in
+ *                      order to unbind the current cache
+ *
+ * @api
+ */
+void chHeapCacheBind(heap_cache_t *hcp) {
+
+  chSysLock();
+  currp->p_hcache = hcp;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Allocates an object using the cache of the current thread.
+ * @details The allocated object is guaranteed to be properly aligned for a
+ *          pointer data type (@p stkalign_t).
+ *
+ * @param[in] size      the size of the object to be allocated
+ * @return              A pointer to the allocated object.
+ * @retval NULL         if the object cannot be allocated.
+ *
+ * @api
+ */
+void *chHeapCacheAlloc(size_t size) {
+  heap_cache_t *hcp = currp->p_hcache;
+  void *objs[CH_CFG_HEAP_CACHE_BATCH];
+  size_t k, n;
+  unsigned i;
+  void *p;
+
+  if (hcp == NULL) {
+    return chHeapAlloc(NULL, size);
+  }
+
+  i = hc_class(size);
+  if (i >= (unsigned)CH_HEAP_CACHE_CLASSES) {
+    hcp->hc_misses++;
+    return chHeapAlloc(hcp->hc_heap, size);
+  }
+
+  chSysLock();
+  p = chPoolAllocI(&hcp->hc_pools[i]);
+  if (p != NULL) {
+    hcp->hc_counts[i]--;
+    hcp->hc_hits++;
+    chSysUnlock();
+
+    return p;
+  }
+  hcp->hc_misses++;
+  chSysUnlock();
+
+  /* Empty class, refilling it with a batch of objects, the first one is
+     returned to the caller.*/
+  n = chHeapAllocBatch(hcp->hc_heap, HC_CLASS_SIZE(i), objs,
+                       (size_t)CH_CFG_HEAP_CACHE_BATCH);
+  if (n == 0) {
+    return NULL;
+  }
+  chSysLock();
+  for (k = 1; k < n; k++) {
+    chPoolFreeI(&hcp->hc_pools[i], objs[k]);
+  }
+  hcp->hc_counts[i] += n - 1;
+  chSysUnlock();
+
+  return objs[0];
+}
+
+/**
+ * @brief   Frees an object using the cache of the current thread.
+ * @details The object is returned to the cache if it belongs to the cache
+ *          heap and its size matches one of the classes else it is returned
+ *          to its heap.
+ * @pre     The object must have been allocated using
+ *          @p chHeapCacheAlloc() or @p chHeapAlloc().
+ *
+ * @param[in] p         pointer to the object to be freed
+ *
+ * @api
+ */
+void chHeapCacheFree(void *p) {
+  heap_cache_t *hcp = currp->p_hcache;
+  unsigned i;
+
+  chDbgCheck(p != NULL);
+
+  if (hcp == NULL) {
+    chHeapFree(p);
+    return;
+  }
+
+  /* Blocks of other heaps must not be handed out by this cache.*/
+  if (HC_BLOCK_HEAP(p) != hcp->hc_heap) {
+    chHeapFree(p);
+    return;
+  }
+
+  i = hc_class(HC_BLOCK_SIZE(p));
+  if ((i >= (unsigned)CH_HEAP_CACHE_CLASSES) ||
+      (HC_BLOCK_SIZE(p) != HC_CLASS_SIZE(i))) {
+    chHeapFree(p);
+    return;
+  }
+
+  chSysLock();
+  chPoolFreeI(&hcp->hc_pools[i], p);
+  hcp->hc_counts[i]++;
+  chSysUnlock();
+
+  if (hcp->hc_counts[i] > (size_t)CH_CFG_HEAP_CACHE_LIMIT) {
+    hc_drain(hcp, i, (size_t)CH_CFG_HEAP_CACHE_BATCH);
+  }
+}
+
+/**
+ * @brief   Returns all the cached objects to the heap.
+ * @pre     The cache must not be in use by other threads.
+ *
+ * @param[in] hcp       pointer to the @p heap_cache_t object
+ *
+ * @api
+ */
+void chHeapCacheFlush(heap_cache_t *hcp) {
+  unsigned i;
+
+  chDbgCheck(hcp != NULL);
+
+  for (i = 0U; i < (unsigned)CH_HEAP_CACHE_CLASSES; i++) {
+    while (hcp->hc_counts[i] > 0) {
+      hc_drain(hcp, i, (size_t)CH_CFG_HEAP_CACHE_BATCH);
+    }
+  }
+}
+
+/**
+ * @brief   Reports the heap cache status.
+ *
+ * @param[in] hcp       pointer to the @p heap_cache_t object
+ * @param[in] sizep     pointer to a variable that will receive the total
+ *                      size of the cached objects or @p NULL
+ * @return              The number of cached objects.
+ *
+ * @api
+ */
+size_t chHeapCacheStatus(heap_cache_t *hcp, size_t *sizep) {
+  size_t n, sz;
+  unsigned i;
+
+  chDbgCheck(hcp != NULL);
+
+  n = 0;
+  sz = 0;
+  chSysLock();
+  for (i = 0U; i < (unsigned)CH_HEAP_CACHE_CLASSES; i++) {
+    n += hcp->hc_counts[i];
+    sz += hcp->hc_counts[i] * HC_CLASS_SIZE(i);
+  }
+  chSysUnlock();
+  if (sizep != NULL) {
+    *sizep = sz;
+  }
+
+  return n;
+}
+
+#endif /* CH_CFG_USE_HEAP_CACHE */
+
+/** @} */
@@ -43,7 +43,10 @@
  *          possible approach is to allocate memory (from a memory pool for
  *          example) from the posting side and free it on the fetching side.
  *          Another approach is to set a "done" flag into the structure pointed
- *          by the message.
+ *          by the message.<br>
+ *          The <b>Post Many</b> and <b>Fetch Many</b> operations transfer
+ *          a block of messages adjusting the semaphores once, a consumer
+ *          can drain the mailbox in a single call.
  * @pre     In order to use the mailboxes APIs the @p CH_CFG_USE_MAILBOXES option
  *          must be enabled in @p chconf.h.
  * @{
@@ -69,6 +72,87 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Reserves free slots for posting.
+ * @details One slot has already been obtained by the caller, up to
+ *          @p n - 1 further slots are taken if immediately available.
+ *
+ * @param[in] sp        pointer to the semaphore counting the slots
+ * @param[in] n         number of slots required
+ * @return              The number of slots reserved, including the one
+ *                      already obtained.
+ */
+static cnt_t mb_take_more(semaphore_t *sp, cnt_t n) {
+  cnt_t k = chSemGetCounterI(sp);
+
+  if (k > n - 1) {
+    k = n - 1;
+  }
+  if (k <= 0) {
+    return 1;
+  }
+
+  /* The counter is positive so there are no waiting threads, the counter
+     can be adjusted directly.*/
+  sp->s_cnt -= k;
+
+  return k + 1;
+}
+
+/**
+ * @brief   Copies messages into the mailbox buffer.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[in] msgs      the messages to be copied
+ * @param[in] n         number of messages
+ */
+static void mb_write(mailbox_t *mbp, const msg_t *msgs, cnt_t n) {
+  msg_t *wrptr = mbp->mb_wrptr;
+  cnt_t n1 = (cnt_t)(mbp->mb_top - wrptr);
+
+  /* Copy in two parts if the buffer end is crossed.*/
+  if (n >= n1) {
+    n -= n1;
+    while (n1 > 0) {
+      *wrptr++ = *msgs++;
+      n1--;
+    }
+    wrptr = mbp->mb_buffer;
+  }
+  while (n > 0) {
+    *wrptr++ = *msgs++;
+    n--;
+  }
+  mbp->mb_wrptr = wrptr;
+}
+
+/**
+ * @brief   Copies messages from the mailbox buffer.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[out] msgs     the buffer receiving the messages
+ * @param[in] n         number of messages
+ */
+static void mb_read(mailbox_t *mbp, msg_t *msgs, cnt_t n) {
+  msg_t *rdptr = mbp->mb_rdptr;
+  cnt_t n1 = (cnt_t)(mbp->mb_top - rdptr);
+
+  /* Copy in two parts if the buffer end is crossed.*/
+  if (n >= n1) {
+    n -= n1;
+    while (n1 > 0) {
+      *msgs++ = *rdptr++;
+      n1--;
+    }
+    rdptr = mbp->mb_buffer;
+  }
+  while (n > 0) {
+    *msgs++ = *rdptr++;
+    n--;
+  }
+  mbp->mb_rdptr = rdptr;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -426,6 +510,202 @@ msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp) {
 
   return MSG_OK;
 }
+
+/**
+ * @brief   Posts a block of messages into a mailbox.
+ * @details The invoking thread waits until at least an empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          all the messages that fit into the free slots are posted.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[in] msgs      the messages to be posted on the mailbox
+ * @param[in] n         number of messages to be posted
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of messages posted.
+ * @retval 0            if the operation has timed out or the mailbox has
+ *                      been reset while waiting.
+ *
+ * @api
+ */
+cnt_t chMBPostMany(mailbox_t *mbp, const msg_t *msgs, cnt_t n,
+                   systime_t time) {
+  cnt_t k;
+
+  chSysLock();
+  k = chMBPostManyS(mbp, msgs, n, time);
+  chSysUnlock();
+
+  return k;
+}
+
+/**
+ * @brief   Posts a block of messages into a mailbox.
+ * @details The invoking thread waits until at least an empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          all the messages that fit into the free slots are posted.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[in] msgs      the messages to be posted on the mailbox
+ * @param[in] n         number of messages to be posted
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of messages posted.
+ * @retval 0            if the operation has timed out or the mailbox has
+ *                      been reset while waiting.
+ *
+ * @sclass
+ */
+cnt_t chMBPostManyS(mailbox_t *mbp, const msg_t *msgs, cnt_t n,
+                    systime_t time) {
+  cnt_t k;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0));
+
+  if (chSemWaitTimeoutS(&mbp->mb_emptysem, time) != MSG_OK) {
+    return 0;
+  }
+  k = mb_take_more(&mbp->mb_emptysem, n);
+  mb_write(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_fullsem, k);
+  chSchRescheduleS();
+
+  return k;
+}
+
+/**
+ * @brief   Posts a block of messages into a mailbox.
+ * @details This variant is non-blocking, the messages that fit into the
+ *          free slots are posted.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[in] msgs      the messages to be posted on the mailbox
+ * @param[in] n         number of messages to be posted
+ * @return              The number of messages posted.
+ * @retval 0            if the mailbox is full.
+ *
+ * @iclass
+ */
+cnt_t chMBPostManyI(mailbox_t *mbp, const msg_t *msgs, cnt_t n) {
+  cnt_t k;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0));
+
+  if (chSemGetCounterI(&mbp->mb_emptysem) <= 0) {
+    return 0;
+  }
+  chSemFastWaitI(&mbp->mb_emptysem);
+  k = mb_take_more(&mbp->mb_emptysem, n);
+  mb_write(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_fullsem, k);
+
+  return k;
+}
+
+/**
+ * @brief   Retrieves a block of messages from a mailbox.
+ * @details The invoking thread waits until at least a message is posted in
+ *          the mailbox or the specified time runs out, then all the queued
+ *          messages are fetched up to the specified number.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[out] msgs     the buffer receiving the messages
+ * @param[in] n         maximum number of messages to be fetched
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of messages fetched.
+ * @retval 0            if the operation has timed out or the mailbox has
+ *                      been reset while waiting.
+ *
+ * @api
+ */
+cnt_t chMBFetchMany(mailbox_t *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chSysLock();
+  k = chMBFetchManyS(mbp, msgs, n, time);
+  chSysUnlock();
+
+  return k;
+}
+
+/**
+ * @brief   Retrieves a block of messages from a mailbox.
+ * @details The invoking thread waits until at least a message is posted in
+ *          the mailbox or the specified time runs out, then all the queued
+ *          messages are fetched up to the specified number.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[out] msgs     the buffer receiving the messages
+ * @param[in] n         maximum number of messages to be fetched
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of messages fetched.
+ * @retval 0            if the operation has timed out or the mailbox has
+ *                      been reset while waiting.
+ *
+ * @sclass
+ */
+cnt_t chMBFetchManyS(mailbox_t *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0));
+
+  if (chSemWaitTimeoutS(&mbp->mb_fullsem, time) != MSG_OK) {
+    return 0;
+  }
+  k = mb_take_more(&mbp->mb_fullsem, n);
+  mb_read(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_emptysem, k);
+  chSchRescheduleS();
+
+  return k;
+}
+
+/**
+ * @brief   Retrieves a block of messages from a mailbox.
+ * @details This variant is non-blocking, the queued messages are fetched
+ *          up to the specified number.
+ *
+ * @param[in] mbp       the pointer to an initialized @p mailbox_t object
+ * @param[out] msgs     the buffer receiving the messages
+ * @param[in] n         maximum number of messages to be fetched
+ * @return              The number of messages fetched.
+ * @retval 0            if the mailbox is empty.
+ *
+ * @iclass
+ */
+cnt_t chMBFetchManyI(mailbox_t *mbp, msg_t *msgs, cnt_t n) {
+  cnt_t k;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0));
+
+  if (chSemGetCounterI(&mbp->mb_fullsem) <= 0) {
+    return 0;
+  }
+  chSemFastWaitI(&mbp->mb_fullsem);
+  k = mb_take_more(&mbp->mb_fullsem, n);
+  mb_read(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_emptysem, k);
+
+  return k;
+}
 #endif /* CH_CFG_USE_MAILBOXES */
 
 /** @} */
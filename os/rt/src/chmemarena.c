@@ -0,0 +1,159 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chmemarena.c
+ * @brief   Memory Arenas code.
+ *
+ * @addtogroup arenas
+ * @details Memory Arenas related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          An arena allocates memory from a buffer by simply advancing a
+ *          pointer, the allocated memory is not released individually but
+ *          all at once by resetting the arena or partially by rewinding the
+ *          arena to a mark previously taken using @p chArenaGetMarkX().<br>
+ *          Marks can be nested in order to implement scopes, for example:
+ *          @code
+ *          arena_mark_t mark = chArenaGetMarkX(&arena);
+ *          char *line = chArenaAlloc(&arena, LINE_SIZE);
+ *          ...
+ *          chArenaRewind(&arena, mark);
+ *          @endcode
+ *          The arena buffer is usually a chunk of memory obtained using
+ *          @p chCoreAlloc() or @p chHeapAlloc(), allocation and release
+ *          are executed in constant time and without fragmentation, this
+ *          makes arenas suitable for request-scoped temporary buffers.<br>
+ *          The arenas APIs do not perform any locking, an arena must be
+ *          used by a single thread or protected by the caller.
+ * @pre     In order to use the memory arenas APIs the
+ *          @p CH_CFG_USE_MEMARENAS option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_MEMARENAS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a memory arena.
+ * @pre     The buffer base must be aligned to the @p stkalign_t type size.
+ *
+ * @param[out] map      pointer to a @p memory_arena_t structure
+ * @param[in] buf       arena buffer base
+ * @param[in] size      arena buffer size
+ *
+ * @init
+ */
+void chArenaObjectInit(memory_arena_t *map, void *buf, size_t size) {
+
+  chDbgCheck((map != NULL) && (buf != NULL) && ARENA_IS_ALIGNED(buf));
+
+  map->ma_base = (uint8_t *)buf;
+  map->ma_next = (uint8_t *)buf;
+  map->ma_end  = (uint8_t *)buf + ARENA_ALIGN_PREV(size);
+  map->ma_peak = 0;
+}
+
+/**
+ * @brief   Allocates a block of memory from an arena.
+ * @details The allocated block is guaranteed to be properly aligned for a
+ *          pointer data type (@p stkalign_t).
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated block.
+ * @retval NULL         if the arena is exhausted.
+ *
+ * @xclass
+ */
+void *chArenaAlloc(memory_arena_t *map, size_t size) {
+  uint8_t *p;
+
+  chDbgCheck(map != NULL);
+
+  size = ARENA_ALIGN_NEXT(size);
+  if (size > (size_t)(map->ma_end - map->ma_next)) {
+    return NULL;
+  }
+
+  p = map->ma_next;
+  map->ma_next += size;
+  if ((size_t)(map->ma_next - map->ma_base) > map->ma_peak) {
+    map->ma_peak = (size_t)(map->ma_next - map->ma_base);
+  }
+
+  return p;
+}
+
+/**
+ * @brief   Rewinds an arena to a mark.
+ * @details All the blocks allocated after the mark are released, the marks
+ *          taken after the specified one become invalid.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ * @param[in] mark      a mark previously returned by @p chArenaGetMarkX()
+ *
+ * @xclass
+ */
+void chArenaRewind(memory_arena_t *map, arena_mark_t mark) {
+
+  chDbgCheck((map != NULL) &&
+             (mark >= map->ma_base) && (mark <= map->ma_next));
+
+  map->ma_next = mark;
+}
+
+/**
+ * @brief   Releases all the blocks allocated from an arena.
+ * @note    The peak usage is retained.
+ *
+ * @param[in] map       pointer to a @p memory_arena_t structure
+ *
+ * @xclass
+ */
+void chArenaReset(memory_arena_t *map) {
+
+  chDbgCheck(map != NULL);
+
+  map->ma_next = map->ma_base;
+}
+
+#endif /* CH_CFG_USE_MEMARENAS */
+
+/** @} */
@@ -37,7 +37,16 @@
  *          can coexist and share the main memory.<br>
  *          This allocator, alone, is also useful for very simple
  *          applications that just require a simple way to get memory
- *          blocks.
+ *          blocks.<br>
+ *          Additional memory regions, for example fast or DMA-capable RAM
+ *          banks, can be registered using @p chCoreAddRegion(), each region
+ *          has its own allocation pointer, attributes and blocks alignment.
+ *          Memory can be allocated from a specific region using
+ *          @p chCoreAllocFrom() or from a region selected by attributes
+ *          using @p chCoreAllocPolicy(), the @p chCoreAllocFast() and
+ *          @p chCoreAllocDMA() functions can be used as heap providers with
+ *          @p chHeapObjectInitProvider(), their I-class variants as
+ *          providers for memory pools.
  * @pre     In order to use the core memory manager APIs the @p CH_CFG_USE_MEMCORE
  *          option must be enabled in @p chconf.h.
  * @{
@@ -59,13 +68,82 @@
 /* Module local variables.                                                   */
 /*===========================================================================*/
 
-static uint8_t *nextmem;
-static uint8_t *endmem;
+/**
+ * @brief   Memory regions, the region zero is the default one.
+ */
+static memory_region_t regions[CH_CFG_MEMCORE_REGIONS];
+
+/**
+ * @brief   Number of registered regions.
+ */
+static unsigned nregions;
 
 /*===========================================================================*/
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Allocates a memory block from a region.
+ * @details Both the block address and size are aligned to the region
+ *          alignment, the address is also aligned to the specified
+ *          alignment if it is stricter.
+ */
+static void *region_alloc(memory_region_t *mrp, size_t size, size_t align) {
+  uint8_t *p;
+
+  if (align < mrp->mr_align) {
+    align = mrp->mr_align;
+  }
+  p = (uint8_t *)(((size_t)mrp->mr_next + align - 1U) & ~(align - 1U));
+  size = (size + mrp->mr_align - 1U) & ~(mrp->mr_align - 1U);
+  if ((p > mrp->mr_end) || ((size_t)(mrp->mr_end - p) < size)) {
+    return NULL;
+  }
+  mrp->mr_next = p + size;
+
+  return p;
+}
+
+/**
+ * @brief   Allocates a memory block from the first suitable region.
+ *
+ * @param[in] attr      attributes the region must have
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         if there is no suitable region with enough memory.
+ */
+static void *regions_alloc(uint32_t attr, size_t size) {
+  unsigned i;
+  void *p;
+
+  for (i = 0U; i < nregions; i++) {
+    if ((regions[i].mr_attr & attr) == attr) {
+      p = region_alloc(&regions[i], size, 0U);
+      if (p != NULL) {
+        return p;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Compares two strings.
+ */
+static bool name_equal(const char *s1, const char *s2) {
+
+  while (*s1 == *s2) {
+    if (*s1 == '\0') {
+      return true;
+    }
+    s1++;
+    s2++;
+  }
+
+  return false;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -80,14 +158,18 @@ void _core_init(void) {
   extern uint8_t __heap_base__[];
   extern uint8_t __heap_end__[];
 
-  nextmem = (uint8_t *)MEM_ALIGN_NEXT(__heap_base__);
-  endmem = (uint8_t *)MEM_ALIGN_PREV(__heap_end__);
+  regions[0].mr_next = (uint8_t *)MEM_ALIGN_NEXT(__heap_base__);
+  regions[0].mr_end = (uint8_t *)MEM_ALIGN_PREV(__heap_end__);
 #else
   static stkalign_t buffer[MEM_ALIGN_NEXT(CH_CFG_MEMCORE_SIZE)/MEM_ALIGN_SIZE];
 
-  nextmem = (uint8_t *)&buffer[0];
-  endmem = (uint8_t *)&buffer[MEM_ALIGN_NEXT(CH_CFG_MEMCORE_SIZE)/MEM_ALIGN_SIZE];
+  regions[0].mr_next = (uint8_t *)&buffer[0];
+  regions[0].mr_end = (uint8_t *)&buffer[MEM_ALIGN_NEXT(CH_CFG_MEMCORE_SIZE)/MEM_ALIGN_SIZE];
 #endif
+  regions[0].mr_name = "core";
+  regions[0].mr_attr = (uint32_t)CH_CFG_MEMCORE_DEFAULT_ATTR;
+  regions[0].mr_align = MEM_ALIGN_SIZE;
+  nregions = 1U;
 }
 
 /**
@@ -117,6 +199,8 @@ void *chCoreAlloc(size_t size) {
  * @details The size of the returned block is aligned to the alignment
  *          type so it is not possible to allocate less than
  *          <code>MEM_ALIGN_SIZE</code>.
+ * @note    If @p CH_CFG_MEMCORE_PREFER is not zero then the regions having
+ *          the preferred attributes are tried before the region zero.
  *
  * @param[in] size      the size of the block to be allocated.
  * @return              A pointer to the allocated memory block.
@@ -125,16 +209,60 @@ void *chCoreAlloc(size_t size) {
  * @iclass
  */
 void *chCoreAllocI(size_t size) {
+#if (CH_CFG_MEMCORE_REGIONS > 1) && (CH_CFG_MEMCORE_PREFER != 0)
   void *p;
+#endif
 
   chDbgCheckClassI();
 
-  size = MEM_ALIGN_NEXT(size);
-  if ((size_t)(endmem - nextmem) < size) {
-    return NULL;
+#if (CH_CFG_MEMCORE_REGIONS > 1) && (CH_CFG_MEMCORE_PREFER != 0)
+  p = regions_alloc((uint32_t)CH_CFG_MEMCORE_PREFER, size);
+  if (p != NULL) {
+    return p;
   }
-  p = nextmem;
-  nextmem += size;
+#endif
+
+  return region_alloc(&regions[0], size, 0U);
+}
+
+/**
+ * @brief   Allocates an aligned memory block.
+ * @details The block is allocated from the region zero, the memory skipped
+ *          in order to align the block is not recovered.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the block alignment, it must be a power of two
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, core memory exhausted.
+ *
+ * @iclass
+ */
+void *chCoreAllocAlignedI(size_t size, size_t align) {
+
+  chDbgCheckClassI();
+  chDbgCheck((align > 0U) && ((align & (align - 1U)) == 0U));
+
+  return region_alloc(&regions[0], size, align);
+}
+
+/**
+ * @brief   Allocates an aligned memory block.
+ * @details The block is allocated from the region zero, the memory skipped
+ *          in order to align the block is not recovered.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the block alignment, it must be a power of two
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, core memory exhausted.
+ *
+ * @api
+ */
+void *chCoreAllocAligned(size_t size, size_t align) {
+  void *p;
+
+  chSysLock();
+  p = chCoreAllocAlignedI(size, align);
+  chSysUnlock();
 
   return p;
 }
@@ -148,7 +276,233 @@ void *chCoreAllocI(size_t size) {
  */
 size_t chCoreGetStatusX(void) {
 
-  return (size_t)(endmem - nextmem);
+  return chCoreGetRegionStatusX(&regions[0]);
+}
+
+/**
+ * @brief   Registers a core memory region.
+ *
+ * @param[in] name      the region name
+ * @param[in] base      the region base
+ * @param[in] size      the region size
+ * @param[in] attr      the region attributes, a combination of the
+ *                      @p CH_MEM_ATTR_ flags
+ * @param[in] align     alignment of the blocks allocated from the region,
+ *                      it must be a power of two not smaller than
+ *                      @p MEM_ALIGN_SIZE
+ * @return              A pointer to the region descriptor.
+ * @retval NULL         if the regions table is full.
+ *
+ * @api
+ */
+memory_region_t *chCoreAddRegion(const char *name, void *base, size_t size,
+                                 uint32_t attr, size_t align) {
+  memory_region_t *mrp = NULL;
+
+  chDbgCheck((name != NULL) && (base != NULL) &&
+             (align >= MEM_ALIGN_SIZE) && ((align & (align - 1U)) == 0U));
+
+  chSysLock();
+  if (nregions < (unsigned)CH_CFG_MEMCORE_REGIONS) {
+    mrp = &regions[nregions];
+    mrp->mr_name = name;
+    mrp->mr_next = (uint8_t *)base;
+    mrp->mr_end = (uint8_t *)base + size;
+    mrp->mr_attr = attr;
+    mrp->mr_align = align;
+    nregions++;
+  }
+  chSysUnlock();
+
+  return mrp;
+}
+
+/**
+ * @brief   Finds a core memory region by name.
+ *
+ * @param[in] name      the region name
+ * @return              A pointer to the region descriptor.
+ * @retval NULL         if the region does not exist.
+ *
+ * @api
+ */
+memory_region_t *chCoreFindRegion(const char *name) {
+  unsigned i;
+
+  chDbgCheck(name != NULL);
+
+  for (i = 0U; i < nregions; i++) {
+    if (name_equal(regions[i].mr_name, name)) {
+      return &regions[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Allocates a memory block from a region.
+ * @details The address and the size of the returned block are aligned to
+ *          the region alignment.
+ *
+ * @param[in] mrp       pointer to the region
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, region exhausted.
+ *
+ * @iclass
+ */
+void *chCoreAllocFromI(memory_region_t *mrp, size_t size) {
+
+  chDbgCheckClassI();
+  chDbgCheck(mrp != NULL);
+
+  return region_alloc(mrp, size, 0U);
+}
+
+/**
+ * @brief   Allocates a memory block from a region.
+ * @details The address and the size of the returned block are aligned to
+ *          the region alignment.
+ *
+ * @param[in] mrp       pointer to the region
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, region exhausted.
+ *
+ * @api
+ */
+void *chCoreAllocFrom(memory_region_t *mrp, size_t size) {
+  void *p;
+
+  chSysLock();
+  p = chCoreAllocFromI(mrp, size);
+  chSysUnlock();
+
+  return p;
+}
+
+/**
+ * @brief   Allocates a memory block from a region selected by attributes.
+ * @details The regions having both the required and the preferred
+ *          attributes are tried first, then the regions only having the
+ *          required attributes. The regions are tried in registration
+ *          order.
+ *
+ * @param[in] required  attributes the region must have
+ * @param[in] preferred attributes the region should have
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no suitable region with enough
+ *                      memory.
+ *
+ * @iclass
+ */
+void *chCoreAllocPolicyI(uint32_t required, uint32_t preferred,
+                         size_t size) {
+  void *p;
+
+  chDbgCheckClassI();
+
+  if (preferred != 0U) {
+    p = regions_alloc(required | preferred, size);
+    if (p != NULL) {
+      return p;
+    }
+  }
+
+  return regions_alloc(required, size);
+}
+
+/**
+ * @brief   Allocates a memory block from a region selected by attributes.
+ * @details The regions having both the required and the preferred
+ *          attributes are tried first, then the regions only having the
+ *          required attributes. The regions are tried in registration
+ *          order.
+ *
+ * @param[in] required  attributes the region must have
+ * @param[in] preferred attributes the region should have
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no suitable region with enough
+ *                      memory.
+ *
+ * @api
+ */
+void *chCoreAllocPolicy(uint32_t required, uint32_t preferred,
+                        size_t size) {
+  void *p;
+
+  chSysLock();
+  p = chCoreAllocPolicyI(required, preferred, size);
+  chSysUnlock();
+
+  return p;
+}
+
+/**
+ * @brief   Allocates a memory block preferably from fast memory.
+ * @note    This function is compatible with the @p memgetfunc_t type and
+ *          can be used as provider for memory pools.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, core memory exhausted.
+ *
+ * @iclass
+ */
+void *chCoreAllocFastI(size_t size) {
+
+  return chCoreAllocPolicyI(0U, CH_MEM_ATTR_FAST, size);
+}
+
+/**
+ * @brief   Allocates a memory block preferably from fast memory.
+ * @note    This function is compatible with the @p memgetfunc_t type and
+ *          can be used as provider for heaps.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, core memory exhausted.
+ *
+ * @api
+ */
+void *chCoreAllocFast(size_t size) {
+
+  return chCoreAllocPolicy(0U, CH_MEM_ATTR_FAST, size);
+}
+
+/**
+ * @brief   Allocates a memory block from DMA-capable memory.
+ * @note    This function is compatible with the @p memgetfunc_t type and
+ *          can be used as provider for memory pools.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no DMA-capable memory available.
+ *
+ * @iclass
+ */
+void *chCoreAllocDMAI(size_t size) {
+
+  return chCoreAllocPolicyI(CH_MEM_ATTR_DMA, 0U, size);
+}
+
+/**
+ * @brief   Allocates a memory block from DMA-capable memory.
+ * @note    This function is compatible with the @p memgetfunc_t type and
+ *          can be used as provider for heaps.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no DMA-capable memory available.
+ *
+ * @api
+ */
+void *chCoreAllocDMA(size_t size) {
+
+  return chCoreAllocPolicy(CH_MEM_ATTR_DMA, 0U, size);
 }
 #endif /* CH_CFG_USE_MEMCORE */
 
@@ -29,7 +29,12 @@
  *          problems.<br>
  *          Memory Pools do not enforce any alignment constraint on the
  *          contained object however the objects must be properly aligned
- *          to contain a pointer to void.
+ *          to contain a pointer to void.<br>
+ *          If the @p CH_CFG_USE_SEMAPHORES option is enabled then guarded
+ *          memory pools are also available, a counter semaphore guards the
+ *          pool and the threads allocating from an empty pool are
+ *          suspended, with an optional timeout, until an object is
+ *          returned to the pool.
  * @pre     In order to use the memory pools APIs the @p CH_CFG_USE_MEMPOOLS option
  *          must be enabled in @p chconf.h.
  * @{
@@ -55,6 +60,85 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Detaches a chain of objects from the head of a memory pool.
+ * @pre     Must be called from within a critical zone.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] n         maximum number of objects to be detached
+ * @param[out] np       number of detached objects
+ * @return              The first object of the chain.
+ */
+static struct pool_header *pool_detach(memory_pool_t *mp, size_t n,
+                                       size_t *np) {
+  struct pool_header *php, *tail;
+  size_t k;
+
+  php = mp->mp_next;
+  tail = NULL;
+  for (k = 0; (k < n) && (mp->mp_next != NULL); k++) {
+    tail = mp->mp_next;
+    mp->mp_next = tail->ph_next;
+  }
+  if (tail != NULL) {
+    tail->ph_next = NULL;
+  }
+  *np = k;
+
+  return php;
+}
+
+/**
+ * @brief   Gets an object from the provider of a memory pool.
+ * @details If the pool alignment is stricter than the provider alignment
+ *          then a larger block is requested and the object is aligned
+ *          within it.
+ * @pre     The pool must have a provider.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the object.
+ * @retval NULL         if the provider failed.
+ */
+static void *pool_provide(memory_pool_t *mp) {
+  uint8_t *p;
+
+  if (mp->mp_align <= MEM_ALIGN_SIZE) {
+    return mp->mp_provider(mp->mp_object_size);
+  }
+
+  p = mp->mp_provider(mp->mp_object_size + mp->mp_align - MEM_ALIGN_SIZE);
+  if (p != NULL) {
+    p = (uint8_t *)(((size_t)p + mp->mp_align - 1U) &
+                    ~(mp->mp_align - 1U));
+  }
+
+  return p;
+}
+
+/**
+ * @brief   Links an array of objects in a chain.
+ *
+ * @param[in] objs      array of pointers to the objects
+ * @param[in] n         number of objects, must not be zero
+ * @return              The last object of the chain, the first one is
+ *                      @p objs[0].
+ */
+static struct pool_header *pool_link(void *objs[], size_t n) {
+  struct pool_header *php = objs[0];
+  size_t k;
+
+  chDbgCheck(php != NULL);
+
+  for (k = 1; k < n; k++) {
+    chDbgCheck(objs[k] != NULL);
+
+    php->ph_next = objs[k];
+    php = php->ph_next;
+  }
+
+  return php;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -79,6 +163,38 @@ void chPoolObjectInit(memory_pool_t *mp, size_t size, memgetfunc_t provider) {
   mp->mp_next = NULL;
   mp->mp_object_size = size;
   mp->mp_provider = provider;
+  mp->mp_align = sizeof (void *);
+}
+
+/**
+ * @brief   Initializes an empty memory pool with aligned objects.
+ * @details The objects size is rounded up to a multiple of the alignment
+ *          so that the elements of an array loaded in the pool are all
+ *          aligned.
+ * @note    The objects obtained from the provider are aligned within
+ *          larger blocks if the alignment is stricter than
+ *          @p MEM_ALIGN_SIZE, pools loaded with aligned arrays have no
+ *          overhead.
+ *
+ * @param[out] mp       pointer to a @p memory_pool_t structure
+ * @param[in] size      the size of the objects contained in this memory pool,
+ *                      the minimum accepted size is the size of a pointer to
+ *                      void.
+ * @param[in] align     the objects alignment, it must be a power of two not
+ *                      smaller than the size of a pointer to void
+ * @param[in] provider  memory provider function for the memory pool or
+ *                      @p NULL if the pool is not allowed to grow
+ *                      automatically
+ *
+ * @init
+ */
+void chPoolObjectInitAligned(memory_pool_t *mp, size_t size, size_t align,
+                             memgetfunc_t provider) {
+
+  chDbgCheck((align >= sizeof (void *)) && ((align & (align - 1U)) == 0U));
+
+  chPoolObjectInit(mp, (size + align - 1U) & ~(align - 1U), provider);
+  mp->mp_align = align;
 }
 
 /**
@@ -96,7 +212,8 @@ void chPoolObjectInit(memory_pool_t *mp, size_t size, memgetfunc_t provider) {
  */
 void chPoolLoadArray(memory_pool_t *mp, void *p, size_t n) {
 
-  chDbgCheck((mp != NULL) && (n != 0));
+  chDbgCheck((mp != NULL) && (n != 0) &&
+             (((size_t)p & (mp->mp_align - 1U)) == 0U));
 
   while (n) {
     chPoolAdd(mp, p);
@@ -125,7 +242,7 @@ void *chPoolAllocI(memory_pool_t *mp) {
     mp->mp_next = mp->mp_next->ph_next;
   }
   else if (mp->mp_provider != NULL) {
-    objp = mp->mp_provider(mp->mp_object_size);
+    objp = pool_provide(mp);
   }
 
   return objp;
@@ -192,6 +309,341 @@ void chPoolFree(memory_pool_t *mp, void *objp) {
   chSysUnlock();
 }
 
+/**
+ * @brief   Allocates a batch of objects from a memory pool.
+ * @details The objects are detached from the pool as a single chain, the
+ *          objects missing from the pool are requested to the pool provider,
+ *          if any.
+ * @pre     The memory pool must be already been initialized.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[out] objs     array receiving the pointers to the allocated objects
+ * @param[in] n         number of objects to be allocated
+ * @return              The number of allocated objects, it can be less than
+ *                      @p n if the pool is exhausted.
+ *
+ * @iclass
+ */
+size_t chPoolAllocBatchI(memory_pool_t *mp, void *objs[], size_t n) {
+  struct pool_header *php;
+  size_t k, i;
+
+  chDbgCheckClassI();
+  chDbgCheck((mp != NULL) && (objs != NULL));
+
+  php = pool_detach(mp, n, &k);
+  for (i = 0; i < k; i++) {
+    objs[i] = php;
+    php = php->ph_next;
+  }
+  if (mp->mp_provider != NULL) {
+    while (k < n) {
+      objs[k] = pool_provide(mp);
+      if (objs[k] == NULL) {
+        break;
+      }
+      k++;
+    }
+  }
+
+  return k;
+}
+
+/**
+ * @brief   Allocates a batch of objects from a memory pool.
+ * @details The objects are detached from the pool as a single chain into a
+ *          single critical zone, the array is filled outside the critical
+ *          zone.
+ * @pre     The memory pool must be already been initialized.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[out] objs     array receiving the pointers to the allocated objects
+ * @param[in] n         number of objects to be allocated
+ * @return              The number of allocated objects, it can be less than
+ *                      @p n if the pool is exhausted.
+ *
+ * @api
+ */
+size_t chPoolAllocBatch(memory_pool_t *mp, void *objs[], size_t n) {
+  struct pool_header *php;
+  size_t k, i;
+
+  chDbgCheck((mp != NULL) && (objs != NULL));
+
+  chSysLock();
+  php = pool_detach(mp, n, &k);
+  chSysUnlock();
+
+  for (i = 0; i < k; i++) {
+    objs[i] = php;
+    php = php->ph_next;
+  }
+  if ((k < n) && (mp->mp_provider != NULL)) {
+    chSysLock();
+    while (k < n) {
+      objs[k] = pool_provide(mp);
+      if (objs[k] == NULL) {
+        break;
+      }
+      k++;
+    }
+    chSysUnlock();
+  }
+
+  return k;
+}
+
+/**
+ * @brief   Releases a batch of objects into a memory pool.
+ * @pre     The memory pool must be already been initialized.
+ * @pre     The freed objects must be of the right size for the specified
+ *          memory pool.
+ * @pre     The objects must be properly aligned to contain a pointer to void.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objs      array of pointers to the objects to be released
+ * @param[in] n         number of objects to be released
+ *
+ * @iclass
+ */
+void chPoolFreeBatchI(memory_pool_t *mp, void *objs[], size_t n) {
+  struct pool_header *tail;
+
+  chDbgCheckClassI();
+  chDbgCheck((mp != NULL) && (objs != NULL));
+
+  if (n > 0) {
+    tail = pool_link(objs, n);
+    tail->ph_next = mp->mp_next;
+    mp->mp_next = objs[0];
+  }
+}
+
+/**
+ * @brief   Releases a batch of objects into a memory pool.
+ * @details The objects are linked in a chain outside the critical zone, the
+ *          chain is then inserted in the pool in constant time.
+ * @pre     The memory pool must be already been initialized.
+ * @pre     The freed objects must be of the right size for the specified
+ *          memory pool.
+ * @pre     The objects must be properly aligned to contain a pointer to void.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objs      array of pointers to the objects to be released
+ * @param[in] n         number of objects to be released
+ *
+ * @api
+ */
+void chPoolFreeBatch(memory_pool_t *mp, void *objs[], size_t n) {
+  struct pool_header *tail;
+
+  chDbgCheck((mp != NULL) && (objs != NULL));
+
+  if (n > 0) {
+    tail = pool_link(objs, n);
+
+    chSysLock();
+    tail->ph_next = mp->mp_next;
+    mp->mp_next = objs[0];
+    chSysUnlock();
+  }
+}
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an empty guarded memory pool.
+ *
+ * @param[out] gmp      pointer to a @p guarded_memory_pool_t structure
+ * @param[in] size      the size of the objects contained in this guarded
+ *                      memory pool, the minimum accepted size is the size
+ *                      of a pointer to void.
+ *
+ * @init
+ */
+void chGuardedPoolObjectInit(guarded_memory_pool_t *gmp, size_t size) {
+
+  chPoolObjectInit(&gmp->gmp_pool, size, NULL);
+  chSemObjectInit(&gmp->gmp_sem, (cnt_t)0);
+}
+
+/**
+ * @brief   Initializes an empty guarded memory pool with aligned objects.
+ * @details The objects size is rounded up to a multiple of the alignment
+ *          so that the elements of an array loaded in the pool are all
+ *          aligned.
+ *
+ * @param[out] gmp      pointer to a @p guarded_memory_pool_t structure
+ * @param[in] size      the size of the objects contained in this guarded
+ *                      memory pool, the minimum accepted size is the size
+ *                      of a pointer to void.
+ * @param[in] align     the objects alignment, it must be a power of two not
+ *                      smaller than the size of a pointer to void
+ *
+ * @init
+ */
+void chGuardedPoolObjectInitAligned(guarded_memory_pool_t *gmp,
+                                    size_t size, size_t align) {
+
+  chPoolObjectInitAligned(&gmp->gmp_pool, size, align, NULL);
+  chSemObjectInit(&gmp->gmp_sem, (cnt_t)0);
+}
+
+/**
+ * @brief   Loads a guarded memory pool with an array of static objects.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The array elements must be of the right size for the specified
+ *          guarded memory pool.
+ * @post    The guarded memory pool contains the elements of the input array.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] p         pointer to the array first element
+ * @param[in] n         number of elements in the array
+ *
+ * @api
+ */
+void chGuardedPoolLoadArray(guarded_memory_pool_t *gmp, void *p, size_t n) {
+
+  chDbgCheck((gmp != NULL) && (n != 0) &&
+             (((size_t)p & (gmp->gmp_pool.mp_align - 1U)) == 0U));
+
+  while (n) {
+    chGuardedPoolAdd(gmp, p);
+    p = (void *)(((uint8_t *)p) + gmp->gmp_pool.mp_object_size);
+    n--;
+  }
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details This variant is non-blocking, the function returns @p NULL if
+ *          the pool is empty.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the pool is empty.
+ *
+ * @iclass
+ */
+void *chGuardedPoolAllocI(guarded_memory_pool_t *gmp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(gmp != NULL);
+
+  if (chGuardedPoolGetCounterI(gmp) <= (cnt_t)0) {
+    return NULL;
+  }
+  chSemFastWaitI(&gmp->gmp_sem);
+
+  return chPoolAllocI(&gmp->gmp_pool);
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details If the pool is empty the calling thread is suspended until an
+ *          object is returned to the pool or the timeout expires.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @sclass
+ */
+void *chGuardedPoolAllocTimeoutS(guarded_memory_pool_t *gmp,
+                                 systime_t time) {
+  msg_t msg;
+
+  chDbgCheckClassS();
+  chDbgCheck(gmp != NULL);
+
+  msg = chSemWaitTimeoutS(&gmp->gmp_sem, time);
+  if (msg != MSG_OK) {
+    return NULL;
+  }
+
+  return chPoolAllocI(&gmp->gmp_pool);
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details If the pool is empty the calling thread is suspended until an
+ *          object is returned to the pool or the timeout expires.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+void *chGuardedPoolAllocTimeout(guarded_memory_pool_t *gmp,
+                                systime_t time) {
+  void *p;
+
+  chSysLock();
+  p = chGuardedPoolAllocTimeoutS(gmp, time);
+  chSysUnlock();
+
+  return p;
+}
+
+/**
+ * @brief   Releases an object into a guarded memory pool.
+ * @details A thread waiting for an object, if any, is made ready, this
+ *          function can be used from interrupt handlers.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The object must be properly aligned to contain a pointer to void.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @iclass
+ */
+void chGuardedPoolFreeI(guarded_memory_pool_t *gmp, void *objp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(gmp != NULL);
+
+  chPoolFreeI(&gmp->gmp_pool, objp);
+  chSemSignalI(&gmp->gmp_sem);
+}
+
+/**
+ * @brief   Releases an object into a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The object must be properly aligned to contain a pointer to void.
+ *
+ * @param[in] gmp       pointer to a @p guarded_memory_pool_t structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @api
+ */
+void chGuardedPoolFree(guarded_memory_pool_t *gmp, void *objp) {
+
+  chSysLock();
+  chGuardedPoolFreeI(gmp, objp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+#endif /* CH_CFG_USE_SEMAPHORES */
+
 #endif /* CH_CFG_USE_MEMPOOLS */
 
 /** @} */
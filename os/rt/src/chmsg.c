@@ -36,6 +36,12 @@
  *          Messages are usually processed in FIFO order but it is possible to
  *          process them in priority order by enabling the
  *          @p CH_CFG_USE_MESSAGES_PRIORITY option in @p chconf.h.<br>
+ *          If the @p CH_CFG_USE_MESSAGES_ASYNC option is enabled then a
+ *          client can also send messages without waiting for the answer,
+ *          the message is queued on the server through a message handle
+ *          and the answer is collected later from the same handle. A client
+ *          can pipeline several messages using several handles, the
+ *          asynchronous messages are always served in FIFO order.<br>
  * @pre     In order to use the message APIs the @p CH_CFG_USE_MESSAGES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling messages requires 6-12 (depending on the architecture)
@@ -121,7 +127,7 @@ thread_t *chMsgWait(void) {
   thread_t *tp;
 
   chSysLock();
-  if (!chMsgIsPendingI(currp)) {
+  while (!chMsgIsPendingI(currp)) {
     chSchGoSleepS(CH_STATE_WTMSG);
   }
   tp = queue_fifo_remove(&currp->p_msgqueue);
@@ -149,6 +155,156 @@ void chMsgRelease(thread_t *tp, msg_t msg) {
   chSysUnlock();
 }
 
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Sends an asynchronous message to the specified thread.
+ * @details The message is queued on the receiver through the handle, the
+ *          sender does not wait for the answer.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] tp        the pointer to the thread
+ * @param[out] mhp      pointer to a free @p msg_handle_t structure
+ * @param[in] msg       the message
+ *
+ * @iclass
+ */
+void chMsgSendAsyncI(thread_t *tp, msg_handle_t *mhp, msg_t msg) {
+
+  chDbgCheckClassI();
+  chDbgCheck((tp != NULL) && (mhp != NULL));
+
+  mhp->mh_next   = NULL;
+  mhp->mh_msg    = msg;
+  mhp->mh_state  = MSG_HANDLE_QUEUED;
+  mhp->mh_thread = NULL;
+  if (tp->p_amsghead == NULL) {
+    tp->p_amsghead = mhp;
+  }
+  else {
+    tp->p_amsgtail->mh_next = mhp;
+  }
+  tp->p_amsgtail = mhp;
+  if (tp->p_state == CH_STATE_WTMSG) {
+    (void) chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Sends an asynchronous message to the specified thread.
+ * @details The message is queued on the receiver through the handle, the
+ *          sender does not wait for the answer, the answer is retrieved
+ *          later using @p chMsgCollectTimeout().
+ * @note    If the message is a pointer then the pointed data must stay
+ *          stable until the answer has been collected.
+ *
+ * @param[in] tp        the pointer to the thread
+ * @param[out] mhp      pointer to a free @p msg_handle_t structure
+ * @param[in] msg       the message
+ *
+ * @api
+ */
+void chMsgSendAsync(thread_t *tp, msg_handle_t *mhp, msg_t msg) {
+
+  chSysLock();
+  chMsgSendAsyncI(tp, mhp, msg);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Suspends the thread and waits for an incoming asynchronous
+ *          message.
+ * @post    After receiving a message the function @p chMsgGetAsync() must
+ *          be called in order to retrieve the message and then
+ *          @p chMsgReleaseAsync() must be invoked in order to send the
+ *          answer.
+ *
+ * @return              A reference to the handle carrying the message.
+ *
+ * @api
+ */
+msg_handle_t *chMsgWaitAsync(void) {
+  thread_t *ctp = currp;
+  msg_handle_t *mhp;
+
+  chSysLock();
+  while (!chMsgIsPendingAsyncI(ctp)) {
+    chSchGoSleepS(CH_STATE_WTMSG);
+  }
+  mhp = ctp->p_amsghead;
+  ctp->p_amsghead = mhp->mh_next;
+  mhp->mh_state = MSG_HANDLE_SERVING;
+  chSysUnlock();
+
+  return mhp;
+}
+
+/**
+ * @brief   Releases an asynchronous message specifying an answer.
+ * @details The answer is stored in the handle and the thread collecting
+ *          it, if any, is resumed.
+ * @pre     Invoke this function only after a message has been received
+ *          using @p chMsgWaitAsync().
+ *
+ * @param[in] mhp       pointer to the @p msg_handle_t structure
+ * @param[in] msg       message to be returned to the sender
+ *
+ * @api
+ */
+void chMsgReleaseAsync(msg_handle_t *mhp, msg_t msg) {
+
+  chSysLock();
+  chDbgAssert(mhp->mh_state == MSG_HANDLE_SERVING, "invalid state");
+  mhp->mh_msg = msg;
+  mhp->mh_state = MSG_HANDLE_DONE;
+  chThdResumeS(&mhp->mh_thread, msg);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Collects the answer of an asynchronous message.
+ * @details If the answer is not yet available then the invoking thread
+ *          waits until the server releases the message or the specified
+ *          time runs out. After a successful collection the handle can be
+ *          reused.
+ *
+ * @param[in] mhp       pointer to the @p msg_handle_t structure
+ * @param[out] msgp     pointer to a @p msg_t variable for the answer
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the answer has been collected.
+ * @retval MSG_TIMEOUT  if the answer is not available within the specified
+ *                      time.
+ *
+ * @api
+ */
+msg_t chMsgCollectTimeout(msg_handle_t *mhp, msg_t *msgp, systime_t time) {
+
+  chDbgCheck((mhp != NULL) && (msgp != NULL));
+
+  chSysLock();
+  if (mhp->mh_state != MSG_HANDLE_DONE) {
+    (void) chThdSuspendTimeoutS(&mhp->mh_thread, time);
+    if (mhp->mh_state != MSG_HANDLE_DONE) {
+      chSysUnlock();
+
+      return MSG_TIMEOUT;
+    }
+  }
+  *msgp = mhp->mh_msg;
+  chSysUnlock();
+
+  return MSG_OK;
+}
+#endif /* CH_CFG_USE_MESSAGES_ASYNC */
+
 #endif /* CH_CFG_USE_MESSAGES */
 
 /** @} */
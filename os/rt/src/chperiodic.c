@@ -0,0 +1,178 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chperiodic.c
+ * @brief   Periodic threads code.
+ *
+ * @addtogroup periodic
+ * @details Periodic threads APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A periodic object describes the activation pattern of a thread
+ *          executing a job every @p period system ticks starting from
+ *          a specified absolute time. The thread calls @p chPTWaitNext()
+ *          at the end of each job, the function sleeps until the next
+ *          activation using @p chThdSleepUntilWindowed() and keeps
+ *          statistics about the activations:
+ *          - Activation jitter, best, worst and average.
+ *          - Jobs execution time, if @p CH_CFG_USE_TM is enabled.
+ *          - Number of overruns, jobs that did not complete before the
+ *            next activation time.
+ *          .
+ *          On overrun the optional deadline miss callback is invoked and
+ *          the missed activations are skipped, the phase of the
+ *          activation pattern is preserved.<br>
+ *          If the registry is enabled then the object is reachable from
+ *          the owning thread using @p chRegGetThreadPeriodicI().
+ * @pre     In order to use the periodic threads APIs the
+ *          @p CH_CFG_USE_PERIODIC option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p periodic_t object.
+ * @note    The first activation time should not be in the past by more than
+ *          one period, the first call to @p chPTWaitNext() would not be
+ *          able to detect it.
+ *
+ * @param[out] ptp      pointer to a @p periodic_t structure
+ * @param[in] start     absolute system time of the first activation
+ * @param[in] period    activation period in system ticks
+ * @param[in] miss      deadline miss callback or @p NULL, the callback is
+ *                      invoked in the context of the periodic thread
+ *
+ * @init
+ */
+void chPTObjectInit(periodic_t *ptp, systime_t start, systime_t period,
+                    ptmiss_t miss) {
+
+  chDbgCheck((ptp != NULL) && (period > (systime_t)0));
+
+  ptp->pt_next        = start;
+  ptp->pt_period      = period;
+  ptp->pt_miss        = miss;
+  ptp->pt_thread      = NULL;
+  ptp->pt_activations = (ucnt_t)0;
+  ptp->pt_overruns    = (ucnt_t)0;
+  ptp->pt_jbest       = (systime_t)-1;
+  ptp->pt_jworst      = (systime_t)0;
+  ptp->pt_jcumulative = (uint32_t)0;
+#if CH_CFG_USE_TM
+  chTMObjectInit(&ptp->pt_exec);
+#endif
+}
+
+/**
+ * @brief   Waits for the next activation.
+ * @details The first invocation binds the object to the calling thread and
+ *          waits for the first activation, the following invocations mark
+ *          the end of the current job and wait for the next activation.
+ *          If the current job did not complete before the next activation
+ *          time then an overrun is accounted, the deadline miss callback is
+ *          invoked and the missed activations are skipped.
+ *
+ * @param[in] ptp       pointer to the @p periodic_t object
+ *
+ * @api
+ */
+void chPTWaitNext(periodic_t *ptp) {
+  systime_t now, jitter;
+
+  chDbgCheck(ptp != NULL);
+  chDbgAssert((ptp->pt_thread == NULL) || (ptp->pt_thread == chThdGetSelfX()),
+              "not owner");
+
+  if (ptp->pt_thread == NULL) {
+    ptp->pt_thread = chThdGetSelfX();
+#if CH_CFG_USE_REGISTRY
+    ptp->pt_thread->p_periodic = ptp;
+#endif
+  }
+  else {
+#if CH_CFG_USE_TM
+    chTMStopMeasurementX(&ptp->pt_exec);
+#endif
+    ptp->pt_next += ptp->pt_period;
+    now = chVTGetSystemTime();
+    if (!chVTIsTimeWithinX(now, ptp->pt_next - ptp->pt_period,
+                           ptp->pt_next)) {
+      /* Overrun, the job went past its deadline.*/
+      ptp->pt_overruns++;
+      if (ptp->pt_miss != NULL) {
+        ptp->pt_miss(ptp);
+        now = chVTGetSystemTime();
+      }
+
+      /* Skipping the missed activations, the next one is the first
+         activation time in the future.*/
+      ptp->pt_next += ((systime_t)(now - ptp->pt_next) / ptp->pt_period) *
+                      ptp->pt_period + ptp->pt_period;
+    }
+  }
+
+  /* If the activation time is passed while going to sleep then the
+     windowed sleep returns immediately, the delay is accounted as jitter.*/
+  (void) chThdSleepUntilWindowed(ptp->pt_next - ptp->pt_period, ptp->pt_next);
+
+  /* Activation statistics.*/
+  jitter = chVTTimeElapsedSinceX(ptp->pt_next);
+  ptp->pt_activations++;
+  ptp->pt_jcumulative += (uint32_t)jitter;
+  if (jitter < ptp->pt_jbest) {
+    ptp->pt_jbest = jitter;
+  }
+  if (jitter > ptp->pt_jworst) {
+    ptp->pt_jworst = jitter;
+  }
+#if CH_CFG_USE_TM
+  chTMStartMeasurementX(&ptp->pt_exec);
+#endif
+}
+
+#endif /* CH_CFG_USE_PERIODIC */
+
+/** @} */
@@ -93,6 +93,9 @@ void chIQObjectInit(input_queue_t *iqp, uint8_t *bp, size_t size,
   iqp->q_top = bp + size;
   iqp->q_notify = infy;
   iqp->q_link = link;
+#if CH_CFG_USE_WAITSETS
+  iqp->q_wse = NULL;
+#endif
 }
 
 /**
@@ -143,6 +146,11 @@ msg_t chIQPutI(input_queue_t *iqp, uint8_t b) {
   }
 
   chThdDequeueNextI(&iqp->q_waiting, Q_OK);
+#if CH_CFG_USE_WAITSETS
+  if (iqp->q_wse != NULL) {
+    _waitset_signal(iqp->q_wse);
+  }
+#endif
 
   return Q_OK;
 }
@@ -277,6 +285,9 @@ void chOQObjectInit(output_queue_t *oqp, uint8_t *bp, size_t size,
   oqp->q_top = bp + size;
   oqp->q_notify = onfy;
   oqp->q_link = link;
+#if CH_CFG_USE_WAITSETS
+  oqp->q_wse = NULL;
+#endif
 }
 
 /**
@@ -39,7 +39,12 @@
  *          Another possible use is for centralized threads memory management,
  *          terminating threads can pulse an event source and an event handler
  *          can perform a scansion of the registry in order to recover the
- *          memory.
+ *          memory.<br>
+ *          If the @p CH_DBG_FILL_THREADS debug option is enabled then the
+ *          registry can also measure the stack usage of the threads by
+ *          scanning the fill pattern left untouched in their stacks, the
+ *          scan can be performed on demand or by a low priority scanner
+ *          thread. The stacks are read without locking the kernel.
  * @pre     In order to use the threads registry the @p CH_CFG_USE_REGISTRY
  *          option must be enabled in @p chconf.h.
  * @{
@@ -67,6 +72,68 @@
 #define _offsetof(st, m)                                                    \
   ((size_t)((char *)&((st *)0)->m - (char *)0))
 
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+/*
+ * Stack fill pattern replicated in a scanning word.
+ */
+#define REG_FILL_WORD                                                       \
+  (((size_t)-1 / (size_t)0xFFU) * (size_t)CH_DBG_STACK_FILL_VALUE)
+
+/*
+ * Scanning word alignment mask.
+ */
+#define REG_WORD_MASK   (sizeof (size_t) - 1U)
+
+/**
+ * @brief   Counts the fill pattern bytes at the start of a stack.
+ * @details The pattern is compared a word at a time, the bytes before the
+ *          first aligned word and within the first word not matching the
+ *          pattern are compared individually.
+ * @note    The stacks are assumed to grow downward, the pattern is scanned
+ *          upward starting from the stack limit.
+ *
+ * @param[in] p         the stack limit
+ * @param[in] endp      the stack end, the scan never goes beyond it
+ * @return              The number of untouched bytes.
+ */
+static size_t reg_stack_unused(const uint8_t *p, const uint8_t *endp) {
+  const uint8_t *startp = p;
+
+  while ((p < endp) && (((size_t)p & REG_WORD_MASK) != 0U) &&
+         (*p == (uint8_t)CH_DBG_STACK_FILL_VALUE)) {
+    p++;
+  }
+  if (((size_t)p & REG_WORD_MASK) == 0U) {
+    while (((size_t)(endp - p) >= sizeof (size_t)) &&
+           (*(const size_t *)p == REG_FILL_WORD)) {
+      p += sizeof (size_t);
+    }
+    while ((p < endp) && (*p == (uint8_t)CH_DBG_STACK_FILL_VALUE)) {
+      p++;
+    }
+  }
+
+  return (size_t)(p - startp);
+}
+
+/**
+ * @brief   Stack scanner thread.
+ *
+ * @param[in] p         the scan interval
+ */
+static msg_t reg_scanner_thread(void *p) {
+  systime_t interval = (systime_t)(size_t)p;
+
+  chRegSetThreadName("stkscan");
+  while (true) {
+    chRegScanStacks();
+    chThdSleep(interval);
+  }
+
+  return MSG_OK;
+}
+#endif /* CH_DBG_FILL_THREADS */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -129,7 +196,7 @@ thread_t *chRegFirstThread(void) {
   thread_t *tp;
 
   chSysLock();
-  tp = ch.rlist.r_newer;
+  tp = REG_HEADER.r_newer;
 #if CH_CFG_USE_DYNAMIC
   tp->p_refs++;
 #endif
@@ -154,7 +221,7 @@ thread_t *chRegNextThread(thread_t *tp) {
 
   chSysLock();
   ntp = tp->p_newer;
-  if (ntp == (thread_t *)&ch.rlist) {
+  if (ntp == (thread_t *)&REG_HEADER) {
     ntp = NULL;
   }
 #if CH_CFG_USE_DYNAMIC
@@ -171,6 +238,83 @@ thread_t *chRegNextThread(thread_t *tp) {
   return ntp;
 }
 
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+/**
+ * @brief   Scans the stack of a thread.
+ * @details The stack is scanned from its limit until the first location
+ *          not containing the fill pattern or its end, the result is also
+ *          stored in the thread and can be retrieved later using
+ *          @p chRegGetStackUnusedX().
+ * @note    Only the stacks of the threads created using
+ *          @p chThdCreateStatic() or the dynamic threads APIs are filled,
+ *          the threads created using @p chThdCreateI() and the main
+ *          threads are not scanned and zero is returned.
+ * @note    The stack is read without locking the kernel, the caller must
+ *          hold a reference to the thread, as the one returned by the
+ *          registry functions, or otherwise make sure that the thread
+ *          memory is not released during the scan.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The unused stack size in bytes.
+ *
+ * @api
+ */
+size_t chRegScanStack(thread_t *tp) {
+  size_t n;
+
+  chDbgCheck(tp != NULL);
+
+  n = 0;
+  if (tp->p_stkend != NULL) {
+    n = reg_stack_unused((const uint8_t *)(tp + 1), tp->p_stkend);
+  }
+  tp->p_stkunused = n;
+
+  return n;
+}
+
+/**
+ * @brief   Scans the stacks of all the threads in the registry.
+ * @details The kernel is only locked while moving to the next thread, the
+ *          processor is yielded to the threads at the same priority after
+ *          each scan.
+ *
+ * @api
+ */
+void chRegScanStacks(void) {
+  thread_t *tp;
+
+  tp = chRegFirstThread();
+  do {
+    (void) chRegScanStack(tp);
+    chThdYield();
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+
+/**
+ * @brief   Starts the stack scanner thread.
+ * @details The scanner thread periodically scans the stacks of all the
+ *          threads in the registry, the results can be retrieved using
+ *          @p chRegGetStackUnusedX().
+ * @note    The thread is created at @p LOWPRIO priority, it only competes
+ *          with the other threads at the lowest priority.
+ *
+ * @param[out] wsp      pointer to a working area dedicated to the scanner
+ * @param[in] size      size of the working area
+ * @param[in] interval  interval between the scans
+ * @return              The pointer to the scanner thread.
+ *
+ * @api
+ */
+thread_t *chRegStartStackScanner(void *wsp, size_t size,
+                                 systime_t interval) {
+
+  return chThdCreateStatic(wsp, size, LOWPRIO, reg_scanner_thread,
+                           (void *)(size_t)interval);
+}
+#endif /* CH_DBG_FILL_THREADS */
+
 #endif /* CH_CFG_USE_REGISTRY */
 
 /** @} */
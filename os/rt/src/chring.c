@@ -0,0 +1,259 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chring.c
+ * @brief   Rings code.
+ *
+ * @addtogroup rings
+ * @details Single producer single consumer rings.
+ *          <h2>Operation mode</h2>
+ *          A ring is a circular buffer of fixed size elements shared by
+ *          exactly one producer and one consumer, the capacity is a power
+ *          of two.<br>
+ *          The producer only updates the write counter and the consumer
+ *          only updates the read counter so both sides operate without
+ *          entering the kernel, an ISR can write a burst of elements
+ *          without locking the system.<br>
+ *          Operations defined for rings:
+ *          - <b>Write</b>: Elements are copied into the ring, the number
+ *            of elements written is returned. This operation never blocks
+ *            and can be invoked from any context.
+ *          - <b>Read</b>: Elements are copied from the ring, the number of
+ *            elements read is returned. This operation never blocks and
+ *            can be invoked from any context.
+ *          - <b>Read with timeout</b>: As above but the consumer thread
+ *            waits for data if the ring is empty. Only in this case the
+ *            kernel is entered, the producer wakes the consumer after
+ *            writing.
+ *          .
+ * @pre     In order to use the rings APIs the @p CH_CFG_USE_RINGS option
+ *          must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Copies bytes.
+ *
+ * @param[out] dp       destination pointer
+ * @param[in] sp        source pointer
+ * @param[in] n         number of bytes
+ */
+static void rg_copy(uint8_t *dp, const uint8_t *sp, size_t n) {
+
+  while (n > 0U) {
+    *dp++ = *sp++;
+    n--;
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p ring_t object.
+ *
+ * @param[out] rp       pointer to a @p ring_t structure
+ * @param[in] buf       pointer to the ring buffer, it must be able to contain
+ *                      @p n elements
+ * @param[in] esize     size of an element
+ * @param[in] n         number of elements in the buffer, it must be a power
+ *                      of two
+ *
+ * @init
+ */
+void chRingObjectInit(ring_t *rp, void *buf, size_t esize, size_t n) {
+
+  chDbgCheck((rp != NULL) && (buf != NULL) && (esize > 0U) &&
+             (n > 0U) && ((n & (n - 1U)) == 0U));
+
+  rp->rg_buffer  = (uint8_t *)buf;
+  rp->rg_esize   = esize;
+  rp->rg_mask    = n - 1U;
+  rp->rg_wrcnt   = (size_t)0;
+  rp->rg_rdcnt   = (size_t)0;
+  rp->rg_waiting = false;
+  rp->rg_thread  = NULL;
+}
+
+/**
+ * @brief   Writes elements into a ring.
+ * @details The elements that fit into the ring are written, the consumer
+ *          is woken up if it is waiting for data.
+ * @note    Only the producer can invoke this function.
+ * @note    If invoked from within a critical zone in thread context then
+ *          a reschedule must be performed before leaving the zone.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @param[in] bp        pointer to the elements to be written
+ * @param[in] n         number of elements to be written
+ * @return              The number of elements written.
+ *
+ * @xclass
+ */
+size_t chRingWriteX(ring_t *rp, const void *bp, size_t n) {
+  size_t wr, i, n1;
+
+  chDbgCheck((rp != NULL) && (bp != NULL));
+
+  /* The free slots are only known after reading the consumer counter, the
+     barrier prevents the writes into those slots from being anticipated.*/
+  wr = rp->rg_wrcnt;
+  i = chRingGetSizeX(rp) - (wr - rp->rg_rdcnt);
+  port_memory_barrier();
+  if (n > i) {
+    n = i;
+  }
+  if (n == 0U) {
+    return 0U;
+  }
+
+  /* Copy, in two parts if the buffer end is crossed.*/
+  i = wr & rp->rg_mask;
+  n1 = chRingGetSizeX(rp) - i;
+  if (n1 > n) {
+    n1 = n;
+  }
+  rg_copy(rp->rg_buffer + (i * rp->rg_esize), (const uint8_t *)bp,
+          n1 * rp->rg_esize);
+  rg_copy(rp->rg_buffer, (const uint8_t *)bp + (n1 * rp->rg_esize),
+          (n - n1) * rp->rg_esize);
+
+  /* Publishing the data then checking for a waiting consumer, the
+     consumer does the opposite so at least one side sees the other.*/
+  port_memory_barrier();
+  rp->rg_wrcnt = wr + n;
+  port_memory_barrier();
+  if (rp->rg_waiting) {
+    syssts_t sts = chSysGetStatusAndLockX();
+    chThdResumeI(&rp->rg_thread, MSG_OK);
+    chSysRestoreStatusX(sts);
+  }
+
+  return n;
+}
+
+/**
+ * @brief   Reads elements from a ring.
+ * @note    Only the consumer can invoke this function.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @param[out] bp       pointer to the buffer receiving the elements
+ * @param[in] n         maximum number of elements to be read
+ * @return              The number of elements read.
+ *
+ * @xclass
+ */
+size_t chRingReadX(ring_t *rp, void *bp, size_t n) {
+  size_t rd, i, n1;
+
+  chDbgCheck((rp != NULL) && (bp != NULL));
+
+  rd = rp->rg_rdcnt;
+  i = rp->rg_wrcnt - rd;
+  port_memory_barrier();
+  if (n > i) {
+    n = i;
+  }
+  if (n == 0U) {
+    return 0U;
+  }
+
+  /* Copy, in two parts if the buffer end is crossed.*/
+  i = rd & rp->rg_mask;
+  n1 = chRingGetSizeX(rp) - i;
+  if (n1 > n) {
+    n1 = n;
+  }
+  rg_copy((uint8_t *)bp, rp->rg_buffer + (i * rp->rg_esize),
+          n1 * rp->rg_esize);
+  rg_copy((uint8_t *)bp + (n1 * rp->rg_esize), rp->rg_buffer,
+          (n - n1) * rp->rg_esize);
+
+  /* The slots are released only after the data has been copied.*/
+  port_memory_barrier();
+  rp->rg_rdcnt = rd + n;
+
+  return n;
+}
+
+/**
+ * @brief   Reads elements from a ring.
+ * @details If the ring is empty the invoking thread waits until data is
+ *          written or the specified time runs out, the kernel is entered
+ *          only in this case.
+ * @note    Only the consumer can invoke this function.
+ *
+ * @param[in] rp        pointer to a @p ring_t structure
+ * @param[out] bp       pointer to the buffer receiving the elements
+ * @param[in] n         maximum number of elements to be read
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of elements read, zero if the operation
+ *                      timed out.
+ *
+ * @api
+ */
+size_t chRingReadTimeout(ring_t *rp, void *bp, size_t n, systime_t time) {
+  size_t nr;
+
+  nr = chRingReadX(rp, bp, n);
+  if ((nr > 0U) || (n == 0U) || (time == TIME_IMMEDIATE)) {
+    return nr;
+  }
+
+  chSysLock();
+  rp->rg_waiting = true;
+  port_memory_barrier();
+  if (chRingGetUsedX(rp) == 0U) {
+    (void) chThdSuspendTimeoutS(&rp->rg_thread, time);
+  }
+  rp->rg_waiting = false;
+  chSysUnlock();
+
+  return chRingReadX(rp, bp, n);
+}
+
+#endif /* CH_CFG_USE_RINGS */
+
+/** @} */
@@ -36,10 +36,22 @@
 /* Module exported variables.                                                */
 /*===========================================================================*/
 
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   System data structures, one for each core.
+ */
+ch_system_t ch_cores[PORT_CORES_NUMBER];
+
+/**
+ * @brief   Kernel lock shared among the cores.
+ */
+port_spinlock_t ch_spinlock;
+#else
 /**
  * @brief   System data structures.
  */
 ch_system_t ch;
+#endif
 
 /*===========================================================================*/
 /* Module local types.                                                       */
@@ -53,6 +65,172 @@ ch_system_t ch;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_SCH_SLICE_TIMER || defined(__DOXYGEN__)
+/**
+ * @brief   Time slice expiration callback.
+ * @details The running thread quantum is consumed only if there are threads
+ *          with the same priority waiting for their turn, the preemption is
+ *          then performed on interrupt exit.
+ *
+ * @param[in] p         the callback parameter, unused in this scenario
+ */
+static void slice_expired(void *p) {
+  tprio_t p1;
+
+  (void)p;
+  chSysLockFromISR();
+  p1 = firstprio(&ch.rlist);
+  if ((p1 == currp->p_prio) && !edf_first_later(p1)) {
+    currp->p_preempt = (tslices_t)0;
+  }
+  chSysUnlockFromISR();
+}
+
+/**
+ * @brief   Starts the time slice of the thread becoming current.
+ * @details The slice timer is armed only if there are other threads with
+ *          the same priority in the ready list.
+ */
+static void slice_start(void) {
+  tprio_t p1 = firstprio(&ch.rlist);
+
+  if (chVTIsArmedI(&ch.rlist.r_slice)) {
+    chVTDoResetI(&ch.rlist.r_slice);
+  }
+  if ((p1 == currp->p_prio) && !edf_first_later(p1)) {
+    chVTDoSetI(&ch.rlist.r_slice, (systime_t)CH_CFG_TIME_QUANTUM,
+               slice_expired, NULL);
+  }
+}
+#endif /* CH_SCH_SLICE_TIMER */
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a thread of the EDF priority level in the ready list.
+ * @details The thread is positioned behind the threads with an earlier
+ *          deadline, the threads with the same deadline are passed over
+ *          unless the insertion is performed ahead.
+ *
+ * @param[in] tp        the thread to be inserted
+ * @param[in] ahead     insertion ahead of the threads with the same deadline
+ */
+static void rlist_edf_insert(thread_t *tp, bool ahead) {
+  thread_t *cp;
+
+#if CH_CFG_RLIST_BITMAP
+  thread_t *hp = (thread_t *)&ch.rlist.r_queues[CH_CFG_EDF_PRIO];
+
+  cp = hp->p_next;
+  while ((cp != hp) &&
+         (ahead ? edf_before(cp->p_deadline, tp->p_deadline) :
+                  !edf_before(tp->p_deadline, cp->p_deadline))) {
+    cp = cp->p_next;
+  }
+  rlist_bitmap_set(&ch.rlist, CH_CFG_EDF_PRIO);
+#else
+  cp = ch.rlist.r_queue.p_next;
+  while (cp->p_prio > CH_CFG_EDF_PRIO) {
+    cp = cp->p_next;
+  }
+  while ((cp->p_prio == CH_CFG_EDF_PRIO) &&
+         (ahead ? edf_before(cp->p_deadline, tp->p_deadline) :
+                  !edf_before(tp->p_deadline, cp->p_deadline))) {
+    cp = cp->p_next;
+  }
+#endif
+  /* Insertion on p_prev.*/
+  tp->p_next = cp;
+  tp->p_prev = cp->p_prev;
+  tp->p_prev->p_next = cp->p_prev = tp;
+}
+#endif /* CH_CFG_SCHED_EDF */
+
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @brief   Prepares a preempted thread for insertion in the ready list.
+ * @details If the thread has a preemption threshold above its priority then
+ *          it is made ready at the threshold level, no thread with priority
+ *          not above the threshold can run before it is resumed.
+ * @note    While the thread is ready at its threshold level its priority
+ *          must be changed using @p _threshold_set_base_prio().
+ *
+ * @param[in] tp        the preempted thread
+ */
+static inline void threshold_preempted(thread_t *tp) {
+
+  if (tp->p_threshold > tp->p_prio) {
+    tp->p_savedprio = tp->p_prio;
+    tp->p_prio = tp->p_threshold;
+    tp->p_flags |= CH_FLAG_THRESHOLD;
+  }
+}
+
+/**
+ * @brief   Restores the priority of a thread resumed from the ready list.
+ * @details The saved priority is restored unless threads waiting on the
+ *          mutexes owned by the thread require a higher priority, the
+ *          inherited priority is calculated as done by @p chMtxUnlock().
+ *
+ * @param[in] tp        the resumed thread
+ */
+static inline void threshold_resumed(thread_t *tp) {
+
+  if ((tp->p_flags & CH_FLAG_THRESHOLD) != 0U) {
+    tprio_t newprio = tp->p_savedprio;
+#if CH_CFG_USE_MUTEXES
+    mutex_t *mp = tp->p_mtxlist;
+
+    /* The saved priority can only be above the real priority because of
+       priority inheritance.*/
+    chDbgAssert((tp->p_savedprio >= tp->p_realprio) &&
+                ((mp != NULL) || (tp->p_savedprio == tp->p_realprio)),
+                "stale saved priority");
+
+    /* Priority inherited while the thread was ready at its threshold
+       level.*/
+    while (mp != NULL) {
+      if (queue_notempty(&mp->m_queue) &&
+          (mp->m_queue.p_next->p_prio > newprio)) {
+        newprio = mp->m_queue.p_next->p_prio;
+      }
+      mp = mp->m_next;
+    }
+#endif
+    tp->p_flags &= (tmode_t)~CH_FLAG_THRESHOLD;
+    tp->p_prio = newprio;
+  }
+}
+#endif /* CH_CFG_SCHED_THRESHOLD */
+
+/**
+ * @brief   Removes the first thread from the ready list and returns it.
+ * @pre     The ready list must not be empty.
+ *
+ * @return              The removed thread pointer.
+ *
+ * @notapi
+ */
+static inline thread_t *rlist_remove_first(void) {
+  thread_t *tp;
+
+#if CH_CFG_RLIST_BITMAP
+  tprio_t prio = firstprio(&ch.rlist);
+  threads_queue_t *tqp = &ch.rlist.r_queues[prio];
+
+  tp = queue_fifo_remove(tqp);
+  if (queue_isempty(tqp)) {
+    rlist_bitmap_clear(&ch.rlist, prio);
+  }
+#else
+  tp = queue_fifo_remove(&ch.rlist.r_queue);
+#endif
+#if CH_CFG_SCHED_THRESHOLD
+  threshold_resumed(tp);
+#endif
+
+  return tp;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -66,9 +244,25 @@ void _scheduler_init(void) {
 
   queue_init(&ch.rlist.r_queue);
   ch.rlist.r_prio = NOPRIO;
+#if CH_CFG_RLIST_BITMAP
+  {
+    unsigned i;
+
+    ch.rlist.r_summary = 0U;
+    for (i = 0U; i < CH_RLIST_WORDS; i++) {
+      ch.rlist.r_map[i] = 0U;
+    }
+    for (i = 0U; i < CH_RLIST_LEVELS; i++) {
+      queue_init(&ch.rlist.r_queues[i]);
+    }
+  }
+#endif
 #if CH_CFG_USE_REGISTRY
   ch.rlist.r_newer = ch.rlist.r_older = (thread_t *)&ch.rlist;
 #endif
+#if CH_SCH_SLICE_TIMER
+  chVTObjectInit(&ch.rlist.r_slice);
+#endif
 }
 
 #if !CH_CFG_OPTIMIZE_SPEED || defined(__DOXYGEN__)
@@ -201,7 +395,14 @@ thread_t *list_remove(threads_list_t *tlp) {
 /**
  * @brief   Inserts a thread in the Ready List.
  * @details The thread is positioned behind all threads with higher or equal
- *          priority.
+ *          priority, at the EDF priority level behind all threads with an
+ *          earlier or equal deadline.
+ * @note    If @p CH_CFG_RLIST_BITMAP is enabled then the insertion is
+ *          performed in constant time regardless of the number of ready
+ *          threads.
+ * @note    In SMP mode the thread is inserted in the Ready List of the core
+ *          it is bound to, if it is not the current core then that core is
+ *          notified.
  * @pre     The thread must not be already inserted in any list through its
  *          @p p_next and @p p_prev or list corruption would occur.
  * @post    This function does not reschedule so a call to a rescheduling
@@ -215,7 +416,9 @@ thread_t *list_remove(threads_list_t *tlp) {
  * @iclass
  */
 thread_t *chSchReadyI(thread_t *tp) {
+#if !CH_CFG_RLIST_BITMAP
   thread_t *cp;
+#endif
 
   chDbgCheckClassI();
   chDbgCheck(tp != NULL);
@@ -224,7 +427,34 @@ thread_t *chSchReadyI(thread_t *tp) {
               "invalid state");
 
   tp->p_state = CH_STATE_READY;
+#if CH_SCH_SLICE_TIMER
+  /* A thread with the same priority of the running one becomes ready, the
+     time slice of the running thread starts if not already running.*/
+  if ((tp != currp) && (tp->p_prio == currp->p_prio) &&
+      !chVTIsArmedI(&ch.rlist.r_slice)) {
+    chVTDoSetI(&ch.rlist.r_slice, (systime_t)CH_CFG_TIME_QUANTUM,
+               slice_expired, NULL);
+  }
+#endif
+#if CH_CFG_SCHED_EDF
+  if (tp->p_prio == CH_CFG_EDF_PRIO) {
+    rlist_edf_insert(tp, false);
+    return tp;
+  }
+#endif
+#if CH_CFG_RLIST_BITMAP
+  chDbgAssert(tp->p_prio < CH_RLIST_LEVELS, "invalid priority");
+
+  /* Insertion at the end of the queue associated to the thread priority.*/
+  queue_insert(tp, &ch.rlist.r_queues[tp->p_prio]);
+  rlist_bitmap_set(&ch.rlist, tp->p_prio);
+#else
+#if CH_CFG_SMP_MODE
+  /* The thread is inserted in the ready list of the core it is bound to.*/
+  cp = (thread_t *)&ch_cores[tp->p_core].rlist.r_queue;
+#else
   cp = (thread_t *)&ch.rlist.r_queue;
+#endif
   do {
     cp = cp->p_next;
   } while (cp->p_prio >= tp->p_prio);
@@ -232,10 +462,59 @@ thread_t *chSchReadyI(thread_t *tp) {
   tp->p_next = cp;
   tp->p_prev = cp->p_prev;
   tp->p_prev->p_next = cp->p_prev = tp;
+#endif
+#if CH_CFG_SMP_MODE
+  /* The other core is notified, it will reschedule if required.*/
+  if (tp->p_core != port_get_core_id()) {
+    port_notify_core(tp->p_core);
+  }
+#endif
 
   return tp;
 }
 
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @brief   Changes the priority of a thread ready at its threshold level.
+ * @details The new priority is stored as the priority to be restored when
+ *          the thread is resumed, a priority boosted by priority
+ *          inheritance is not lowered. The thread is re-enqueued only if
+ *          the new priority is above its current level.
+ * @pre     The thread must be flagged with @p CH_FLAG_THRESHOLD.
+ * @note    Not an user function, the functions changing the priority of
+ *          a thread in any state must use this function for the threads
+ *          raised to their threshold level.
+ *
+ * @param[in] tp        the thread
+ * @param[in] newprio   the new priority level
+ *
+ * @notapi
+ */
+void _threshold_set_base_prio(thread_t *tp, tprio_t newprio) {
+
+  chDbgAssert(((tp->p_flags & CH_FLAG_THRESHOLD) != 0U) &&
+              (tp->p_state == CH_STATE_READY),
+              "not ready at threshold level");
+
+#if CH_CFG_USE_MUTEXES
+  if ((tp->p_savedprio != tp->p_realprio) && (newprio <= tp->p_savedprio)) {
+    tp->p_realprio = newprio;
+    return;
+  }
+  tp->p_realprio = newprio;
+#endif
+  tp->p_savedprio = newprio;
+  if (newprio > tp->p_prio) {
+    tp->p_prio = newprio;
+#if CH_DBG_ENABLE_ASSERTS
+    /* Prevents an assertion in chSchReadyI().*/
+    tp->p_state = CH_STATE_CURRENT;
+#endif
+    chSchReadyI(rlist_dequeue(tp));
+  }
+}
+#endif /* CH_CFG_SCHED_THRESHOLD */
+
 /**
  * @brief   Puts the current thread to sleep into the specified state.
  * @details The thread goes into a sleeping state. The possible
@@ -256,13 +535,16 @@ void chSchGoSleepS(tstate_t newstate) {
      time quantum when it will wakeup.*/
   otp->p_preempt = CH_CFG_TIME_QUANTUM;
 #endif
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove_first());
 #if defined(CH_CFG_IDLE_ENTER_HOOK)
   if (currp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_ENTER_HOOK();
   }
 #endif
   currp->p_state = CH_STATE_CURRENT;
+#if CH_SCH_SLICE_TIMER
+  slice_start();
+#endif
   chSysSwitch(currp, otp);
 }
 
@@ -364,15 +646,29 @@ void chSchWakeupS(thread_t *ntp, msg_t msg) {
      restart execution.*/
   ntp->p_u.rdymsg = msg;
 
+#if CH_CFG_SMP_MODE
+  /* Threads bound to other cores are just made ready, their core is
+     notified.*/
+  if (ntp->p_core != port_get_core_id()) {
+    chSchReadyI(ntp);
+    return;
+  }
+#endif
+
   /* If the waken thread has a not-greater priority than the current
      one then it is just inserted in the ready list else it made
      running immediately and the invoking thread goes in the ready
      list instead.*/
-  if (ntp->p_prio <= currp->p_prio) {
+  if ((ntp->p_prio <= preemptprio(currp)) && !edf_preempts(ntp)) {
     chSchReadyI(ntp);
   }
   else {
-    thread_t *otp = chSchReadyI(currp);
+    thread_t *otp;
+
+#if CH_CFG_SCHED_THRESHOLD
+    threshold_preempted(currp);
+#endif
+    otp = chSchReadyI(currp);
     setcurrp(ntp);
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
@@ -380,6 +676,9 @@ void chSchWakeupS(thread_t *ntp, msg_t msg) {
   }
 #endif
     ntp->p_state = CH_STATE_CURRENT;
+#if CH_SCH_SLICE_TIMER
+    slice_start();
+#endif
     chSysSwitch(ntp, otp);
   }
 }
@@ -414,19 +713,25 @@ void chSchRescheduleS(void) {
  * @special
  */
 bool chSchIsPreemptionRequired(void) {
-  tprio_t p1 = firstprio(&ch.rlist.r_queue);
-  tprio_t p2 = currp->p_prio;
+  tprio_t p1 = firstprio(&ch.rlist);
+  tprio_t pt = preemptprio(currp);
 
 #if CH_CFG_TIME_QUANTUM > 0
+  tprio_t p2 = currp->p_prio;
+
   /* If the running thread has not reached its time quantum, reschedule only
      if the first thread on the ready queue has a higher priority.
      Otherwise, if the running thread has used up its time quantum, reschedule
-     if the first thread on the ready queue has equal or higher priority.*/
-  return currp->p_preempt ? p1 > p2 : p1 >= p2;
+     if the first thread on the ready queue has equal or higher priority.
+     A preemption threshold above the thread priority disables the round
+     robin.*/
+  return (currp->p_preempt || (pt != p2)) ?
+         (p1 > pt) || edf_first_preempts(p1) :
+         (p1 >= p2) && !edf_first_later(p1);
 #else
   /* If the round robin preemption feature is not enabled then performs a
      simpler comparison.*/
-  return p1 > p2;
+  return (p1 > pt) || edf_first_preempts(p1);
 #endif
 }
 
@@ -445,7 +750,7 @@ void chSchDoRescheduleBehind(void) {
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove_first());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -454,6 +759,9 @@ void chSchDoRescheduleBehind(void) {
   currp->p_state = CH_STATE_CURRENT;
 #if CH_CFG_TIME_QUANTUM > 0
   otp->p_preempt = CH_CFG_TIME_QUANTUM;
+#endif
+#if CH_SCH_SLICE_TIMER
+  slice_start();
 #endif
   chSchReadyI(otp);
   chSysSwitch(currp, otp);
@@ -469,11 +777,16 @@ void chSchDoRescheduleBehind(void) {
  * @special
  */
 void chSchDoRescheduleAhead(void) {
-  thread_t *otp, *cp;
+  thread_t *otp;
+#if CH_CFG_RLIST_BITMAP
+  threads_queue_t *tqp;
+#else
+  thread_t *cp;
+#endif
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove_first());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -482,14 +795,38 @@ void chSchDoRescheduleAhead(void) {
   currp->p_state = CH_STATE_CURRENT;
 
   otp->p_state = CH_STATE_READY;
-  cp = (thread_t *)&ch.rlist.r_queue;
-  do {
-    cp = cp->p_next;
-  } while (cp->p_prio > otp->p_prio);
-  /* Insertion on p_prev.*/
-  otp->p_next = cp;
-  otp->p_prev = cp->p_prev;
-  otp->p_prev->p_next = cp->p_prev = otp;
+#if CH_CFG_SCHED_THRESHOLD
+  threshold_preempted(otp);
+#endif
+#if CH_CFG_SCHED_EDF
+  if (otp->p_prio == CH_CFG_EDF_PRIO) {
+    rlist_edf_insert(otp, true);
+  }
+  else
+#endif
+  {
+#if CH_CFG_RLIST_BITMAP
+    /* Insertion at the head of the queue associated to the thread
+       priority.*/
+    tqp = &ch.rlist.r_queues[otp->p_prio];
+    otp->p_prev = (thread_t *)tqp;
+    otp->p_next = tqp->p_next;
+    otp->p_next->p_prev = tqp->p_next = otp;
+    rlist_bitmap_set(&ch.rlist, otp->p_prio);
+#else
+    cp = (thread_t *)&ch.rlist.r_queue;
+    do {
+      cp = cp->p_next;
+    } while (cp->p_prio > otp->p_prio);
+    /* Insertion on p_prev.*/
+    otp->p_next = cp;
+    otp->p_prev = cp->p_prev;
+    otp->p_prev->p_next = cp->p_prev = otp;
+#endif
+  }
+#if CH_SCH_SLICE_TIMER
+  slice_start();
+#endif
 
   chSysSwitch(currp, otp);
 }
@@ -508,8 +845,9 @@ void chSchDoReschedule(void) {
 
 #if CH_CFG_TIME_QUANTUM > 0
   /* If CH_CFG_TIME_QUANTUM is enabled then there are two different scenarios
-     to handle on preemption: time quantum elapsed or not.*/
-  if (currp->p_preempt == 0) {
+     to handle on preemption: time quantum elapsed or not. A thread with a
+     preemption threshold above its priority is always preempted.*/
+  if ((currp->p_preempt == 0) && (preemptprio(currp) == currp->p_prio)) {
     /* The thread consumed its time quantum so it is enqueued behind threads
        with same priority level, however, it acquires a new time quantum.*/
     chSchDoRescheduleBehind();
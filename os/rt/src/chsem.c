@@ -81,6 +81,16 @@
 #define sem_insert(tp, qp) queue_insert(tp, qp)
 #endif
 
+#if CH_CFG_USE_WAITSETS
+#define sem_signal_waitset(sp) {                                            \
+  if (((sp)->s_cnt > (cnt_t)0) && ((sp)->s_wse != NULL)) {                  \
+    _waitset_signal((sp)->s_wse);                                           \
+  }                                                                         \
+}
+#else
+#define sem_signal_waitset(sp)
+#endif
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -100,6 +110,9 @@ void chSemObjectInit(semaphore_t *sp, cnt_t n) {
 
   queue_init(&sp->s_queue);
   sp->s_cnt = n;
+#if CH_CFG_USE_WAITSETS
+  sp->s_wse = NULL;
+#endif
 }
 
 /**
@@ -158,6 +171,7 @@ void chSemResetI(semaphore_t *sp, cnt_t n) {
   while (++cnt <= 0) {
     chSchReadyI(queue_lifo_remove(&sp->s_queue))->p_u.rdymsg = MSG_RESET;
   }
+  sem_signal_waitset(sp);
 }
 
 /**
@@ -302,6 +316,12 @@ void chSemSignal(semaphore_t *sp) {
   if (++sp->s_cnt <= 0) {
     chSchWakeupS(queue_fifo_remove(&sp->s_queue), MSG_OK);
   }
+#if CH_CFG_USE_WAITSETS
+  else if (sp->s_wse != NULL) {
+    _waitset_signal(sp->s_wse);
+    chSchRescheduleS();
+  }
+#endif
   chSysUnlock();
 }
 
@@ -331,6 +351,7 @@ void chSemSignalI(semaphore_t *sp) {
     tp->p_u.rdymsg = MSG_OK;
     chSchReadyI(tp);
   }
+  sem_signal_waitset(sp);
 }
 
 /**
@@ -360,6 +381,7 @@ void chSemAddCounterI(semaphore_t *sp, cnt_t n) {
     }
     n--;
   }
+  sem_signal_waitset(sp);
 }
 
 /**
@@ -390,6 +412,7 @@ msg_t chSemSignalWait(semaphore_t *sps, semaphore_t *spw) {
   if (++sps->s_cnt <= 0) {
     chSchReadyI(queue_fifo_remove(&sps->s_queue))->p_u.rdymsg = MSG_OK;
   }
+  sem_signal_waitset(sps);
   if (--spw->s_cnt < 0) {
     thread_t *ctp = currp;
     sem_insert(ctp, &spw->s_queue);
@@ -73,6 +73,48 @@ static void _idle_thread(void *p) {
 }
 #endif /* CH_CFG_NO_IDLE_THREAD */
 
+/**
+ * @brief   Makes the current instructions flow the main thread.
+ * @details The main thread is created and, if enabled, the idle thread.
+ */
+static void _main_thread_init(void) {
+#if CH_DBG_ENABLE_STACK_CHECK
+  extern stkalign_t __main_thread_stack_base__;
+#endif
+
+  /* In SMP mode the other cores could be already running, the registry
+     is shared.*/
+  _smp_lock();
+#if !CH_CFG_NO_IDLE_THREAD
+  /* Now this instructions flow becomes the main thread.*/
+  setcurrp(_thread_init(&ch.mainthread, NORMALPRIO));
+#else
+  /* Now this instructions flow becomes the idle thread.*/
+  setcurrp(_thread_init(&ch.mainthread, IDLEPRIO));
+#endif
+  _smp_unlock();
+
+  currp->p_state = CH_STATE_CURRENT;
+#if CH_DBG_ENABLE_STACK_CHECK
+  /* This is a special case because the main thread thread_t structure is not
+     adjacent to its stack area.*/
+  currp->p_stklimit = &__main_thread_stack_base__;
+#endif
+  chSysEnable();
+
+  /* Note, &ch_debug points to the string "main" if the registry is
+     active, else the parameter is ignored.*/
+  chRegSetThreadName((const char *)&ch_debug);
+
+#if !CH_CFG_NO_IDLE_THREAD
+  /* This thread has the lowest priority in the system, its role is just to
+     serve interrupts in its context while keeping the lowest energy saving
+     mode compatible with the system status.*/
+  chThdCreateStatic(ch.idle_thread_wa, sizeof(ch.idle_thread_wa), IDLEPRIO,
+                    (tfunc_t)_idle_thread, NULL);
+#endif
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -85,12 +127,12 @@ static void _idle_thread(void *p) {
  * @post    The main thread is created with priority @p NORMALPRIO and
  *          interrupts are enabled.
  *
+ * @note    In SMP mode this function must be invoked by the core zero, the
+ *          other cores must invoke @p chSysInitCore() afterward.
+ *
  * @special
  */
 void chSysInit(void) {
-#if CH_DBG_ENABLE_STACK_CHECK
-  extern stkalign_t __main_thread_stack_base__;
-#endif
 
   port_init();
   _scheduler_init();
@@ -111,34 +153,49 @@ void chSysInit(void) {
   _dbg_trace_init();
 #endif
 
-#if !CH_CFG_NO_IDLE_THREAD
-  /* Now this instructions flow becomes the main thread.*/
-  setcurrp(_thread_init(&ch.mainthread, NORMALPRIO));
-#else
-  /* Now this instructions flow becomes the idle thread.*/
-  setcurrp(_thread_init(&ch.mainthread, IDLEPRIO));
-#endif
+  _main_thread_init();
 
-  currp->p_state = CH_STATE_CURRENT;
-#if CH_DBG_ENABLE_STACK_CHECK
-  /* This is a special case because the main thread thread_t structure is not
-     adjacent to its stack area.*/
-  currp->p_stklimit = &__main_thread_stack_base__;
+#if CH_CFG_VT_DEFERRED
+  /* This thread invokes the callbacks of the deferred virtual timers.*/
+  chThdCreateStatic(ch.vtdeferred_wa, sizeof(ch.vtdeferred_wa),
+                    CH_CFG_VT_DEFERRED_PRIO, (tfunc_t)_vt_deferred_thread,
+                    NULL);
 #endif
-  chSysEnable();
+}
 
-  /* Note, &ch_debug points to the string "main" if the registry is
-     active, else the parameter is ignored.*/
-  chRegSetThreadName((const char *)&ch_debug);
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   ChibiOS/RT initialization on the other cores.
+ * @details Initializes the scheduler and the virtual timers of the
+ *          executing core, after executing this function the current
+ *          instructions stream becomes the main thread of the core.
+ * @pre     The function @p chSysInit() must have been already executed
+ *          by the core zero.
+ * @pre     Interrupts must disabled before invoking this function.
+ * @post    The main thread is created with priority @p NORMALPRIO and
+ *          interrupts are enabled.
+ *
+ * @special
+ */
+void chSysInitCore(void) {
 
-#if !CH_CFG_NO_IDLE_THREAD
-  /* This thread has the lowest priority in the system, its role is just to
-     serve interrupts in its context while keeping the lowest energy saving
-     mode compatible with the system status.*/
-  chThdCreateStatic(ch.idle_thread_wa, sizeof(ch.idle_thread_wa), IDLEPRIO,
-                    (tfunc_t)_idle_thread, NULL);
+  chDbgAssert(port_get_core_id() != 0U, "not allowed on core zero");
+
+  _scheduler_init();
+  _vt_init();
+#if CH_CFG_USE_TM
+  _tm_init();
 #endif
+#if CH_DBG_STATISTICS
+  _stats_init();
+#endif
+#if CH_DBG_ENABLE_TRACE
+  _dbg_trace_init();
+#endif
+
+  _main_thread_init();
 }
+#endif /* CH_CFG_SMP_MODE */
 
 /**
  * @brief   Halts the system.
@@ -183,7 +240,7 @@ void chSysTimerHandlerI(void) {
 
   chDbgCheckClassI();
 
-#if CH_CFG_TIME_QUANTUM > 0
+#if (CH_CFG_TIME_QUANTUM > 0) && (CH_CFG_ST_TIMEDELTA == 0)
   /* Running thread has not used up quantum yet? */
   if (currp->p_preempt > 0)
     /* Decrement remaining quantum.*/
@@ -191,6 +248,16 @@ void chSysTimerHandlerI(void) {
 #endif
 #if CH_DBG_THREADS_PROFILING
   currp->p_time++;
+#endif
+#if CH_CFG_SCHED_BUDGET
+  /* The running thread is charged for the whole tick, it is demoted when
+     its budget for the current period is used up.*/
+  if ((currp->p_budget != NULL) &&
+      (currp->p_budget->tb_remaining > (systime_t)0)) {
+    if (--currp->p_budget->tb_remaining == (systime_t)0) {
+      _thread_budget_exhausted(currp);
+    }
+  }
 #endif
   chVTDoTickI();
 #if defined(CH_CFG_SYSTEM_TICK_HOOK)
@@ -0,0 +1,373 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chthdpool.c
+ * @brief   Thread pools code.
+ *
+ * @addtogroup thread_pools
+ * @details Fixed sets of worker threads executing short jobs.
+ *          <h2>Operation mode</h2>
+ *          A thread pool owns a set of worker threads, all at the same
+ *          priority, and a queue of jobs. A job is a function and its
+ *          argument, jobs are executed by the first available worker in
+ *          FIFO order.<br>
+ *          Compared to the creation of a dynamic thread for each job the
+ *          stack allocation, the thread initialization and the release of
+ *          the terminated thread are paid only once, when the pool is
+ *          started.<br>
+ *          Operations defined for thread pools:
+ *          - <b>Submit</b>: A job is queued, the submitting thread waits
+ *            if all the job descriptors are in use.
+ *          - <b>Wait</b>: The invoking thread waits until all the
+ *            submitted jobs have been completed.
+ *          - <b>Stop</b>: The workers terminate after executing the queued
+ *            jobs.
+ *          .
+ *          The job descriptors are allocated from a guarded pool loaded
+ *          with an array given on initialization, the number of
+ *          descriptors limits the number of pending jobs.
+ * @pre     In order to use the thread pools APIs the
+ *          @p CH_CFG_USE_THREADPOOLS option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Queues a job.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] jp        pointer to a free job descriptor
+ * @param[in] func      the job function
+ * @param[in] arg       the job function argument
+ *
+ * @notapi
+ */
+static void tp_enqueue(thread_pool_t *tpp, thread_pool_job_t *jp,
+                       tpfunc_t func, void *arg) {
+
+  jp->tj_next = NULL;
+  jp->tj_func = func;
+  jp->tj_arg  = arg;
+  if (tpp->tp_tail == NULL) {
+    tpp->tp_head = jp;
+  }
+  else {
+    tpp->tp_tail->tj_next = jp;
+  }
+  tpp->tp_tail = jp;
+  tpp->tp_pending++;
+  chSemSignalI(&tpp->tp_sem);
+}
+
+/**
+ * @brief   Worker thread.
+ *
+ * @param[in] p         pointer to the @p thread_pool_t structure
+ * @return              The exit message, always zero.
+ */
+static msg_t tp_worker(void *p) {
+  thread_pool_t *tpp = (thread_pool_t *)p;
+
+  while (true) {
+    thread_pool_job_t *jp;
+    tpfunc_t func;
+    void *arg;
+
+    chSysLock();
+    (void) chSemWaitS(&tpp->tp_sem);
+    jp = tpp->tp_head;
+    if (jp == NULL) {
+      /* Stop request, the queue has been drained.*/
+      chSysUnlock();
+      return 0;
+    }
+    tpp->tp_head = jp->tj_next;
+    if (tpp->tp_head == NULL) {
+      tpp->tp_tail = NULL;
+    }
+    func = jp->tj_func;
+    arg  = jp->tj_arg;
+    chGuardedPoolFreeI(&tpp->tp_free, jp);
+    chSchRescheduleS();
+    chSysUnlock();
+
+    func(arg);
+
+    chSysLock();
+    if (--tpp->tp_pending == (size_t)0) {
+      chThdDequeueAllI(&tpp->tp_waiting, MSG_OK);
+      chSchRescheduleS();
+    }
+    chSysUnlock();
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p thread_pool_t object.
+ * @note    The pool has no workers after initialization, workers are added
+ *          using @p chThdPoolAddWorker().
+ *
+ * @param[out] tpp      pointer to a @p thread_pool_t structure
+ * @param[in] jobs      array of job descriptors
+ * @param[in] n         number of job descriptors in the array, it is the
+ *                      maximum number of jobs queued at the same time
+ * @param[in] prio      the priority level of the workers
+ *
+ * @init
+ */
+void chThdPoolObjectInit(thread_pool_t *tpp, thread_pool_job_t *jobs,
+                         size_t n, tprio_t prio) {
+
+  chDbgCheck((tpp != NULL) && (jobs != NULL) && (n > (size_t)0) &&
+             (prio <= HIGHPRIO));
+
+  chGuardedPoolObjectInit(&tpp->tp_free, sizeof (thread_pool_job_t));
+  chGuardedPoolLoadArray(&tpp->tp_free, jobs, n);
+  chSemObjectInit(&tpp->tp_sem, (cnt_t)0);
+  tpp->tp_head    = NULL;
+  tpp->tp_tail    = NULL;
+  tpp->tp_pending = (size_t)0;
+  chThdQueueObjectInit(&tpp->tp_waiting);
+  tpp->tp_prio    = prio;
+  tpp->tp_workers = 0U;
+}
+
+/**
+ * @brief   Adds a worker thread to a thread pool.
+ * @details The worker is created at the pool priority and starts serving
+ *          the jobs queue immediately.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[out] wsp      pointer to a working area dedicated to the worker
+ * @param[in] size      size of the working area
+ * @return              The pointer to the @p thread_t structure of the
+ *                      worker.
+ *
+ * @api
+ */
+thread_t *chThdPoolAddWorker(thread_pool_t *tpp, void *wsp, size_t size) {
+
+  chDbgCheck(tpp != NULL);
+
+  chSysLock();
+  tpp->tp_workers++;
+  chSysUnlock();
+
+  return chThdCreateStatic(wsp, size, tpp->tp_prio, tp_worker, tpp);
+}
+
+/**
+ * @brief   Submits a job to a thread pool.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if there are no free job descriptors.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] func      the job function
+ * @param[in] arg       the job function argument
+ * @return              The operation status.
+ * @retval MSG_OK       if the job has been queued.
+ * @retval MSG_TIMEOUT  if there are no free job descriptors.
+ *
+ * @iclass
+ */
+msg_t chThdPoolSubmitI(thread_pool_t *tpp, tpfunc_t func, void *arg) {
+  thread_pool_job_t *jp;
+
+  chDbgCheckClassI();
+  chDbgCheck((tpp != NULL) && (func != NULL));
+
+  jp = (thread_pool_job_t *)chGuardedPoolAllocI(&tpp->tp_free);
+  if (jp == NULL) {
+    return MSG_TIMEOUT;
+  }
+  tp_enqueue(tpp, jp, func, arg);
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Submits a job to a thread pool.
+ * @details The invoking thread waits until a job descriptor is available
+ *          or the specified time runs out.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] func      the job function
+ * @param[in] arg       the job function argument
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the job has been queued.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chThdPoolSubmitTimeoutS(thread_pool_t *tpp, tpfunc_t func,
+                              void *arg, systime_t time) {
+  thread_pool_job_t *jp;
+
+  chDbgCheckClassS();
+  chDbgCheck((tpp != NULL) && (func != NULL));
+
+  jp = (thread_pool_job_t *)chGuardedPoolAllocTimeoutS(&tpp->tp_free, time);
+  if (jp == NULL) {
+    return MSG_TIMEOUT;
+  }
+  tp_enqueue(tpp, jp, func, arg);
+  chSchRescheduleS();
+
+  return MSG_OK;
+}
+
+/**
+ * @brief   Submits a job to a thread pool.
+ * @details The invoking thread waits until a job descriptor is available
+ *          or the specified time runs out.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] func      the job function
+ * @param[in] arg       the job function argument
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if the job has been queued.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chThdPoolSubmitTimeout(thread_pool_t *tpp, tpfunc_t func,
+                             void *arg, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chThdPoolSubmitTimeoutS(tpp, func, arg, time);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Waits for the completion of all the submitted jobs.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if all the jobs have been completed.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chThdPoolWaitTimeoutS(thread_pool_t *tpp, systime_t time) {
+
+  chDbgCheckClassS();
+  chDbgCheck(tpp != NULL);
+
+  if (tpp->tp_pending == (size_t)0) {
+    return MSG_OK;
+  }
+
+  return chThdEnqueueTimeoutS(&tpp->tp_waiting, time);
+}
+
+/**
+ * @brief   Waits for the completion of all the submitted jobs.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       if all the jobs have been completed.
+ * @retval MSG_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chThdPoolWaitTimeout(thread_pool_t *tpp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chThdPoolWaitTimeoutS(tpp, time);
+  chSysUnlock();
+
+  return msg;
+}
+
+/**
+ * @brief   Stops the workers of a thread pool.
+ * @details The jobs already queued are executed then the workers
+ *          terminate, the workers can be joined using @p chThdWait() if
+ *          @p CH_CFG_USE_WAITEXIT is enabled.
+ * @note    No jobs can be submitted after this function has been invoked
+ *          and until the pool is initialized again.
+ *
+ * @param[in] tpp       pointer to a @p thread_pool_t structure
+ *
+ * @api
+ */
+void chThdPoolStop(thread_pool_t *tpp) {
+
+  chDbgCheck(tpp != NULL);
+
+  chSysLock();
+  while (tpp->tp_workers > 0U) {
+    tpp->tp_workers--;
+    chSemSignalI(&tpp->tp_sem);
+  }
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+#endif /* CH_CFG_USE_THREADPOOLS */
+
+/** @} */
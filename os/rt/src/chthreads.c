@@ -74,6 +74,113 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Changes the priority of a thread in any state.
+ * @details The thread is re-enqueued with its new priority if it is in the
+ *          ready list or in a priority ordered queue.
+ * @note    A priority boosted by priority inheritance is not lowered, the
+ *          new priority becomes effective when the mutexes are released.
+ *
+ * @param[in] tp        the thread
+ * @param[in] newprio   the new priority level
+ */
+static void thread_set_prio(thread_t *tp, tprio_t newprio) {
+
+#if CH_CFG_SCHED_THRESHOLD
+  /* A thread ready at its threshold level has its priority saved.*/
+  if ((tp->p_flags & CH_FLAG_THRESHOLD) != 0U) {
+    _threshold_set_base_prio(tp, newprio);
+    return;
+  }
+#endif
+#if CH_CFG_USE_MUTEXES
+  if ((tp->p_prio != tp->p_realprio) && (newprio <= tp->p_prio)) {
+    tp->p_realprio = newprio;
+    return;
+  }
+  tp->p_realprio = newprio;
+#endif
+  tp->p_prio = newprio;
+
+  /* The following states need priority queues reordering.*/
+  switch (tp->p_state) {
+#if CH_CFG_USE_MUTEXES |                                                    \
+    CH_CFG_USE_CONDVARS |                                                   \
+    (CH_CFG_USE_SEMAPHORES && CH_CFG_USE_SEMAPHORES_PRIORITY) |             \
+    (CH_CFG_USE_MESSAGES && CH_CFG_USE_MESSAGES_PRIORITY)
+#if CH_CFG_USE_MUTEXES
+  case CH_STATE_WTMTX:
+#endif
+#if CH_CFG_USE_CONDVARS
+  case CH_STATE_WTCOND:
+#endif
+#if CH_CFG_USE_SEMAPHORES && CH_CFG_USE_SEMAPHORES_PRIORITY
+  case CH_STATE_WTSEM:
+#endif
+#if CH_CFG_USE_MESSAGES && CH_CFG_USE_MESSAGES_PRIORITY
+  case CH_STATE_SNDMSGQ:
+#endif
+    queue_prio_insert(queue_dequeue(tp), (threads_queue_t *)tp->p_u.wtobjp);
+    break;
+#endif
+  case CH_STATE_READY:
+#if CH_DBG_ENABLE_ASSERTS
+    /* Prevents an assertion in chSchReadyI().*/
+    tp->p_state = CH_STATE_CURRENT;
+#endif
+    chSchReadyI(rlist_dequeue(tp));
+    break;
+  default:
+    break;
+  }
+}
+
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+/**
+ * @brief   Restores the priority of a demoted thread.
+ *
+ * @param[in] bp        pointer to the @p thread_budget_t object
+ */
+static void budget_restore(thread_budget_t *bp) {
+
+  if (bp->tb_demoted) {
+    bp->tb_demoted = false;
+    thread_set_prio(bp->tb_thread, bp->tb_savedprio);
+  }
+}
+
+/**
+ * @brief   Budget replenishment callback.
+ *
+ * @param[in] p         pointer to the @p thread_budget_t object
+ */
+static void budget_replenish(void *p) {
+  thread_budget_t *bp = (thread_budget_t *)p;
+
+  chSysLockFromISR();
+  bp->tb_remaining = bp->tb_budget;
+  budget_restore(bp);
+  chVTDoSetI(&bp->tb_timer, bp->tb_period, budget_replenish, bp);
+  chSysUnlockFromISR();
+}
+
+/**
+ * @brief   Detaches the CPU budget from a thread.
+ *
+ * @param[in] tp        the thread
+ */
+static void budget_detach(thread_t *tp) {
+  thread_budget_t *bp = tp->p_budget;
+
+  if (chVTIsArmedI(&bp->tb_timer)) {
+    chVTDoResetI(&bp->tb_timer);
+  }
+  budget_restore(bp);
+  bp->tb_thread = NULL;
+  tp->p_budget = NULL;
+}
+#endif /* CH_CFG_SCHED_BUDGET */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -96,6 +203,18 @@ thread_t *_thread_init(thread_t *tp, tprio_t prio) {
 #if CH_CFG_TIME_QUANTUM > 0
   tp->p_preempt = CH_CFG_TIME_QUANTUM;
 #endif
+#if CH_CFG_SCHED_EDF
+  tp->p_deadline = chVTGetSystemTimeX();
+#endif
+#if CH_CFG_SCHED_THRESHOLD
+  tp->p_threshold = NOPRIO;
+#endif
+#if CH_CFG_SCHED_BUDGET
+  tp->p_budget = NULL;
+#endif
+#if CH_CFG_SMP_MODE
+  tp->p_core = port_get_core_id();
+#endif
 #if CH_CFG_USE_MUTEXES
   tp->p_realprio = prio;
   tp->p_mtxlist = NULL;
@@ -109,8 +228,18 @@ thread_t *_thread_init(thread_t *tp, tprio_t prio) {
 #if CH_CFG_USE_DYNAMIC
   tp->p_refs = 1;
 #endif
+#if CH_CFG_USE_HEAP_CACHE
+  tp->p_hcache = NULL;
+#endif
 #if CH_CFG_USE_REGISTRY
   tp->p_name = NULL;
+#if CH_CFG_USE_PERIODIC
+  tp->p_periodic = NULL;
+#endif
+#if CH_DBG_FILL_THREADS
+  tp->p_stkunused = (size_t)0;
+  tp->p_stkend = NULL;
+#endif
   REG_INSERT(tp);
 #endif
 #if CH_CFG_USE_WAITEXIT
@@ -118,6 +247,10 @@ thread_t *_thread_init(thread_t *tp, tprio_t prio) {
 #endif
 #if CH_CFG_USE_MESSAGES
   queue_init(&tp->p_msgqueue);
+#if CH_CFG_USE_MESSAGES_ASYNC
+  tp->p_amsghead = NULL;
+  tp->p_amsgtail = NULL;
+#endif
 #endif
 #if CH_DBG_ENABLE_STACK_CHECK
   tp->p_stklimit = (stkalign_t *)(tp + 1);
@@ -219,7 +352,11 @@ thread_t *chThdCreateStatic(void *wsp, size_t size,
 #endif
 
   chSysLock();
-  chSchWakeupS(tp = chThdCreateI(wsp, size, prio, pf, arg), MSG_OK);
+  tp = chThdCreateI(wsp, size, prio, pf, arg);
+#if CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS
+  tp->p_stkend = (uint8_t *)wsp + size;
+#endif
+  chSchWakeupS(tp, MSG_OK);
   chSysUnlock();
 
   return tp;
@@ -263,20 +400,140 @@ tprio_t chThdSetPriority(tprio_t newprio) {
   chSysLock();
 #if CH_CFG_USE_MUTEXES
   oldprio = currp->p_realprio;
-  if ((currp->p_prio == currp->p_realprio) || (newprio > currp->p_prio)) {
-    currp->p_prio = newprio;
-  }
-  currp->p_realprio = newprio;
 #else
   oldprio = currp->p_prio;
-  currp->p_prio = newprio;
 #endif
+  thread_set_prio(currp, newprio);
   chSchRescheduleS();
   chSysUnlock();
 
   return oldprio;
 }
 
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @brief   Changes the running thread preemption threshold.
+ * @details While the threshold is above the thread priority the thread can
+ *          only be preempted by threads with priority greater than the
+ *          threshold, the other threads made ready meanwhile wait until the
+ *          thread lowers its threshold or goes to sleep. Lowering the
+ *          threshold can cause an immediate reschedule.
+ * @note    Threads are created with a threshold equal to @p NOPRIO, the
+ *          threshold is not inherited by the threads the caller creates.
+ *
+ * @param[in] newthreshold the new preemption threshold
+ * @return              The old preemption threshold.
+ *
+ * @api
+ */
+tprio_t chThdSetThreshold(tprio_t newthreshold) {
+  tprio_t oldthreshold;
+
+  chDbgCheck(newthreshold <= HIGHPRIO);
+
+  chSysLock();
+  oldthreshold = currp->p_threshold;
+  currp->p_threshold = newthreshold;
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return oldthreshold;
+}
+#endif /* CH_CFG_SCHED_THRESHOLD */
+
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+/**
+ * @brief   Demotes a thread that used up its CPU budget.
+ * @note    Not an user function, it is invoked by the system tick handler.
+ *
+ * @param[in] tp        the running thread
+ *
+ * @notapi
+ */
+void _thread_budget_exhausted(thread_t *tp) {
+  thread_budget_t *bp = tp->p_budget;
+
+  bp->tb_overruns++;
+  if (!bp->tb_demoted) {
+#if CH_CFG_USE_MUTEXES
+    bp->tb_savedprio = tp->p_realprio;
+#else
+    bp->tb_savedprio = tp->p_prio;
+#endif
+    if (bp->tb_prio < bp->tb_savedprio) {
+      bp->tb_demoted = true;
+      thread_set_prio(tp, bp->tb_prio);
+    }
+  }
+}
+
+/**
+ * @brief   Initializes a CPU budget object.
+ * @note    A thread demoted to @p IDLEPRIO only runs when the system would
+ *          be otherwise idle, this is equivalent to a suspension until the
+ *          next replenishment.
+ *
+ * @param[out] bp       pointer to the @p thread_budget_t object
+ * @param[in] budget    ticks the thread can run in each period
+ * @param[in] period    replenishment period in ticks
+ * @param[in] prio      priority of the thread while its budget is used up
+ *
+ * @init
+ */
+void chThdBudgetObjectInit(thread_budget_t *bp, systime_t budget,
+                           systime_t period, tprio_t prio) {
+
+  chDbgCheck((bp != NULL) && (budget > (systime_t)0) && (budget <= period) &&
+             (prio >= IDLEPRIO) && (prio <= HIGHPRIO));
+
+  chVTObjectInit(&bp->tb_timer);
+  bp->tb_thread    = NULL;
+  bp->tb_budget    = budget;
+  bp->tb_period    = period;
+  bp->tb_remaining = budget;
+  bp->tb_prio      = prio;
+  bp->tb_demoted   = false;
+  bp->tb_overruns  = (ucnt_t)0;
+}
+
+/**
+ * @brief   Attaches a CPU budget to a thread.
+ * @details The thread budget is fully replenished and the replenishment
+ *          period starts, a previously attached budget is detached first
+ *          restoring the thread priority if demoted.
+ * @note    A budget object can be attached to a single thread, the budget
+ *          is automatically detached when the thread terminates.
+ * @note    The priority saved on demotion is restored on replenishment, the
+ *          priority changes performed by a demoted thread are lost.
+ *
+ * @param[in] tp        the thread
+ * @param[in] bp        pointer to the @p thread_budget_t object or @p NULL
+ *                      in order to just detach the current budget
+ *
+ * @api
+ */
+void chThdSetBudget(thread_t *tp, thread_budget_t *bp) {
+
+  chDbgCheck(tp != NULL);
+
+  chSysLock();
+  if (tp->p_budget != NULL) {
+    budget_detach(tp);
+  }
+  if (bp != NULL) {
+    chDbgAssert(bp->tb_thread == NULL, "already attached");
+
+    bp->tb_thread = tp;
+    bp->tb_remaining = bp->tb_budget;
+    bp->tb_demoted = false;
+    tp->p_budget = bp;
+    chVTDoSetI(&bp->tb_timer, bp->tb_period, budget_replenish, bp);
+  }
+  chSchRescheduleS();
+  chSysUnlock();
+}
+#endif /* CH_CFG_SCHED_BUDGET */
+
 /**
  * @brief   Requests a thread termination.
  * @pre     The target thread must be written to invoke periodically
@@ -364,6 +621,54 @@ systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next) {
   return next;
 }
 
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   Changes the deadline of the running thread.
+ * @details The new deadline is only relevant if the thread belongs to the
+ *          @p CH_CFG_EDF_PRIO priority level, if another thread at the same
+ *          level has now an earlier deadline then it preempts the caller.
+ * @note    Threads are created with a deadline equal to their creation
+ *          time.
+ *
+ * @param[in] deadline  the new absolute deadline
+ *
+ * @api
+ */
+void chThdSetDeadline(systime_t deadline) {
+
+  chSysLock();
+  currp->p_deadline = deadline;
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Suspends the invoking thread until the system time arrives to the
+ *          specified value then refreshes its deadline.
+ * @details This is meant for periodic EDF threads, the deadline of the next
+ *          job is set before sleeping so the thread enters the ready list
+ *          in the right position when awakened.
+ * @see     chThdSleepUntil()
+ *
+ * @param[in] time      absolute system time of the next release
+ * @param[in] deadline  absolute deadline of the next job
+ *
+ * @api
+ */
+void chThdSleepUntilWithDeadline(systime_t time, systime_t deadline) {
+
+  chSysLock();
+  currp->p_deadline = deadline;
+  if ((time -= chVTGetSystemTimeX()) > 0) {
+    chThdSleepS(time);
+  }
+  else {
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+}
+#endif /* CH_CFG_SCHED_EDF */
+
 /**
  * @brief   Yields the time slot.
  * @details Yields the CPU control to the next thread in the ready list with
@@ -417,6 +722,11 @@ void chThdExitS(msg_t msg) {
   thread_t *tp = currp;
 
   tp->p_u.exitcode = msg;
+#if CH_CFG_SCHED_BUDGET
+  if (tp->p_budget != NULL) {
+    budget_detach(tp);
+  }
+#endif
 #if defined(CH_CFG_THREAD_EXIT_HOOK)
   CH_CFG_THREAD_EXIT_HOOK(tp);
 #endif
@@ -511,7 +821,7 @@ msg_t chThdSuspendS(thread_reference_t *trp) {
   chDbgAssert(*trp == NULL, "not NULL");
 
   *trp = tp;
-  tp->p_u.wtobjp = &trp;
+  tp->p_u.wtobjp = trp;
   chSchGoSleepS(CH_STATE_SUSPENDED);
 
   return chThdGetSelfX()->p_u.rdymsg;
@@ -546,7 +856,7 @@ msg_t chThdSuspendTimeoutS(thread_reference_t *trp, systime_t timeout) {
   }
 
   *trp = tp;
-  tp->p_u.wtobjp = &trp;
+  tp->p_u.wtobjp = trp;
 
   return chSchGoSleepTimeoutS(CH_STATE_SUSPENDED, timeout);
 }
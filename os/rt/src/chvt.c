@@ -32,6 +32,34 @@
 /* Module local definitions.                                                 */
 /*===========================================================================*/
 
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Current time of the timing wheel.
+ * @details Time of the last processed wheel event, in tick mode it is the
+ *          system time itself.
+ */
+#if CH_CFG_ST_TIMEDELTA == 0
+#define WHEEL_TIME              ch.vtlist.vt_systime
+#else
+#define WHEEL_TIME              ch.vtlist.vt_lasttime
+#endif
+
+/**
+ * @brief   Mask of a slot index within a wheel level.
+ */
+#define WHEEL_MASK              ((systime_t)CH_VT_WHEEL_SLOTS - (systime_t)1)
+
+/**
+ * @brief   Mask of the meaningful bits in a level bitmap.
+ */
+#define WHEEL_MAP_MASK          (0xFFFFFFFFU >> (32 - CH_VT_WHEEL_SLOTS))
+
+/**
+ * @brief   Time shift of a wheel level.
+ */
+#define WHEEL_SHIFT(l)          ((unsigned)(l) * (unsigned)CH_CFG_VT_WHEEL_BITS)
+#endif /* CH_CFG_VT_TIMING_WHEEL */
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
@@ -48,6 +76,236 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a timer in the wheel.
+ * @details The timer is appended to a slot of the lowest level able to
+ *          represent the distance between its expiration time and the
+ *          wheel time.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ */
+static void wheel_insert(virtual_timer_t *vtp) {
+  systime_t delta = vtp->vt_time - WHEEL_TIME;
+  vt_wheel_slot_t *sp;
+  unsigned l = 0U, i;
+
+  while ((l < (unsigned)(CH_VT_WHEEL_LEVELS - 1)) &&
+         ((delta >> WHEEL_SHIFT(l + 1U)) != (systime_t)0)) {
+    l++;
+  }
+  i  = (unsigned)((vtp->vt_time >> WHEEL_SHIFT(l)) & WHEEL_MASK);
+  sp = &ch.vtlist.vt_slots[l][i];
+
+  vtp->vt_next = (virtual_timer_t *)sp;
+  vtp->vt_prev = sp->vt_prev;
+  vtp->vt_prev->vt_next = vtp;
+  sp->vt_prev = vtp;
+  ch.vtlist.vt_map[l] |= (uint32_t)1 << i;
+}
+
+/**
+ * @brief   Removes a timer from the wheel.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ */
+static void wheel_remove(virtual_timer_t *vtp) {
+
+  vtp->vt_prev->vt_next = vtp->vt_next;
+  vtp->vt_next->vt_prev = vtp->vt_prev;
+
+  /* If the slot became empty then both links point to the slot header, its
+     position in the slots array gives the bit to be cleared.*/
+  if (vtp->vt_next == vtp->vt_prev) {
+    unsigned n = (unsigned)((vt_wheel_slot_t *)vtp->vt_next -
+                            &ch.vtlist.vt_slots[0][0]);
+
+    ch.vtlist.vt_map[n / (unsigned)CH_VT_WHEEL_SLOTS] &=
+        ~((uint32_t)1 << (n % (unsigned)CH_VT_WHEEL_SLOTS));
+  }
+}
+
+/**
+ * @brief   Moves the timers of the current slot of a level to the lower
+ *          levels.
+ *
+ * @param[in] l         the wheel level, it must be greater than zero
+ */
+static void wheel_cascade(unsigned l) {
+  unsigned i = (unsigned)((WHEEL_TIME >> WHEEL_SHIFT(l)) & WHEEL_MASK);
+  vt_wheel_slot_t *sp = &ch.vtlist.vt_slots[l][i];
+  virtual_timer_t *vtp = sp->vt_next;
+
+  /* The slot is emptied then the detached timers are inserted again, now
+     they all expire within the time span of a slot of this level.*/
+  sp->vt_next = sp->vt_prev = (virtual_timer_t *)sp;
+  ch.vtlist.vt_map[l] &= ~((uint32_t)1 << i);
+  while (vtp != (virtual_timer_t *)sp) {
+    virtual_timer_t *next = vtp->vt_next;
+
+    wheel_insert(vtp);
+    vtp = next;
+  }
+}
+
+/**
+ * @brief   Index of the least significant bit set in a word.
+ *
+ * @param[in] map       the word, it must not be zero
+ * @return              The bit index.
+ */
+static inline unsigned wheel_ctz(uint32_t map) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctz(map);
+#else
+  unsigned n = 0U;
+
+  while ((map & 1U) == 0U) {
+    map >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+/**
+ * @brief   Rotates a level bitmap.
+ *
+ * @param[in] map       the level bitmap
+ * @param[in] n         the slot index that becomes bit zero
+ * @return              The rotated bitmap.
+ */
+static inline uint32_t wheel_rotate(uint32_t map, unsigned n) {
+
+  if (n > 0U) {
+    map = ((map >> n) | (map << ((unsigned)CH_VT_WHEEL_SLOTS - n))) &
+          WHEEL_MAP_MASK;
+  }
+  return map;
+}
+
+/**
+ * @brief   Coalesces a timer with the timers already in level zero.
+ * @details If a non-empty level zero slot falls within the slack window
+ *          then the timer expiration is moved there, this way the timer
+ *          expires together with the timers already in the slot.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] slack     the number of ticks the expiration can be postponed
+ */
+static void wheel_coalesce(virtual_timer_t *vtp, systime_t slack) {
+  systime_t first = vtp->vt_time - WHEEL_TIME;
+  systime_t last;
+  uint32_t map = ch.vtlist.vt_map[0];
+
+  if ((map == 0U) || (first > WHEEL_MASK)) {
+    return;
+  }
+  last = (slack > (WHEEL_MASK - first)) ? WHEEL_MASK : first + slack;
+
+  /* Rotating the bitmap so that bit zero represents the current slot then
+     keeping only the slots within the window.*/
+  map = wheel_rotate(map, (unsigned)(WHEEL_TIME & WHEEL_MASK));
+  map &= (WHEEL_MAP_MASK >> (unsigned)(WHEEL_MASK - last)) &
+         ~(((uint32_t)1 << (unsigned)first) - 1U);
+  if (map != 0U) {
+    vtp->vt_time = WHEEL_TIME + (systime_t)wheel_ctz(map);
+  }
+}
+
+/**
+ * @brief   Processes the wheel at the current wheel time.
+ * @details The upper levels slots reached by the wheel time are cascaded
+ *          then the timers in the current level zero slot are triggered.
+ * @note    The system lock is released while invoking the callbacks.
+ */
+static void wheel_process(void) {
+  vt_wheel_slot_t *sp;
+  unsigned l = 1U;
+
+  while ((l < (unsigned)CH_VT_WHEEL_LEVELS) &&
+         ((WHEEL_TIME & (((systime_t)1 << WHEEL_SHIFT(l)) - (systime_t)1)) ==
+          (systime_t)0)) {
+    wheel_cascade(l);
+    l++;
+  }
+
+  /* All the timers in the current level zero slot expire now.*/
+  sp = &ch.vtlist.vt_slots[0][WHEEL_TIME & WHEEL_MASK];
+  while (sp->vt_next != (virtual_timer_t *)sp) {
+    virtual_timer_t *vtp = sp->vt_next;
+    vtfunc_t fn = vtp->vt_func;
+
+    wheel_remove(vtp);
+#if CH_CFG_VT_DEFERRED
+    if ((vtp->vt_flags & CH_VT_FLAG_DEFERRED) != 0U) {
+      _vt_defer(vtp);
+      continue;
+    }
+#endif
+    vtp->vt_func = (vtfunc_t)NULL;
+    chSysUnlockFromISR();
+    fn(vtp->vt_par);
+    chSysLockFromISR();
+  }
+}
+
+#if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Checks if there are no armed timers in the wheel.
+ *
+ * @return              The wheel state.
+ * @retval false        if there is at least one armed timer.
+ * @retval true         if the wheel is empty.
+ */
+static bool wheel_is_empty(void) {
+  unsigned l;
+
+  for (l = 0U; l < (unsigned)CH_VT_WHEEL_LEVELS; l++) {
+    if (ch.vtlist.vt_map[l] != 0U) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief   Time of the next wheel event.
+ * @details An event is either the expiration of a level zero slot or the
+ *          cascade of a non-empty slot of an upper level, the slots bitmaps
+ *          allow to find it without scanning the timers.
+ * @pre     The wheel must not be empty.
+ *
+ * @return              The time of the next event relative to the wheel
+ *                      time.
+ */
+static systime_t wheel_next_event(void) {
+  systime_t next = (systime_t)0;
+  unsigned l;
+
+  for (l = 0U; l < (unsigned)CH_VT_WHEEL_LEVELS; l++) {
+    uint32_t map = ch.vtlist.vt_map[l];
+
+    if (map != 0U) {
+      unsigned n = (unsigned)(((WHEEL_TIME >> WHEEL_SHIFT(l)) + (systime_t)1) &
+                              WHEEL_MASK);
+      systime_t d;
+
+      /* Rotating the bitmap so that bit zero represents the slot following
+         the current one.*/
+      map = wheel_rotate(map, n);
+      d = (systime_t)((systime_t)(wheel_ctz(map) + 1U) << WHEEL_SHIFT(l)) -
+          (WHEEL_TIME & (((systime_t)1 << WHEEL_SHIFT(l)) - (systime_t)1));
+      if ((next == (systime_t)0) || (d < next)) {
+        next = d;
+      }
+    }
+  }
+  return next;
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#endif /* CH_CFG_VT_TIMING_WHEEL */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -60,21 +318,51 @@
  */
 void _vt_init(void) {
 
+#if CH_CFG_VT_TIMING_WHEEL
+  unsigned l, i;
+
+  for (l = 0U; l < (unsigned)CH_VT_WHEEL_LEVELS; l++) {
+    for (i = 0U; i < (unsigned)CH_VT_WHEEL_SLOTS; i++) {
+      ch.vtlist.vt_slots[l][i].vt_next = (void *)&ch.vtlist.vt_slots[l][i];
+      ch.vtlist.vt_slots[l][i].vt_prev = (void *)&ch.vtlist.vt_slots[l][i];
+    }
+    ch.vtlist.vt_map[l] = 0U;
+  }
+#else
   ch.vtlist.vt_next = ch.vtlist.vt_prev = (void *)&ch.vtlist;
   ch.vtlist.vt_delta = (systime_t)-1;
+#endif
 #if CH_CFG_ST_TIMEDELTA == 0
   ch.vtlist.vt_systime = 0;
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
   ch.vtlist.vt_lasttime = 0;
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#if CH_CFG_VT_DEFERRED
+  ch.vtdeferred.vt_next = ch.vtdeferred.vt_prev = (void *)&ch.vtdeferred;
+  ch.vtdeferred.vt_thread = NULL;
+  ch.vtdeferred.vt_depth = (ucnt_t)0;
+  ch.vtdeferred.vt_maxdepth = (ucnt_t)0;
+  ch.vtdeferred.vt_ncallbacks = (ucnt_t)0;
+  ch.vtdeferred.vt_nbatches = (ucnt_t)0;
+#if CH_CFG_USE_TM
+  chTMObjectInit(&ch.vtdeferred.vt_batch);
+#endif
+#endif
 }
 
 /**
- * @brief   Enables a virtual timer.
+ * @brief   Enables a virtual timer with a tolerance on the expiration time.
  * @details The timer is enabled and programmed to trigger after the delay
- *          specified as parameter.
+ *          specified as parameter or up to @p slack ticks later. If another
+ *          expiration is already scheduled within that window then the timer
+ *          is made to expire together with it, this way no additional timer
+ *          events are generated and, in tick-less mode, the alarm is not
+ *          reprogrammed.
  * @pre     The timer must not be already armed before calling this function.
  * @note    The callback function is invoked from interrupt context.
+ * @note    With @p CH_CFG_VT_TIMING_WHEEL enabled only the expirations
+ *          within the level zero slots, plus the next alarm in tick-less
+ *          mode, are considered for coalescing.
  *
  * @param[out] vtp      the @p virtual_timer_t structure pointer
  * @param[in] delay     the number of ticks before the operation timeouts, the
@@ -83,6 +371,8 @@ void _vt_init(void) {
  *                        normal time specification.
  *                      - @a TIME_IMMEDIATE this value is not allowed.
  *                      .
+ * @param[in] slack     the number of ticks the expiration can be postponed,
+ *                      zero means no tolerance
  * @param[in] vtfunc    the timer callback function. After invoking the
  *                      callback the timer is disabled and the structure can
  *                      be disposed or reused.
@@ -91,15 +381,64 @@ void _vt_init(void) {
  *
  * @iclass
  */
-void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
-                vtfunc_t vtfunc, void *par) {
+void chVTDoSetWithSlackI(virtual_timer_t *vtp, systime_t delay,
+                         systime_t slack, vtfunc_t vtfunc, void *par) {
+#if !CH_CFG_VT_TIMING_WHEEL
   virtual_timer_t *p;
+#endif
 
   chDbgCheckClassI();
   chDbgCheck((vtp != NULL) && (vtfunc != NULL) && (delay != TIME_IMMEDIATE));
 
   vtp->vt_par = par;
   vtp->vt_func = vtfunc;
+#if CH_CFG_VT_DEFERRED
+  vtp->vt_flags = 0U;
+#endif
+
+#if CH_CFG_VT_TIMING_WHEEL
+#if CH_CFG_ST_TIMEDELTA > 0
+  {
+    systime_t now = port_timer_get_time();
+
+    /* If the requested delay is lower than the minimum safe delta then it
+       is raised to the minimum safe value.*/
+    if (delay < CH_CFG_ST_TIMEDELTA) {
+      delay = CH_CFG_ST_TIMEDELTA;
+    }
+    vtp->vt_time = now + delay;
+
+    if (wheel_is_empty()) {
+      /* The wheel is empty, the current time becomes the new wheel time.*/
+      ch.vtlist.vt_lasttime = now;
+      port_timer_start_alarm(vtp->vt_time);
+    }
+    else {
+      systime_t alarm = port_timer_get_alarm();
+
+      /* The slack window is measured from the original deadline, the
+         coalescing could have already moved the expiration time.*/
+      wheel_coalesce(vtp, slack);
+      if ((systime_t)(alarm - (now + delay)) <= slack) {
+        /* The next wheel event falls within the slack window, the timer is
+           made to expire with it and the alarm is left untouched.*/
+        vtp->vt_time = alarm;
+      }
+      else if ((vtp->vt_time - ch.vtlist.vt_lasttime) <
+               (alarm - ch.vtlist.vt_lasttime)) {
+        /* The timer expires before the next wheel event so it becomes the
+           next alarm event in time.*/
+        port_timer_set_alarm(vtp->vt_time);
+      }
+    }
+  }
+#else /* CH_CFG_ST_TIMEDELTA == 0 */
+  vtp->vt_time = ch.vtlist.vt_systime + delay;
+  wheel_coalesce(vtp, slack);
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+
+  wheel_insert(vtp);
+#else /* !CH_CFG_VT_TIMING_WHEEL */
   p = ch.vtlist.vt_next;
 
 #if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
@@ -122,12 +461,6 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
       /* Now the delay is calculated as delta from the last tick interrupt
          time.*/
       delay += now - ch.vtlist.vt_lasttime;
-
-      /* If the specified delay is closer in time than the first element
-         in the delta list then it becomes the next alarm event in time.*/
-      if (delay < p->vt_delta) {
-        port_timer_set_alarm(ch.vtlist.vt_lasttime + delay);
-      }
     }
   }
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
@@ -139,6 +472,22 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
     p = p->vt_next;
   }
 
+  /* If the following timer expires within the slack window then this
+     timer is made to expire together with it.*/
+  if ((p != (virtual_timer_t *)&ch.vtlist) &&
+      ((systime_t)(p->vt_delta - delay) <= slack)) {
+    delay = p->vt_delta;
+  }
+
+#if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
+  /* If the specified delay is closer in time than the first element
+     in the delta list then it becomes the next alarm event in time.*/
+  if ((p == ch.vtlist.vt_next) && (p != (virtual_timer_t *)&ch.vtlist) &&
+      (delay < p->vt_delta)) {
+    port_timer_set_alarm(ch.vtlist.vt_lasttime + delay);
+  }
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+
   /* The timer is inserted in the delta list.*/
   vtp->vt_prev = (vtp->vt_next = p)->vt_prev;
   vtp->vt_prev->vt_next = p->vt_prev = vtp;
@@ -148,6 +497,7 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
      value in the header must be restored.*/;
   p->vt_delta -= delay;
   ch.vtlist.vt_delta = (systime_t)-1;
+#endif /* !CH_CFG_VT_TIMING_WHEEL */
 }
 
 /**
@@ -164,6 +514,31 @@ void chVTDoResetI(virtual_timer_t *vtp) {
   chDbgCheck(vtp != NULL);
   chDbgAssert(vtp->vt_func != NULL, "timer not set or already triggered");
 
+#if CH_CFG_VT_DEFERRED
+  if ((vtp->vt_flags & CH_VT_FLAG_PENDING) != 0U) {
+    /* The timer already expired, its callback is removed from the deferred
+       queue before being invoked.*/
+    vtp->vt_prev->vt_next = vtp->vt_next;
+    vtp->vt_next->vt_prev = vtp->vt_prev;
+    vtp->vt_func = (vtfunc_t)NULL;
+    vtp->vt_flags = 0U;
+    ch.vtdeferred.vt_depth--;
+    return;
+  }
+#endif
+
+#if CH_CFG_VT_TIMING_WHEEL
+  wheel_remove(vtp);
+  vtp->vt_func = (vtfunc_t)NULL;
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  /* An alarm earlier than the next wheel event is harmless so it is only
+     stopped when the wheel becomes empty.*/
+  if (wheel_is_empty()) {
+    port_timer_stop_alarm();
+  }
+#endif
+#else /* !CH_CFG_VT_TIMING_WHEEL */
   /* Removing the element from the delta list.*/
   vtp->vt_next->vt_delta += vtp->vt_delta;
   vtp->vt_prev->vt_next = vtp->vt_next;
@@ -194,6 +569,169 @@ void chVTDoResetI(virtual_timer_t *vtp) {
     }
   }
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#endif /* !CH_CFG_VT_TIMING_WHEEL */
+}
+
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Enables a deferred virtual timer.
+ * @details The timer is enabled and programmed to trigger after the delay
+ *          specified as parameter. On expiration the callback is not invoked
+ *          from the timer interrupt but queued, it is invoked later by the
+ *          deferred callbacks thread together with the other expired
+ *          deferred timers.
+ * @pre     The timer must not be already armed before calling this function.
+ * @note    The callback is invoked from thread context, it must use
+ *          @p chSysLock() and @p chSysUnlock() instead of the "FromISR"
+ *          variants and it should never block.
+ * @note    The timer is considered armed until its callback is invoked,
+ *          resetting it while the callback is pending cancels the callback.
+ *
+ * @param[out] vtp      the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+void chVTDoSetDeferredI(virtual_timer_t *vtp, systime_t delay,
+                        vtfunc_t vtfunc, void *par) {
+
+  chVTDoSetI(vtp, delay, vtfunc, par);
+  vtp->vt_flags = CH_VT_FLAG_DEFERRED;
+}
+
+/**
+ * @brief   Queues the callback of an expired deferred timer.
+ * @note    Internal use only, the timer must have already been removed
+ *          from the timers list.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ *
+ * @notapi
+ */
+void _vt_defer(virtual_timer_t *vtp) {
+  vt_deferred_t *dp = &ch.vtdeferred;
+
+  vtp->vt_flags |= CH_VT_FLAG_PENDING;
+  vtp->vt_next = (virtual_timer_t *)dp;
+  vtp->vt_prev = dp->vt_prev;
+  vtp->vt_prev->vt_next = vtp;
+  dp->vt_prev = vtp;
+  if (++dp->vt_depth > dp->vt_maxdepth) {
+    dp->vt_maxdepth = dp->vt_depth;
+  }
+
+  /* Waking up the callbacks thread if it is waiting for work.*/
+  chThdResumeI(&dp->vt_thread, MSG_OK);
+}
+
+/**
+ * @brief   Deferred virtual timers callbacks thread.
+ * @details The thread invokes the pending callbacks in batches, a batch ends
+ *          when the deferred queue is empty.
+ *
+ * @param[in] p         the thread parameter, unused in this scenario
+ *
+ * @notapi
+ */
+void _vt_deferred_thread(void *p) {
+  vt_deferred_t *dp = &ch.vtdeferred;
+
+  (void)p;
+  chRegSetThreadName("vtdeferred");
+  chSysLock();
+  while (true) {
+    while (dp->vt_next == (virtual_timer_t *)dp) {
+      (void) chThdSuspendS(&dp->vt_thread);
+    }
+
+#if CH_CFG_USE_TM
+    chTMStartMeasurementX(&dp->vt_batch);
+#endif
+    do {
+      virtual_timer_t *vtp = dp->vt_next;
+      vtfunc_t fn = vtp->vt_func;
+
+      /* The timer is removed from the queue and marked as non-armed.*/
+      dp->vt_next = vtp->vt_next;
+      dp->vt_next->vt_prev = (virtual_timer_t *)dp;
+      dp->vt_depth--;
+      dp->vt_ncallbacks++;
+      vtp->vt_func = (vtfunc_t)NULL;
+      vtp->vt_flags = 0U;
+
+      /* The callback is invoked outside the kernel critical zone.*/
+      chSysUnlock();
+      fn(vtp->vt_par);
+      chSysLock();
+    } while (dp->vt_next != (virtual_timer_t *)dp);
+    dp->vt_nbatches++;
+#if CH_CFG_USE_TM
+    chTMStopMeasurementX(&dp->vt_batch);
+#endif
+  }
+}
+#endif /* CH_CFG_VT_DEFERRED */
+
+#if CH_CFG_VT_TIMING_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Timing wheel ticker.
+ * @details In tick mode the wheel advances by one slot. In tick-less mode
+ *          all the wheel events up to the current time are processed, then
+ *          the alarm is programmed for the next event.
+ * @note    Internal use only, it is invoked by @p chVTDoTickI().
+ *
+ * @notapi
+ */
+void _vt_wheel_tick(void) {
+
+#if CH_CFG_ST_TIMEDELTA == 0
+  ch.vtlist.vt_systime++;
+  wheel_process();
+#else /* CH_CFG_ST_TIMEDELTA > 0 */
+  systime_t now, next;
+
+  while (true) {
+    if (wheel_is_empty()) {
+      /* No tick event needed so the alarm timer is stopped.*/
+      port_timer_stop_alarm();
+      return;
+    }
+
+    /* The next event is outside the current time window, the loop
+       is stopped here.*/
+    next = wheel_next_event();
+    now = chVTGetSystemTimeX();
+    if (next > (systime_t)(now - ch.vtlist.vt_lasttime)) {
+      break;
+    }
+
+    /* The wheel time jumps to the event, the empty slots in between do not
+       need to be visited.*/
+    ch.vtlist.vt_lasttime += next;
+    wheel_process();
+  }
+
+  /* Updating the alarm to the next event, event that must not be closer in
+     time than the minimum time delta.*/
+  next += ch.vtlist.vt_lasttime;
+  if ((systime_t)(next - now) >= CH_CFG_ST_TIMEDELTA) {
+    port_timer_set_alarm(next);
+  }
+  else {
+    port_timer_set_alarm(now + CH_CFG_ST_TIMEDELTA);
+  }
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
+#endif /* CH_CFG_VT_TIMING_WHEEL */
 
 /** @} */
@@ -0,0 +1,417 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwaitsets.c
+ * @brief   Wait-sets code.
+ *
+ * @addtogroup waitsets
+ * @details Wait-sets allow a thread to wait on several kernel objects.
+ *          <h2>Operation mode</h2>
+ *          A wait-set is an array of entries, each entry is identified by
+ *          its index and registers a semaphore, a mailbox, an input queue
+ *          or a mask of events of the owner thread.<br>
+ *          A wait operation returns the identifier of a ready entry: a
+ *          semaphore with a positive counter, a non-empty mailbox or input
+ *          queue, or pending events. The object is not consumed, the thread
+ *          is supposed to perform the appropriate non-blocking operation
+ *          on it.<br>
+ *          The registered objects mark their entry as signaled when
+ *          becoming ready and wake the waiting thread, so a wait operation
+ *          only checks the signaled entries and the events entries. If
+ *          several entries are ready then the one with the lowest
+ *          identifier is returned.
+ * @pre     In order to use the wait-sets APIs the @p CH_CFG_USE_WAITSETS
+ *          option must be enabled in @p chconf.h.
+ * @note    An object can be registered in a single wait-set and a wait-set
+ *          can be waited on by a single thread at time.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_WAITSETS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+#define ws_mask(id) ((eventmask_t)1 << (id))
+
+/**
+ * @brief   Registers an object into a wait-set entry.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        entry identifier
+ * @param[in] type      entry type
+ * @param[in] objp      pointer to the registered object
+ * @return              Pointer to the entry.
+ */
+static waitset_entry_t *ws_register(waitset_t *wsp, unsigned id,
+                                    uint8_t type, void *objp) {
+  waitset_entry_t *wep = &wsp->ws_entries[id];
+
+  chDbgAssert(wep->we_type == WS_TYPE_NONE, "entry in use");
+  chDbgAssert(wsp->ws_thread == NULL, "wait-set in use");
+
+  wep->we_objp = objp;
+  wep->we_events = (eventmask_t)0;
+  wep->we_type = type;
+
+  return wep;
+}
+
+/**
+ * @brief   Verifies if the object registered in an entry is ready.
+ *
+ * @param[in] wep       pointer to a @p waitset_entry_t structure
+ * @return              The object state.
+ */
+static bool ws_is_ready(waitset_entry_t *wep) {
+
+  switch (wep->we_type) {
+  case WS_TYPE_SEMAPHORE:
+    return chSemGetCounterI((semaphore_t *)wep->we_objp) > (cnt_t)0;
+#if CH_CFG_USE_QUEUES
+  case WS_TYPE_INPUTQUEUE:
+    return !chIQIsEmptyI((input_queue_t *)wep->we_objp);
+#endif
+#if CH_CFG_USE_EVENTS
+  case WS_TYPE_EVENTS:
+    return (currp->p_epending & wep->we_events) != (eventmask_t)0;
+#endif
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief   Returns the first ready entry.
+ * @details Only the signaled entries and the events entries are checked,
+ *          the signaled entries found not ready anymore are cleared.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @return              The identifier of the ready entry.
+ * @retval MSG_TIMEOUT  if no entry is ready.
+ */
+static msg_t ws_get_ready(waitset_t *wsp) {
+  eventmask_t m = wsp->ws_signaled | wsp->ws_evtentries;
+  unsigned id = 0U;
+
+  while (m != (eventmask_t)0) {
+    if ((m & (eventmask_t)1) != (eventmask_t)0) {
+      if (ws_is_ready(&wsp->ws_entries[id])) {
+        return (msg_t)id;
+      }
+      wsp->ws_signaled &= ~ws_mask(id);
+    }
+    m >>= 1;
+    id++;
+  }
+
+  return MSG_TIMEOUT;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Signals a wait-set entry.
+ * @details The entry is marked as signaled and the waiting thread, if any,
+ *          is made ready.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] wep       pointer to the @p waitset_entry_t structure
+ *
+ * @notapi
+ */
+void _waitset_signal(waitset_entry_t *wep) {
+  waitset_t *wsp = wep->we_ws;
+  thread_t *tp = wsp->ws_thread;
+
+  chDbgCheckClassI();
+
+  wsp->ws_signaled |= ws_mask(wep - wsp->ws_entries);
+  if ((tp != NULL) && (tp->p_state == CH_STATE_WTSET)) {
+    tp->p_u.rdymsg = MSG_OK;
+    (void) chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Initializes a @p waitset_t object.
+ *
+ * @param[out] wsp      pointer to a @p waitset_t structure
+ * @param[in] entries   pointer to an array of @p waitset_entry_t
+ *                      structures
+ * @param[in] n         number of entries in the array, up to
+ *                      @p WS_MAX_ENTRIES
+ *
+ * @init
+ */
+void chWSObjectInit(waitset_t *wsp, waitset_entry_t *entries, unsigned n) {
+  unsigned i;
+
+  chDbgCheck((wsp != NULL) && (entries != NULL) &&
+             (n > 0U) && (n <= WS_MAX_ENTRIES));
+
+  wsp->ws_entries    = entries;
+  wsp->ws_n          = n;
+  wsp->ws_signaled   = (eventmask_t)0;
+  wsp->ws_evtentries = (eventmask_t)0;
+  wsp->ws_events     = (eventmask_t)0;
+  wsp->ws_thread     = NULL;
+  for (i = 0U; i < n; i++) {
+    entries[i].we_ws     = wsp;
+    entries[i].we_objp   = NULL;
+    entries[i].we_events = (eventmask_t)0;
+    entries[i].we_type   = WS_TYPE_NONE;
+  }
+}
+
+/**
+ * @brief   Registers a semaphore in a wait-set.
+ * @details The entry is ready while the semaphore counter is positive.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        identifier of a free entry
+ * @param[in] sp        pointer to a @p semaphore_t structure
+ *
+ * @api
+ */
+void chWSAddSemaphore(waitset_t *wsp, unsigned id, semaphore_t *sp) {
+
+  chDbgCheck((wsp != NULL) && (id < wsp->ws_n) && (sp != NULL));
+
+  chSysLock();
+  chDbgAssert(sp->s_wse == NULL, "already registered");
+  sp->s_wse = ws_register(wsp, id, WS_TYPE_SEMAPHORE, sp);
+  if (sp->s_cnt > (cnt_t)0) {
+    wsp->ws_signaled |= ws_mask(id);
+  }
+  chSysUnlock();
+}
+
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+/**
+ * @brief   Registers a mailbox in a wait-set.
+ * @details The entry is ready while the mailbox contains messages.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        identifier of a free entry
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ *
+ * @api
+ */
+void chWSAddMailbox(waitset_t *wsp, unsigned id, mailbox_t *mbp) {
+
+  chDbgCheck(mbp != NULL);
+
+  chWSAddSemaphore(wsp, id, &mbp->mb_fullsem);
+}
+#endif /* CH_CFG_USE_MAILBOXES */
+
+#if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
+/**
+ * @brief   Registers an input queue in a wait-set.
+ * @details The entry is ready while the input queue contains data.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        identifier of a free entry
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ *
+ * @api
+ */
+void chWSAddInputQueue(waitset_t *wsp, unsigned id, input_queue_t *iqp) {
+
+  chDbgCheck((wsp != NULL) && (id < wsp->ws_n) && (iqp != NULL));
+
+  chSysLock();
+  chDbgAssert(iqp->q_wse == NULL, "already registered");
+  iqp->q_wse = ws_register(wsp, id, WS_TYPE_INPUTQUEUE, iqp);
+  if (!chIQIsEmptyI(iqp)) {
+    wsp->ws_signaled |= ws_mask(id);
+  }
+  chSysUnlock();
+}
+#endif /* CH_CFG_USE_QUEUES */
+
+#if CH_CFG_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @brief   Registers a set of events in a wait-set.
+ * @details The entry is ready while any of the specified events is pending
+ *          for the thread waiting on the wait-set. The events are not
+ *          cleared by the wait operation.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        identifier of a free entry
+ * @param[in] events    the events mask
+ *
+ * @api
+ */
+void chWSAddEvents(waitset_t *wsp, unsigned id, eventmask_t events) {
+
+  chDbgCheck((wsp != NULL) && (id < wsp->ws_n) &&
+             (events != (eventmask_t)0));
+
+  chSysLock();
+  ws_register(wsp, id, WS_TYPE_EVENTS, NULL)->we_events = events;
+  wsp->ws_evtentries |= ws_mask(id);
+  wsp->ws_events |= events;
+  chSysUnlock();
+}
+#endif /* CH_CFG_USE_EVENTS */
+
+/**
+ * @brief   Removes an entry from a wait-set.
+ * @details The registered object, if any, is unlinked from the wait-set.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] id        identifier of a registered entry
+ *
+ * @api
+ */
+void chWSRemove(waitset_t *wsp, unsigned id) {
+  waitset_entry_t *wep;
+  unsigned i;
+
+  chDbgCheck((wsp != NULL) && (id < wsp->ws_n));
+
+  chSysLock();
+  chDbgAssert(wsp->ws_thread == NULL, "wait-set in use");
+
+  wep = &wsp->ws_entries[id];
+  switch (wep->we_type) {
+  case WS_TYPE_SEMAPHORE:
+    ((semaphore_t *)wep->we_objp)->s_wse = NULL;
+    break;
+#if CH_CFG_USE_QUEUES
+  case WS_TYPE_INPUTQUEUE:
+    ((input_queue_t *)wep->we_objp)->q_wse = NULL;
+    break;
+#endif
+  default:
+    break;
+  }
+  wep->we_objp = NULL;
+  wep->we_events = (eventmask_t)0;
+  wep->we_type = WS_TYPE_NONE;
+  wsp->ws_signaled &= ~ws_mask(id);
+  wsp->ws_evtentries &= ~ws_mask(id);
+
+  /* The events mask is rebuilt from the remaining events entries.*/
+  wsp->ws_events = (eventmask_t)0;
+  for (i = 0U; i < wsp->ws_n; i++) {
+    wsp->ws_events |= wsp->ws_entries[i].we_events;
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Waits for any of the wait-set entries to become ready.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The identifier of the ready entry or an error code.
+ * @retval MSG_TIMEOUT  if no entry became ready within the specified time.
+ *
+ * @sclass
+ */
+msg_t chWSWaitTimeoutS(waitset_t *wsp, systime_t time) {
+  systime_t start = chVTGetSystemTimeX();
+  systime_t remaining = time;
+  msg_t msg;
+
+  chDbgCheckClassS();
+  chDbgCheck(wsp != NULL);
+  chDbgAssert(wsp->ws_thread == NULL, "wait-set in use");
+
+  while (true) {
+    msg = ws_get_ready(wsp);
+    if ((msg != MSG_TIMEOUT) || (TIME_IMMEDIATE == time)) {
+      return msg;
+    }
+
+    /* An entry signaled but found not ready restarts the wait for the
+       remaining time.*/
+    if (TIME_INFINITE != time) {
+      systime_t elapsed = chVTTimeElapsedSinceX(start);
+      if (elapsed >= time) {
+        return MSG_TIMEOUT;
+      }
+      remaining = time - elapsed;
+    }
+
+    wsp->ws_thread = currp;
+#if CH_CFG_USE_EVENTS
+    currp->p_u.ewmask = wsp->ws_events;
+#endif
+    msg = chSchGoSleepTimeoutS(CH_STATE_WTSET, remaining);
+    wsp->ws_thread = NULL;
+    if (msg != MSG_OK) {
+      return msg;
+    }
+  }
+}
+
+/**
+ * @brief   Waits for any of the wait-set entries to become ready.
+ *
+ * @param[in] wsp       pointer to a @p waitset_t structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The identifier of the ready entry or an error code.
+ * @retval MSG_TIMEOUT  if no entry became ready within the specified time.
+ *
+ * @api
+ */
+msg_t chWSWaitTimeout(waitset_t *wsp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chWSWaitTimeoutS(wsp, time);
+  chSysUnlock();
+
+  return msg;
+}
+
+#endif /* CH_CFG_USE_WAITSETS */
+
+/** @} */
@@ -787,6 +787,26 @@ namespace chibios_rt {
 
     chPoolFreeI(&pool, objp);
   }
+
+  size_t MemoryPool::allocBatchI(void *objs[], size_t n) {
+
+    return chPoolAllocBatchI(&pool, objs, n);
+  }
+
+  size_t MemoryPool::allocBatch(void *objs[], size_t n) {
+
+    return chPoolAllocBatch(&pool, objs, n);
+  }
+
+  void MemoryPool::freeBatchI(void *objs[], size_t n) {
+
+    chPoolFreeBatchI(&pool, objs, n);
+  }
+
+  void MemoryPool::freeBatch(void *objs[], size_t n) {
+
+    chPoolFreeBatch(&pool, objs, n);
+  }
 #endif /* CH_CFG_USE_MEMPOOLS */
 }
 
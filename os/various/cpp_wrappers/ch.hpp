@@ -2245,6 +2245,54 @@ namespace chibios_rt {
      * @iclass
      */
     void freeI(void *objp);
+
+    /**
+     * @brief   Allocates a batch of objects from a memory pool.
+     * @pre     The memory pool must be already been initialized.
+     *
+     * @param[out] objs     array receiving the pointers to the allocated
+     *                      objects
+     * @param[in] n         number of objects to be allocated
+     * @return              The number of allocated objects.
+     *
+     * @iclass
+     */
+    size_t allocBatchI(void *objs[], size_t n);
+
+    /**
+     * @brief   Allocates a batch of objects from a memory pool.
+     * @pre     The memory pool must be already been initialized.
+     *
+     * @param[out] objs     array receiving the pointers to the allocated
+     *                      objects
+     * @param[in] n         number of objects to be allocated
+     * @return              The number of allocated objects.
+     *
+     * @api
+     */
+    size_t allocBatch(void *objs[], size_t n);
+
+    /**
+     * @brief   Releases a batch of objects into a memory pool.
+     * @pre     The memory pool must be already been initialized.
+     *
+     * @param[in] objs      array of pointers to the objects to be released
+     * @param[in] n         number of objects to be released
+     *
+     * @iclass
+     */
+    void freeBatchI(void *objs[], size_t n);
+
+    /**
+     * @brief   Releases a batch of objects into a memory pool.
+     * @pre     The memory pool must be already been initialized.
+     *
+     * @param[in] objs      array of pointers to the objects to be released
+     * @param[in] n         number of objects to be released
+     *
+     * @api
+     */
+    void freeBatch(void *objs[], size_t n);
   };
 
   /*------------------------------------------------------------------------*
@@ -2274,9 +2322,306 @@ namespace chibios_rt {
 
       loadArray(pool_buf, N);
     }
+
+    using MemoryPool::allocBatchI;
+    using MemoryPool::allocBatch;
+    using MemoryPool::freeBatchI;
+    using MemoryPool::freeBatch;
+
+    /**
+     * @brief   Allocates a batch of objects from the pool.
+     * @note    The objects constructors are not invoked.
+     *
+     * @param[out] objs     array receiving the pointers to the allocated
+     *                      objects
+     * @param[in] n         number of objects to be allocated
+     * @return              The number of allocated objects.
+     *
+     * @iclass
+     */
+    size_t allocBatchI(T *objs[], size_t n) {
+
+      return chPoolAllocBatchI(&pool, reinterpret_cast<void **>(objs), n);
+    }
+
+    /**
+     * @brief   Allocates a batch of objects from the pool.
+     * @note    The objects constructors are not invoked.
+     *
+     * @param[out] objs     array receiving the pointers to the allocated
+     *                      objects
+     * @param[in] n         number of objects to be allocated
+     * @return              The number of allocated objects.
+     *
+     * @api
+     */
+    size_t allocBatch(T *objs[], size_t n) {
+
+      return chPoolAllocBatch(&pool, reinterpret_cast<void **>(objs), n);
+    }
+
+    /**
+     * @brief   Releases a batch of objects into the pool.
+     * @note    The objects destructors are not invoked.
+     *
+     * @param[in] objs      array of pointers to the objects to be released
+     * @param[in] n         number of objects to be released
+     *
+     * @iclass
+     */
+    void freeBatchI(T *objs[], size_t n) {
+
+      chPoolFreeBatchI(&pool, reinterpret_cast<void **>(objs), n);
+    }
+
+    /**
+     * @brief   Releases a batch of objects into the pool.
+     * @note    The objects destructors are not invoked.
+     *
+     * @param[in] objs      array of pointers to the objects to be released
+     * @param[in] n         number of objects to be released
+     *
+     * @api
+     */
+    void freeBatch(T *objs[], size_t n) {
+
+      chPoolFreeBatch(&pool, reinterpret_cast<void **>(objs), n);
+    }
   };
 #endif /* CH_CFG_USE_MEMPOOLS */
 
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::ObjectsFifo                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating an objects FIFO, its objects and
+   *          its messages buffer.
+   *
+   * @param T               type of the objects
+   * @param N               number of objects
+   */
+  template<class T, size_t N>
+  class ObjectsFifo {
+  private:
+    /* The objects buffer is declared as an array of pointers to void for
+       the same reasons explained in ObjectsPool, each object is rounded
+       up to a multiple of the size of a pointer.*/
+    void *obj_buf[N * ((sizeof (T) + sizeof (void *) - 1U) /
+                       sizeof (void *))];
+    msg_t msg_buf[N];
+
+  public:
+    /**
+     * @brief   Embedded @p ::objects_fifo_t structure.
+     */
+    ::objects_fifo_t fifo;
+
+    /**
+     * @brief   ObjectsFifo constructor.
+     *
+     * @init
+     */
+    ObjectsFifo(void) {
+
+      chFifoObjectInit(&fifo, sizeof (T), N, sizeof (void *),
+                       obj_buf, msg_buf);
+    }
+
+    /**
+     * @brief   Allocates a free object.
+     * @note    The object constructor is not invoked.
+     *
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if an object is not immediately available.
+     *
+     * @iclass
+     */
+    T *takeObjectI(void) {
+
+      return reinterpret_cast<T *>(chFifoTakeObjectI(&fifo));
+    }
+
+    /**
+     * @brief   Allocates a free object.
+     * @note    The object constructor is not invoked.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if an object is not available within the
+     *                      specified timeout.
+     *
+     * @sclass
+     */
+    T *takeObjectS(systime_t time) {
+
+      return reinterpret_cast<T *>(chFifoTakeObjectTimeoutS(&fifo, time));
+    }
+
+    /**
+     * @brief   Allocates a free object.
+     * @note    The object constructor is not invoked.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if an object is not available within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    T *takeObject(systime_t time) {
+
+      return reinterpret_cast<T *>(chFifoTakeObjectTimeout(&fifo, time));
+    }
+
+    /**
+     * @brief   Releases a fetched object.
+     * @note    The object destructor is not invoked.
+     *
+     * @param[in] objp      pointer to the object to be released
+     *
+     * @iclass
+     */
+    void returnObjectI(T *objp) {
+
+      chFifoReturnObjectI(&fifo, objp);
+    }
+
+    /**
+     * @brief   Releases a fetched object.
+     * @note    The object destructor is not invoked.
+     *
+     * @param[in] objp      pointer to the object to be released
+     *
+     * @sclass
+     */
+    void returnObjectS(T *objp) {
+
+      chFifoReturnObjectS(&fifo, objp);
+    }
+
+    /**
+     * @brief   Releases a fetched object.
+     * @note    The object destructor is not invoked.
+     *
+     * @param[in] objp      pointer to the object to be released
+     *
+     * @api
+     */
+    void returnObject(T *objp) {
+
+      chFifoReturnObject(&fifo, objp);
+    }
+
+    /**
+     * @brief   Posts an object.
+     * @note    By design the object can be always immediately posted.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @iclass
+     */
+    void sendObjectI(T *objp) {
+
+      chFifoSendObjectI(&fifo, objp);
+    }
+
+    /**
+     * @brief   Posts an object.
+     * @note    By design the object can be always immediately posted.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @sclass
+     */
+    void sendObjectS(T *objp) {
+
+      chFifoSendObjectS(&fifo, objp);
+    }
+
+    /**
+     * @brief   Posts an object.
+     * @note    By design the object can be always immediately posted.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @api
+     */
+    void sendObject(T *objp) {
+
+      chFifoSendObject(&fifo, objp);
+    }
+
+    /**
+     * @brief   Fetches an object.
+     *
+     * @param[out] objpp    pointer to the fetched object reference
+     * @return              The operation status.
+     * @retval MSG_OK       if an object has been correctly fetched.
+     * @retval MSG_TIMEOUT  if the FIFO is empty and a message cannot be
+     *                      fetched.
+     *
+     * @iclass
+     */
+    msg_t receiveObjectI(T **objpp) {
+
+      return chFifoReceiveObjectI(&fifo, reinterpret_cast<void **>(objpp));
+    }
+
+    /**
+     * @brief   Fetches an object.
+     *
+     * @param[out] objpp    pointer to the fetched object reference
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval MSG_OK       if an object has been correctly fetched.
+     * @retval MSG_TIMEOUT  if the operation has timed out.
+     *
+     * @sclass
+     */
+    msg_t receiveObjectS(T **objpp, systime_t time) {
+
+      return chFifoReceiveObjectTimeoutS(&fifo,
+                                         reinterpret_cast<void **>(objpp),
+                                         time);
+    }
+
+    /**
+     * @brief   Fetches an object.
+     *
+     * @param[out] objpp    pointer to the fetched object reference
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval MSG_OK       if an object has been correctly fetched.
+     * @retval MSG_TIMEOUT  if the operation has timed out.
+     *
+     * @api
+     */
+    msg_t receiveObject(T **objpp, systime_t time) {
+
+      return chFifoReceiveObjectTimeout(&fifo,
+                                        reinterpret_cast<void **>(objpp),
+                                        time);
+    }
+  };
+#endif /* CH_CFG_USE_OBJ_FIFOS */
+
   /*------------------------------------------------------------------------*
    * chibios_rt::BaseSequentialStreamInterface                              *
    *------------------------------------------------------------------------*/
@@ -106,12 +106,155 @@ static void cmd_systime(BaseSequentialStream *chp, int argc, char *argv[]) {
   chprintf(chp, "%lu\r\n", (unsigned long)chVTGetSystemTime());
 }
 
+#if CH_CFG_USE_REGISTRY && CH_CFG_USE_PERIODIC
+static void cmd_periodic(BaseSequentialStream *chp, int argc, char *argv[]) {
+  thread_t *tp;
+  periodic_t *ptp;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "periodic");
+    return;
+  }
+  chprintf(chp, "    addr period activations overruns jbest jworst javg");
+#if CH_CFG_USE_TM
+  chprintf(chp, " ebest eworst eavg");
+#endif
+  chprintf(chp, "\r\n");
+  tp = chRegFirstThread();
+  do {
+    chSysLock();
+    ptp = chRegGetThreadPeriodicI(tp);
+    chSysUnlock();
+    if (ptp != NULL) {
+      chprintf(chp, "%.8lx %6lu %11lu %8lu %5lu %6lu %4lu",
+               (uint32_t)tp, (uint32_t)ptp->pt_period,
+               (uint32_t)ptp->pt_activations, (uint32_t)ptp->pt_overruns,
+               ptp->pt_activations > 0 ? (uint32_t)ptp->pt_jbest : 0,
+               (uint32_t)ptp->pt_jworst, (uint32_t)chPTGetAverageJitterX(ptp));
+#if CH_CFG_USE_TM
+      chprintf(chp, " %5lu %6lu %4lu",
+               ptp->pt_exec.n > 0 ? (uint32_t)ptp->pt_exec.best : 0,
+               (uint32_t)ptp->pt_exec.worst,
+               ptp->pt_exec.n > 0 ?
+                 (uint32_t)(ptp->pt_exec.cumulative / ptp->pt_exec.n) : 0);
+#endif
+      chprintf(chp, "\r\n");
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+#endif
+
+#if CH_CFG_USE_REGISTRY && CH_CFG_USE_HEAP_CACHE
+static void cmd_hcache(BaseSequentialStream *chp, int argc, char *argv[]) {
+  thread_t *tp;
+  heap_cache_t *hcp;
+  size_t n, sz;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "hcache");
+    return;
+  }
+  chprintf(chp, "    addr     hits   misses rate objects  bytes\r\n");
+  tp = chRegFirstThread();
+  do {
+    chSysLock();
+    hcp = chHeapCacheGetI(tp);
+    chSysUnlock();
+    if (hcp != NULL) {
+      n = chHeapCacheStatus(hcp, &sz);
+      chprintf(chp, "%.8lx %8lu %8lu %3u%% %7lu %6lu\r\n",
+               (uint32_t)tp, (uint32_t)hcp->hc_hits,
+               (uint32_t)hcp->hc_misses, chHeapCacheGetHitRateX(hcp),
+               (uint32_t)n, (uint32_t)sz);
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+#endif
+
+#if CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS
+static void cmd_stacks(BaseSequentialStream *chp, int argc, char *argv[]) {
+  thread_t *tp;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "stacks");
+    return;
+  }
+  chprintf(chp, "    addr unused name\r\n");
+  tp = chRegFirstThread();
+  do {
+    chprintf(chp, "%.8lx %6lu %s\r\n",
+             (uint32_t)tp, (uint32_t)chRegScanStack(tp),
+             tp->p_name == NULL ? "" : tp->p_name);
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+#endif
+
+#if CH_CFG_USE_HEAP && CH_CFG_HEAP_PROFILE
+static void cmd_heap(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static heap_profile_t profile;
+  size_t n, sz;
+  unsigned i;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "heap");
+    return;
+  }
+  chHeapGetProfile(NULL, &profile);
+  n = chHeapStatus(NULL, &sz);
+  chprintf(chp, "used:      %lu bytes\r\n", (uint32_t)profile.hp_used);
+  chprintf(chp, "max used:  %lu bytes\r\n", (uint32_t)profile.hp_max_used);
+  chprintf(chp, "free:      %lu bytes in %lu fragments\r\n",
+           (uint32_t)sz, (uint32_t)n);
+  chprintf(chp, "largest:   %lu bytes\r\n",
+           (uint32_t)chHeapGetLargestFree(NULL));
+  chprintf(chp, "allocs:    %lu, frees: %lu, failures: %lu\r\n",
+           (uint32_t)profile.hp_allocs, (uint32_t)profile.hp_frees,
+           (uint32_t)profile.hp_failures);
+  for (i = 0; i < CH_HEAP_PROFILE_BUCKETS; i++) {
+    if (profile.hp_hist[i] > 0) {
+      chprintf(chp, "%s%5lu: %lu blocks\r\n",
+               i < CH_HEAP_PROFILE_BUCKETS - 1 ? "<=" : "> ",
+               i < CH_HEAP_PROFILE_BUCKETS - 1 ? 16UL << i : 16UL << (i - 1),
+               (uint32_t)profile.hp_hist[i]);
+    }
+  }
+  chprintf(chp, "    site blocks  bytes\r\n");
+  for (i = 0; i < CH_CFG_HEAP_PROFILE_SITES; i++) {
+    if (profile.hp_sites[i].hs_blocks > 0) {
+      chprintf(chp, "%.8lx %6lu %6lu\r\n",
+               (uint32_t)profile.hp_sites[i].hs_tag,
+               (uint32_t)profile.hp_sites[i].hs_blocks,
+               (uint32_t)profile.hp_sites[i].hs_bytes);
+    }
+  }
+}
+#endif
+
 /**
  * @brief   Array of the default commands.
  */
 static ShellCommand local_commands[] = {
   {"info", cmd_info},
   {"systime", cmd_systime},
+#if CH_CFG_USE_REGISTRY && CH_CFG_USE_PERIODIC
+  {"periodic", cmd_periodic},
+#endif
+#if CH_CFG_USE_REGISTRY && CH_CFG_USE_HEAP_CACHE
+  {"hcache", cmd_hcache},
+#endif
+#if CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS
+  {"stacks", cmd_stacks},
+#endif
+#if CH_CFG_USE_HEAP && CH_CFG_HEAP_PROFILE
+  {"heap", cmd_heap},
+#endif
   {NULL, NULL}
 };
 
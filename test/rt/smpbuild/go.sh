@@ -0,0 +1,67 @@
+#!/bin/bash
+export XOPT XDEFS SMP_MODE
+
+XOPT="-ggdb -O2 -fomit-frame-pointer -DDELAY_BETWEEN_TESTS=0"
+XDEFS=""
+SMP_MODE=TRUE
+
+function clean() {
+  make clean > /dev/null
+}
+
+function compile() {
+  echo -n "  * Building..."
+  if ! make > buildlog.txt
+  then
+    echo "failed"
+    clean
+    exit
+  fi
+  echo "OK"
+}
+
+function execute_test() {
+  echo -n "  * Testing..."
+  if ! ./ch > testlog.txt
+  then
+    echo "failed"
+    clean
+    exit
+  fi
+  echo "OK"
+  clean
+}
+
+echo "Default maximum settings"
+compile
+execute_test
+
+echo "CH_CFG_SMP_MODE=FALSE CH_CFG_ST_TIMEDELTA=2 CH_CFG_TIME_QUANTUM=20"
+SMP_MODE=FALSE
+XDEFS="-DCH_CFG_ST_TIMEDELTA=2 -DCH_CFG_TIME_QUANTUM=20 -DCH_DBG_THREADS_PROFILING=FALSE"
+compile
+execute_test
+
+echo "CH_CFG_SMP_MODE=FALSE CH_CFG_ST_TIMEDELTA=2 CH_CFG_VT_TIMING_WHEEL=TRUE"
+SMP_MODE=FALSE
+XDEFS="-DCH_CFG_ST_TIMEDELTA=2 -DCH_CFG_VT_TIMING_WHEEL=TRUE -DCH_DBG_THREADS_PROFILING=FALSE"
+compile
+execute_test
+
+echo "CH_CFG_SMP_MODE=FALSE CH_CFG_ST_TIMEDELTA=2 CH_CFG_VT_TIMING_WHEEL=TRUE CH_CFG_VT_WHEEL_BITS=2"
+SMP_MODE=FALSE
+XDEFS="-DCH_CFG_ST_TIMEDELTA=2 -DCH_CFG_VT_TIMING_WHEEL=TRUE -DCH_CFG_VT_WHEEL_BITS=2 -DCH_DBG_THREADS_PROFILING=FALSE"
+compile
+execute_test
+
+echo "CH_DBG_FILL_THREADS=TRUE"
+SMP_MODE=TRUE
+XDEFS="-DCH_DBG_FILL_THREADS=TRUE"
+compile
+execute_test
+
+echo "CH_CFG_SMP_MODE=FALSE CH_CFG_SCHED_THRESHOLD=TRUE CH_CFG_SCHED_BUDGET=TRUE"
+SMP_MODE=FALSE
+XDEFS="-DCH_CFG_SCHED_THRESHOLD=TRUE -DCH_CFG_SCHED_BUDGET=TRUE"
+compile
+execute_test
@@ -0,0 +1,103 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ch.h"
+#include "test.h"
+
+/*
+ * Console stream over the host standard output.
+ */
+static size_t con_write(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+  n = fwrite(bp, 1, n, stdout);
+  fflush(stdout);
+  return n;
+}
+
+static size_t con_read(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t con_put(void *ip, uint8_t b) {
+
+  (void)ip;
+  putchar(b);
+  if (b == '\n')
+    fflush(stdout);
+  return MSG_OK;
+}
+
+static msg_t con_get(void *ip) {
+
+  (void)ip;
+  return MSG_RESET;
+}
+
+static const struct BaseSequentialStreamVMT vmt = {
+  con_write, con_read, con_put, con_get
+};
+
+static BaseSequentialStream con = {&vmt};
+
+#if CH_CFG_SMP_MODE
+/*
+ * Main function of the other cores, the core main thread just sleeps, the
+ * test threads are bound to the core by the test suite.
+ */
+static void core_main(void) {
+
+  chSysInitCore();
+  while (true)
+    chThdSleepMilliseconds(500);
+}
+#endif
+
+/*
+ * Simulator main.
+ */
+int main(int argc, char *argv[]) {
+#if CH_CFG_SMP_MODE
+  unsigned core;
+#endif
+  msg_t result;
+
+  (void)argc;
+  (void)argv;
+
+  /*
+   * Kernel initialization on the core zero, the main() function becomes a
+   * thread and the RTOS is active, then the other cores are started.
+   */
+  chSysInit();
+#if CH_CFG_SMP_MODE
+  for (core = 1; core < PORT_CORES_NUMBER; core++)
+    _sim_start_core(core, core_main);
+#endif
+
+  result = TestThread(&con);
+  if (result)
+    exit(1);
+  else
+    exit(0);
+}
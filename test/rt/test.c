@@ -23,7 +23,6 @@
  */
 
 #include "ch.h"
-#include "hal.h"
 
 #include "test.h"
 #include "testthd.h"
@@ -31,11 +30,19 @@
 #include "testmtx.h"
 #include "testmsg.h"
 #include "testmbox.h"
+#include "testring.h"
+#include "testobjfifo.h"
 #include "testevt.h"
 #include "testheap.h"
 #include "testpools.h"
+#include "testarena.h"
 #include "testdyn.h"
+#include "testtpool.h"
 #include "testqueues.h"
+#include "testwaitset.h"
+#include "testvt.h"
+#include "testedf.h"
+#include "testsmp.h"
 #include "testbmk.h"
 
 /*
@@ -47,11 +54,19 @@ static ROMCONST struct testcase * ROMCONST *patterns[] = {
   patternmtx,
   patternmsg,
   patternmbox,
+  patternring,
+  patternobjfifo,
   patternevt,
   patternheap,
   patternpools,
+  patternarena,
   patterndyn,
+  patterntpool,
   patternqueues,
+  patternwaitset,
+  patternvt,
+  patternedf,
+  patternsmp,
   patternbmk,
   NULL
 };
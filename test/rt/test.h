@@ -39,6 +39,34 @@
 #define TEST_NO_BENCHMARKS      FALSE
 #endif
 
+/**
+ * @brief   Number of threads used by the scaled mass reschedule benchmark.
+ * @note    The benchmark is not included if this value is not greater
+ *          than @p MAX_THREADS, this is the default on the architectures
+ *          with very little RAM.
+ */
+#if !defined(TEST_BMK_MASS_THREADS) || defined(__DOXYGEN__)
+#if defined(CH_ARCHITECTURE_AVR) || defined(CH_ARCHITECTURE_MSP430) ||      \
+    defined(CH_ARCHITECTURE_STM8)
+#define TEST_BMK_MASS_THREADS   5
+#else
+#define TEST_BMK_MASS_THREADS   20
+#endif
+#endif
+
+/**
+ * @brief   Number of timers kept armed by the scaled virtual timers
+ *          benchmark.
+ */
+#if !defined(TEST_BMK_ARMED_TIMERS) || defined(__DOXYGEN__)
+#if defined(CH_ARCHITECTURE_AVR) || defined(CH_ARCHITECTURE_MSP430) ||      \
+    defined(CH_ARCHITECTURE_STM8)
+#define TEST_BMK_ARMED_TIMERS   8
+#else
+#define TEST_BMK_ARMED_TIMERS   64
+#endif
+#endif
+
 #define MAX_THREADS             5
 #define MAX_TOKENS              16
 
@@ -5,11 +5,19 @@ TESTSRC = ${CHIBIOS}/test/rt/test.c \
           ${CHIBIOS}/test/rt/testmtx.c \
           ${CHIBIOS}/test/rt/testmsg.c \
           ${CHIBIOS}/test/rt/testmbox.c \
+          ${CHIBIOS}/test/rt/testring.c \
+          ${CHIBIOS}/test/rt/testobjfifo.c \
           ${CHIBIOS}/test/rt/testevt.c \
           ${CHIBIOS}/test/rt/testheap.c \
           ${CHIBIOS}/test/rt/testpools.c \
+          ${CHIBIOS}/test/rt/testarena.c \
           ${CHIBIOS}/test/rt/testdyn.c \
+          ${CHIBIOS}/test/rt/testtpool.c \
           ${CHIBIOS}/test/rt/testqueues.c \
+          ${CHIBIOS}/test/rt/testwaitset.c \
+          ${CHIBIOS}/test/rt/testvt.c \
+          ${CHIBIOS}/test/rt/testedf.c \
+          ${CHIBIOS}/test/rt/testsmp.c \
           ${CHIBIOS}/test/rt/testbmk.c
 
 # Required include directories
@@ -0,0 +1,125 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_arena Memory Arenas test
+ *
+ * File: @ref testarena.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref arenas subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref arenas code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_USE_MEMARENAS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_arena_001
+ * .
+ * @file testarena.c
+ * @brief Memory Arenas test source file
+ * @file testarena.h
+ * @brief Memory Arenas test header file
+ */
+
+#if CH_CFG_USE_MEMARENAS || defined(__DOXYGEN__)
+
+#define ARENA_SIZE      (ARENA_ALIGN_SIZE * 32)
+
+static memory_arena_t arena1;
+
+static stkalign_t arena_buf[ARENA_SIZE / ARENA_ALIGN_SIZE];
+
+/**
+ * @page test_arena_001 Allocation and scopes test
+ *
+ * <h2>Description</h2>
+ * Blocks are allocated from an arena within two nested scopes, the scopes
+ * are closed by rewinding the arena to their marks, the arena is then
+ * exhausted and reset.<br>
+ * The test expects the blocks to be aligned, the memory released by a
+ * scope to be reused and the peak usage to be retained.
+ */
+
+static void arena1_setup(void) {
+
+  chArenaObjectInit(&arena1, arena_buf, sizeof arena_buf);
+}
+
+static void arena1_execute(void) {
+  void *p1, *p2, *p3;
+  arena_mark_t mark1, mark2;
+
+  p1 = chArenaAlloc(&arena1, 1);
+  test_assert(1, (p1 != NULL) && ARENA_IS_ALIGNED(p1), "allocation failed");
+  test_assert(2, chArenaGetUsedX(&arena1) == ARENA_ALIGN_SIZE, "wrong size");
+
+  /* Nested scopes.*/
+  mark1 = chArenaGetMarkX(&arena1);
+  (void)chArenaAlloc(&arena1, ARENA_ALIGN_SIZE * 4);
+  mark2 = chArenaGetMarkX(&arena1);
+  p2 = chArenaAlloc(&arena1, ARENA_ALIGN_SIZE * 2);
+  chArenaRewind(&arena1, mark2);
+  p3 = chArenaAlloc(&arena1, ARENA_ALIGN_SIZE);
+  test_assert(3, p3 == p2, "memory not reused");
+  chArenaRewind(&arena1, mark1);
+  test_assert(4, chArenaGetUsedX(&arena1) == ARENA_ALIGN_SIZE,
+              "scope not released");
+  test_assert(5, chArenaGetPeakX(&arena1) == ARENA_ALIGN_SIZE * 7,
+              "wrong peak");
+
+  /* Exhausting the arena.*/
+  test_assert(6, chArenaAlloc(&arena1, ARENA_SIZE) == NULL,
+              "allocation not failed");
+  test_assert(7, chArenaAlloc(&arena1, chArenaGetFreeX(&arena1)) != NULL,
+              "allocation failed");
+  test_assert(8, chArenaGetFreeX(&arena1) == 0, "not exhausted");
+
+  /* Releasing everything, the peak is retained.*/
+  chArenaReset(&arena1);
+  test_assert(9, chArenaGetUsedX(&arena1) == 0, "not empty");
+  test_assert(10, chArenaGetPeakX(&arena1) == ARENA_SIZE, "wrong peak");
+  test_assert(11, chArenaAlloc(&arena1, 1) == p1, "memory not reused");
+}
+
+ROMCONST struct testcase testarena1 = {
+  "Memory Arenas, allocation and scopes",
+  arena1_setup,
+  NULL,
+  arena1_execute
+};
+
+#endif /* CH_CFG_USE_MEMARENAS */
+
+/**
+ * @brief   Test sequence for arenas.
+ */
+ROMCONST struct testcase * ROMCONST patternarena[] = {
+#if CH_CFG_USE_MEMARENAS || defined(__DOXYGEN__)
+  &testarena1,
+#endif
+  NULL
+};
@@ -49,6 +49,21 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
+ * - @subpage test_benchmarks_017
+ * - @subpage test_benchmarks_018
+ * - @subpage test_benchmarks_019
+ * - @subpage test_benchmarks_020
+ * - @subpage test_benchmarks_021
+ * - @subpage test_benchmarks_022
+ * - @subpage test_benchmarks_023
+ * - @subpage test_benchmarks_024
+ * - @subpage test_benchmarks_025
+ * - @subpage test_benchmarks_026
+ * - @subpage test_benchmarks_027
+ * - @subpage test_benchmarks_028
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -192,6 +207,65 @@ ROMCONST struct testcase testbmk3 = {
   NULL,
   bmk3_execute
 };
+
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_028 Messages performance #4
+ *
+ * <h2>Description</h2>
+ * A message server thread is created with the same priority of the client
+ * thread, the client sends bursts of four asynchronous messages and then
+ * collects the answers. The messages throughput per second is measured and
+ * the result printed in the output log.
+ */
+
+static msg_t thread28(void *p) {
+  msg_handle_t *mhp;
+  msg_t msg;
+
+  (void)p;
+  do {
+    mhp = chMsgWaitAsync();
+    msg = chMsgGetAsync(mhp);
+    chMsgReleaseAsync(mhp, msg);
+  } while (msg);
+  return 0;
+}
+
+static void bmk28_execute(void) {
+  uint32_t n = 0;
+  msg_handle_t mh[4];
+  unsigned i;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX(),
+                                 thread28, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < 4; i++)
+      chMsgSendAsync(threads[0], &mh[i], 1);
+    for (i = 0; i < 4; i++)
+      (void)chMsgCollect(&mh[i]);
+    n += 4;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chMsgSendAsync(threads[0], &mh[0], 0);
+  (void)chMsgCollect(&mh[0]);
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" msgs/S");
+}
+
+ROMCONST struct testcase testbmk28 = {
+  "Benchmark, messages #4 (asynchronous)",
+  NULL,
+  NULL,
+  bmk28_execute
+};
+#endif /* CH_CFG_USE_MESSAGES_ASYNC */
 #endif /* if CH_CFG_USE_MESSAGES */
 
 /**
@@ -357,14 +431,36 @@ static void bmk7_setup(void) {
   chSemObjectInit(&sem1, 0);
 }
 
-static void bmk7_execute(void) {
+#if (TEST_BMK_MASS_THREADS > MAX_THREADS) || defined(__DOXYGEN__)
+/*
+ * Working areas for the threads exceeding the MAX_THREADS limit of the
+ * common test buffers.
+ */
+static stkalign_t mass_wa[TEST_BMK_MASS_THREADS - MAX_THREADS]
+                         [WA_SIZE / sizeof(stkalign_t)];
+static thread_t *mass_threads[TEST_BMK_MASS_THREADS - MAX_THREADS];
+#endif
+
+/*
+ * Mass reschedule loop, the specified number of threads is created at
+ * increasing priorities above the tester thread.
+ */
+static void mass_reschedule(unsigned nthreads) {
+  unsigned i;
   uint32_t n;
 
-  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()+5, thread3, NULL);
-  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX()+4, thread3, NULL);
-  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriorityX()+3, thread3, NULL);
-  threads[3] = chThdCreateStatic(wa[3], WA_SIZE, chThdGetPriorityX()+2, thread3, NULL);
-  threads[4] = chThdCreateStatic(wa[4], WA_SIZE, chThdGetPriorityX()+1, thread3, NULL);
+  for (i = 0; i < nthreads; i++) {
+    tprio_t prio = chThdGetPriorityX() + (tprio_t)(nthreads - i);
+
+    if (i < MAX_THREADS)
+      threads[i] = chThdCreateStatic(wa[i], WA_SIZE, prio, thread3, NULL);
+#if TEST_BMK_MASS_THREADS > MAX_THREADS
+    else
+      mass_threads[i - MAX_THREADS] = chThdCreateStatic(mass_wa[i - MAX_THREADS],
+                                                        WA_SIZE, prio,
+                                                        thread3, NULL);
+#endif
+  }
 
   n = 0;
   test_wait_tick();
@@ -377,23 +473,233 @@ static void bmk7_execute(void) {
 #endif
   } while (!test_timer_done);
   test_terminate_threads();
+#if TEST_BMK_MASS_THREADS > MAX_THREADS
+  for (i = MAX_THREADS; i < nthreads; i++)
+    chThdTerminate(mass_threads[i - MAX_THREADS]);
+#endif
   chSemReset(&sem1, 0);
   test_wait_threads();
+#if TEST_BMK_MASS_THREADS > MAX_THREADS
+  for (i = MAX_THREADS; i < nthreads; i++)
+    chThdWait(mass_threads[i - MAX_THREADS]);
+#endif
 
   test_print("--- Score : ");
   test_printn(n);
   test_print(" reschedules/S, ");
-  test_printn(n * 6);
+  test_printn(n * (nthreads + 1));
   test_println(" ctxswc/S");
 }
 
+static void bmk7_execute(void) {
+
+  mass_reschedule(5);
+}
+
 ROMCONST struct testcase testbmk7 = {
   "Benchmark, mass reschedule, 5 threads",
   bmk7_setup,
   NULL,
   bmk7_execute
 };
+
+#if (TEST_BMK_MASS_THREADS > MAX_THREADS) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_014 Mass reschedule performance, scaled
+ *
+ * <h2>Description</h2>
+ * Same as @ref test_benchmarks_007 but using @p TEST_BMK_MASS_THREADS
+ * threads, the difference between the two scores shows how the reschedule
+ * cost grows with the number of ready threads. The bitmap ready list,
+ * @p CH_CFG_RLIST_BITMAP, is expected to keep the per-thread cost
+ * constant.
+ */
+
+static void bmk14_execute(void) {
+
+  mass_reschedule(TEST_BMK_MASS_THREADS);
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, mass reschedule, scaled threads",
+  bmk7_setup,
+  NULL,
+  bmk14_execute
+};
+#endif
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_017 EDF mass reschedule performance
+ *
+ * <h2>Description</h2>
+ * Same as @ref test_benchmarks_007 but the five threads share the EDF
+ * priority level and are ordered by their deadlines, the difference between
+ * the two scores shows the cost of the deadline ordered insertion.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static msg_t thread17(void *p) {
+
+  chThdSetDeadline(*(systime_t *)p);
+  while (!chThdShouldTerminateX())
+    chSemWait(&sem1);
+  return 0;
+}
+
+static void bmk17_execute(void) {
+  static systime_t deadlines[MAX_THREADS];
+  tprio_t prio = chThdSetPriority(CH_CFG_EDF_PRIO - 1);
+  systime_t base = chVTGetSystemTime() + S2ST(1);
+  unsigned i;
+  uint32_t n;
+
+  /* The threads are created in reverse deadline order.*/
+  for (i = 0; i < MAX_THREADS; i++) {
+    deadlines[i] = base + (systime_t)(MAX_THREADS - i);
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, CH_CFG_EDF_PRIO,
+                                   thread17, (void *)&deadlines[i]);
+  }
+
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSemReset(&sem1, 0);
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  test_terminate_threads();
+  chSemReset(&sem1, 0);
+  test_wait_threads();
+  chThdSetPriority(prio);
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" reschedules/S, ");
+  test_printn(n * (MAX_THREADS + 1));
+  test_println(" ctxswc/S");
+}
+
+ROMCONST struct testcase testbmk17 = {
+  "Benchmark, EDF mass reschedule, 5 threads",
+  bmk7_setup,
+  NULL,
+  bmk17_execute
+};
+#endif /* CH_CFG_SCHED_EDF */
+
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_018 Preemption threshold
+ *
+ * <h2>Description</h2>
+ * Three threads with priority above the tester thread wait on a semaphore,
+ * the tester thread signals the semaphore three times then lowers its
+ * preemption threshold letting the woken threads run.<br>
+ * The loop is executed for a second with no threshold then for a second
+ * with the threshold raised above the three threads, the context switches
+ * are counted in both cases in order to show the switches saved by the
+ * threshold.
+ */
+
+static thread_t * volatile th_last;
+static volatile uint32_t th_ctxswc;
+
+/*
+ * Counts the context switches by tracking the thread running last.
+ */
+static void th_account(void) {
+
+  if (th_last != chThdGetSelfX()) {
+    th_last = chThdGetSelfX();
+    th_ctxswc++;
+  }
+}
+
+static msg_t thread18(void *p) {
+
+  (void)p;
+  while (!chThdShouldTerminateX()) {
+    chSemWait(&sem1);
+    th_account();
+  }
+  return 0;
+}
+
+static uint32_t threshold_loop(tprio_t threshold) {
+  tprio_t oldthreshold;
+  uint32_t n;
+
+  th_last = chThdGetSelfX();
+  th_ctxswc = 0;
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    oldthreshold = chThdSetThreshold(threshold);
+    chSemSignal(&sem1);
+    th_account();
+    chSemSignal(&sem1);
+    th_account();
+    chSemSignal(&sem1);
+    th_account();
+    chThdSetThreshold(oldthreshold);
+    th_account();
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
 #endif
+  } while (!test_timer_done);
+
+  return n;
+}
+
+static void bmk18_execute(void) {
+  tprio_t prio = chThdGetPriorityX();
+  uint32_t n1, n2, c1, c2;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread18, NULL);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 2, thread18, NULL);
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio + 3, thread18, NULL);
+
+  n1 = threshold_loop(NOPRIO);
+  c1 = th_ctxswc;
+  n2 = threshold_loop(prio + 3);
+  c2 = th_ctxswc;
+
+  test_terminate_threads();
+  chSemReset(&sem1, 0);
+  test_wait_threads();
+
+  test_assert(1, c2 / n2 < c1 / n1, "no context switches saved");
+
+  test_print("--- Score : ");
+  test_printn(n1);
+  test_print(" loops/S, ");
+  test_printn(c1);
+  test_println(" ctxswc/S (no threshold)");
+  test_print("--- Score : ");
+  test_printn(n2);
+  test_print(" loops/S, ");
+  test_printn(c2);
+  test_println(" ctxswc/S (threshold)");
+  test_print("--- Saved : ");
+  test_printn(c1 / n1 - c2 / n2);
+  test_println(" ctxswc/loop");
+}
+
+ROMCONST struct testcase testbmk18 = {
+  "Benchmark, preemption threshold",
+  bmk7_setup,
+  NULL,
+  bmk18_execute
+};
+#endif /* CH_CFG_SCHED_THRESHOLD */
+#endif /* CH_CFG_USE_SEMAPHORES */
 
 /**
  * @page test_benchmarks_008 I/O Round-Robin voluntary reschedule.
@@ -448,6 +754,71 @@ ROMCONST struct testcase testbmk8 = {
   bmk8_execute
 };
 
+#if (CH_CFG_TIME_QUANTUM > 0) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_016 Round-Robin preemption
+ *
+ * <h2>Description</h2>
+ * Five threads are created at equal priority, each thread just increases
+ * its own counter and never yields, the switches are only caused by the
+ * time quantum expiration. All the threads are required to run.<br>
+ * The performance is calculated by counting the time slices after a second
+ * of continuous operations. In tick-less mode the quantum is enforced by
+ * the one-shot slice timer.
+ */
+
+static thread_t * volatile rr_last;
+static volatile uint32_t rr_slices;
+static volatile uint32_t rr_counts[MAX_THREADS];
+
+static msg_t thread16(void *p) {
+
+  do {
+    if (rr_last != chThdGetSelfX()) {
+      rr_last = chThdGetSelfX();
+      rr_slices++;
+    }
+    (*(volatile uint32_t *)p)++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while(!chThdShouldTerminateX());
+  return 0;
+}
+
+static void bmk16_execute(void) {
+  int i;
+
+  rr_last = NULL;
+  rr_slices = 0;
+  for (i = 0; i < MAX_THREADS; i++)
+    rr_counts[i] = 0;
+  test_wait_tick();
+
+  for (i = 0; i < MAX_THREADS; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriorityX()-1,
+                                   thread16, (void *)&rr_counts[i]);
+
+  chThdSleepSeconds(1);
+  test_terminate_threads();
+  test_wait_threads();
+
+  for (i = 0; i < MAX_THREADS; i++)
+    test_assert(i + 1, rr_counts[i] > 0, "thread starved");
+
+  test_print("--- Score : ");
+  test_printn(rr_slices);
+  test_println(" slices/S");
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, round robin preemption",
+  NULL,
+  NULL,
+  bmk16_execute
+};
+#endif /* CH_CFG_TIME_QUANTUM > 0 */
+
 #if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
 /**
  * @page test_benchmarks_009 I/O Queues throughput
@@ -497,110 +868,301 @@ ROMCONST struct testcase testbmk9 = {
 };
 #endif /* CH_CFG_USE_QUEUES */
 
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
 /**
- * @page test_benchmarks_010 Virtual Timers set/reset performance
+ * @page test_benchmarks_025 SPSC Rings throughput
  *
  * <h2>Description</h2>
- * A virtual timer is set and immediately reset into a continuous loop.<br>
+ * Four bytes are written and then read from a ring into a continuous loop,
+ * first one byte at time then as a single burst. The loop is the same of
+ * @ref test_benchmarks_009 but no critical zones are required.<br>
  * The performance is calculated by measuring the number of iterations after
  * a second of continuous operations.
  */
 
-static void tmo(void *param) {(void)param;}
+static void bmk25_execute(void) {
+  uint32_t n1 = 0, n2 = 0;
+  static uint8_t rb[16];
+  static ring_t ring;
+  static const uint8_t wb[4] = {0, 1, 2, 3};
+  uint8_t b[4];
 
-static void bmk10_execute(void) {
-  static virtual_timer_t vt1, vt2;
-  uint32_t n = 0;
+  chRingObjectInit(&ring, rb, 1, sizeof(rb));
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    (void)chRingPutX(&ring, &wb[0]);
+    (void)chRingPutX(&ring, &wb[1]);
+    (void)chRingPutX(&ring, &wb[2]);
+    (void)chRingPutX(&ring, &wb[3]);
+    (void)chRingGetX(&ring, &b[0]);
+    (void)chRingGetX(&ring, &b[1]);
+    (void)chRingGetX(&ring, &b[2]);
+    (void)chRingGetX(&ring, &b[3]);
+    n1++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
 
   test_wait_tick();
   test_start_timer(1000);
   do {
-    chSysLock();
-    chVTDoSetI(&vt1, 1, tmo, NULL);
-    chVTDoSetI(&vt2, 10000, tmo, NULL);
-    chVTDoResetI(&vt1);
-    chVTDoResetI(&vt2);
-    chSysUnlock();
-    n++;
+    (void)chRingWriteX(&ring, wb, 4);
+    (void)chRingReadX(&ring, b, 4);
+    n2++;
 #if defined(SIMULATOR)
     _sim_check_for_interrupts();
 #endif
   } while (!test_timer_done);
+
   test_print("--- Score : ");
-  test_printn(n * 2);
-  test_println(" timers/S");
+  test_printn(n1 * 4);
+  test_println(" bytes/S (single)");
+  test_print("--- Score : ");
+  test_printn(n2 * 4);
+  test_println(" bytes/S (burst)");
 }
 
-ROMCONST struct testcase testbmk10 = {
-  "Benchmark, virtual timers set/reset",
+ROMCONST struct testcase testbmk25 = {
+  "Benchmark, SPSC Rings throughput",
   NULL,
   NULL,
-  bmk10_execute
+  bmk25_execute
 };
+#endif /* CH_CFG_USE_RINGS */
 
-#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
 /**
- * @page test_benchmarks_011 Semaphores wait/signal performance
+ * @page test_benchmarks_027 Mailboxes throughput
  *
  * <h2>Description</h2>
- * A counting semaphore is taken/released into a continuous loop, no Context
- * Switch happens because the counter is always non negative.<br>
+ * Four messages are posted and then fetched from a mailbox into a
+ * continuous loop, first one message at time then as a single block using
+ * the bulk operations.<br>
  * The performance is calculated by measuring the number of iterations after
  * a second of continuous operations.
  */
 
-static void bmk11_setup(void) {
-
-  chSemObjectInit(&sem1, 1);
-}
+static void bmk27_execute(void) {
+  uint32_t n1 = 0, n2 = 0;
+  static msg_t mbbuf[4];
+  static mailbox_t mb;
+  static const msg_t wb[4] = {0, 1, 2, 3};
+  msg_t b[4];
 
-static void bmk11_execute(void) {
-  uint32_t n = 0;
+  chMBObjectInit(&mb, mbbuf, 4);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    (void)chMBPost(&mb, wb[0], TIME_INFINITE);
+    (void)chMBPost(&mb, wb[1], TIME_INFINITE);
+    (void)chMBPost(&mb, wb[2], TIME_INFINITE);
+    (void)chMBPost(&mb, wb[3], TIME_INFINITE);
+    (void)chMBFetch(&mb, &b[0], TIME_INFINITE);
+    (void)chMBFetch(&mb, &b[1], TIME_INFINITE);
+    (void)chMBFetch(&mb, &b[2], TIME_INFINITE);
+    (void)chMBFetch(&mb, &b[3], TIME_INFINITE);
+    n1++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
 
   test_wait_tick();
   test_start_timer(1000);
   do {
-    chSemWait(&sem1);
-    chSemSignal(&sem1);
-    chSemWait(&sem1);
-    chSemSignal(&sem1);
-    chSemWait(&sem1);
-    chSemSignal(&sem1);
-    chSemWait(&sem1);
-    chSemSignal(&sem1);
-    n++;
+    (void)chMBPostMany(&mb, wb, 4, TIME_INFINITE);
+    (void)chMBFetchMany(&mb, b, 4, TIME_INFINITE);
+    n2++;
 #if defined(SIMULATOR)
     _sim_check_for_interrupts();
 #endif
   } while (!test_timer_done);
+
   test_print("--- Score : ");
-  test_printn(n * 4);
-  test_println(" wait+signal/S");
+  test_printn(n1 * 4);
+  test_println(" msgs/S (single)");
+  test_print("--- Score : ");
+  test_printn(n2 * 4);
+  test_println(" msgs/S (bulk)");
 }
 
-ROMCONST struct testcase testbmk11 = {
-  "Benchmark, semaphores wait/signal",
-  bmk11_setup,
+ROMCONST struct testcase testbmk27 = {
+  "Benchmark, mailboxes throughput",
   NULL,
-  bmk11_execute
+  NULL,
+  bmk27_execute
 };
-#endif
+#endif /* CH_CFG_USE_MAILBOXES */
 
-#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
 /**
- * @page test_benchmarks_012 Mutexes lock/unlock performance
+ * @page test_benchmarks_010 Virtual Timers set/reset performance
  *
  * <h2>Description</h2>
- * A mutex is locked/unlocked into a continuous loop, no Context Switch happens
- * because there are no other threads asking for the mutex.<br>
+ * A virtual timer is set and immediately reset into a continuous loop.<br>
  * The performance is calculated by measuring the number of iterations after
  * a second of continuous operations.
  */
 
-static void bmk12_setup(void) {
-
-  chMtxObjectInit(&mtx1);
-}
+static void tmo(void *param) {(void)param;}
+
+static void bmk10_execute(void) {
+  static virtual_timer_t vt1, vt2;
+  uint32_t n = 0;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chVTDoSetI(&vt1, 1, tmo, NULL);
+    chVTDoSetI(&vt2, 10000, tmo, NULL);
+    chVTDoResetI(&vt1);
+    chVTDoResetI(&vt2);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_printn(n * 2);
+  test_println(" timers/S");
+}
+
+ROMCONST struct testcase testbmk10 = {
+  "Benchmark, virtual timers set/reset",
+  NULL,
+  NULL,
+  bmk10_execute
+};
+
+/**
+ * @page test_benchmarks_015 Virtual Timers set/reset performance, scaled
+ *
+ * <h2>Description</h2>
+ * Same as @ref test_benchmarks_010 but with @p TEST_BMK_ARMED_TIMERS other
+ * timers armed during the measurement, the second timer expires after all
+ * of them. The difference between the two scores shows how the set/reset
+ * cost grows with the number of armed timers. The timing wheel,
+ * @p CH_CFG_VT_TIMING_WHEEL, is expected to keep the cost constant.
+ */
+
+static virtual_timer_t armed_vts[TEST_BMK_ARMED_TIMERS];
+
+static void bmk15_setup(void) {
+  unsigned i;
+
+  chSysLock();
+  for (i = 0; i < TEST_BMK_ARMED_TIMERS; i++) {
+    chVTDoSetI(&armed_vts[i], S2ST(2) + (systime_t)i, tmo, NULL);
+  }
+  chSysUnlock();
+}
+
+static void bmk15_teardown(void) {
+  unsigned i;
+
+  chSysLock();
+  for (i = 0; i < TEST_BMK_ARMED_TIMERS; i++) {
+    chVTResetI(&armed_vts[i]);
+  }
+  chSysUnlock();
+}
+
+static void bmk15_execute(void) {
+  static virtual_timer_t vt1, vt2;
+  uint32_t n = 0;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chVTDoSetI(&vt1, 1, tmo, NULL);
+    chVTDoSetI(&vt2, S2ST(4), tmo, NULL);
+    chVTDoResetI(&vt1);
+    chVTDoResetI(&vt2);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_printn(n * 2);
+  test_println(" timers/S");
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, virtual timers set/reset, scaled timers",
+  bmk15_setup,
+  bmk15_teardown,
+  bmk15_execute
+};
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_011 Semaphores wait/signal performance
+ *
+ * <h2>Description</h2>
+ * A counting semaphore is taken/released into a continuous loop, no Context
+ * Switch happens because the counter is always non negative.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk11_setup(void) {
+
+  chSemObjectInit(&sem1, 1);
+}
+
+static void bmk11_execute(void) {
+  uint32_t n = 0;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSemWait(&sem1);
+    chSemSignal(&sem1);
+    chSemWait(&sem1);
+    chSemSignal(&sem1);
+    chSemWait(&sem1);
+    chSemSignal(&sem1);
+    chSemWait(&sem1);
+    chSemSignal(&sem1);
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_printn(n * 4);
+  test_println(" wait+signal/S");
+}
+
+ROMCONST struct testcase testbmk11 = {
+  "Benchmark, semaphores wait/signal",
+  bmk11_setup,
+  NULL,
+  bmk11_execute
+};
+#endif
+
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_012 Mutexes lock/unlock performance
+ *
+ * <h2>Description</h2>
+ * A mutex is locked/unlocked into a continuous loop, no Context Switch happens
+ * because there are no other threads asking for the mutex.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk12_setup(void) {
+
+  chMtxObjectInit(&mtx1);
+}
 
 static void bmk12_execute(void) {
   uint32_t n = 0;
@@ -634,6 +1196,494 @@ ROMCONST struct testcase testbmk12 = {
 };
 #endif
 
+#if (CH_CFG_USE_HEAP && !CH_CFG_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_019 Heap allocator under fragmentation
+ *
+ * <h2>Description</h2>
+ * A heap is fragmented by allocating blocks of pseudo-random sizes and
+ * releasing one block every two, then a block of pseudo-random size is
+ * allocated and released into a continuous loop. Some of the requested
+ * sizes do not fit any hole so the whole free space has to be searched.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations, the worst iteration time is measured
+ * using the realtime counter. Running the benchmark with
+ * @p CH_CFG_HEAP_TLSF enabled and disabled compares the two allocators.
+ */
+
+#define BMK19_BLOCKS    128
+
+static memory_heap_t bmk_heap;
+
+static void bmk19_setup(void) {
+
+  chHeapObjectInit(&bmk_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void bmk19_execute(void) {
+  static void *blocks[BMK19_BLOCKS];
+  uint32_t seed = 0x12345678U;
+  uint32_t n = 0;
+  unsigned i, nblocks;
+  size_t frags, sz;
+  void *p;
+#if PORT_SUPPORTS_RT
+  rtcnt_t start, worst = 0;
+#endif
+
+  /* Fragmentation, holes of 8..64 bytes.*/
+  for (nblocks = 0; nblocks < BMK19_BLOCKS; nblocks++) {
+    seed = seed * 1103515245U + 12345U;
+    blocks[nblocks] = chHeapAlloc(&bmk_heap, 8 + (seed >> 16) % 57);
+    if (blocks[nblocks] == NULL)
+      break;
+  }
+  for (i = 0; i < nblocks; i += 2)
+    chHeapFree(blocks[i]);
+  frags = chHeapStatus(&bmk_heap, &sz);
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    seed = seed * 1103515245U + 12345U;
+#if PORT_SUPPORTS_RT
+    start = chSysGetRealtimeCounterX();
+#endif
+    p = chHeapAlloc(&bmk_heap, 8 + (seed >> 16) % 89);
+    if (p != NULL)
+      chHeapFree(p);
+#if PORT_SUPPORTS_RT
+    start = chSysGetRealtimeCounterX() - start;
+    if (start > worst)
+      worst = start;
+#endif
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  for (i = 1; i < nblocks; i += 2)
+    chHeapFree(blocks[i]);
+
+  test_print("--- Frags : ");
+  test_printn(frags);
+  test_print(" free blocks, ");
+  test_printn(sz);
+  test_println(" bytes");
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" alloc+free/S");
+#if PORT_SUPPORTS_RT
+  test_print("--- Worst : ");
+  test_printn(worst);
+  test_println(" RT counter cycles");
+#endif
+}
+
+ROMCONST struct testcase testbmk19 = {
+  "Benchmark, heap allocator under fragmentation",
+  bmk19_setup,
+  NULL,
+  bmk19_execute
+};
+
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_020 Heap caches performance
+ *
+ * <h2>Description</h2>
+ * Four small objects are allocated and released into a continuous loop,
+ * first using the heap then using a heap cache bound to the test
+ * thread.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations, the hit rate of the cache is
+ * reported.
+ */
+
+static heap_cache_t bmk_hcache;
+
+static void bmk20_setup(void) {
+
+  bmk19_setup();
+  chHeapCacheObjectInit(&bmk_hcache, &bmk_heap);
+}
+
+static void bmk20_teardown(void) {
+
+  chHeapCacheFlush(&bmk_hcache);
+  chHeapCacheBind(NULL);
+}
+
+static void bmk20_execute(void) {
+  void *p1, *p2, *p3, *p4;
+  uint32_t n1 = 0, n2 = 0;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    p1 = chHeapAlloc(&bmk_heap, 16);
+    p2 = chHeapAlloc(&bmk_heap, 32);
+    p3 = chHeapAlloc(&bmk_heap, 16);
+    p4 = chHeapAlloc(&bmk_heap, 64);
+    chHeapFree(p1);
+    chHeapFree(p2);
+    chHeapFree(p3);
+    chHeapFree(p4);
+    n1++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  chHeapCacheBind(&bmk_hcache);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    p1 = chHeapCacheAlloc(16);
+    p2 = chHeapCacheAlloc(32);
+    p3 = chHeapCacheAlloc(16);
+    p4 = chHeapCacheAlloc(64);
+    chHeapCacheFree(p1);
+    chHeapCacheFree(p2);
+    chHeapCacheFree(p3);
+    chHeapCacheFree(p4);
+    n2++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  test_print("--- Score : ");
+  test_printn(n1 * 4);
+  test_println(" alloc+free/S (heap)");
+  test_print("--- Score : ");
+  test_printn(n2 * 4);
+  test_print(" alloc+free/S (cache), ");
+  test_printn(chHeapCacheGetHitRateX(&bmk_hcache));
+  test_println("% hits");
+}
+
+ROMCONST struct testcase testbmk20 = {
+  "Benchmark, heap caches",
+  bmk20_setup,
+  bmk20_teardown,
+  bmk20_execute
+};
+#endif /* CH_CFG_USE_HEAP_CACHE */
+#endif
+
+#if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_021 Memory pools batch operations performance
+ *
+ * <h2>Description</h2>
+ * A burst of objects is allocated from a memory pool and released into a
+ * continuous loop, first using the single object APIs then using the batch
+ * APIs.<br>
+ * The performance is calculated by measuring the number of objects
+ * allocated and released after a second of continuous operations.
+ */
+
+#define BMK21_BURST     16
+
+static MEMORYPOOL_DECL(bmk_mp, 16, NULL);
+
+static void bmk21_setup(void) {
+
+  chPoolObjectInit(&bmk_mp, 16, NULL);
+  chPoolLoadArray(&bmk_mp, test.buffer, BMK21_BURST);
+}
+
+static void bmk21_execute(void) {
+  void *objs[BMK21_BURST];
+  uint32_t n1 = 0, n2 = 0;
+  unsigned i;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < BMK21_BURST; i++)
+      objs[i] = chPoolAlloc(&bmk_mp);
+    for (i = 0; i < BMK21_BURST; i++)
+      chPoolFree(&bmk_mp, objs[i]);
+    n1++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    (void)chPoolAllocBatch(&bmk_mp, objs, BMK21_BURST);
+    chPoolFreeBatch(&bmk_mp, objs, BMK21_BURST);
+    n2++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  test_print("--- Score : ");
+  test_printn(n1 * BMK21_BURST);
+  test_println(" objects/S (single)");
+  test_print("--- Score : ");
+  test_printn(n2 * BMK21_BURST);
+  test_println(" objects/S (batch)");
+}
+
+ROMCONST struct testcase testbmk21 = {
+  "Benchmark, memory pools batch operations",
+  bmk21_setup,
+  NULL,
+  bmk21_execute
+};
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_022 Guarded memory pools performance
+ *
+ * <h2>Description</h2>
+ * An object is passed back and forth between the test thread and a higher
+ * priority thread using two guarded memory pools, the higher priority
+ * thread is blocked on the first pool each time the object is released
+ * into it.<br>
+ * The performance is calculated by measuring the number of round trips
+ * after a second of continuous operations.
+ */
+
+static guarded_memory_pool_t bmk_gmp1, bmk_gmp2;
+
+static void *bmk22_obj[4];
+
+static void bmk22_setup(void) {
+
+  chGuardedPoolObjectInit(&bmk_gmp1, 16);
+  chGuardedPoolObjectInit(&bmk_gmp2, 16);
+}
+
+static msg_t thread22(void *p) {
+  void *objp;
+
+  (void)p;
+  do {
+    objp = chGuardedPoolAllocTimeout(&bmk_gmp1, TIME_INFINITE);
+    chGuardedPoolFree(&bmk_gmp2, objp);
+  } while (!chThdShouldTerminateX());
+  return 0;
+}
+
+static void bmk22_execute(void) {
+  void *objp = bmk22_obj;
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread22, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chGuardedPoolFree(&bmk_gmp1, objp);
+    objp = chGuardedPoolAllocTimeout(&bmk_gmp2, TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chThdTerminate(threads[0]);
+  chGuardedPoolFree(&bmk_gmp1, objp);
+  test_wait_threads();
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" round trips/S, ");
+  test_printn(n << 1);
+  test_println(" ctxswc/S");
+}
+
+ROMCONST struct testcase testbmk22 = {
+  "Benchmark, guarded memory pools",
+  bmk22_setup,
+  NULL,
+  bmk22_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+#endif /* CH_CFG_USE_MEMPOOLS */
+
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_026 Objects FIFOs performance
+ *
+ * <h2>Description</h2>
+ * An object is taken, sent, received and returned into a continuous loop,
+ * first using an objects FIFO then using a guarded memory pool and a
+ * mailbox operated separately.<br>
+ * The performance is calculated by measuring the number of objects
+ * exchanged after a second of continuous operations.
+ */
+
+static objects_fifo_t bmk_fifo;
+
+static void *bmk26_objs[4][2];
+
+static msg_t bmk26_msgs[4];
+
+static mailbox_t bmk26_mb;
+
+static void bmk26_execute(void) {
+  uint32_t n1 = 0, n2 = 0;
+  void *objp;
+  msg_t msg;
+
+  chFifoObjectInit(&bmk_fifo, sizeof bmk26_objs[0], 4, sizeof (void *),
+                   bmk26_objs, bmk26_msgs);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    objp = chFifoTakeObjectTimeout(&bmk_fifo, TIME_INFINITE);
+    chFifoSendObject(&bmk_fifo, objp);
+    (void)chFifoReceiveObjectTimeout(&bmk_fifo, &objp, TIME_INFINITE);
+    chFifoReturnObject(&bmk_fifo, objp);
+    n1++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  /* Same objects, the mailbox carries their index.*/
+  chGuardedPoolObjectInit(&bmk_gmp1, sizeof bmk26_objs[0]);
+  chGuardedPoolLoadArray(&bmk_gmp1, bmk26_objs, 4);
+  chMBObjectInit(&bmk26_mb, bmk26_msgs, 4);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    objp = chGuardedPoolAllocTimeout(&bmk_gmp1, TIME_INFINITE);
+    (void)chMBPost(&bmk26_mb, (msg_t)((void *(*)[2])objp - bmk26_objs),
+                   TIME_INFINITE);
+    (void)chMBFetch(&bmk26_mb, &msg, TIME_INFINITE);
+    chGuardedPoolFree(&bmk_gmp1, bmk26_objs[msg]);
+    n2++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  test_print("--- Score : ");
+  test_printn(n1);
+  test_println(" objects/S (FIFO)");
+  test_print("--- Score : ");
+  test_printn(n2);
+  test_println(" objects/S (pool and mailbox)");
+}
+
+ROMCONST struct testcase testbmk26 = {
+  "Benchmark, objects FIFOs",
+  NULL,
+  NULL,
+  bmk26_execute
+};
+#endif /* CH_CFG_USE_OBJ_FIFOS */
+
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_023 Thread pools performance
+ *
+ * <h2>Description</h2>
+ * Empty jobs are continuously submitted to a thread pool with a single
+ * worker at lower priority than the test thread, the test thread waits
+ * for the completion of each job. A full @p chThdPoolSubmit() /
+ * @p chThdPoolWaitTimeout() cycle is performed in each iteration, it can
+ * be compared with the threads full cycle of @ref test_benchmarks_005
+ * and @ref test_benchmarks_024.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static thread_pool_t bmk_tpool;
+
+static thread_pool_job_t bmk_tpool_jobs[4];
+
+static void bmk23_setup(void) {
+
+  chThdPoolObjectInit(&bmk_tpool, bmk_tpool_jobs, 4,
+                      chThdGetPriorityX() - 1);
+}
+
+static void job23(void *p) {
+
+  (void)p;
+}
+
+static void bmk23_execute(void) {
+  uint32_t n = 0;
+
+  threads[0] = chThdPoolAddWorker(&bmk_tpool, wa[0], WA_SIZE);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chThdPoolSubmit(&bmk_tpool, job23, NULL);
+    (void)chThdPoolWaitTimeout(&bmk_tpool, TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chThdPoolStop(&bmk_tpool);
+  test_wait_threads();
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" jobs/S");
+}
+
+ROMCONST struct testcase testbmk23 = {
+  "Benchmark, thread pools",
+  bmk23_setup,
+  NULL,
+  bmk23_execute
+};
+#endif /* CH_CFG_USE_THREADPOOLS */
+
+#if (CH_CFG_USE_DYNAMIC && CH_CFG_USE_HEAP) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_024 Dynamic threads performance, full cycle
+ *
+ * <h2>Description</h2>
+ * Threads are continuously created from the heap and terminated into a
+ * loop. A full @p chThdCreateFromHeap() / @p chThdExit() / @p chThdWait()
+ * cycle is performed in each iteration.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk24_execute(void) {
+  uint32_t n = 0;
+  tprio_t prio = chThdGetPriorityX() - 1;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    thread_t *tp = chThdCreateFromHeap(NULL, WA_SIZE, prio, thread1, NULL);
+    test_assert(1, tp != NULL, "heap exhausted");
+    chThdWait(tp);
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" threads/S");
+}
+
+ROMCONST struct testcase testbmk24 = {
+  "Benchmark, dynamic threads, full cycle",
+  NULL,
+  NULL,
+  bmk24_execute
+};
+#endif /* CH_CFG_USE_DYNAMIC && CH_CFG_USE_HEAP */
+
 /**
  * @page test_benchmarks_013 RAM Footprint
  *
@@ -703,23 +1753,66 @@ ROMCONST struct testcase * ROMCONST patternbmk[] = {
   &testbmk1,
   &testbmk2,
   &testbmk3,
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  &testbmk28,
+#endif
 #endif
   &testbmk4,
   &testbmk5,
   &testbmk6,
 #if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
   &testbmk7,
+#if TEST_BMK_MASS_THREADS > MAX_THREADS
+  &testbmk14,
+#endif
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+  &testbmk17,
+#endif
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+  &testbmk18,
+#endif
 #endif
   &testbmk8,
+#if CH_CFG_TIME_QUANTUM > 0
+  &testbmk16,
+#endif
 #if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
   &testbmk9,
+#endif
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
+  &testbmk25,
+#endif
+#if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
+  &testbmk27,
 #endif
   &testbmk10,
+  &testbmk15,
 #if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
   &testbmk11,
 #endif
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
   &testbmk12,
+#endif
+#if (CH_CFG_USE_HEAP && !CH_CFG_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+  &testbmk19,
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+  &testbmk20,
+#endif
+#endif
+#if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
+  &testbmk21,
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+  &testbmk22,
+#endif
+#endif
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+  &testbmk26,
+#endif
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+  &testbmk23,
+#endif
+#if (CH_CFG_USE_DYNAMIC && CH_CFG_USE_HEAP) || defined(__DOXYGEN__)
+  &testbmk24,
 #endif
   &testbmk13,
 #endif
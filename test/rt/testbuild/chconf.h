@@ -64,6 +64,43 @@
 #define CH_CFG_ST_TIMEDELTA                 0
 #endif
 
+/**
+ * @brief   Virtual timers timing wheel.
+ * @details If enabled then the virtual timers are kept in a hierarchical
+ *          timing wheel instead of the delta list. Arming and disarming a
+ *          timer take constant time regardless of the number of armed
+ *          timers.
+ * @note    The default is @p FALSE.
+ * @note    The wheel requires extra RAM in the system structure, see
+ *          @p CH_CFG_VT_WHEEL_BITS.
+ */
+#if !defined(CH_CFG_VT_TIMING_WHEEL) || defined(__DOXIGEN__)
+#define CH_CFG_VT_TIMING_WHEEL              FALSE
+#endif
+
+/**
+ * @brief   Timing wheel slots per level, as a power of two.
+ * @details Each wheel level has <tt>2^CH_CFG_VT_WHEEL_BITS</tt> slots, the
+ *          number of levels is derived from @p CH_CFG_ST_RESOLUTION.
+ * @note    Allowed values are from 2 to 5.
+ */
+#if !defined(CH_CFG_VT_WHEEL_BITS) || defined(__DOXIGEN__)
+#define CH_CFG_VT_WHEEL_BITS                4
+#endif
+
+/**
+ * @brief   Deferred virtual timers callbacks.
+ * @details If enabled then timers armed using @p chVTDoSetDeferredI() have
+ *          their callbacks invoked, in batches, by a dedicated kernel thread
+ *          instead of the timer interrupt.
+ * @note    The default is @p FALSE.
+ * @note    The thread priority and stack size are specified by
+ *          @p CH_CFG_VT_DEFERRED_PRIO and @p CH_CFG_VT_DEFERRED_STACK_SIZE.
+ */
+#if !defined(CH_CFG_VT_DEFERRED) || defined(__DOXIGEN__)
+#define CH_CFG_VT_DEFERRED                  FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -82,8 +119,8 @@
  *          threads can still preempt, the kernel is always preemptive.
  * @note    Disabling the round robin preemption makes the kernel more compact
  *          and generally faster.
- * @note    The round robin preemption is not supported in tickless mode and
- *          must be set to zero in that case.
+ * @note    In tickless mode the quantum is enforced by a one-shot timer
+ *          armed only while threads with equal priority are ready.
  */
 #if !defined(CH_CFG_TIME_QUANTUM) || defined(__DOXIGEN__)
 #define CH_CFG_TIME_QUANTUM                 20
@@ -104,6 +141,19 @@
 #define CH_CFG_MEMCORE_SIZE                 0x20000
 #endif
 
+/**
+ * @brief   Number of core memory regions.
+ * @details The region zero is the RAM area managed by the OS, the other
+ *          regions can be registered by the application using
+ *          @p chCoreAddRegion(), for example fast or DMA-capable RAM banks.
+ *
+ * @note    The default is 1.
+ * @note    Requires @p CH_CFG_USE_MEMCORE.
+ */
+#if !defined(CH_CFG_MEMCORE_REGIONS) || defined(__DOXIGEN__)
+#define CH_CFG_MEMCORE_REGIONS              1
+#endif
+
 /**
  * @brief   Idle thread automatic spawn suppression.
  * @details When this option is activated the function @p chSysInit()
@@ -135,6 +185,79 @@
 #define CH_CFG_OPTIMIZE_SPEED               TRUE
 #endif
 
+/**
+ * @brief   Bitmap ready list.
+ * @details If enabled then the ready list is implemented as an array of
+ *          FIFO queues, one for each priority level, plus a bitmap of the
+ *          non-empty queues. Threads are made ready in constant time
+ *          regardless of the number of ready threads.
+ *
+ * @note    The default is @p FALSE.
+ * @note    The bitmap and the queues array require extra RAM in the
+ *          system structure.
+ */
+#if !defined(CH_CFG_RLIST_BITMAP) || defined(__DOXIGEN__)
+#define CH_CFG_RLIST_BITMAP                 FALSE
+#endif
+
+/**
+ * @brief   Earliest deadline first scheduling class.
+ * @details If enabled then the threads at the @p CH_CFG_EDF_PRIO priority
+ *          level carry an absolute deadline and are scheduled in deadline
+ *          order, a thread with an earlier deadline preempts a thread
+ *          at the same level with a later deadline.
+ *
+ * @note    The default is @p FALSE.
+ * @note    The EDF priority level should be reserved to EDF threads, the
+ *          other priority levels are not affected.
+ */
+#if !defined(CH_CFG_SCHED_EDF) || defined(__DOXIGEN__)
+#define CH_CFG_SCHED_EDF                    FALSE
+#endif
+
+/**
+ * @brief   Preemption threshold.
+ * @details If enabled then each thread has a preemption threshold, the
+ *          running thread can only be preempted by threads with a priority
+ *          greater than both its priority and its threshold. Threads
+ *          cooperating within a priority range avoid preempting each other
+ *          and the related context switches.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_SCHED_THRESHOLD) || defined(__DOXIGEN__)
+#define CH_CFG_SCHED_THRESHOLD              FALSE
+#endif
+
+/**
+ * @brief   Threads CPU budget.
+ * @details If enabled then a CPU budget object can be attached to a thread,
+ *          the thread is allowed to run for a limited number of ticks in
+ *          each replenishment period and is demoted to a lower priority
+ *          when the budget is used up.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires the tick mode, the consumed time is accounted on each
+ *          system tick to the running thread.
+ */
+#if !defined(CH_CFG_SCHED_BUDGET) || defined(__DOXIGEN__)
+#define CH_CFG_SCHED_BUDGET                 FALSE
+#endif
+
+/**
+ * @brief   Symmetric multiprocessing mode.
+ * @details If enabled then each core has its own ready list, virtual
+ *          timers list, main and idle threads. Threads are bound to
+ *          a core and the kernel lock is shared among cores through a
+ *          spinlock.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port with @p PORT_SUPPORTS_SMP.
+ */
+#if !defined(CH_CFG_SMP_MODE) || defined(__DOXIGEN__)
+#define CH_CFG_SMP_MODE                     FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -165,6 +288,18 @@
 #define CH_CFG_USE_REGISTRY                 TRUE
 #endif
 
+/**
+ * @brief   Periodic threads APIs.
+ * @details If enabled then the periodic thread objects APIs are included
+ *          in the kernel.
+ * @note    Execution time statistics also require @p CH_CFG_USE_TM.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_PERIODIC) || defined(__DOXIGEN__)
+#define CH_CFG_USE_PERIODIC                 FALSE
+#endif
+
 /**
  * @brief   Threads synchronization APIs.
  * @details If enabled then the @p chThdWait() function is included in
@@ -291,6 +426,19 @@
 #define CH_CFG_USE_MESSAGES_PRIORITY        FALSE
 #endif
 
+/**
+ * @brief   Asynchronous Messages APIs.
+ * @details If enabled then a client can send messages without waiting for
+ *          the answer, the answer is collected later through a message
+ *          handle.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MESSAGES.
+ */
+#if !defined(CH_CFG_USE_MESSAGES_ASYNC) || defined(__DOXIGEN__)
+#define CH_CFG_USE_MESSAGES_ASYNC           FALSE
+#endif
+
 /**
  * @brief   Mailboxes APIs.
  * @details If enabled then the asynchronous messages (mailboxes) APIs are
@@ -303,6 +451,30 @@
 #define CH_CFG_USE_MAILBOXES                TRUE
 #endif
 
+/**
+ * @brief   Rings APIs.
+ * @details If enabled then the single producer single consumer rings APIs
+ *          are included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_RINGS) || defined(__DOXIGEN__)
+#define CH_CFG_USE_RINGS                    FALSE
+#endif
+
+/**
+ * @brief   Objects FIFOs APIs.
+ * @details If enabled then the objects FIFOs APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MAILBOXES.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ */
+#if !defined(CH_CFG_USE_OBJ_FIFOS) || defined(__DOXIGEN__)
+#define CH_CFG_USE_OBJ_FIFOS                FALSE
+#endif
+
 /**
  * @brief   I/O Queues APIs.
  * @details If enabled then the I/O queues APIs are included in the kernel.
@@ -313,6 +485,19 @@
 #define CH_CFG_USE_QUEUES                   TRUE
 #endif
 
+/**
+ * @brief   Wait-sets APIs.
+ * @details If enabled then the wait-sets APIs are included in the kernel,
+ *          a thread can wait for any of several semaphores, mailboxes,
+ *          input queues or events.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_SEMAPHORES.
+ */
+#if !defined(CH_CFG_USE_WAITSETS) || defined(__DOXIGEN__)
+#define CH_CFG_USE_WAITSETS                 FALSE
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -338,6 +523,49 @@
 #define CH_CFG_USE_HEAP                     TRUE
 #endif
 
+/**
+ * @brief   TLSF heap allocator.
+ * @details If enabled then the heap allocator uses a Two-Level Segregated
+ *          Fit strategy, allocations and releases are performed in
+ *          constant time regardless of the heap fragmentation.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ * @note    Each heap descriptor contains the free lists table, about
+ *          200 pointers, and each block header contains an extra pointer.
+ */
+#if !defined(CH_CFG_HEAP_TLSF) || defined(__DOXIGEN__)
+#define CH_CFG_HEAP_TLSF                    FALSE
+#endif
+
+/**
+ * @brief   Per-thread heap caches.
+ * @details If enabled then the heap caches APIs are included in the
+ *          kernel, small objects are allocated from and released to
+ *          size-classed free lists owned by the calling thread.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP and @p CH_CFG_USE_MEMPOOLS.
+ */
+#if !defined(CH_CFG_USE_HEAP_CACHE) || defined(__DOXIGEN__)
+#define CH_CFG_USE_HEAP_CACHE               FALSE
+#endif
+
+/**
+ * @brief   Heap profiling.
+ * @details If enabled then the heap keeps usage statistics, a histogram
+ *          of the live allocations by size and the allocations owned by
+ *          each call site, the allocation and free operations are also
+ *          recorded in a trace buffer.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ * @note    Each block header contains an extra field.
+ */
+#if !defined(CH_CFG_HEAP_PROFILE) || defined(__DOXIGEN__)
+#define CH_CFG_HEAP_PROFILE                 FALSE
+#endif
+
 /**
  * @brief   Memory Pools Allocator APIs.
  * @details If enabled then the memory pools allocator APIs are included
@@ -349,6 +577,17 @@
 #define CH_CFG_USE_MEMPOOLS                 TRUE
 #endif
 
+/**
+ * @brief   Memory Arenas APIs.
+ * @details If enabled then the memory arenas APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_MEMARENAS) || defined(__DOXIGEN__)
+#define CH_CFG_USE_MEMARENAS                FALSE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -362,6 +601,19 @@
 #define CH_CFG_USE_DYNAMIC                  TRUE
 #endif
 
+/**
+ * @brief   Thread pools APIs.
+ * @details If enabled then the thread pools APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_SEMAPHORES.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ */
+#if !defined(CH_CFG_USE_THREADPOOLS) || defined(__DOXIGEN__)
+#define CH_CFG_USE_THREADPOOLS              FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -40,6 +40,96 @@ XDEFS=-DCH_CFG_OPTIMIZE_SPEED=FALSE
 compile
 execute_test
 
+echo "CH_CFG_RLIST_BITMAP=TRUE"
+XDEFS=-DCH_CFG_RLIST_BITMAP=TRUE
+compile
+execute_test
+
+echo "CH_CFG_SCHED_EDF=TRUE"
+XDEFS=-DCH_CFG_SCHED_EDF=TRUE
+compile
+execute_test
+
+echo "CH_CFG_SCHED_EDF=TRUE CH_CFG_RLIST_BITMAP=TRUE"
+XDEFS="-DCH_CFG_SCHED_EDF=TRUE -DCH_CFG_RLIST_BITMAP=TRUE"
+compile
+execute_test
+
+echo "CH_CFG_SCHED_THRESHOLD=TRUE"
+XDEFS=-DCH_CFG_SCHED_THRESHOLD=TRUE
+compile
+execute_test
+
+echo "CH_CFG_SCHED_BUDGET=TRUE"
+XDEFS=-DCH_CFG_SCHED_BUDGET=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_PERIODIC=TRUE"
+XDEFS=-DCH_CFG_USE_PERIODIC=TRUE
+compile
+execute_test
+
+echo "CH_CFG_HEAP_TLSF=TRUE"
+XDEFS=-DCH_CFG_HEAP_TLSF=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_HEAP_CACHE=TRUE"
+XDEFS=-DCH_CFG_USE_HEAP_CACHE=TRUE
+compile
+execute_test
+
+echo "CH_CFG_HEAP_PROFILE=TRUE"
+XDEFS=-DCH_CFG_HEAP_PROFILE=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_MEMARENAS=TRUE"
+XDEFS=-DCH_CFG_USE_MEMARENAS=TRUE
+compile
+execute_test
+
+echo "CH_CFG_MEMCORE_REGIONS=3"
+XDEFS=-DCH_CFG_MEMCORE_REGIONS=3
+compile
+execute_test
+
+echo "CH_CFG_USE_THREADPOOLS=TRUE"
+XDEFS=-DCH_CFG_USE_THREADPOOLS=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_RINGS=TRUE"
+XDEFS=-DCH_CFG_USE_RINGS=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_OBJ_FIFOS=TRUE"
+XDEFS=-DCH_CFG_USE_OBJ_FIFOS=TRUE
+compile
+execute_test
+
+echo "CH_CFG_USE_WAITSETS=TRUE"
+XDEFS=-DCH_CFG_USE_WAITSETS=TRUE
+compile
+execute_test
+
+echo "CH_CFG_VT_TIMING_WHEEL=TRUE"
+XDEFS=-DCH_CFG_VT_TIMING_WHEEL=TRUE
+compile
+execute_test
+
+echo "CH_CFG_VT_TIMING_WHEEL=TRUE CH_CFG_VT_WHEEL_BITS=2"
+XDEFS="-DCH_CFG_VT_TIMING_WHEEL=TRUE -DCH_CFG_VT_WHEEL_BITS=2"
+compile
+execute_test
+
+echo "CH_CFG_VT_DEFERRED=TRUE"
+XDEFS=-DCH_CFG_VT_DEFERRED=TRUE
+compile
+execute_test
+
 echo "CH_CFG_TIME_QUANTUM=0"
 XDEFS=-DCH_CFG_TIME_QUANTUM=0
 compile
@@ -100,6 +190,11 @@ XDEFS=-DCH_CFG_USE_MESSAGES_PRIORITY=TRUE
 compile
 execute_test
 
+echo "CH_CFG_USE_MESSAGES_ASYNC=TRUE"
+XDEFS=-DCH_CFG_USE_MESSAGES_ASYNC=TRUE
+compile
+execute_test
+
 echo "CH_CFG_USE_MAILBOXES=FALSE"
 XDEFS=-DCH_CFG_USE_MAILBOXES=FALSE
 compile
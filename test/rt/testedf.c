@@ -0,0 +1,257 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_edf EDF scheduling test
+ *
+ * File: @ref testedf.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the earliest deadline first
+ * scheduling class of the @ref scheduler subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the EDF related code
+ * and to verify that a feasible periodic task set meets its deadlines.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_SCHED_EDF
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_edf_001
+ * - @subpage test_edf_002
+ * - @subpage test_edf_003
+ * .
+ * @file testedf.c
+ * @brief EDF scheduling test source file
+ * @file testedf.h
+ * @brief EDF scheduling test header file
+ */
+
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+
+/*
+ * Common release time of the threads created by a test case.
+ */
+static systime_t edf_release;
+
+/*
+ * Consumes the specified number of ticks of CPU time, the ticks elapsed
+ * while the thread was preempted are not counted.
+ */
+static void edf_consume(systime_t ticks) {
+  systime_t last = chVTGetSystemTime();
+
+  while (ticks > 0) {
+    systime_t now = chVTGetSystemTime();
+
+    if (now != last) {
+      if ((systime_t)(now - last) == 1)
+        ticks--;
+      last = now;
+    }
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+}
+
+/**
+ * @page test_edf_001 Deadline ordering
+ *
+ * <h2>Description</h2>
+ * Five threads are created at the EDF priority level in pseudo-random
+ * order, each thread sleeps until a common release time after setting a
+ * different deadline.<br>
+ * The test expects the threads to perform their operations in deadline
+ * order regardless of the creation order.
+ */
+
+static msg_t thread1(void *p) {
+  char c = *(char *)p;
+
+  chThdSleepUntilWithDeadline(edf_release,
+                              edf_release + (systime_t)(c - 'A' + 1) *
+                                            MS2ST(10));
+  test_emit_token(c);
+  return 0;
+}
+
+static void edf1_execute(void) {
+  tprio_t prio = chThdSetPriority(CH_CFG_EDF_PRIO + 1);
+
+  edf_release = test_wait_tick() + MS2ST(10);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, CH_CFG_EDF_PRIO, thread1, "C");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, CH_CFG_EDF_PRIO, thread1, "E");
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, CH_CFG_EDF_PRIO, thread1, "A");
+  threads[3] = chThdCreateStatic(wa[3], WA_SIZE, CH_CFG_EDF_PRIO, thread1, "D");
+  threads[4] = chThdCreateStatic(wa[4], WA_SIZE, CH_CFG_EDF_PRIO, thread1, "B");
+  test_wait_threads();
+  chThdSetPriority(prio);
+  test_assert_sequence(1, "ABCDE");
+}
+
+ROMCONST struct testcase testedf1 = {
+  "EDF, deadline ordering",
+  NULL,
+  NULL,
+  edf1_execute
+};
+
+/**
+ * @page test_edf_002 Deadline preemption
+ *
+ * <h2>Description</h2>
+ * A thread with a far deadline runs a long job, a thread released during
+ * the job with an earlier deadline preempts it while a thread released
+ * with a later deadline has to wait for the job completion.<br>
+ * The test expects the threads to complete their jobs in deadline order.
+ */
+
+static msg_t thread2(void *p) {
+  char c = *(char *)p;
+
+  switch (c) {
+  case 'A':
+    chThdSleepUntilWithDeadline(edf_release, edf_release + MS2ST(500));
+    if (chThdGetDeadlineX() != edf_release + MS2ST(500))
+      test_emit_token('X');
+    edf_consume(MS2ST(40));
+    break;
+  case 'B':
+    chThdSleepUntilWithDeadline(edf_release + MS2ST(10),
+                                edf_release + MS2ST(20));
+    break;
+  default:
+    chThdSleepUntilWithDeadline(edf_release + MS2ST(15),
+                                edf_release + MS2ST(1000));
+    break;
+  }
+  test_emit_token(c);
+  return 0;
+}
+
+static void edf2_execute(void) {
+  tprio_t prio = chThdSetPriority(CH_CFG_EDF_PRIO + 1);
+
+  edf_release = test_wait_tick() + MS2ST(10);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, CH_CFG_EDF_PRIO, thread2, "C");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, CH_CFG_EDF_PRIO, thread2, "B");
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, CH_CFG_EDF_PRIO, thread2, "A");
+  test_wait_threads();
+  chThdSetPriority(prio);
+  test_assert_sequence(2, "BAC");
+}
+
+ROMCONST struct testcase testedf2 = {
+  "EDF, deadline preemption",
+  NULL,
+  NULL,
+  edf2_execute
+};
+
+/**
+ * @page test_edf_003 Periodic task set schedulability
+ *
+ * <h2>Description</h2>
+ * Three periodic threads with deadlines shorter than their periods are
+ * released together and run for a fixed time, the task set is feasible
+ * under EDF but not in release order.<br>
+ * The test expects all the jobs to be executed and no deadline to be
+ * missed.
+ */
+
+/*
+ * Periodic task parameters, in milliseconds.
+ */
+typedef struct {
+  unsigned cost;
+  unsigned period;
+  unsigned deadline;
+} edf_task_t;
+
+static const edf_task_t edf_tasks[3] = {
+  {2, 20, 8},
+  {3, 30, 15},
+  {5, 40, 25}
+};
+
+#define EDF_RUN_TIME    MS2ST(200)
+
+static unsigned edf_jobs;
+static unsigned edf_misses;
+
+static msg_t thread3(void *p) {
+  const edf_task_t *etp = (const edf_task_t *)p;
+  systime_t release = edf_release;
+
+  while (chVTIsTimeWithinX(release, edf_release,
+                           edf_release + EDF_RUN_TIME)) {
+    chThdSleepUntilWithDeadline(release, release + MS2ST(etp->deadline));
+    edf_consume(MS2ST(etp->cost));
+    chSysLock();
+    if (!chVTIsSystemTimeWithinX(release, release + MS2ST(etp->deadline)))
+      edf_misses++;
+    edf_jobs++;
+    chSysUnlock();
+    release += MS2ST(etp->period);
+  }
+  return 0;
+}
+
+static void edf3_execute(void) {
+  tprio_t prio = chThdSetPriority(CH_CFG_EDF_PRIO + 1);
+  unsigned i;
+
+  edf_jobs = 0;
+  edf_misses = 0;
+  edf_release = test_wait_tick() + MS2ST(10);
+  for (i = 0; i < 3; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, CH_CFG_EDF_PRIO, thread3,
+                                   (void *)&edf_tasks[i]);
+  test_wait_threads();
+  chThdSetPriority(prio);
+  test_assert(1, edf_jobs == 10 + 7 + 5, "missing jobs");
+  test_assert(2, edf_misses == 0, "deadline missed");
+}
+
+ROMCONST struct testcase testedf3 = {
+  "EDF, periodic task set",
+  NULL,
+  NULL,
+  edf3_execute
+};
+
+#endif /* CH_CFG_SCHED_EDF */
+
+/**
+ * @brief   Test sequence for EDF scheduling.
+ */
+ROMCONST struct testcase * ROMCONST patternedf[] = {
+#if CH_CFG_SCHED_EDF || defined(__DOXYGEN__)
+  &testedf1,
+  &testedf2,
+  &testedf3,
+#endif
+  NULL
+};
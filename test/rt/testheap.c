@@ -37,6 +37,11 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_heap_001
+ * - @subpage test_heap_002
+ * - @subpage test_heap_003
+ * - @subpage test_heap_004
+ * - @subpage test_heap_005
+ * - @subpage test_heap_006
  * .
  * @file testheap.c
  * @brief Heap test source file
@@ -137,6 +142,8 @@ static void heap1_execute(void) {
 
   test_assert(11, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
   test_assert(12, n == sz, "size changed");
+  test_assert(13, chHeapGetLargestFree(&test_heap) == n,
+              "wrong largest free block");
 }
 
 ROMCONST struct testcase testheap1 = {
@@ -146,6 +153,433 @@ ROMCONST struct testcase testheap1 = {
   heap1_execute
 };
 
+/**
+ * @page test_heap_002 Random allocation test
+ *
+ * <h2>Description</h2>
+ * Blocks of pseudo-random sizes are allocated and released in
+ * pseudo-random order, each block is filled with a pattern that is
+ * verified before releasing it.<br>
+ * The test expects the blocks to never overlap and to find the heap back
+ * to the initial status after releasing all the blocks.
+ */
+
+#define HEAP2_SLOTS     16
+#define HEAP2_LOOPS     1000
+
+static void heap2_execute(void) {
+  static uint8_t *slots[HEAP2_SLOTS];
+  static size_t sizes[HEAP2_SLOTS];
+  uint32_t seed = 0x12345678U;
+  size_t n, sz, i;
+  unsigned loop, slot;
+
+  (void)chHeapStatus(&test_heap, &sz);
+  for (slot = 0; slot < HEAP2_SLOTS; slot++)
+    slots[slot] = NULL;
+
+  for (loop = 0; loop < HEAP2_LOOPS; loop++) {
+    seed = seed * 1103515245U + 12345U;
+    slot = (unsigned)(seed >> 16) % HEAP2_SLOTS;
+    if (slots[slot] != NULL) {
+      for (i = 0; i < sizes[slot]; i++) {
+        if (slots[slot][i] != (uint8_t)slot)
+          test_fail(1);
+      }
+      chHeapFree(slots[slot]);
+      slots[slot] = NULL;
+    }
+    else {
+      sizes[slot] = 1 + ((seed >> 8) % 96);
+      slots[slot] = chHeapAlloc(&test_heap, sizes[slot]);
+      if (slots[slot] != NULL) {
+        for (i = 0; i < sizes[slot]; i++)
+          slots[slot][i] = (uint8_t)slot;
+      }
+    }
+  }
+
+  for (slot = 0; slot < HEAP2_SLOTS; slot++) {
+    if (slots[slot] != NULL)
+      chHeapFree(slots[slot]);
+  }
+  test_assert(2, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(3, n == sz, "size changed");
+}
+
+ROMCONST struct testcase testheap2 = {
+  "Heap, random allocation test",
+  heap1_setup,
+  NULL,
+  heap2_execute
+};
+
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+/**
+ * @page test_heap_003 Heap caches test
+ *
+ * <h2>Description</h2>
+ * A heap cache is bound to the test thread, objects are allocated and
+ * released through the cache.<br>
+ * The test expects the first allocation to refill the cache with a batch
+ * of objects, the following allocations to be served by the cache, objects
+ * of other heaps not to be cached and the heap to be back to the initial
+ * status after flushing the cache.
+ */
+
+static heap_cache_t test_hcache;
+
+static void heap3_setup(void) {
+
+  heap1_setup();
+  chHeapCacheObjectInit(&test_hcache, &test_heap);
+}
+
+static void heap3_teardown(void) {
+
+  chHeapCacheBind(NULL);
+}
+
+static void heap3_execute(void) {
+  void *p1, *p2, *p3, *p4;
+  size_t n, sz;
+
+  (void)chHeapStatus(&test_heap, &sz);
+  chHeapCacheBind(&test_hcache);
+
+  /* Refill on the first allocation then hits.*/
+  p1 = chHeapCacheAlloc(SIZE);
+  test_assert(1, p1 != NULL, "allocation failed");
+  test_assert(2, chHeapCacheStatus(&test_hcache, &n) ==
+                 CH_CFG_HEAP_CACHE_BATCH - 1, "not refilled");
+  p2 = chHeapCacheAlloc(SIZE);
+  p3 = chHeapCacheAlloc(SIZE);
+  test_assert(3, (p2 != NULL) && (p3 != NULL), "allocation failed");
+  test_assert(4, (test_hcache.hc_hits == 2) && (test_hcache.hc_misses == 1),
+              "wrong counters");
+
+  /* Objects not fitting any class are served by the heap.*/
+  p4 = chHeapCacheAlloc(CH_HEAP_CACHE_MIN_SIZE << CH_HEAP_CACHE_CLASSES);
+  test_assert(5, p4 != NULL, "allocation failed");
+  chHeapCacheFree(p4);
+
+  /* Objects of other heaps are returned to their heap.*/
+  p4 = chHeapAlloc(NULL, SIZE);
+  test_assert(6, p4 != NULL, "allocation failed");
+  chHeapCacheFree(p4);
+  test_assert(7, chHeapCacheStatus(&test_hcache, &n) ==
+                 CH_CFG_HEAP_CACHE_BATCH - 3, "foreign object cached");
+
+  /* Released objects go back to the cache.*/
+  chHeapCacheFree(p3);
+  chHeapCacheFree(p2);
+  chHeapCacheFree(p1);
+  test_assert(8, chHeapCacheStatus(&test_hcache, &n) ==
+                 CH_CFG_HEAP_CACHE_BATCH, "not cached");
+  test_assert(9, n == CH_CFG_HEAP_CACHE_BATCH * CH_HEAP_CACHE_MIN_SIZE,
+              "wrong size");
+
+  /* Flushing, the heap is expected to be back to the initial status.*/
+  chHeapCacheFlush(&test_hcache);
+  test_assert(10, chHeapCacheStatus(&test_hcache, &n) == 0, "not empty");
+  test_assert(11, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(12, n == sz, "size changed");
+}
+
+ROMCONST struct testcase testheap3 = {
+  "Heap, heap caches test",
+  heap3_setup,
+  heap3_teardown,
+  heap3_execute
+};
+#endif /* CH_CFG_USE_HEAP_CACHE */
+
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+/**
+ * @page test_heap_004 Heap profiling test
+ *
+ * <h2>Description</h2>
+ * Tagged and untagged blocks are allocated and released, an allocation
+ * is made to fail.<br>
+ * The test expects the profiling data to account the live blocks by size
+ * and by call site, the high water mark to be retained and the last
+ * operations to be recorded in the trace buffer.
+ */
+
+static const char heap4_tag[] = "heap4";
+
+static heap_profile_t test_profile;
+
+static const heap_site_t *heap4_site(const void *tag) {
+  unsigned i;
+
+  for (i = 0; i < CH_CFG_HEAP_PROFILE_SITES; i++) {
+    if (test_profile.hp_sites[i].hs_tag == tag)
+      return &test_profile.hp_sites[i];
+  }
+  return NULL;
+}
+
+static void heap4_execute(void) {
+  void *p1, *p2, *p3, *p4;
+  const heap_site_t *hsp;
+  size_t n, sz;
+
+  (void)chHeapStatus(&test_heap, &sz);
+
+  p1 = chHeapAllocTagged(&test_heap, SIZE, heap4_tag);
+  p2 = chHeapAllocTagged(&test_heap, SIZE * 4, heap4_tag);
+  p3 = chHeapAlloc(&test_heap, SIZE);
+  test_assert(1, (p1 != NULL) && (p2 != NULL) && (p3 != NULL),
+              "allocation failed");
+  chHeapGetProfile(&test_heap, &test_profile);
+  test_assert(2, test_profile.hp_used == SIZE * 6, "wrong used size");
+  test_assert(3, test_profile.hp_allocs == 3, "wrong allocations counter");
+  test_assert(4, (test_profile.hp_hist[0] == 2) &&
+                 (test_profile.hp_hist[2] == 1), "wrong histogram");
+  hsp = heap4_site(heap4_tag);
+  test_assert(5, hsp != NULL, "site not found");
+  test_assert(6, (hsp->hs_blocks == 2) && (hsp->hs_bytes == SIZE * 5),
+              "wrong site data");
+
+  /* The high water mark is retained after release.*/
+  chHeapFree(p2);
+  p4 = chHeapAlloc(&test_heap, sz * 2);
+  test_assert(7, p4 == NULL, "allocation not failed");
+  chHeapGetProfile(&test_heap, &test_profile);
+  test_assert(8, (test_profile.hp_used == SIZE * 2) &&
+                 (test_profile.hp_max_used == SIZE * 6), "wrong used size");
+  test_assert(9, (test_profile.hp_frees == 1) &&
+                 (test_profile.hp_failures == 1), "wrong counters");
+
+#if CH_CFG_HEAP_TRACE_BUFFER_SIZE > 1
+  /* Last two events, the release and the failure.*/
+  {
+    uint32_t i = (ch_heap_trace.ht_next + ch_heap_trace.ht_size - 2U) %
+                 ch_heap_trace.ht_size;
+    heap_trace_event_t *hep = &ch_heap_trace.ht_buffer[i];
+
+    test_assert(10, (hep->he_type == CH_HEAP_TRACE_FREE) &&
+                    (hep->he_ptr == p2) &&
+                    (hep->he_size == SIZE * 4) &&
+                    (hep->he_tag == heap4_tag), "wrong free event");
+    hep = &ch_heap_trace.ht_buffer[(i + 1U) % ch_heap_trace.ht_size];
+    test_assert(11, (hep->he_type == CH_HEAP_TRACE_FAIL) &&
+                    (hep->he_heap == &test_heap) &&
+                    (hep->he_tp == chThdGetSelfX()), "wrong fail event");
+  }
+#endif
+
+  /* All released, the heap is expected to be back to the initial status.*/
+  chHeapFree(p1);
+  chHeapFree(p3);
+  chHeapGetProfile(&test_heap, &test_profile);
+  test_assert(12, test_profile.hp_used == 0, "wrong used size");
+  hsp = heap4_site(heap4_tag);
+  test_assert(13, (hsp == NULL) || (hsp->hs_blocks == 0), "blocks leaked");
+  test_assert(14, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(15, n == sz, "size changed");
+}
+
+ROMCONST struct testcase testheap4 = {
+  "Heap, profiling test",
+  heap1_setup,
+  NULL,
+  heap4_execute
+};
+#endif /* CH_CFG_HEAP_PROFILE */
+
+#if (CH_CFG_MEMCORE_REGIONS >= 3) || defined(__DOXYGEN__)
+/**
+ * @page test_heap_005 Core memory regions test
+ *
+ * <h2>Description</h2>
+ * Two core memory regions are registered, a fast region and a fast
+ * DMA-capable region with 32 bytes alignment, blocks are allocated by
+ * region and by attributes until the regions are exhausted, the core
+ * allocator is also used as provider for a memory pool and for a heap.<br>
+ * The test expects the blocks to be aligned as required by the region, the
+ * regions to be selected by attributes in registration order and the
+ * allocations to fall back to the other suitable regions.
+ */
+
+#define HEAP5_REGION_SIZE   256
+
+static stkalign_t heap5_fast[HEAP5_REGION_SIZE / sizeof (stkalign_t)];
+static stkalign_t heap5_dma[HEAP5_REGION_SIZE / sizeof (stkalign_t)];
+static memory_heap_t heap5_heap;
+static memory_region_t *heap5_fastp, *heap5_dmap;
+
+static bool heap5_within(void *p, stkalign_t *buf) {
+
+  return ((uint8_t *)p >= (uint8_t *)buf) &&
+         ((uint8_t *)p < (uint8_t *)buf + HEAP5_REGION_SIZE);
+}
+
+static memory_region_t *heap5_region(const char *name, stkalign_t *buf,
+                                     uint32_t attr, size_t align) {
+  memory_region_t *mrp;
+
+  /* The regions cannot be removed, on later executions the existing
+     regions are rewound.*/
+  mrp = chCoreFindRegion(name);
+  if (mrp == NULL) {
+    return chCoreAddRegion(name, buf, HEAP5_REGION_SIZE, attr, align);
+  }
+  mrp->mr_next = (uint8_t *)buf;
+  return mrp;
+}
+
+static void heap5_setup(void) {
+
+  heap5_fastp = heap5_region("fast", heap5_fast, CH_MEM_ATTR_FAST,
+                             MEM_ALIGN_SIZE);
+  heap5_dmap = heap5_region("dma", heap5_dma,
+                            CH_MEM_ATTR_DMA | CH_MEM_ATTR_FAST, 32);
+}
+
+static void heap5_execute(void) {
+  memory_region_t *mrp;
+  void *p1, *p2;
+
+  test_assert(1, (heap5_fastp != NULL) && (heap5_dmap != NULL),
+              "region not registered");
+  mrp = chCoreFindRegion("core");
+  test_assert(2, (mrp != NULL) &&
+                 (mrp->mr_attr == (uint32_t)CH_CFG_MEMCORE_DEFAULT_ATTR),
+                 "default region not found");
+  test_assert(3, chCoreFindRegion("none") == NULL, "unknown region found");
+
+  /* Address and size aligned to the region alignment.*/
+  p1 = chCoreAllocFrom(heap5_dmap, 10);
+  p2 = chCoreAllocFrom(heap5_dmap, 1);
+  test_assert(4, (p1 != NULL) && (((size_t)p1 & 31U) == 0U),
+              "wrong alignment");
+  test_assert(5, (uint8_t *)p2 == (uint8_t *)p1 + 32, "wrong size");
+
+  /* Selection by attributes.*/
+  p1 = chCoreAllocPolicy(CH_MEM_ATTR_DMA, CH_MEM_ATTR_FAST, 16);
+  test_assert(6, heap5_within(p1, heap5_dma), "preferred region not used");
+  p1 = chCoreAllocFast(16);
+  test_assert(7, heap5_within(p1, heap5_fast), "wrong region order");
+
+  /* Region exhaustion and fall back.*/
+  p1 = chCoreAllocFrom(heap5_fastp, chCoreGetRegionStatusX(heap5_fastp));
+  test_assert(8, p1 != NULL, "allocation failed");
+  test_assert(9, chCoreGetRegionStatusX(heap5_fastp) == 0, "not exhausted");
+  test_assert(10, chCoreAllocFrom(heap5_fastp, 1) == NULL,
+              "allocation not failed");
+  p1 = chCoreAllocFast(16);
+  test_assert(11, heap5_within(p1, heap5_dma), "no fall back");
+
+#if CH_CFG_USE_MEMPOOLS
+  /* Core allocator used as provider.*/
+  {
+    memory_pool_t mp;
+
+    chPoolObjectInit(&mp, 16, chCoreAllocFastI);
+    p1 = chPoolAlloc(&mp);
+    test_assert(12, heap5_within(p1, heap5_dma), "wrong provider region");
+  }
+#endif
+
+  /* Core allocator used as heap provider.*/
+  chHeapObjectInitProvider(&heap5_heap, chCoreAllocFast);
+  p1 = chHeapAlloc(&heap5_heap, 16);
+  test_assert(13, heap5_within(p1, heap5_dma), "wrong provider region");
+  chHeapFree(p1);
+  p2 = chHeapAlloc(&heap5_heap, 16);
+  test_assert(14, p2 == p1, "block not reused");
+
+  /* No other region is both fast and DMA-capable.*/
+  p1 = chCoreAllocFrom(heap5_dmap, chCoreGetRegionStatusX(heap5_dmap));
+  test_assert(15, p1 != NULL, "allocation failed");
+  test_assert(16, chCoreAllocPolicy(CH_MEM_ATTR_DMA | CH_MEM_ATTR_FAST,
+                                    0U, 1) == NULL,
+              "allocation not failed");
+}
+
+ROMCONST struct testcase testheap5 = {
+  "Heap, core memory regions",
+  heap5_setup,
+  NULL,
+  heap5_execute
+};
+#endif /* CH_CFG_MEMCORE_REGIONS >= 3 */
+
+/**
+ * @page test_heap_006 Aligned allocation test
+ *
+ * <h2>Description</h2>
+ * For each alignment from 4 to 64 bytes an aligned block is allocated after
+ * an unaligned block, both blocks are filled and then released. Aligned
+ * blocks are also allocated from the default heap and from the core
+ * allocator.<br>
+ * The test expects the blocks to be aligned, their contents not to be
+ * overwritten and the heap to be back to the initial status after each
+ * sequence.
+ */
+
+static const size_t heap6_aligns[] = {4, 8, 16, 32, 64};
+
+static void heap6_fill(void *p, size_t size, uint8_t v) {
+
+  while (size-- > 0) {
+    *(uint8_t *)p = v;
+    p = (uint8_t *)p + 1;
+  }
+}
+
+static bool heap6_check(void *p, size_t size, uint8_t v) {
+
+  while (size-- > 0) {
+    if (*(uint8_t *)p != v) {
+      return false;
+    }
+    p = (uint8_t *)p + 1;
+  }
+  return true;
+}
+
+static void heap6_execute(void) {
+  void *p1, *p2;
+  size_t n, sz, align;
+  unsigned i;
+
+  (void)chHeapStatus(&test_heap, &sz);
+  for (i = 0; i < sizeof heap6_aligns / sizeof heap6_aligns[0]; i++) {
+    align = heap6_aligns[i];
+    p1 = chHeapAlloc(&test_heap, SIZE);
+    p2 = chHeapAllocAligned(&test_heap, SIZE + 1, align);
+    test_assert(1, (p1 != NULL) && (p2 != NULL), "allocation failed");
+    test_assert(2, ((size_t)p2 & (align - 1U)) == 0U, "wrong alignment");
+    heap6_fill(p1, SIZE, 0xA5);
+    heap6_fill(p2, SIZE + 1, 0x5A);
+    test_assert(3, heap6_check(p1, SIZE, 0xA5) &&
+                   heap6_check(p2, SIZE + 1, 0x5A), "overlapping blocks");
+    chHeapFree(p1);
+    chHeapFree(p2);
+    test_assert(4, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+    test_assert(5, n == sz, "size changed");
+  }
+
+  /* Default heap and core allocator.*/
+  p1 = chHeapAllocAligned(NULL, SIZE, 64);
+  test_assert(6, (p1 != NULL) && (((size_t)p1 & 63U) == 0U),
+              "wrong alignment");
+  chHeapFree(p1);
+  p1 = chCoreAllocAligned(SIZE, 64);
+  test_assert(7, (p1 != NULL) && (((size_t)p1 & 63U) == 0U),
+              "wrong alignment");
+}
+
+ROMCONST struct testcase testheap6 = {
+  "Heap, aligned allocation",
+  heap1_setup,
+  NULL,
+  heap6_execute
+};
+
 #endif /* CH_CFG_USE_HEAP.*/
 
 /**
@@ -154,6 +588,17 @@ ROMCONST struct testcase testheap1 = {
 ROMCONST struct testcase * ROMCONST patternheap[] = {
 #if (CH_CFG_USE_HEAP && !CH_CFG_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
   &testheap1,
+  &testheap2,
+#if CH_CFG_USE_HEAP_CACHE || defined(__DOXYGEN__)
+  &testheap3,
+#endif
+#if CH_CFG_HEAP_PROFILE || defined(__DOXYGEN__)
+  &testheap4,
+#endif
+#if (CH_CFG_MEMCORE_REGIONS >= 3) || defined(__DOXYGEN__)
+  &testheap5,
+#endif
+  &testheap6,
 #endif
   NULL
 };
@@ -40,6 +40,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_mbox_001
+ * - @subpage test_mbox_002
  * .
  * @file testmbox.c
  * @brief Mailboxes test source file
@@ -226,6 +227,119 @@ ROMCONST struct testcase testmbox1 = {
   mbox1_execute
 };
 
+/**
+ * @page test_mbox_002 Bulk operations
+ *
+ * <h2>Description</h2>
+ * Blocks of messages are posted/fetched from a mailbox crossing the buffer
+ * end, then a consumer thread waiting on an empty mailbox and a producer
+ * thread waiting on a full mailbox are released by bulk operations.<br>
+ * The test expects the messages in order, the partial transfers to be
+ * limited by the free slots or queued messages and the waiting threads to
+ * transfer a whole block when released.
+ */
+
+static msg_t thread2a(void *p) {
+  msg_t msgs[MB_SIZE];
+  cnt_t i, n;
+
+  (void)p;
+  n = chMBFetchMany(&mb1, msgs, MB_SIZE, TIME_INFINITE);
+  for (i = 0; i < n; i++)
+    test_emit_token(msgs[i]);
+  test_emit_token('0' + n);
+  return 0;
+}
+
+static msg_t thread2b(void *p) {
+  static const msg_t msgs[] = {'X', 'Y', 'Z'};
+
+  (void)p;
+  test_emit_token('0' + chMBPostMany(&mb1, msgs, 3, TIME_INFINITE));
+  return 0;
+}
+
+static void mbox2_execute(void) {
+  static const msg_t msgs1[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G'};
+  static const msg_t msgs2[] = {'H', 'I', 'J'};
+  msg_t msgs[MB_SIZE * 2];
+  cnt_t i, n;
+
+  /*
+   * Testing partial transfers and buffer circularity.
+   */
+  n = chMBPostMany(&mb1, msgs1, 3, TIME_INFINITE);
+  test_assert(1, n == 3, "wrong count");
+  n = chMBFetchMany(&mb1, msgs, 2, TIME_INFINITE);
+  test_assert(2, n == 2, "wrong count");
+  n = chMBPostMany(&mb1, &msgs1[3], 4, TIME_INFINITE);
+  test_assert(3, n == 4, "wrong count");
+  n = chMBPostMany(&mb1, msgs1, 1, TIME_IMMEDIATE);
+  test_assert(4, n == 0, "not full");
+  chSysLock();
+  n = chMBPostManyI(&mb1, msgs1, 1);
+  chSysUnlock();
+  test_assert(5, n == 0, "not full");
+  test_assert_lock(6, chMBGetUsedCountI(&mb1) == MB_SIZE, "not full");
+  chSysLock();
+  n = chMBFetchManyI(&mb1, &msgs[2], MB_SIZE * 2 - 2);
+  chSysUnlock();
+  test_assert(7, n == MB_SIZE, "wrong count");
+  for (i = 0; i < MB_SIZE + 2; i++)
+    test_emit_token(msgs[i]);
+  test_assert_sequence(8, "ABCDEFG");
+
+  /*
+   * Testing fetch timeout.
+   */
+  n = chMBFetchMany(&mb1, msgs, MB_SIZE, 1);
+  test_assert(9, n == 0, "not empty");
+  chSysLock();
+  n = chMBFetchManyI(&mb1, msgs, MB_SIZE);
+  chSysUnlock();
+  test_assert(10, n == 0, "not empty");
+  test_assert_lock(11, chMBGetFreeCountI(&mb1) == MB_SIZE, "not empty");
+  test_assert(12, mb1.mb_rdptr == mb1.mb_wrptr, "pointers not aligned");
+
+  /*
+   * Testing a consumer waiting on an empty mailbox, the whole block is
+   * fetched at once.
+   */
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread2a, NULL);
+  chSysLock();
+  n = chMBPostManyI(&mb1, msgs2, 3);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_assert(13, n == 3, "wrong count");
+  test_wait_threads();
+  test_assert_sequence(14, "HIJ3");
+
+  /*
+   * Testing a producer waiting on a full mailbox, the freed slots are
+   * filled at once.
+   */
+  n = chMBPostMany(&mb1, msgs1, MB_SIZE, TIME_INFINITE);
+  test_assert(15, n == MB_SIZE, "wrong count");
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread2b, NULL);
+  n = chMBFetchMany(&mb1, msgs, 2, TIME_INFINITE);
+  test_assert(16, n == 2, "wrong count");
+  test_wait_threads();
+  n = chMBFetchMany(&mb1, &msgs[2], MB_SIZE, TIME_IMMEDIATE);
+  test_assert(17, n == MB_SIZE, "wrong count");
+  for (i = 0; i < MB_SIZE + 2; i++)
+    test_emit_token(msgs[i]);
+  test_assert_sequence(18, "2ABCDEXY");
+}
+
+ROMCONST struct testcase testmbox2 = {
+  "Mailboxes, bulk operations",
+  mbox1_setup,
+  NULL,
+  mbox2_execute
+};
+
 #endif /* CH_CFG_USE_MAILBOXES */
 
 /**
@@ -234,6 +348,7 @@ ROMCONST struct testcase testmbox1 = {
 ROMCONST struct testcase * ROMCONST patternmbox[] = {
 #if CH_CFG_USE_MAILBOXES || defined(__DOXYGEN__)
   &testmbox1,
+  &testmbox2,
 #endif
   NULL
 };
@@ -38,6 +38,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_msg_001
+ * - @subpage test_msg_002
  * .
  * @file testmsg.c
  * @brief Messages test source file
@@ -95,6 +96,68 @@ ROMCONST struct testcase testmsg1 = {
   msg1_execute
 };
 
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @page test_msg_002 Asynchronous messages
+ *
+ * <h2>Description</h2>
+ * Three asynchronous messages are sent to a server thread with lower
+ * priority then the answers are collected.<br>
+ * The test expects the sender to not be blocked by the sending, the
+ * collection to time out while the server has not run and the answers to
+ * be collected in order.
+ */
+
+static msg_t thread2(void *p) {
+  msg_handle_t *mhp;
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < 3; i++) {
+    mhp = chMsgWaitAsync();
+    test_emit_token(chMsgGetAsync(mhp));
+    chMsgReleaseAsync(mhp, chMsgGetAsync(mhp) + 1);
+  }
+  return 0;
+}
+
+static void msg2_execute(void) {
+  msg_handle_t mh[3];
+  msg_t msg;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                 thread2, NULL);
+
+  /*
+   * Testing the pipelined sending, the server is not executed.
+   */
+  chMsgSendAsync(threads[0], &mh[0], 'A');
+  chMsgSendAsync(threads[0], &mh[1], 'B');
+  chMsgSendAsync(threads[0], &mh[2], 'C');
+  test_assert_lock(1, chMsgIsPendingAsyncI(threads[0]), "not pending");
+  test_assert_lock(2, !chMsgIsCompletedI(&mh[0]), "completed");
+  msg = chMsgCollectTimeout(&mh[0], &msg, TIME_IMMEDIATE);
+  test_assert(3, msg == MSG_TIMEOUT, "wrong wake-up message");
+  test_assert_sequence(4, "");
+
+  /*
+   * Testing the answers collection.
+   */
+  test_assert(5, chMsgCollect(&mh[0]) == 'B', "wrong answer");
+  test_assert(6, chMsgCollect(&mh[1]) == 'C', "wrong answer");
+  test_assert(7, chMsgCollect(&mh[2]) == 'D', "wrong answer");
+  test_wait_threads();
+  test_assert_sequence(8, "ABC");
+}
+
+ROMCONST struct testcase testmsg2 = {
+  "Messages, asynchronous send",
+  NULL,
+  NULL,
+  msg2_execute
+};
+#endif /* CH_CFG_USE_MESSAGES_ASYNC */
+
 #endif /* CH_CFG_USE_MESSAGES */
 
 /**
@@ -103,6 +166,9 @@ ROMCONST struct testcase testmsg1 = {
 ROMCONST struct testcase * ROMCONST patternmsg[] = {
 #if CH_CFG_USE_MESSAGES || defined(__DOXYGEN__)
   &testmsg1,
+#if CH_CFG_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  &testmsg2,
+#endif
 #endif
   NULL
 };
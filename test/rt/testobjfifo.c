@@ -0,0 +1,227 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_objfifo Objects FIFOs test
+ *
+ * File: @ref testobjfifo.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref objects_fifos
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref objects_fifos
+ * code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_USE_OBJ_FIFOS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_objfifo_001
+ * - @subpage test_objfifo_002
+ * .
+ * @file testobjfifo.c
+ * @brief Objects FIFOs test source file
+ * @file testobjfifo.h
+ * @brief Objects FIFOs test header file
+ */
+
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+
+#define OBJFIFO_OBJECTS     4
+
+/*
+ * Object type, the size is a multiple of the pointer size but not a power
+ * of two on 32 bits architectures.
+ */
+typedef struct {
+  size_t    seq;
+  char      token;
+  uint8_t   data[7];
+} fifo_object_t;
+
+static objects_fifo_t fifo1;
+
+static fifo_object_t fifo_objects[OBJFIFO_OBJECTS];
+
+static msg_t fifo_msgs[OBJFIFO_OBJECTS];
+
+static void objfifo_setup(void) {
+
+  chFifoObjectInit(&fifo1, sizeof (fifo_object_t), OBJFIFO_OBJECTS,
+                   sizeof (void *), fifo_objects, fifo_msgs);
+}
+
+/**
+ * @page test_objfifo_001 Objects loop
+ *
+ * <h2>Description</h2>
+ * All the objects are taken, filled and sent then received and returned,
+ * the operations on an exhausted pool or an empty FIFO are tested.<br>
+ * The test expects the objects to be received in order, unmodified, and
+ * the operations to fail when no objects are available.
+ */
+
+static void objfifo1_execute(void) {
+  fifo_object_t *objs[OBJFIFO_OBJECTS], *objp = NULL;
+  unsigned i;
+
+  /* Taking all the objects.*/
+  for (i = 0; i < OBJFIFO_OBJECTS; i++) {
+    if (i & 1) {
+      objs[i] = chFifoTakeObjectTimeout(&fifo1, TIME_IMMEDIATE);
+    }
+    else {
+      chSysLock();
+      objs[i] = chFifoTakeObjectI(&fifo1);
+      chSysUnlock();
+    }
+    test_assert(1, objs[i] != NULL, "object not available");
+    objs[i]->seq = i;
+  }
+  test_assert(2, chFifoTakeObjectTimeout(&fifo1, TIME_IMMEDIATE) == NULL,
+              "pool not exhausted");
+  test_assert_lock(3, chFifoTakeObjectI(&fifo1) == NULL,
+                   "pool not exhausted");
+
+  /* Sending in reverse order.*/
+  chFifoSendObject(&fifo1, objs[3]);
+  chSysLock();
+  chFifoSendObjectI(&fifo1, objs[2]);
+  chFifoSendObjectS(&fifo1, objs[1]);
+  chSysUnlock();
+  chFifoSendObject(&fifo1, objs[0]);
+
+  /* Receiving and returning.*/
+  for (i = 0; i < OBJFIFO_OBJECTS; i++) {
+    msg_t msg;
+
+    if (i & 1) {
+      msg = chFifoReceiveObjectTimeout(&fifo1, (void **)&objp,
+                                       TIME_IMMEDIATE);
+    }
+    else {
+      chSysLock();
+      msg = chFifoReceiveObjectI(&fifo1, (void **)&objp);
+      chSysUnlock();
+    }
+    test_assert(4, msg == MSG_OK, "receive failed");
+    test_assert(5, (objp == objs[OBJFIFO_OBJECTS - 1 - i]) &&
+                   (objp->seq == OBJFIFO_OBJECTS - 1 - i),
+                "wrong object");
+    if (i & 1) {
+      chFifoReturnObject(&fifo1, objp);
+    }
+    else {
+      chSysLock();
+      chFifoReturnObjectS(&fifo1, objp);
+      chSysUnlock();
+    }
+  }
+  test_assert(6, chFifoReceiveObjectTimeout(&fifo1, (void **)&objp,
+                                            TIME_IMMEDIATE) == MSG_TIMEOUT,
+              "FIFO not empty");
+
+  /* The objects are available again.*/
+  for (i = 0; i < OBJFIFO_OBJECTS; i++) {
+    objs[i] = chFifoTakeObjectTimeout(&fifo1, TIME_IMMEDIATE);
+    test_assert(7, objs[i] != NULL, "object not available");
+  }
+  chSysLock();
+  for (i = 0; i < OBJFIFO_OBJECTS; i++) {
+    chFifoReturnObjectI(&fifo1, objs[i]);
+  }
+  chSysUnlock();
+}
+
+ROMCONST struct testcase testobjfifo1 = {
+  "Objects FIFOs, objects loop",
+  objfifo_setup,
+  NULL,
+  objfifo1_execute
+};
+
+/**
+ * @page test_objfifo_002 Producer and consumer
+ *
+ * <h2>Description</h2>
+ * A consumer thread with lower priority than the test thread receives
+ * objects and emits the tokens they carry, the test thread sends more
+ * objects than the FIFO holds so it waits for the consumer to return
+ * them.<br>
+ * The test expects the tokens in the order they were sent.
+ */
+
+static msg_t thread2(void *p) {
+  fifo_object_t *objp;
+
+  (void)p;
+  while (chFifoReceiveObjectTimeout(&fifo1, (void **)&objp,
+                                    TIME_INFINITE) == MSG_OK) {
+    char token = objp->token;
+
+    chFifoReturnObject(&fifo1, objp);
+    if (token == 0)
+      break;
+    test_emit_token(token);
+  }
+  return 0;
+}
+
+static void objfifo2_execute(void) {
+  static const char tokens[] = "ABCDEFGH";
+  fifo_object_t *objp;
+  unsigned i;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() - 1,
+                                 thread2, NULL);
+  for (i = 0; i < sizeof tokens; i++) {
+    objp = chFifoTakeObjectTimeout(&fifo1, MS2ST(500));
+    test_assert(1, objp != NULL, "object not available");
+    objp->token = tokens[i];
+    chFifoSendObject(&fifo1, objp);
+  }
+  test_wait_threads();
+  test_assert_sequence(2, "ABCDEFGH");
+}
+
+ROMCONST struct testcase testobjfifo2 = {
+  "Objects FIFOs, producer and consumer",
+  objfifo_setup,
+  NULL,
+  objfifo2_execute
+};
+
+#endif /* CH_CFG_USE_OBJ_FIFOS */
+
+/**
+ * @brief   Test sequence for objects FIFOs.
+ */
+ROMCONST struct testcase * ROMCONST patternobjfifo[] = {
+#if CH_CFG_USE_OBJ_FIFOS || defined(__DOXYGEN__)
+  &testobjfifo1,
+  &testobjfifo2,
+#endif
+  NULL
+};
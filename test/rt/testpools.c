@@ -37,6 +37,9 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_pools_001
+ * - @subpage test_pools_002
+ * - @subpage test_pools_003
+ * - @subpage test_pools_004
  * .
  * @file testpools.c
  * @brief Memory Pools test source file
@@ -104,6 +107,210 @@ ROMCONST struct testcase testpools1 = {
   pools1_execute
 };
 
+/**
+ * @page test_pools_002 Batch operations test
+ *
+ * <h2>Description</h2>
+ * The memory blocks are removed from a memory pool and added back using the
+ * batch operations, the I-class variants are used too.<br>
+ * The test expects the batches to be limited by the pool content and the
+ * objects to be returned in the same order they have been released.
+ */
+
+static void pools2_execute(void) {
+  void *objs[MAX_THREADS + 1];
+  size_t n;
+
+  /* Adding the WAs to the pool.*/
+  chPoolLoadArray(&mp1, wa[0], MAX_THREADS);
+
+  /* Emptying the pool in a single batch, it must be limited by the pool
+     content.*/
+  n = chPoolAllocBatch(&mp1, objs, MAX_THREADS + 1);
+  test_assert(1, n == MAX_THREADS, "wrong batch size");
+  test_assert(2, chPoolAlloc(&mp1) == NULL, "list not empty");
+
+  /* Releasing in a single batch, the objects are expected back in the
+     same order.*/
+  chPoolFreeBatch(&mp1, objs, MAX_THREADS);
+  n = chPoolAllocBatch(&mp1, &objs[MAX_THREADS - 2], 2);
+  test_assert(3, n == 2, "wrong batch size");
+  test_assert(4, (objs[MAX_THREADS - 2] == objs[0]) &&
+                 (objs[MAX_THREADS - 1] == objs[1]), "wrong order");
+
+  /* Same using the I-class variants.*/
+  chSysLock();
+  chPoolFreeBatchI(&mp1, objs, 2);
+  chPoolFreeBatchI(&mp1, objs, 0);
+  n = chPoolAllocBatchI(&mp1, objs, MAX_THREADS);
+  chSysUnlock();
+  test_assert(5, n == MAX_THREADS, "wrong batch size");
+  test_assert(6, chPoolAlloc(&mp1) == NULL, "list not empty");
+
+  /* Covering the case where a provider is unable to return more memory.*/
+  chPoolObjectInit(&mp1, 16, null_provider);
+  test_assert(7, chPoolAllocBatch(&mp1, objs, 2) == 0,
+              "provider returned memory");
+}
+
+ROMCONST struct testcase testpools2 = {
+  "Memory Pools, batch operations",
+  pools1_setup,
+  NULL,
+  pools2_execute
+};
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @page test_pools_003 Guarded memory pools test
+ *
+ * <h2>Description</h2>
+ * Three objects are added to a guarded memory pool then removed, the
+ * allocation from the empty pool is tested with and without timeout, a
+ * thread waiting for an object is then served by a release, finally the
+ * pool is emptied using the non-blocking I-class allocation.<br>
+ * The test expects the allocations from the empty pool to time out or
+ * fail and the waiting thread to be resumed by the release.
+ */
+
+#define GMP_OBJECTS     3
+
+static GUARDEDMEMORYPOOL_DECL(gmp1, sizeof (void *) * 4);
+
+static void *gmp_buf[GMP_OBJECTS][4];
+
+static void pools3_setup(void) {
+
+  chGuardedPoolObjectInit(&gmp1, sizeof (void *) * 4);
+}
+
+static msg_t thread3(void *p) {
+
+  (void)p;
+  if (chGuardedPoolAllocTimeout(&gmp1, TIME_INFINITE) != NULL)
+    test_emit_token('A');
+  return 0;
+}
+
+static void pools3_execute(void) {
+  void *objs[GMP_OBJECTS];
+  cnt_t cnt;
+  int i;
+
+  /* Adding the objects to the pool.*/
+  chGuardedPoolLoadArray(&gmp1, gmp_buf, GMP_OBJECTS);
+  chSysLock();
+  cnt = chGuardedPoolGetCounterI(&gmp1);
+  chSysUnlock();
+  test_assert(1, cnt == GMP_OBJECTS, "wrong counter");
+
+  /* Emptying the pool.*/
+  for (i = 0; i < GMP_OBJECTS; i++) {
+    objs[i] = chGuardedPoolAllocTimeout(&gmp1, TIME_IMMEDIATE);
+    test_assert(2, objs[i] != NULL, "list empty");
+  }
+
+  /* Now must be empty, with and without timeout.*/
+  test_assert(3, chGuardedPoolAllocTimeout(&gmp1, TIME_IMMEDIATE) == NULL,
+              "list not empty");
+  test_assert(4, chGuardedPoolAllocTimeout(&gmp1, MS2ST(10)) == NULL,
+              "list not empty");
+
+  /* A thread waiting on the empty pool is resumed by a release.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread3, NULL);
+  chGuardedPoolFree(&gmp1, objs[0]);
+  test_emit_token('B');
+  test_wait_threads();
+  test_assert_sequence(5, "AB");
+
+  /* Releasing the remaining objects, the I-class variant as it would be
+     done from an ISR.*/
+  chSysLock();
+  chGuardedPoolFreeI(&gmp1, objs[1]);
+  chGuardedPoolAddI(&gmp1, objs[2]);
+  chSchRescheduleS();
+  cnt = chGuardedPoolGetCounterI(&gmp1);
+  chSysUnlock();
+  test_assert(6, cnt == GMP_OBJECTS - 1, "wrong counter");
+
+  /* Emptying the pool using the I-class variant.*/
+  chSysLock();
+  objs[0] = chGuardedPoolAllocI(&gmp1);
+  objs[1] = chGuardedPoolAllocI(&gmp1);
+  objs[2] = chGuardedPoolAllocI(&gmp1);
+  cnt = chGuardedPoolGetCounterI(&gmp1);
+  chSysUnlock();
+  test_assert(7, (objs[0] != NULL) && (objs[1] != NULL), "list empty");
+  test_assert(8, objs[2] == NULL, "list not empty");
+  test_assert(9, cnt == 0, "wrong counter");
+}
+
+ROMCONST struct testcase testpools3 = {
+  "Memory Pools, guarded pools",
+  pools3_setup,
+  NULL,
+  pools3_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+/**
+ * @page test_pools_004 Aligned objects test
+ *
+ * <h2>Description</h2>
+ * For each alignment from 4 to 64 bytes, not smaller than a pointer, a
+ * memory pool is loaded with an aligned array and objects are allocated
+ * until the array is exhausted, then objects are requested to the core
+ * allocator provider.<br>
+ * The test expects all the objects to be aligned and the objects size to
+ * be rounded to the alignment.
+ */
+
+static const size_t pools4_aligns[] = {4, 8, 16, 32, 64};
+
+static void pools4_execute(void) {
+  uint8_t *buf;
+  void *p1, *p2;
+  size_t align;
+  unsigned i, j;
+
+  for (i = 0; i < sizeof pools4_aligns / sizeof pools4_aligns[0]; i++) {
+    align = pools4_aligns[i];
+    if (align < sizeof (void *)) {
+      continue;
+    }
+
+    /* Aligned array, no threads are running so the test buffer can be
+       used.*/
+    buf = (uint8_t *)(((size_t)test.buffer + align - 1U) & ~(align - 1U));
+    chPoolObjectInitAligned(&mp1, sizeof (void *) + 1, align, NULL);
+    test_assert(1, (mp1.mp_object_size % align) == 0, "wrong objects size");
+    chPoolLoadArray(&mp1, buf, 4);
+    for (j = 0; j < 4; j++) {
+      p1 = chPoolAlloc(&mp1);
+      test_assert(2, (p1 != NULL) && (((size_t)p1 & (align - 1U)) == 0U),
+                  "wrong alignment");
+    }
+    test_assert(3, chPoolAlloc(&mp1) == NULL, "list not empty");
+
+    /* Objects from the provider.*/
+    chPoolObjectInitAligned(&mp1, sizeof (void *) + 1, align, chCoreAllocI);
+    p1 = chPoolAlloc(&mp1);
+    p2 = chPoolAlloc(&mp1);
+    test_assert(4, (p1 != NULL) && (((size_t)p1 & (align - 1U)) == 0U) &&
+                   (p2 != NULL) && (((size_t)p2 & (align - 1U)) == 0U),
+                "wrong alignment");
+    test_assert(5, p1 != p2, "same object");
+  }
+}
+
+ROMCONST struct testcase testpools4 = {
+  "Memory Pools, aligned objects",
+  NULL,
+  NULL,
+  pools4_execute
+};
+
 #endif /* CH_CFG_USE_MEMPOOLS */
 
 /*
@@ -112,6 +319,11 @@ ROMCONST struct testcase testpools1 = {
 ROMCONST struct testcase * ROMCONST patternpools[] = {
 #if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
   &testpools1,
+  &testpools2,
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+  &testpools3,
+#endif
+  &testpools4,
 #endif
   NULL
 };
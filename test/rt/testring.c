@@ -0,0 +1,181 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_ring SPSC Rings test
+ *
+ * File: @ref testring.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref rings subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref rings code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_USE_RINGS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_ring_001
+ * - @subpage test_ring_002
+ * .
+ * @file testring.c
+ * @brief SPSC Rings test source file
+ * @file testring.h
+ * @brief SPSC Rings test header file
+ */
+
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
+
+#define RING_SIZE       8
+
+static ring_t ring1;
+
+static uint32_t ring_buf[RING_SIZE];
+
+/**
+ * @page test_ring_001 Write and read
+ *
+ * <h2>Description</h2>
+ * Elements are written into and read from a ring, the ring is filled and
+ * emptied with operations crossing the end of the buffer.<br>
+ * The test expects the elements to be read in the same order they were
+ * written and the operations on a full or empty ring to fail.
+ */
+
+static void ring1_setup(void) {
+
+  chRingObjectInit(&ring1, ring_buf, sizeof (uint32_t), RING_SIZE);
+}
+
+static void ring1_execute(void) {
+  uint32_t src[RING_SIZE + 2], dst[RING_SIZE];
+  unsigned i;
+
+  for (i = 0; i < RING_SIZE + 2; i++)
+    src[i] = 0x55AA0000 + i;
+
+  /* Partial write and read.*/
+  test_assert(1, chRingWriteX(&ring1, src, 6) == 6, "wrong size");
+  test_assert(2, (chRingGetUsedX(&ring1) == 6) &&
+                 (chRingGetFreeX(&ring1) == RING_SIZE - 6), "wrong counters");
+  test_assert(3, chRingReadX(&ring1, dst, RING_SIZE) == 6, "wrong size");
+  for (i = 0; i < 6; i++)
+    test_assert(4, dst[i] == src[i], "wrong data");
+
+  /* Writing more than the capacity, the buffer end is crossed.*/
+  test_assert(5, chRingWriteX(&ring1, src, RING_SIZE + 2) == RING_SIZE,
+              "wrong size");
+  test_assert(6, !chRingPutX(&ring1, &src[0]), "ring not full");
+  test_assert(7, chRingReadX(&ring1, dst, RING_SIZE) == RING_SIZE,
+              "wrong size");
+  for (i = 0; i < RING_SIZE; i++)
+    test_assert(8, dst[i] == src[i], "wrong data");
+
+  /* Empty ring.*/
+  test_assert(9, !chRingGetX(&ring1, &dst[0]), "ring not empty");
+  test_assert(10, chRingReadTimeout(&ring1, dst, 1, TIME_IMMEDIATE) == 0,
+              "ring not empty");
+  test_assert(11, chRingPutX(&ring1, &src[1]) && chRingGetX(&ring1, &dst[0]),
+              "single element operations failed");
+  test_assert(12, dst[0] == src[1], "wrong data");
+}
+
+ROMCONST struct testcase testring1 = {
+  "SPSC Rings, write and read",
+  ring1_setup,
+  NULL,
+  ring1_execute
+};
+
+/**
+ * @page test_ring_002 Blocking read
+ *
+ * <h2>Description</h2>
+ * A consumer thread with higher priority than the test thread waits on an
+ * empty ring, the test thread writes two bursts of tokens, the consumer
+ * terminates when its wait times out. The test thread then waits on the
+ * ring with a short timeout.<br>
+ * The test expects the consumer to be woken by each burst and the tokens
+ * to be received in order.
+ */
+
+static ring_t ring2;
+
+static char ring2_buf[4];
+
+static void ring2_setup(void) {
+
+  chRingObjectInit(&ring2, ring2_buf, 1, sizeof ring2_buf);
+}
+
+static msg_t thread2(void *p) {
+  char buf[4];
+  size_t i, n;
+
+  (void)p;
+  while ((n = chRingReadTimeout(&ring2, buf, sizeof buf, MS2ST(50))) > 0) {
+    for (i = 0; i < n; i++)
+      test_emit_token(buf[i]);
+  }
+  return 0;
+}
+
+static void ring2_execute(void) {
+  char c;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread2, NULL);
+  test_assert(1, chRingWriteX(&ring2, "AB", 2) == 2, "wrong size");
+  test_assert(2, chRingWriteX(&ring2, "CDEF", 4) == 4, "wrong size");
+  test_wait_threads();
+  test_assert_sequence(3, "ABCDEF");
+
+  /* The test thread is now the consumer.*/
+  test_assert(4, chRingReadTimeout(&ring2, &c, 1, MS2ST(5)) == 0,
+              "timeout expected");
+  test_assert(5, chRingWriteX(&ring2, "G", 1) == 1, "wrong size");
+  test_assert(6, chRingReadTimeout(&ring2, &c, 1, MS2ST(5)) == 1,
+              "read failed");
+  test_assert(7, c == 'G', "wrong data");
+}
+
+ROMCONST struct testcase testring2 = {
+  "SPSC Rings, blocking read",
+  ring2_setup,
+  NULL,
+  ring2_execute
+};
+
+#endif /* CH_CFG_USE_RINGS */
+
+/**
+ * @brief   Test sequence for rings.
+ */
+ROMCONST struct testcase * ROMCONST patternring[] = {
+#if CH_CFG_USE_RINGS || defined(__DOXYGEN__)
+  &testring1,
+  &testring2,
+#endif
+  NULL
+};
@@ -0,0 +1,320 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_smp SMP test
+ *
+ * File: @ref testsmp.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the SMP mode of the
+ * @ref scheduler subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to verify that threads bound to other
+ * cores are scheduled on their core, can be waken from other cores and
+ * execute in parallel with the threads of the test core.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_SMP_MODE
+ * - @p CH_CFG_USE_SEMAPHORES
+ * - @p CH_CFG_USE_MUTEXES
+ * .
+ * The test must be executed on the core zero, the core one must have been
+ * started. In case some of the required options are not enabled then some
+ * or all tests may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_smp_001
+ * - @subpage test_smp_002
+ * - @subpage test_smp_003
+ * - @subpage test_smp_004
+ * .
+ * @file testsmp.c
+ * @brief SMP test source file
+ * @file testsmp.h
+ * @brief SMP test header file
+ */
+
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+
+/*
+ * Creates a thread bound to the specified core.
+ */
+static thread_t *smp_create_prio(unsigned n, unsigned core, tprio_t prio,
+                                 tfunc_t pf, void *p) {
+  thread_t *tp;
+
+  chSysLock();
+  tp = chThdCreateI(wa[n], WA_SIZE, prio, pf, p);
+  chThdSetAffinityI(tp, core);
+  chThdStartI(tp);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return tp;
+}
+
+/*
+ * Creates a thread bound to the specified core with lower priority than
+ * the test thread.
+ */
+static thread_t *smp_create(unsigned n, unsigned core, tfunc_t pf, void *p) {
+
+  return smp_create_prio(n, core, chThdGetPriorityX() - 1, pf, p);
+}
+
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @page test_smp_001 Cross-core wakeup
+ *
+ * <h2>Description</h2>
+ * A thread bound to the core one and the test thread exchange tokens using
+ * two semaphores, each signal wakes up a thread on the other core.<br>
+ * The test expects the tokens in the correct order and the thread to
+ * be executed on the core one.
+ */
+
+static semaphore_t smp_sem1, smp_sem2;
+static volatile unsigned smp_core;
+
+static void smp1_setup(void) {
+
+  chSemObjectInit(&smp_sem1, 0);
+  chSemObjectInit(&smp_sem2, 0);
+}
+
+static msg_t thread1(void *p) {
+  unsigned i;
+
+  (void)p;
+  smp_core = chSysGetCoreX();
+  for (i = 0; i < 4; i++) {
+    chSemWait(&smp_sem1);
+    test_emit_token('a' + i);
+    chSemSignal(&smp_sem2);
+  }
+  return 0;
+}
+
+static void smp1_execute(void) {
+  unsigned i;
+
+  threads[0] = smp_create(0, 1, thread1, NULL);
+  for (i = 0; i < 4; i++) {
+    test_emit_token('A' + i);
+    chSemSignal(&smp_sem1);
+    test_assert(1, chSemWaitTimeout(&smp_sem2, MS2ST(500)) == MSG_OK,
+                "wakeup lost");
+  }
+  test_wait_threads();
+  test_assert_sequence(2, "AaBbCcDd");
+  test_assert(3, smp_core == 1, "wrong core");
+}
+
+ROMCONST struct testcase testsmp1 = {
+  "SMP, cross-core wakeup",
+  smp1_setup,
+  NULL,
+  smp1_execute
+};
+#endif /* CH_CFG_USE_SEMAPHORES */
+
+/**
+ * @page test_smp_002 Parallel execution
+ *
+ * <h2>Description</h2>
+ * A thread bound to the core one counts in a busy loop until stopped
+ * while the test thread sleeps, then the test thread counts in the
+ * same way.<br>
+ * The test expects the thread of the core one to make progress while the
+ * test thread is executing.
+ */
+
+static volatile bool smp_stop;
+static volatile uint32_t smp_counter;
+
+static msg_t thread2(void *p) {
+
+  (void)p;
+  while (!smp_stop) {
+    smp_counter++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  return 0;
+}
+
+static void smp2_execute(void) {
+  uint32_t n;
+  systime_t start;
+
+  smp_stop = false;
+  smp_counter = 0;
+  threads[0] = smp_create(0, 1, thread2, NULL);
+
+  chThdSleepMilliseconds(10);
+
+  /* The test thread is busy too, the other thread is expected to make
+     progress anyway.*/
+  n = smp_counter;
+  start = chVTGetSystemTime();
+  while (chVTIsSystemTimeWithin(start, start + MS2ST(50))) {
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  smp_stop = true;
+  test_wait_threads();
+  test_assert(1, smp_counter > n, "no parallel execution");
+}
+
+ROMCONST struct testcase testsmp2 = {
+  "SMP, parallel execution",
+  NULL,
+  NULL,
+  smp2_execute
+};
+
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @page test_smp_003 Shared data across cores
+ *
+ * <h2>Description</h2>
+ * A thread bound to the core one and a thread bound to the core zero
+ * increment a shared counter under the protection of a mutex.<br>
+ * The test expects no increments to be lost.
+ */
+
+#define SMP3_LOOPS      2000
+
+static mutex_t smp_mtx;
+
+static void smp3_setup(void) {
+
+  chMtxObjectInit(&smp_mtx);
+}
+
+static msg_t thread3(void *p) {
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < SMP3_LOOPS; i++) {
+    uint32_t n;
+
+    chMtxLock(&smp_mtx);
+    n = smp_counter;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+    smp_counter = n + 1;
+    chMtxUnlock(&smp_mtx);
+  }
+  return 0;
+}
+
+static void smp3_execute(void) {
+
+  smp_counter = 0;
+  threads[0] = smp_create(0, 1, thread3, NULL);
+  threads[1] = smp_create(1, 0, thread3, NULL);
+  test_wait_threads();
+  test_assert(1, smp_counter == 2 * SMP3_LOOPS, "lost increments");
+}
+
+ROMCONST struct testcase testsmp3 = {
+  "SMP, shared data across cores",
+  smp3_setup,
+  NULL,
+  smp3_execute
+};
+#endif /* CH_CFG_USE_MUTEXES */
+
+/**
+ * @page test_smp_004 Cross-core preemption
+ *
+ * <h2>Description</h2>
+ * A thread bound to the core one enters and leaves the kernel lock in a
+ * busy loop, then the test thread starts on the core one a thread with
+ * higher priority.<br>
+ * The test expects the thread with higher priority to preempt the busy
+ * thread when the notification is served and the lock exits in between
+ * to not be reported as missing reschedules.
+ */
+
+static msg_t thread4a(void *p) {
+
+  (void)p;
+  while (!smp_stop) {
+    chSysLock();
+    chSysUnlock();
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  test_emit_token('B');
+  return 0;
+}
+
+static msg_t thread4b(void *p) {
+
+  (void)p;
+  test_emit_token('A');
+  smp_stop = true;
+  return 0;
+}
+
+static void smp4_execute(void) {
+
+  smp_stop = false;
+  threads[0] = smp_create(0, 1, thread4a, NULL);
+  chThdSleepMilliseconds(10);
+  threads[1] = smp_create_prio(1, 1, chThdGetPriorityX() + 1,
+                               thread4b, NULL);
+  test_wait_threads();
+  test_assert_sequence(1, "AB");
+}
+
+ROMCONST struct testcase testsmp4 = {
+  "SMP, cross-core preemption",
+  NULL,
+  NULL,
+  smp4_execute
+};
+
+#endif /* CH_CFG_SMP_MODE */
+
+/**
+ * @brief   Test sequence for SMP mode.
+ */
+ROMCONST struct testcase * ROMCONST patternsmp[] = {
+#if CH_CFG_SMP_MODE || defined(__DOXYGEN__)
+#if CH_CFG_USE_SEMAPHORES || defined(__DOXYGEN__)
+  &testsmp1,
+#endif
+  &testsmp2,
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+  &testsmp3,
+#endif
+  &testsmp4,
+#endif
+  NULL
+};
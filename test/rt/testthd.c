@@ -40,6 +40,11 @@
  * - @subpage test_threads_002
  * - @subpage test_threads_003
  * - @subpage test_threads_004
+ * - @subpage test_threads_005
+ * - @subpage test_threads_006
+ * - @subpage test_threads_007
+ * - @subpage test_threads_008
+ * - @subpage test_threads_009
  * .
  * @file testthd.c
  * @brief Threads and Scheduler test source file
@@ -227,6 +232,355 @@ ROMCONST struct testcase testthd4 = {
   thd4_execute
 };
 
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+/**
+ * @page test_threads_005 Preemption threshold test
+ *
+ * <h2>Description</h2>
+ * The current thread raises its preemption threshold then creates a thread
+ * with priority between its priority and the threshold and a thread with
+ * priority above the threshold.<br>
+ * The test expects the second thread to preempt the current thread
+ * immediately and the first one to run only after the threshold is
+ * lowered back.<br>
+ * Then a thread preempting the current thread lowers its priority to the
+ * threshold level and waits on a mutex owned by the current thread, the
+ * current thread is expected to keep the inherited priority when resumed.
+ */
+
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+static MUTEX_DECL(thd5_mtx);
+
+static msg_t thread5(void *p) {
+
+  chThdSetPriority(chThdGetPriorityX() - 1);
+  chMtxLock((mutex_t *)p);
+  chMtxUnlock((mutex_t *)p);
+  return 0;
+}
+#endif
+
+static void thd5_execute(void) {
+  tprio_t prio = chThdGetPriorityX();
+  tprio_t oldthreshold;
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+  tprio_t newprio;
+#endif
+
+  oldthreshold = chThdSetThreshold(prio + 2);
+  test_assert(1, chThdGetThresholdX() == prio + 2, "wrong threshold");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, thread, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 3, thread, "C");
+  test_emit_token('B');
+  chThdSetThreshold(oldthreshold);
+  test_wait_threads();
+  test_assert_sequence(2, "CBA");
+
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+  /* Priority inherited while ready at the threshold level.*/
+  chMtxLock(&thd5_mtx);
+  oldthreshold = chThdSetThreshold(prio + 2);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 3, thread5,
+                                 &thd5_mtx);
+  newprio = chThdGetPriorityX();
+  chThdSetThreshold(oldthreshold);
+  chMtxUnlock(&thd5_mtx);
+  test_wait_threads();
+  test_assert(3, newprio == prio + 2, "inherited priority lost");
+  test_assert(4, chThdGetPriorityX() == prio, "wrong priority");
+#endif
+}
+
+ROMCONST struct testcase testthd5 = {
+  "Threads, preemption threshold",
+  NULL,
+  NULL,
+  thd5_execute
+};
+#endif /* CH_CFG_SCHED_THRESHOLD */
+
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+/**
+ * @page test_threads_006 CPU budget test
+ *
+ * <h2>Description</h2>
+ * A thread never releasing the CPU is created together with a lower
+ * priority thread also never releasing the CPU, the first thread has a
+ * CPU budget of 20% of each period. Both threads count their loops for
+ * half a second.<br>
+ * The test expects the lower priority thread to run for most of the time
+ * and the budget to be used up in each period.
+ */
+
+static volatile uint32_t bud_counts[2];
+
+static msg_t thread6(void *p) {
+
+  while (!chThdShouldTerminateX()) {
+    (*(volatile uint32_t *)p)++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  return 0;
+}
+
+static void thd6_execute(void) {
+  static thread_budget_t budget;
+  tprio_t prio = chThdGetPriorityX();
+
+  bud_counts[0] = bud_counts[1] = 0;
+  chThdBudgetObjectInit(&budget, MS2ST(20), MS2ST(100), LOWPRIO);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 1, thread6,
+                                 (void *)&bud_counts[0]);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio - 2, thread6,
+                                 (void *)&bud_counts[1]);
+  chThdSetBudget(threads[0], &budget);
+  test_wait_tick();
+  chThdSleepMilliseconds(500);
+  test_terminate_threads();
+  test_wait_threads();
+  test_assert(1, bud_counts[0] > 0, "budgeted thread starved");
+  test_assert(2, bud_counts[1] > bud_counts[0] * 2,
+              "low priority thread not protected");
+  test_assert(3, chThdGetBudgetOverrunsX(&budget) >= 4, "budget not enforced");
+}
+
+ROMCONST struct testcase testthd6 = {
+  "Threads, CPU budget",
+  NULL,
+  NULL,
+  thd6_execute
+};
+#endif /* CH_CFG_SCHED_BUDGET */
+
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+/**
+ * @page test_threads_007 Periodic threads test
+ *
+ * <h2>Description</h2>
+ * A periodic thread records its activation times, the fifth job lasts
+ * more than two periods.<br>
+ * The test expects the activations to happen at the nominal times, the
+ * overrun to be accounted and notified and the missed activations to be
+ * skipped without losing the phase.
+ */
+
+static periodic_t pt;
+static systime_t pt_times[8];
+static unsigned pt_misses;
+
+static void pt_miss(periodic_t *ptp) {
+
+  (void)ptp;
+  pt_misses++;
+}
+
+static msg_t thread7(void *p) {
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < 8; i++) {
+    chPTWaitNext(&pt);
+    pt_times[i] = chVTGetSystemTime();
+    if (i == 4) {
+      chThdSleepMilliseconds(25);
+    }
+  }
+  return 0;
+}
+
+static void thd7_execute(void) {
+  static const unsigned slots[8] = {0, 1, 2, 3, 4, 7, 8, 9};
+  systime_t start;
+  unsigned i;
+
+  pt_misses = 0;
+  start = test_wait_tick() + MS2ST(10);
+  chPTObjectInit(&pt, start, MS2ST(10), pt_miss);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread7, NULL);
+#if CH_CFG_USE_REGISTRY
+  test_assert_lock(1, chRegGetThreadPeriodicI(threads[0]) == &pt,
+                   "not in registry");
+#endif
+  test_wait_threads();
+  for (i = 0; i < 8; i++) {
+    systime_t t = start + MS2ST(10) * slots[i];
+    test_assert(2, chVTIsTimeWithinX(pt_times[i], t,
+                                     t + CH_CFG_ST_TIMEDELTA + 1),
+                "wrong activation time");
+  }
+  test_assert(3, pt.pt_activations == 8, "wrong activations count");
+  test_assert(4, pt.pt_overruns == 1, "overrun not detected");
+  test_assert(5, pt_misses == 1, "miss callback not invoked");
+  test_assert(6, pt.pt_jworst <= CH_CFG_ST_TIMEDELTA, "excessive jitter");
+#if CH_CFG_USE_TM
+  test_assert(7, pt.pt_exec.n == 7, "wrong measurements count");
+#endif
+}
+
+ROMCONST struct testcase testthd7 = {
+  "Threads, periodic API",
+  NULL,
+  NULL,
+  thd7_execute
+};
+#endif /* CH_CFG_USE_PERIODIC */
+
+#if (CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+/**
+ * @page test_threads_008 Stack usage scanning
+ *
+ * <h2>Description</h2>
+ * Three threads are created, one sleeping while all the stacks in the
+ * registry are scanned, one just sleeping and one sleeping while using a
+ * local buffer, then the stacks of the terminated threads are
+ * scanned.<br>
+ * The test expects the result of the registry scan to be stored in the
+ * sleeping thread and the thread using the buffer to have less unused
+ * stack than the other one. A thread created using @p chThdCreateI()
+ * is then scanned, its stack is not filled and no unused stack is
+ * expected to be reported.
+ */
+
+#define THD8_BUFFER_SIZE    32
+
+static msg_t thread8a(void *p) {
+
+  (void)p;
+  chThdSleepMilliseconds(20);
+  return 0;
+}
+
+static msg_t thread8b(void *p) {
+
+  (void)p;
+  chThdSleepMilliseconds(1);
+  return 0;
+}
+
+static msg_t thread8c(void *p) {
+  volatile uint8_t buf[THD8_BUFFER_SIZE];
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < THD8_BUFFER_SIZE; i++) {
+    buf[i] = (uint8_t)i;
+  }
+  /* The buffer is in use while the thread sleeps.*/
+  chThdSleepMilliseconds(1);
+  return (msg_t)buf[THD8_BUFFER_SIZE - 1];
+}
+
+static void thd8_execute(void) {
+  size_t n1, n2;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread8a, NULL);
+  test_assert(1, chRegGetStackUnusedX(threads[0]) == 0,
+              "stack already scanned");
+  chRegScanStacks();
+  n1 = chRegGetStackUnusedX(threads[0]);
+  test_assert(2, (n1 > 0) && (n1 < WA_SIZE), "wrong scan result");
+  test_wait_threads();
+
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriorityX() - 1,
+                                 thread8b, NULL);
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriorityX() - 1,
+                                 thread8c, NULL);
+  test_wait_threads();
+  n1 = chRegScanStack((thread_t *)wa[1]);
+  n2 = chRegScanStack((thread_t *)wa[2]);
+  test_assert(3, (n1 > 0) && (n1 < WA_SIZE), "wrong unused stack");
+  test_assert(4, n2 + THD8_BUFFER_SIZE <= n1, "stack usage not detected");
+
+  chSysLock();
+  threads[3] = chThdCreateI(wa[3], WA_SIZE, chThdGetPriorityX() - 1,
+                            thread8b, NULL);
+  chThdStartI(threads[3]);
+  chSysUnlock();
+  test_wait_threads();
+  n1 = chRegScanStack((thread_t *)wa[3]);
+  test_assert(5, n1 == 0, "unfilled stack scanned");
+}
+
+ROMCONST struct testcase testthd8 = {
+  "Threads, stack usage scanning",
+  NULL,
+  NULL,
+  thd8_execute
+};
+#endif /* CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS */
+
+#if (CH_CFG_SCHED_THRESHOLD && CH_CFG_SCHED_BUDGET) || defined(__DOXYGEN__)
+/**
+ * @page test_threads_009 Preemption threshold and CPU budget
+ *
+ * <h2>Description</h2>
+ * A thread never releasing the CPU and having a preemption threshold above
+ * its priority uses up its CPU budget and is demoted, then it is preempted
+ * and kept ready at its threshold level until its budget is replenished.
+ * <br>
+ * The test expects the thread to run at its original priority after
+ * being resumed.
+ */
+
+static volatile tprio_t thd9_prio;
+
+static msg_t thread9(void *p) {
+
+  (void)p;
+  chThdSetThreshold(chThdGetPriorityX() + 1);
+  while (!chThdShouldTerminateX()) {
+    thd9_prio = chThdGetPriorityX();
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  return 0;
+}
+
+static void thd9_execute(void) {
+  static thread_budget_t budget;
+  tprio_t prio = chThdGetPriorityX();
+  tprio_t prio1, prio2;
+  systime_t start;
+
+  chThdBudgetObjectInit(&budget, MS2ST(20), MS2ST(100), LOWPRIO);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 2, thread9, NULL);
+  chThdSetBudget(threads[0], &budget);
+
+  /* The thread is demoted after 20mS and preempted after 50mS.*/
+  chThdSleepMilliseconds(50);
+  prio1 = thd9_prio;
+
+  /* The replenishment happens while the thread is ready at its threshold
+     level.*/
+  start = chVTGetSystemTime();
+  while (chVTTimeElapsedSinceX(start) < MS2ST(70)) {
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  }
+  thd9_prio = NOPRIO;
+  chThdSleepMilliseconds(5);
+  prio2 = thd9_prio;
+
+  test_terminate_threads();
+  test_wait_threads();
+  test_assert(1, prio1 == LOWPRIO, "not demoted");
+  test_assert(2, prio2 == prio - 2, "still demoted");
+}
+
+ROMCONST struct testcase testthd9 = {
+  "Threads, preemption threshold and CPU budget",
+  NULL,
+  NULL,
+  thd9_execute
+};
+#endif /* CH_CFG_SCHED_THRESHOLD && CH_CFG_SCHED_BUDGET */
+
 /**
  * @brief   Test sequence for threads.
  */
@@ -235,5 +589,20 @@ ROMCONST struct testcase * ROMCONST patternthd[] = {
   &testthd2,
   &testthd3,
   &testthd4,
+#if CH_CFG_SCHED_THRESHOLD || defined(__DOXYGEN__)
+  &testthd5,
+#endif
+#if CH_CFG_SCHED_BUDGET || defined(__DOXYGEN__)
+  &testthd6,
+#endif
+#if CH_CFG_USE_PERIODIC || defined(__DOXYGEN__)
+  &testthd7,
+#endif
+#if (CH_CFG_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+  &testthd8,
+#endif
+#if (CH_CFG_SCHED_THRESHOLD && CH_CFG_SCHED_BUDGET) || defined(__DOXYGEN__)
+  &testthd9,
+#endif
   NULL
 };
@@ -0,0 +1,182 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_tpool Thread Pools test
+ *
+ * File: @ref testtpool.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref thread_pools
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref thread_pools
+ * code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_USE_THREADPOOLS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_tpool_001
+ * - @subpage test_tpool_002
+ * .
+ * @file testtpool.c
+ * @brief Thread Pools test source file
+ * @file testtpool.h
+ * @brief Thread Pools test header file
+ */
+
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+
+#define TPOOL_JOBS      4
+
+static thread_pool_t tpool1;
+
+static thread_pool_job_t tpool_jobs[TPOOL_JOBS];
+
+static char tpool_tokens[] = "ABCD";
+
+static volatile unsigned tpool_counter;
+
+static void tpool_setup(void) {
+
+  chThdPoolObjectInit(&tpool1, tpool_jobs, TPOOL_JOBS,
+                      chThdGetPriorityX() - 1);
+}
+
+/**
+ * @page test_tpool_001 Submit and completion
+ *
+ * <h2>Description</h2>
+ * A pool with a single worker at lower priority than the test thread is
+ * filled with jobs emitting tokens, a further submit is attempted with
+ * immediate timeout, then the test thread waits for the jobs completion
+ * and stops the pool.<br>
+ * The test expects the extra submit to fail, the jobs to be executed in
+ * FIFO order and the worker to terminate.
+ */
+
+static void job1(void *p) {
+
+  test_emit_token(*(char *)p);
+}
+
+static void tpool1_execute(void) {
+  unsigned i;
+
+  threads[0] = chThdPoolAddWorker(&tpool1, wa[0], WA_SIZE);
+  for (i = 0; i < TPOOL_JOBS; i++) {
+    test_assert(1, chThdPoolSubmitTimeout(&tpool1, job1, &tpool_tokens[i],
+                                          TIME_IMMEDIATE) == MSG_OK,
+                "submit failed");
+  }
+  test_assert_lock(2, chThdPoolGetPendingI(&tpool1) == TPOOL_JOBS,
+                   "wrong pending jobs");
+  test_assert(3, chThdPoolSubmitTimeout(&tpool1, job1, &tpool_tokens[0],
+                                        TIME_IMMEDIATE) == MSG_TIMEOUT,
+              "no free job descriptors expected");
+
+  test_assert(4, chThdPoolWaitTimeout(&tpool1, TIME_INFINITE) == MSG_OK,
+              "wait failed");
+  test_assert_sequence(5, "ABCD");
+  test_assert(6, chThdPoolWaitTimeout(&tpool1, TIME_IMMEDIATE) == MSG_OK,
+              "jobs still pending");
+
+  /* Submit from I-class context.*/
+  chSysLock();
+  (void) chThdPoolSubmitI(&tpool1, job1, &tpool_tokens[3]);
+  chSysUnlock();
+  test_assert(7, chThdPoolWaitTimeout(&tpool1, TIME_INFINITE) == MSG_OK,
+              "wait failed");
+  test_assert_sequence(8, "D");
+
+  chThdPoolStop(&tpool1);
+  test_wait_threads();
+}
+
+ROMCONST struct testcase testtpool1 = {
+  "Thread Pools, submit and completion",
+  tpool_setup,
+  NULL,
+  tpool1_execute
+};
+
+/**
+ * @page test_tpool_002 Multiple workers and stop
+ *
+ * <h2>Description</h2>
+ * Two workers execute jobs sleeping for a while, the test thread waits for
+ * the jobs completion with a short timeout then stops the pool while jobs
+ * are still queued.<br>
+ * The test expects the wait to time out and all the queued jobs to be
+ * executed before the workers terminate.
+ */
+
+static void job2(void *p) {
+
+  (void)p;
+  chThdSleepMilliseconds(20);
+  chSysLock();
+  tpool_counter++;
+  chSysUnlock();
+}
+
+static void tpool2_execute(void) {
+  unsigned i;
+
+  tpool_counter = 0;
+  threads[0] = chThdPoolAddWorker(&tpool1, wa[0], WA_SIZE);
+  threads[1] = chThdPoolAddWorker(&tpool1, wa[1], WA_SIZE);
+  for (i = 0; i < TPOOL_JOBS; i++) {
+    chThdPoolSubmit(&tpool1, job2, NULL);
+  }
+  test_assert(1, chThdPoolWaitTimeout(&tpool1, MS2ST(5)) == MSG_TIMEOUT,
+              "timeout expected");
+
+  chThdPoolStop(&tpool1);
+  test_wait_threads();
+  test_assert(2, tpool_counter == TPOOL_JOBS, "jobs lost");
+  test_assert_lock(3, chThdPoolGetPendingI(&tpool1) == 0,
+                   "jobs still pending");
+}
+
+ROMCONST struct testcase testtpool2 = {
+  "Thread Pools, multiple workers and stop",
+  tpool_setup,
+  NULL,
+  tpool2_execute
+};
+
+#endif /* CH_CFG_USE_THREADPOOLS */
+
+/**
+ * @brief   Test sequence for thread pools.
+ */
+ROMCONST struct testcase * ROMCONST patterntpool[] = {
+#if CH_CFG_USE_THREADPOOLS || defined(__DOXYGEN__)
+  &testtpool1,
+  &testtpool2,
+#endif
+  NULL
+};
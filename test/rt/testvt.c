@@ -0,0 +1,300 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_vt Virtual Timers test
+ *
+ * File: @ref testvt.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref time subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover the virtual timers features not
+ * already exercised by the threads timeouts.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_VT_DEFERRED
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_vt_001
+ * - @subpage test_vt_002
+ * - @subpage test_vt_003
+ * - @subpage test_vt_004
+ * .
+ * @file testvt.c
+ * @brief Virtual Timers test source file
+ * @file testvt.h
+ * @brief Virtual Timers test header file
+ */
+
+static virtual_timer_t vt1, vt2, vt3;
+
+/*
+ * Callbacks invoked so far.
+ */
+static unsigned vt_count;
+
+/*
+ * Callback recording the expiration time.
+ */
+static void vt_record(void *p) {
+
+  *(systime_t *)p = chVTGetSystemTimeX();
+  vt_count++;
+}
+
+/**
+ * @page test_vt_001 Slack coalescing
+ *
+ * <h2>Description</h2>
+ * Three timers are armed with overlapping slack windows, all the windows
+ * contain the deadline of the timer having no slack, the test thread then
+ * polls the number of expired timers.<br>
+ * The test expects the timers to expire together, no partial expiration
+ * is observed, and each timer to expire within its slack window.
+ */
+
+static void vt1_execute(void) {
+  static const systime_t delays[3] = {3, 2, 2};
+  static const systime_t slacks[3] = {0, 1, 2};
+  systime_t times[3], base;
+  unsigned i, n;
+
+  vt_count = 0;
+  test_wait_tick();
+  chSysLock();
+  base = chVTGetSystemTimeX();
+  chVTDoSetWithSlackI(&vt1, delays[0], slacks[0], vt_record, &times[0]);
+  chVTDoSetWithSlackI(&vt2, delays[1], slacks[1], vt_record, &times[1]);
+  chVTDoSetWithSlackI(&vt3, delays[2], slacks[2], vt_record, &times[2]);
+  chSysUnlock();
+
+  /* Polling, the first observed expiration must include all the timers.*/
+  do {
+    chSysLock();
+    n = vt_count;
+    chSysUnlock();
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while ((n == 0U) && (chVTTimeElapsedSinceX(base) < MS2ST(100)));
+  test_assert(1, n == 3U, "not coalesced");
+
+  /* Never earlier than the deadline nor later than the slack window.*/
+  for (i = 0; i < 3U; i++) {
+    test_assert(2, (systime_t)(times[i] - base) >= delays[i], "too early");
+    test_assert(3, (systime_t)(times[i] - base) <=
+                   delays[i] + slacks[i] + CH_CFG_ST_TIMEDELTA + 1,
+                "too late");
+  }
+}
+
+ROMCONST struct testcase testvt1 = {
+  "Virtual Timers, slack coalescing",
+  NULL,
+  NULL,
+  vt1_execute
+};
+
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+/*
+ * Deferred callback blocking the callbacks thread until resumed.
+ */
+static thread_reference_t vt_tr;
+
+static void vt_block(void *p) {
+
+  (void)p;
+  chSysLock();
+  (void) chThdSuspendS(&vt_tr);
+  chSysUnlock();
+  test_emit_token('A');
+}
+
+/*
+ * Deferred callback emitting a token.
+ */
+static void vt_token(void *p) {
+
+  test_emit_token(*(char *)p);
+}
+
+static void vt_deferred_setup(void) {
+
+  vt_tr = NULL;
+}
+
+/**
+ * @page test_vt_002 Deferred callbacks context
+ *
+ * <h2>Description</h2>
+ * A deferred timer is armed, its callback records the invoking thread and
+ * its priority.<br>
+ * The test expects the callback to be invoked once by the deferred
+ * callbacks thread and not from the timer interrupt.
+ */
+
+static thread_t *vt_thread;
+static tprio_t vt_prio;
+
+static void vt_context(void *p) {
+
+  (void)p;
+  vt_thread = chThdGetSelfX();
+  vt_prio = chThdGetPriorityX();
+  vt_count++;
+}
+
+static void vt2_execute(void) {
+  bool armed;
+
+  vt_count = 0;
+  vt_thread = NULL;
+  chSysLock();
+  chVTDoSetDeferredI(&vt1, MS2ST(10), vt_context, NULL);
+  chSysUnlock();
+  chThdSleepMilliseconds(50);
+  test_assert(1, vt_count == 1U, "callback not invoked");
+  test_assert(2, (vt_thread != NULL) && (vt_thread != chThdGetSelfX()) &&
+                 (vt_prio == CH_CFG_VT_DEFERRED_PRIO),
+              "not invoked by the callbacks thread");
+  chSysLock();
+  armed = chVTIsArmedI(&vt1);
+  chSysUnlock();
+  test_assert(3, !armed, "still armed");
+}
+
+ROMCONST struct testcase testvt2 = {
+  "Virtual Timers, deferred callbacks context",
+  NULL,
+  NULL,
+  vt2_execute
+};
+
+/**
+ * @page test_vt_003 Deferred callbacks cancellation
+ *
+ * <h2>Description</h2>
+ * The callbacks thread is blocked by a first deferred callback, a second
+ * deferred timer expires while the thread is blocked and is then reset
+ * before its callback is invoked.<br>
+ * The test expects the expired timer to be pending until reset and its
+ * callback to never be invoked.
+ */
+
+static void vt3_execute(void) {
+  bool armed1, armed2;
+  ucnt_t depth1, depth2;
+
+  chSysLock();
+  chVTDoSetDeferredI(&vt1, MS2ST(5), vt_block, NULL);
+  chVTDoSetDeferredI(&vt2, MS2ST(10), vt_token, "B");
+  chSysUnlock();
+  chThdSleepMilliseconds(30);
+
+  chSysLock();
+  armed1 = chVTIsArmedI(&vt2);
+  depth1 = ch.vtdeferred.vt_depth;
+  chVTResetI(&vt2);
+  armed2 = chVTIsArmedI(&vt2);
+  depth2 = ch.vtdeferred.vt_depth;
+  chSysUnlock();
+  test_assert(1, vt_tr != NULL, "callbacks thread not blocked");
+  test_assert(2, armed1 && (depth1 == 1U), "not pending");
+  test_assert(3, !armed2 && (depth2 == 0U), "not cancelled");
+
+  /* Unblocking, the cancelled callback must not run.*/
+  chThdResume(&vt_tr, MSG_OK);
+  chThdSleepMilliseconds(10);
+  test_assert_sequence(4, "A");
+}
+
+ROMCONST struct testcase testvt3 = {
+  "Virtual Timers, deferred callbacks cancellation",
+  vt_deferred_setup,
+  NULL,
+  vt3_execute
+};
+
+/**
+ * @page test_vt_004 Deferred callbacks counters
+ *
+ * <h2>Description</h2>
+ * The callbacks thread is blocked by a first deferred callback while two
+ * other deferred timers expire, then the thread is unblocked.<br>
+ * The test expects the depth counter to account for the pending callbacks,
+ * the maximum depth to be retained and all the callbacks to be invoked in
+ * order within a single batch.
+ */
+
+static void vt4_execute(void) {
+  ucnt_t ncallbacks, nbatches, depth;
+
+  chSysLock();
+  ncallbacks = ch.vtdeferred.vt_ncallbacks;
+  nbatches = ch.vtdeferred.vt_nbatches;
+  chVTDoSetDeferredI(&vt1, MS2ST(5), vt_block, NULL);
+  chVTDoSetDeferredI(&vt2, MS2ST(10), vt_token, "B");
+  chVTDoSetDeferredI(&vt3, MS2ST(15), vt_token, "C");
+  chSysUnlock();
+  chThdSleepMilliseconds(30);
+
+  chSysLock();
+  depth = ch.vtdeferred.vt_depth;
+  chSysUnlock();
+  test_assert(1, vt_tr != NULL, "callbacks thread not blocked");
+  test_assert(2, depth == 2U, "wrong depth");
+
+  /* Unblocking, the pending callbacks are invoked in the same batch.*/
+  chThdResume(&vt_tr, MSG_OK);
+  chThdSleepMilliseconds(10);
+  test_assert_sequence(3, "ABC");
+  test_assert(4, (ch.vtdeferred.vt_depth == 0U) &&
+                 (ch.vtdeferred.vt_maxdepth >= 2U), "wrong depth");
+  test_assert(5, ch.vtdeferred.vt_ncallbacks == ncallbacks + 3U,
+              "wrong callbacks counter");
+  test_assert(6, ch.vtdeferred.vt_nbatches == nbatches + 1U,
+              "wrong batches counter");
+}
+
+ROMCONST struct testcase testvt4 = {
+  "Virtual Timers, deferred callbacks counters",
+  vt_deferred_setup,
+  NULL,
+  vt4_execute
+};
+#endif /* CH_CFG_VT_DEFERRED */
+
+/**
+ * @brief   Test sequence for virtual timers.
+ */
+ROMCONST struct testcase * ROMCONST patternvt[] = {
+  &testvt1,
+#if CH_CFG_VT_DEFERRED || defined(__DOXYGEN__)
+  &testvt2,
+  &testvt3,
+  &testvt4,
+#endif
+  NULL
+};
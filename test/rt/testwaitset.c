@@ -0,0 +1,242 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_waitset Wait-sets test
+ *
+ * File: @ref testwaitset.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref waitsets subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref waitsets code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_CFG_USE_WAITSETS
+ * - @p CH_CFG_USE_MAILBOXES
+ * - @p CH_CFG_USE_QUEUES
+ * - @p CH_CFG_USE_EVENTS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_waitset_001
+ * - @subpage test_waitset_002
+ * .
+ * @file testwaitset.c
+ * @brief Wait-sets test source file
+ * @file testwaitset.h
+ * @brief Wait-sets test header file
+ */
+
+#if (CH_CFG_USE_WAITSETS && CH_CFG_USE_MAILBOXES &&                         \
+     CH_CFG_USE_QUEUES && CH_CFG_USE_EVENTS) || defined(__DOXYGEN__)
+
+#define WS_SEM          0
+#define WS_MBOX         1
+#define WS_QUEUE        2
+#define WS_EVENTS       3
+#define WS_ENTRIES      4
+
+static waitset_t ws1;
+static waitset_entry_t ws1_entries[WS_ENTRIES];
+static semaphore_t sem1;
+static mailbox_t mb1;
+static msg_t mb1_buf[4];
+static input_queue_t iq1;
+static uint8_t iq1_buf[4];
+
+static void waitset_setup(void) {
+
+  chSemObjectInit(&sem1, 0);
+  chMBObjectInit(&mb1, mb1_buf, 4);
+  chIQObjectInit(&iq1, iq1_buf, sizeof iq1_buf, NULL, NULL);
+  chWSObjectInit(&ws1, ws1_entries, WS_ENTRIES);
+  chWSAddSemaphore(&ws1, WS_SEM, &sem1);
+  chWSAddMailbox(&ws1, WS_MBOX, &mb1);
+  chWSAddInputQueue(&ws1, WS_QUEUE, &iq1);
+  chWSAddEvents(&ws1, WS_EVENTS, EVENT_MASK(0));
+  (void) chEvtGetAndClearEvents(ALL_EVENTS);
+}
+
+/**
+ * @page test_waitset_001 Ready objects and timeouts
+ *
+ * <h2>Description</h2>
+ * A semaphore, a mailbox, an input queue and an events mask are registered
+ * in a wait-set, the objects are made ready one at time and then together,
+ * finally an entry is removed.<br>
+ * The test expects the wait to return the ready entry with the lowest
+ * identifier, to time out when no object is ready and to ignore the
+ * removed entry.
+ */
+
+static void waitset1_execute(void) {
+  msg_t msg;
+
+  /*
+   * Testing timeouts with no ready objects.
+   */
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(1, msg == MSG_TIMEOUT, "wrong wake-up message");
+  msg = chWSWaitTimeout(&ws1, MS2ST(10));
+  test_assert(2, msg == MSG_TIMEOUT, "wrong wake-up message");
+
+  /*
+   * Testing each object type.
+   */
+  chSemSignal(&sem1);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(3, msg == WS_SEM, "wrong entry");
+  (void) chSemWaitTimeout(&sem1, TIME_IMMEDIATE);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(4, msg == MSG_TIMEOUT, "entry still ready");
+
+  (void) chMBPost(&mb1, 'A', TIME_IMMEDIATE);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(5, msg == WS_MBOX, "wrong entry");
+  (void) chMBFetch(&mb1, &msg, TIME_IMMEDIATE);
+
+  chSysLock();
+  (void) chIQPutI(&iq1, 'B');
+  chSysUnlock();
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(6, msg == WS_QUEUE, "wrong entry");
+  (void) chIQGetTimeout(&iq1, TIME_IMMEDIATE);
+
+  chEvtSignal(chThdGetSelfX(), EVENT_MASK(1));
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(7, msg == MSG_TIMEOUT, "unregistered event");
+  chEvtSignal(chThdGetSelfX(), EVENT_MASK(0));
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(8, msg == WS_EVENTS, "wrong entry");
+  (void) chEvtGetAndClearEvents(ALL_EVENTS);
+
+  /*
+   * Testing several ready objects, the entries are returned in order.
+   */
+  chSysLock();
+  (void) chIQPutI(&iq1, 'C');
+  chSysUnlock();
+  chSemSignal(&sem1);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(9, msg == WS_SEM, "wrong entry");
+  (void) chSemWaitTimeout(&sem1, TIME_IMMEDIATE);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(10, msg == WS_QUEUE, "wrong entry");
+  (void) chIQGetTimeout(&iq1, TIME_IMMEDIATE);
+
+  /*
+   * Testing entries removal, the object is unlinked.
+   */
+  chWSRemove(&ws1, WS_SEM);
+  test_assert(11, sem1.s_wse == NULL, "still linked");
+  chSemSignal(&sem1);
+  msg = chWSWaitTimeout(&ws1, TIME_IMMEDIATE);
+  test_assert(12, msg == MSG_TIMEOUT, "removed entry ready");
+  chWSRemove(&ws1, WS_MBOX);
+  chWSRemove(&ws1, WS_QUEUE);
+  chWSRemove(&ws1, WS_EVENTS);
+  test_assert(13, (mb1.mb_fullsem.s_wse == NULL) && (iq1.q_wse == NULL),
+              "still linked");
+}
+
+ROMCONST struct testcase testwaitset1 = {
+  "Wait-sets, ready objects and timeouts",
+  waitset_setup,
+  NULL,
+  waitset1_execute
+};
+
+/**
+ * @page test_waitset_002 Blocking wait
+ *
+ * <h2>Description</h2>
+ * A thread with higher priority waits on the wait-set and consumes the
+ * ready object, the objects are made ready one at time.<br>
+ * The test expects the thread to be woken by each object in turn.
+ */
+
+static msg_t thread2(void *p) {
+  msg_t id, msg;
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < WS_ENTRIES; i++) {
+    id = chWSWait(&ws1);
+    switch (id) {
+    case WS_SEM:
+      (void) chSemWaitTimeout(&sem1, TIME_IMMEDIATE);
+      break;
+    case WS_MBOX:
+      (void) chMBFetch(&mb1, &msg, TIME_IMMEDIATE);
+      break;
+    case WS_QUEUE:
+      (void) chIQGetTimeout(&iq1, TIME_IMMEDIATE);
+      break;
+    case WS_EVENTS:
+      (void) chEvtGetAndClearEvents(ALL_EVENTS);
+      break;
+    default:
+      break;
+    }
+    test_emit_token('A' + id);
+  }
+  return 0;
+}
+
+static void waitset2_execute(void) {
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX() + 1,
+                                 thread2, NULL);
+  (void) chMBPost(&mb1, 'A', TIME_IMMEDIATE);
+  chSemSignal(&sem1);
+  chSysLock();
+  (void) chIQPutI(&iq1, 'B');
+  chSchRescheduleS();
+  chSysUnlock();
+  chEvtSignal(threads[0], EVENT_MASK(0));
+  test_wait_threads();
+  test_assert_sequence(1, "BACD");
+}
+
+ROMCONST struct testcase testwaitset2 = {
+  "Wait-sets, blocking wait",
+  waitset_setup,
+  NULL,
+  waitset2_execute
+};
+
+#endif /* CH_CFG_USE_WAITSETS && CH_CFG_USE_MAILBOXES &&
+          CH_CFG_USE_QUEUES && CH_CFG_USE_EVENTS */
+
+/**
+ * @brief   Test sequence for wait-sets.
+ */
+ROMCONST struct testcase * ROMCONST patternwaitset[] = {
+#if (CH_CFG_USE_WAITSETS && CH_CFG_USE_MAILBOXES &&                         \
+     CH_CFG_USE_QUEUES && CH_CFG_USE_EVENTS) || defined(__DOXYGEN__)
+  &testwaitset1,
+  &testwaitset2,
+#endif
+  NULL
+};
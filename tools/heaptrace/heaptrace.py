@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+#    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+#
+#    This file is part of ChibiOS.
+#
+#    ChibiOS is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    ChibiOS is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Decoder of the ChibiOS/RT heap trace buffer.
+
+The heap trace is enabled by CH_CFG_HEAP_PROFILE, the ch_heap_trace buffer
+is dumped from the target as a raw binary image, for example from GDB:
+
+    dump binary value heaptrace.bin ch_heap_trace
+
+then decoded on the host:
+
+    heaptrace.py --ptr 4 --time 4 --elf build/ch.elf heaptrace.bin
+
+The events are printed in chronological order followed by a summary of
+the traced window: peak of the bytes allocated in the window and the
+blocks still allocated at the end of the window grouped by call site.
+The --ptr and --time options must match the target sizes of pointers and
+systime_t, the structures are assumed to use natural alignment.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+
+EVENT_TYPES = {1: "alloc", 2: "free", 3: "fail"}
+
+
+def align(n, a):
+    return (n + a - 1) // a * a
+
+
+class Layout:
+    """Layout of heap_trace_buffer_t and heap_trace_event_t."""
+
+    def __init__(self, ptr, time, big):
+        self.ptr = ptr
+        self.time = time
+        self.endian = ">" if big else "<"
+        self.ptr_fmt = {4: "I", 8: "Q"}[ptr]
+        self.time_fmt = {2: "H", 4: "I", 8: "Q"}[time]
+        rec_align = max(ptr, time)
+        self.fields_off = align(time + 1, ptr)
+        self.rec_size = align(self.fields_off + 5 * ptr, rec_align)
+        self.buf_off = align(12, rec_align)
+
+    def header(self, data):
+        return struct.unpack_from(self.endian + "III", data, 0)
+
+    def event(self, data, index):
+        off = self.buf_off + index * self.rec_size
+        (time,) = struct.unpack_from(self.endian + self.time_fmt, data, off)
+        etype = data[off + self.time]
+        tp, heap, ptr, size, tag = struct.unpack_from(
+            self.endian + self.ptr_fmt * 5, data, off + self.fields_off)
+        return time, etype, tp, heap, ptr, size, tag
+
+
+class Symbolizer:
+    """Resolves call site tags using addr2line, if an ELF file is given."""
+
+    def __init__(self, elf, tool):
+        self.elf = elf
+        self.tool = tool
+        self.cache = {}
+
+    def __call__(self, addr):
+        if addr == 0:
+            return "untagged"
+        if self.elf is None:
+            return "0x%x" % addr
+        if addr not in self.cache:
+            try:
+                out = subprocess.run(
+                    [self.tool, "-f", "-s", "-e", self.elf, "0x%x" % addr],
+                    capture_output=True, text=True, check=True).stdout
+                func, line = (out.splitlines() + ["??", "??"])[:2]
+                self.cache[addr] = "0x%x %s (%s)" % (addr, func, line)
+            except (OSError, subprocess.CalledProcessError):
+                self.cache[addr] = "0x%x" % addr
+        return self.cache[addr]
+
+
+def decode(data, layout, symbolize, quiet):
+    size, nxt, events = layout.header(data)
+    if size == 0 or len(data) < layout.buf_off + size * layout.rec_size:
+        sys.exit("error: dump too short or layout mismatch "
+                 "(buffer size %u)" % size)
+
+    if events >= size:
+        first, count = nxt, size
+    else:
+        first, count = 0, events
+    print("%u events recorded, %u in buffer, %u lost"
+          % (events, count, events - count))
+
+    live = {}
+    used = peak = 0
+    fails = 0
+    for i in range(count):
+        time, etype, tp, heap, ptr, bsize, tag = layout.event(
+            data, (first + i) % size)
+        name = EVENT_TYPES.get(etype, "?%u" % etype)
+        if not quiet:
+            print("%10u %-5s thd=0x%08x heap=0x%08x ptr=0x%08x size=%-6u %s"
+                  % (time, name, tp, heap, ptr, bsize, symbolize(tag)))
+        if etype == 1:
+            live[ptr] = (bsize, tag)
+            used += bsize
+            peak = max(peak, used)
+        elif etype == 2:
+            # Blocks allocated before the window are not known.
+            if live.pop(ptr, None) is not None:
+                used -= bsize
+        elif etype == 3:
+            fails += 1
+
+    print()
+    print("window peak: %u bytes, failures: %u" % (peak, fails))
+    sites = {}
+    for bsize, tag in live.values():
+        blocks, nbytes = sites.get(tag, (0, 0))
+        sites[tag] = (blocks + 1, nbytes + bsize)
+    print("allocated at the end of the window:")
+    print("%8s %8s  %s" % ("blocks", "bytes", "site"))
+    for tag, (blocks, nbytes) in sorted(sites.items(),
+                                        key=lambda s: -s[1][1]):
+        print("%8u %8u  %s" % (blocks, nbytes, symbolize(tag)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dump", help="raw binary dump of ch_heap_trace")
+    ap.add_argument("--ptr", type=int, choices=(4, 8), default=4,
+                    help="target pointer size (default 4)")
+    ap.add_argument("--time", type=int, choices=(2, 4, 8), default=4,
+                    help="target systime_t size (default 4)")
+    ap.add_argument("--big-endian", action="store_true",
+                    help="big endian target")
+    ap.add_argument("--elf", help="ELF file used to resolve call sites")
+    ap.add_argument("--addr2line", default="arm-none-eabi-addr2line",
+                    help="addr2line tool (default arm-none-eabi-addr2line)")
+    ap.add_argument("-q", "--quiet", action="store_true",
+                    help="summary only")
+    args = ap.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    decode(data, Layout(args.ptr, args.time, args.big_endian),
+           Symbolizer(args.elf, args.addr2line), args.quiet)
+
+
+if __name__ == "__main__":
+    main()